@@ -0,0 +1,176 @@
+﻿#ifndef __INC_COMMON_PACKET_CAPTURE_H__
+#define __INC_COMMON_PACKET_CAPTURE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//
+// Capture of decoded client->game packets, one record per packet.
+// The game writes it when packet_capture is set in CONFIG (in-game phase only);
+// the loadsim tool reads it back and replays each descriptor's stream over a
+// freshly logged-in bot.
+//
+// Login packets are outside the in-game phase and never recorded. In game the
+// writer drops HEADER_CG_WHISPER, and HEADER_CG_CHAT lines that are a
+// /safebox_* or /mall_* command (safebox_password, safebox_change_password,
+// mall_password). Every other packet, including normal, party and guild chat,
+// is written as received.
+//
+// bSequence tells the reader the last byte of the payload is the sequence byte
+// of the captured connection; the replayer strips it and appends its own.
+//
+enum
+{
+	PACKET_CAPTURE_MAGIC	= 0x43504d32,	// "2MPC"
+	PACKET_CAPTURE_VERSION	= 1,
+};
+
+typedef struct SPacketCaptureHeader
+{
+	uint32_t	dwMagic;
+	uint32_t	dwVersion;
+} TPacketCaptureHeader;
+
+typedef struct SPacketCaptureRecord
+{
+	uint32_t	dwHandle;		// DESC handle, identifies the stream
+	uint32_t	dwTime;			// get_dword_time() of the game
+	uint16_t	wSize;			// payload size following the record
+	uint8_t		bSequence;
+	uint8_t		bReserved;
+} TPacketCaptureRecord;
+
+class CPacketCaptureWriter
+{
+	public:
+		CPacketCaptureWriter() : m_fp(NULL)
+		{
+		}
+
+		~CPacketCaptureWriter()
+		{
+			Close();
+		}
+
+		bool Open(const char * c_pszFileName)
+		{
+			Close();
+
+			m_fp = fopen(c_pszFileName, "wb");
+
+			if (!m_fp)
+				return false;
+
+			TPacketCaptureHeader header;
+			header.dwMagic		= PACKET_CAPTURE_MAGIC;
+			header.dwVersion	= PACKET_CAPTURE_VERSION;
+
+			if (fwrite(&header, sizeof(header), 1, m_fp) != 1)
+			{
+				Close();
+				return false;
+			}
+
+			return true;
+		}
+
+		void Close()
+		{
+			if (m_fp)
+			{
+				fclose(m_fp);
+				m_fp = NULL;
+			}
+		}
+
+		bool IsOpen() const	{ return m_fp != NULL; }
+
+		void Write(uint32_t dwHandle, uint32_t dwTime, bool bSequence, const void * c_pvData, size_t size)
+		{
+			if (!m_fp || size > 0xffff)
+				return;
+
+			TPacketCaptureRecord record;
+			record.dwHandle		= dwHandle;
+			record.dwTime		= dwTime;
+			record.wSize		= (uint16_t) size;
+			record.bSequence	= bSequence ? 1 : 0;
+			record.bReserved	= 0;
+
+			fwrite(&record, sizeof(record), 1, m_fp);
+			fwrite(c_pvData, size, 1, m_fp);
+		}
+
+		void Flush()
+		{
+			if (m_fp)
+				fflush(m_fp);
+		}
+
+	protected:
+		FILE *	m_fp;
+};
+
+class CPacketCaptureReader
+{
+	public:
+		CPacketCaptureReader() : m_fp(NULL)
+		{
+		}
+
+		~CPacketCaptureReader()
+		{
+			Close();
+		}
+
+		bool Open(const char * c_pszFileName)
+		{
+			Close();
+
+			m_fp = fopen(c_pszFileName, "rb");
+
+			if (!m_fp)
+				return false;
+
+			TPacketCaptureHeader header;
+
+			if (fread(&header, sizeof(header), 1, m_fp) != 1 ||
+					header.dwMagic != PACKET_CAPTURE_MAGIC || header.dwVersion != PACKET_CAPTURE_VERSION)
+			{
+				Close();
+				return false;
+			}
+
+			return true;
+		}
+
+		void Close()
+		{
+			if (m_fp)
+			{
+				fclose(m_fp);
+				m_fp = NULL;
+			}
+		}
+
+		// Returns false at the end of the file or on a torn trailing record.
+		bool Next(TPacketCaptureRecord & rRecord, std::vector<char> & rvecData)
+		{
+			if (!m_fp || fread(&rRecord, sizeof(rRecord), 1, m_fp) != 1)
+				return false;
+
+			rvecData.resize(rRecord.wSize);
+
+			if (rRecord.wSize && fread(&rvecData[0], rRecord.wSize, 1, m_fp) != 1)
+				return false;
+
+			return true;
+		}
+
+	protected:
+		FILE *	m_fp;
+};
+
+#endif
@@ -0,0 +1,239 @@
+﻿#ifndef __INC_COMMON_PROTO_SNAPSHOT_H__
+#define __INC_COMMON_PROTO_SNAPSHOT_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifndef OS_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "tables.h"
+
+//
+// Binary dump of the parsed mob/item proto tables.
+// The db writes it once after parsing the text tables; on restart both db and
+// game map it directly instead of re-parsing and streaming it in the BOOT packet.
+//
+// Open() fails on any version, struct size or checksum mismatch, so callers
+// must always be able to fall back to the text parse / BOOT packet path.
+//
+enum
+{
+	PROTO_SNAPSHOT_MAGIC	= 0x5350324d,	// "M2PS"
+	PROTO_SNAPSHOT_VERSION	= 1,
+};
+
+typedef struct SProtoSnapshotHeader
+{
+	uint32_t	dwMagic;
+	uint32_t	dwVersion;
+	uint32_t	dwSourceStamp;		// hash of the source text files' size/mtime
+	uint32_t	dwMobTableSize;
+	uint32_t	dwMobCount;
+	uint32_t	dwItemTableSize;
+	uint32_t	dwItemCount;
+	uint32_t	dwChecksum;			// FNV-1a of the payload following the header
+} TProtoSnapshotHeader;
+
+class CProtoSnapshot
+{
+	public:
+		CProtoSnapshot() : m_pBase(NULL), m_size(0), m_pHeader(NULL)
+		{
+		}
+
+		~CProtoSnapshot()
+		{
+			Close();
+		}
+
+		static uint32_t Hash(const void * c_pvData, size_t size, uint32_t dwHash = 2166136261u)
+		{
+			const unsigned char * p = (const unsigned char *) c_pvData;
+
+			while (size--)
+			{
+				dwHash ^= *p++;
+				dwHash *= 16777619u;
+			}
+
+			return dwHash;
+		}
+
+		static bool Save(const char * c_pszFileName, uint32_t dwSourceStamp,
+				const std::vector<TMobTable> & c_rMobTable, const std::vector<TItemTable> & c_rItemTable)
+		{
+			TProtoSnapshotHeader header;
+			memset(&header, 0, sizeof(header));
+
+			header.dwMagic			= PROTO_SNAPSHOT_MAGIC;
+			header.dwVersion		= PROTO_SNAPSHOT_VERSION;
+			header.dwSourceStamp	= dwSourceStamp;
+			header.dwMobTableSize	= sizeof(TMobTable);
+			header.dwMobCount		= c_rMobTable.size();
+			header.dwItemTableSize	= sizeof(TItemTable);
+			header.dwItemCount		= c_rItemTable.size();
+
+			uint32_t dwHash = 2166136261u;
+
+			if (!c_rMobTable.empty())
+				dwHash = Hash(&c_rMobTable[0], sizeof(TMobTable) * c_rMobTable.size(), dwHash);
+
+			if (!c_rItemTable.empty())
+				dwHash = Hash(&c_rItemTable[0], sizeof(TItemTable) * c_rItemTable.size(), dwHash);
+
+			header.dwChecksum = dwHash;
+
+			// Write to a temp file and rename so a crash never leaves a torn snapshot.
+			std::string stTempName = std::string(c_pszFileName) + ".tmp";
+
+			FILE * fp = fopen(stTempName.c_str(), "wb");
+
+			if (!fp)
+				return false;
+
+			bool bRet = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+			if (bRet && !c_rMobTable.empty())
+				bRet = fwrite(&c_rMobTable[0], sizeof(TMobTable), c_rMobTable.size(), fp) == c_rMobTable.size();
+
+			if (bRet && !c_rItemTable.empty())
+				bRet = fwrite(&c_rItemTable[0], sizeof(TItemTable), c_rItemTable.size(), fp) == c_rItemTable.size();
+
+			if (fclose(fp) != 0)
+				bRet = false;
+
+			if (bRet)
+			{
+				remove(c_pszFileName);
+				bRet = rename(stTempName.c_str(), c_pszFileName) == 0;
+			}
+
+			if (!bRet)
+				remove(stTempName.c_str());
+
+			return bRet;
+		}
+
+		bool Open(const char * c_pszFileName)
+		{
+			Close();
+
+#ifndef OS_WINDOWS
+			int fd = open(c_pszFileName, O_RDONLY);
+
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+
+			if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(TProtoSnapshotHeader))
+			{
+				close(fd);
+				return false;
+			}
+
+			void * pv = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+
+			if (pv == MAP_FAILED)
+				return false;
+
+			m_pBase = (const char *) pv;
+			m_size = st.st_size;
+#else
+			FILE * fp = fopen(c_pszFileName, "rb");
+
+			if (!fp)
+				return false;
+
+			fseek(fp, 0, SEEK_END);
+			long lSize = ftell(fp);
+			fseek(fp, 0, SEEK_SET);
+
+			if (lSize < (long) sizeof(TProtoSnapshotHeader))
+			{
+				fclose(fp);
+				return false;
+			}
+
+			m_vecBuffer.resize(lSize);
+			bool bRead = fread(&m_vecBuffer[0], lSize, 1, fp) == 1;
+			fclose(fp);
+
+			if (!bRead)
+			{
+				m_vecBuffer.clear();
+				return false;
+			}
+
+			m_pBase = &m_vecBuffer[0];
+			m_size = lSize;
+#endif
+			m_pHeader = (const TProtoSnapshotHeader *) m_pBase;
+
+			if (!Verify())
+			{
+				Close();
+				return false;
+			}
+
+			return true;
+		}
+
+		void Close()
+		{
+#ifndef OS_WINDOWS
+			if (m_pBase)
+				munmap((void *) m_pBase, m_size);
+#else
+			m_vecBuffer.clear();
+#endif
+			m_pBase = NULL;
+			m_size = 0;
+			m_pHeader = NULL;
+		}
+
+		bool IsOpen() const					{ return m_pHeader != NULL; }
+		uint32_t GetSourceStamp() const		{ return m_pHeader ? m_pHeader->dwSourceStamp : 0; }
+		uint32_t GetChecksum() const		{ return m_pHeader ? m_pHeader->dwChecksum : 0; }
+
+		const TMobTable * GetMobTable() const	{ return (const TMobTable *) (m_pBase + sizeof(TProtoSnapshotHeader)); }
+		uint32_t GetMobCount() const			{ return m_pHeader ? m_pHeader->dwMobCount : 0; }
+
+		const TItemTable * GetItemTable() const	{ return (const TItemTable *) ((const char *) GetMobTable() + sizeof(TMobTable) * GetMobCount()); }
+		uint32_t GetItemCount() const			{ return m_pHeader ? m_pHeader->dwItemCount : 0; }
+
+	protected:
+		bool Verify() const
+		{
+			if (m_pHeader->dwMagic != PROTO_SNAPSHOT_MAGIC || m_pHeader->dwVersion != PROTO_SNAPSHOT_VERSION)
+				return false;
+
+			if (m_pHeader->dwMobTableSize != sizeof(TMobTable) || m_pHeader->dwItemTableSize != sizeof(TItemTable))
+				return false;
+
+			size_t payload = sizeof(TMobTable) * (size_t) m_pHeader->dwMobCount + sizeof(TItemTable) * (size_t) m_pHeader->dwItemCount;
+
+			if (m_size != sizeof(TProtoSnapshotHeader) + payload)
+				return false;
+
+			return Hash(m_pBase + sizeof(TProtoSnapshotHeader), payload) == m_pHeader->dwChecksum;
+		}
+
+	protected:
+		const char *					m_pBase;
+		size_t							m_size;
+		const TProtoSnapshotHeader *	m_pHeader;
+#ifdef OS_WINDOWS
+		std::vector<char>				m_vecBuffer;
+#endif
+};
+
+#endif
@@ -6,5 +6,6 @@
 #define _IMPROVED_PACKET_ENCRYPTION_ // 패킷 암호화 개선
 #define __PET_SYSTEM__
 #define __UDP_BLOCK__
+#define ENABLE_SCOPED_TRACE // 스코프 트레이스 (libthecore/trace.h), 끄면 M2_TRACE_SCOPE 는 빈 매크로
 
 #endif
@@ -137,6 +137,8 @@ enum
 	HEADER_GD_UPDATE_CHANNELSTATUS	= 139,
 	HEADER_GD_REQUEST_CHANNELSTATUS	= 140,
 
+	HEADER_GD_RELOAD_ITEM_AWARD	= 141,	// item_award 즉시 읽기 (어드민 RELOAD_AWARD)
+
 	HEADER_GD_SETUP			= 0xff,
 
 	///////////////////////////////////////////////
@@ -880,6 +882,7 @@ typedef struct SPacketGDBoot
 {
     uint32_t	dwItemIDRange[2];
 	char	szIP[16];
+	uint32_t	dwProtoSnapshotChecksum;	// 0: mob/item tables are streamed in the BOOT packet
 } TPacketGDBoot;
 
 typedef struct SPacketGuild
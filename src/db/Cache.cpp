@@ -6,6 +6,8 @@
 #include "ClientManager.h"
 #include "Main.h"
 
+#include <atomic>
+
 extern CPacketInfo g_item_info;
 extern int g_iPlayerCacheFlushSeconds;
 extern int g_iItemCacheFlushSeconds;
@@ -14,7 +16,7 @@ extern int g_test_server;
 extern int g_iItemPriceListTableCacheFlushSeconds;
 // END_OF_MYSHOP_PRICE_LIST
 //
-extern int g_item_count;
+extern std::atomic<int> g_item_count;
 
 CItemCache::CItemCache()
 {
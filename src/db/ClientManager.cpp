@@ -19,6 +19,7 @@
 #include "ItemIDRangeManager.h"
 #include "Cache.h"
 
+#include <atomic>
 #include <memory>
 
 extern int g_iPlayerCacheFlushSeconds;
@@ -35,8 +36,9 @@ DWORD g_dwUsageAvg = 0;
 CPacketInfo g_query_info;
 CPacketInfo g_item_info;
 
-int g_item_count = 0;
-int g_query_count[2];
+// 샤드 스레드에서도 센다
+std::atomic<int> g_item_count(0);
+std::atomic<int> g_query_count[2];
 
 CClientManager::CClientManager() :
 	m_pkAuthPeer(NULL),
@@ -44,19 +46,21 @@ CClientManager::CClientManager() :
 	m_iPlayerDeleteLevelLimit(0),
 	m_iPlayerDeleteLevelLimitLower(0),
 	m_bChinaEventServer(false),
+	m_dwProtoSnapshotChecksum(0),
 	m_iShopTableSize(0),
 	m_pShopTable(NULL),
 	m_iRefineTableSize(0),
 	m_pRefineTable(NULL),
 	m_bShutdowned(FALSE),
-	m_iCacheFlushCount(0),
-	m_iCacheFlushCountLimit(200)
+	m_iCacheFlushCountLimit(200),
+	m_bShardThread(false)
 {
 	m_itemRange.dwMin = 0;
 	m_itemRange.dwMax = 0;
 	m_itemRange.dwUsableItemIDMin = 0;
 
-	memset(g_query_count, 0, sizeof(g_query_count));
+	g_query_count[0] = 0;
+	g_query_count[1] = 0;
 }
 
 CClientManager::~CClientManager()
@@ -105,6 +109,26 @@ bool CClientManager::Initialize()
 	}
 	//END_ITEM_UNIQUE_ID
 
+	char szProtoSnapshot[256+1];
+
+	if (CConfig::instance().GetValue("PROTO_SNAPSHOT", szProtoSnapshot, 256))
+	{
+		m_stProtoSnapshotFileName = szProtoSnapshot;
+		sys_log(0, "PROTO_SNAPSHOT: %s", m_stProtoSnapshotFileName.c_str());
+	}
+
+	int iAwardRefreshSeconds = 0;
+
+	if (CConfig::instance().GetValue("ITEM_AWARD_REFRESH_SECONDS", &iAwardRefreshSeconds))
+		ItemAwardManager::instance().SetRefreshSeconds(iAwardRefreshSeconds);
+
+	int iShardCount = 0;
+
+	if (CConfig::instance().GetValue("PLAYER_SHARD_COUNT", &iShardCount))
+		sys_log(0, "PLAYER_SHARD_COUNT: %d", iShardCount);
+
+	InitializeShards(iShardCount);
+
 	if (!InitializeTables())
 	{
 		sys_err("Table Initialize FAILED");
@@ -180,8 +204,11 @@ void CClientManager::MainLoop()
 	// 메인루프
 	while (!m_bShutdowned)
 	{
+		ProcessMainTasks();
+
 		while ((tmp = CDBManager::instance().PopResult()))
 		{
+			M2_TRACE_SCOPE("query_result");
 			AnalyzeQueryResult(tmp);
 			delete tmp;
 		}
@@ -197,29 +224,8 @@ void CClientManager::MainLoop()
 
 	signal_timer_disable();
 
-	itertype(m_map_playerCache) it = m_map_playerCache.begin();
-
-	//플레이어 테이블 캐쉬 플러쉬	
-	while (it != m_map_playerCache.end())
-	{
-		CPlayerTableCache * c = (it++)->second;
-
-		c->Flush();
-		delete c;
-	}
-	m_map_playerCache.clear();
-
-	
-	itertype(m_map_itemCache) it2 = m_map_itemCache.begin();
-	//아이템 플러쉬
-	while (it2 != m_map_itemCache.end())
-	{
-		CItemCache * c = (it2++)->second;
-
-		c->Flush();
-		delete c;
-	}
-	m_map_itemCache.clear();
+	//플레이어, 아이템 캐쉬 플러쉬
+	DestroyShards();
 
 	// MYSHOP_PRICE_LIST
 	//
@@ -243,7 +249,7 @@ void CClientManager::Quit()
 
 void CClientManager::QUERY_BOOT(CPeer* peer, TPacketGDBoot * p)
 {
-	const BYTE bPacketVersion = 6; // BOOT 패킷이 바뀔때마다 번호를 올리도록 한다.
+	const BYTE bPacketVersion = 7; // BOOT 패킷이 바뀔때마다 번호를 올리도록 한다.
 
 	std::vector<tAdminInfo> vAdmin;
 	std::vector<std::string> vHost;
@@ -253,11 +259,24 @@ void CClientManager::QUERY_BOOT(CPeer* peer, TPacketGDBoot * p)
 
 	sys_log(0, "QUERY_BOOT : AdminInfo (Request ServerIp %s) ", p->szIP);
 
+	// The game core already mapped the same proto snapshot, so mob/item tables are not streamed.
+	DWORD dwProtoSnapshotChecksum = 0;
+
+	if (p->dwProtoSnapshotChecksum && p->dwProtoSnapshotChecksum == m_dwProtoSnapshotChecksum)
+		dwProtoSnapshotChecksum = m_dwProtoSnapshotChecksum;
+
+	size_t mobTableCount = dwProtoSnapshotChecksum ? 0 : m_vec_mobTable.size();
+	size_t itemTableCount = dwProtoSnapshotChecksum ? 0 : m_vec_itemTable.size();
+
+	sys_log(0, "QUERY_BOOT : ProtoSnapshot (Request %08x Current %08x) %s", p->dwProtoSnapshotChecksum, m_dwProtoSnapshotChecksum,
+			dwProtoSnapshotChecksum ? "skip mob/item tables" : "send mob/item tables");
+
 	DWORD dwPacketSize = 
 		sizeof(DWORD) +
 		sizeof(BYTE) +
-		sizeof(WORD) + sizeof(WORD) + sizeof(TMobTable) * m_vec_mobTable.size() +
-		sizeof(WORD) + sizeof(WORD) + sizeof(TItemTable) * m_vec_itemTable.size() +
+		sizeof(DWORD) +
+		sizeof(WORD) + sizeof(WORD) + sizeof(TMobTable) * mobTableCount +
+		sizeof(WORD) + sizeof(WORD) + sizeof(TItemTable) * itemTableCount +
 		sizeof(WORD) + sizeof(WORD) + sizeof(TShopTable) * m_iShopTableSize +
 		sizeof(WORD) + sizeof(WORD) + sizeof(TSkillTable) * m_vec_skillTable.size() +
 		sizeof(WORD) + sizeof(WORD) + sizeof(TRefineTable) * m_iRefineTableSize +
@@ -280,6 +299,7 @@ void CClientManager::QUERY_BOOT(CPeer* peer, TPacketGDBoot * p)
 	peer->EncodeHeader(HEADER_DG_BOOT, 0, dwPacketSize);
 	peer->Encode(&dwPacketSize, sizeof(DWORD));
 	peer->Encode(&bPacketVersion, sizeof(BYTE));
+	peer->Encode(&dwProtoSnapshotChecksum, sizeof(DWORD));
 
 	sys_log(0, "BOOT: PACKET: %d", dwPacketSize);
 	sys_log(0, "BOOT: VERSION: %d", bPacketVersion);
@@ -301,12 +321,12 @@ void CClientManager::QUERY_BOOT(CPeer* peer, TPacketGDBoot * p)
 	sys_log(0, "sizeof(TMonarchInfo) = %d * %d", sizeof(TMonarchInfo));
 
 	peer->EncodeWORD(sizeof(TMobTable));
-	peer->EncodeWORD(m_vec_mobTable.size());
-	peer->Encode(&m_vec_mobTable[0], sizeof(TMobTable) * m_vec_mobTable.size());
+	peer->EncodeWORD(mobTableCount);
+	peer->Encode(&m_vec_mobTable[0], sizeof(TMobTable) * mobTableCount);
 
 	peer->EncodeWORD(sizeof(TItemTable));
-	peer->EncodeWORD(m_vec_itemTable.size());
-	peer->Encode(&m_vec_itemTable[0], sizeof(TItemTable) * m_vec_itemTable.size());
+	peer->EncodeWORD(itemTableCount);
+	peer->Encode(&m_vec_itemTable[0], sizeof(TItemTable) * itemTableCount);
 
 	peer->EncodeWORD(sizeof(TShopTable));
 	peer->EncodeWORD(m_iShopTableSize);
@@ -444,25 +464,37 @@ void CClientManager::QUERY_QUEST_SAVE(CPeer * pkPeer, TQuestTable * pTable, DWOR
 
 	int iSize = dwLen / sizeof(TQuestTable);
 
-	char szQuery[1024];
+	if (iSize == 0)
+		return;
+
+	// 한 패킷은 한 플레이어의 퀘스트만 담고 있다.
+	std::vector<TQuestTable> vec_quest(pTable, pTable + iSize);
+	DWORD dwPeerHandle = pkPeer->GetHandle();
 
-	for (int i = 0; i < iSize; ++i, ++pTable)
+	GetShard(pTable->dwPID)->Post([vec_quest, dwPeerHandle]()
 	{
-		if (pTable->lValue == 0)
-		{
-			snprintf(szQuery, sizeof(szQuery),
-					"DELETE FROM quest%s WHERE dwPID=%d AND szName='%s' AND szState='%s'",
-					GetTablePostfix(), pTable->dwPID, pTable->szName, pTable->szState);
-		}
-		else
+		char szQuery[1024];
+
+		for (size_t i = 0; i < vec_quest.size(); ++i)
 		{
-			snprintf(szQuery, sizeof(szQuery),
-					"REPLACE INTO quest%s (dwPID, szName, szState, lValue) VALUES(%d, '%s', '%s', %ld)",
-					GetTablePostfix(), pTable->dwPID, pTable->szName, pTable->szState, static_cast<long>(pTable->lValue));
-		}
+			const TQuestTable * pTable = &vec_quest[i];
 
-		CDBManager::instance().ReturnQuery(szQuery, QID_QUEST_SAVE, pkPeer->GetHandle(), NULL);
-	}
+			if (pTable->lValue == 0)
+			{
+				snprintf(szQuery, sizeof(szQuery),
+						"DELETE FROM quest%s WHERE dwPID=%d AND szName='%s' AND szState='%s'",
+						GetTablePostfix(), pTable->dwPID, pTable->szName, pTable->szState);
+			}
+			else
+			{
+				snprintf(szQuery, sizeof(szQuery),
+						"REPLACE INTO quest%s (dwPID, szName, szState, lValue) VALUES(%d, '%s', '%s', %ld)",
+						GetTablePostfix(), pTable->dwPID, pTable->szName, pTable->szState, static_cast<long>(pTable->lValue));
+			}
+
+			CDBManager::instance().ReturnQuery(szQuery, QID_QUEST_SAVE, dwPeerHandle, NULL);
+		}
+	});
 }
 
 void CClientManager::QUERY_SAFEBOX_LOAD(CPeer * pkPeer, DWORD dwHandle, TSafeboxLoadPacket * packet, bool bMall)
@@ -595,216 +627,264 @@ void CClientManager::RESULT_SAFEBOX_LOAD(CPeer * pkPeer, SQLMsg * msg)
 			return;
 		}
 
-		static std::vector<TPlayerItem> s_items;
-		CreateItemTableFromRes(msg->Get()->pSQLResult, &s_items, pi->account_id);
+		TSafeboxAwardInsert * pkInsert = new TSafeboxAwardInsert;
+		pkInsert->pkInfo = pi;
+
+		CreateItemTableFromRes(msg->Get()->pSQLResult, &pkInsert->vec_item, pi->account_id);
+
+		ItemAwardManager::TAwardQueue * pQueue = ItemAwardManager::instance().GetByLogin(pi->login);
 
-		std::set<TItemAward *> * pSet = ItemAwardManager::instance().GetByLogin(pi->login);
+		if (pQueue && !m_vec_itemTable.empty())
+			PlaceItemAwards(pi, pQueue, pkInsert);
 
-		if (pSet && !m_vec_itemTable.empty())
+		if (pkInsert->vec_award.empty())
 		{
+			SendSafeboxLoad(pkPeer, pi, pkInsert->vec_item);
+			delete pkInsert;
+			delete pi;
+			return;
+		}
 
-			CGrid grid(5, MAX(1, pi->pSafebox->bSize) * 9);
-			bool bEscape = false;
+		//
+		// 받을 아이템들은 한 쿼리로 넣고, 창고는 결과가 온 뒤에 보낸다.
+		//
+		std::string stQuery;
+		char szValues[256];
 
-			for (DWORD i = 0; i < s_items.size(); ++i)
-			{
-				TPlayerItem & r = s_items[i];
+		stQuery.reserve(128 + pkInsert->vec_award.size() * 64);
+		stQuery = "INSERT INTO item";
+		stQuery += GetTablePostfix();
+		stQuery += " (id, owner_id, window, pos, vnum, count, socket0, socket1, socket2) VALUES";
 
-				itertype(m_map_itemTableByVnum) it = m_map_itemTableByVnum.find(r.vnum);
+		size_t iFirst = pkInsert->vec_item.size() - pkInsert->vec_award.size();
 
-				if (it == m_map_itemTableByVnum.end())
-				{
-					bEscape = true;
-					sys_err("invalid item vnum %u in safebox: login %s", r.vnum, pi->login);
-					break;
-				}
+		for (size_t i = iFirst; i < pkInsert->vec_item.size(); ++i)
+		{
+			const TPlayerItem & r = pkInsert->vec_item[i];
+
+			snprintf(szValues, sizeof(szValues), "%s(%u, %u, '%s', %d, %u, %u, %u, %u, %u)",
+					i == iFirst ? "" : ",",
+					r.id,
+					pi->account_id,
+					pi->ip[0] == 0 ? "SAFEBOX" : "MALL",
+					r.pos,
+					r.vnum, r.count, (DWORD) r.alSockets[0], (DWORD) r.alSockets[1], (DWORD) r.alSockets[2]);
+			stQuery += szValues;
+		}
 
-				grid.Put(r.pos, 1, it->second->bSize);
-			}
+		sys_log(0, "SAFEBOX: item_award %u items for %s", pkInsert->vec_award.size(), pi->login);
 
-			if (!bEscape)
-			{
-				std::vector<std::pair<DWORD, DWORD> > vec_dwFinishedAwardID;
+		CDBManager::instance().ReturnQuery(stQuery.c_str(), QID_SAFEBOX_AWARD_INSERT, pkPeer->GetHandle(), pkInsert);
+	}
+}
 
-				__typeof(pSet->begin()) it = pSet->begin();
+//
+// 로그인의 item_award 큐를 ID 순으로 보며 창고 빈 칸에 놓을 아이템을 만든다.
+// 놓은 것은 bTaken으로 잡아 두어 INSERT 결과가 오기 전에 다시 놓이지 않게 한다.
+//
+void CClientManager::PlaceItemAwards(ClientHandleInfo * pi, ItemAwardManager::TAwardQueue * pQueue, TSafeboxAwardInsert * pkInsert)
+{
+	std::vector<TPlayerItem> & vec_item = pkInsert->vec_item;
+	std::vector<TItemAward *> vec_pkPlaced;
 
-				char szQuery[512];
+	CGrid grid(5, MAX(1, pi->pSafebox->bSize) * 9);
 
-				while (it != pSet->end())
-				{
-					TItemAward * pItemAward = *(it++);
-					const DWORD& dwItemVnum = pItemAward->dwVnum;
+	for (DWORD i = 0; i < vec_item.size(); ++i)
+	{
+		TPlayerItem & r = vec_item[i];
 
-					if (pItemAward->bTaken)
-						continue;
+		itertype(m_map_itemTableByVnum) it = m_map_itemTableByVnum.find(r.vnum);
 
-					if (pi->ip[0] == 0 && pItemAward->bMall)
-						continue;
+		if (it == m_map_itemTableByVnum.end())
+		{
+			sys_err("invalid item vnum %u in safebox: login %s", r.vnum, pi->login);
+			return;
+		}
 
-					if (pi->ip[0] == 1 && !pItemAward->bMall)
-						continue;
+		grid.Put(r.pos, 1, it->second->bSize);
+	}
 
-					itertype(m_map_itemTableByVnum) it = m_map_itemTableByVnum.find(pItemAward->dwVnum);
+	for (itertype(*pQueue) itAward = pQueue->begin(); itAward != pQueue->end(); ++itAward)
+	{
+		TItemAward * pItemAward = itAward->second;
+		const DWORD& dwItemVnum = pItemAward->dwVnum;
 
-					if (it == m_map_itemTableByVnum.end())
-					{
-						sys_err("invalid item vnum %u in item_award: login %s", pItemAward->dwVnum, pi->login);
-						continue;
-					}
+		if (pItemAward->bTaken)
+			continue;
 
-					TItemTable * pItemTable = it->second;
+		if (pi->ip[0] == 0 && pItemAward->bMall)
+			continue;
 
-					int iPos;
+		if (pi->ip[0] == 1 && !pItemAward->bMall)
+			continue;
 
-					if ((iPos = grid.FindBlank(1, it->second->bSize)) == -1)
-						break;
+		itertype(m_map_itemTableByVnum) it = m_map_itemTableByVnum.find(pItemAward->dwVnum);
 
-					TPlayerItem item;
-					memset(&item, 0, sizeof(TPlayerItem));
+		if (it == m_map_itemTableByVnum.end())
+		{
+			sys_err("invalid item vnum %u in item_award: login %s", pItemAward->dwVnum, pi->login);
+			continue;
+		}
 
-					// DWORD dwSocket2 = 0;
-					DWORD dwSocket2 = pItemAward->dwSocket2; //Fix
+		TItemTable * pItemTable = it->second;
 
-					if (pItemTable->bType == ITEM_UNIQUE)
-					{
-						if (pItemAward->dwSocket2 != 0)
-							dwSocket2 = pItemAward->dwSocket2;
-						else
-							dwSocket2 = pItemTable->alValues[0];
-					}
-					else if ((dwItemVnum == 50300 || dwItemVnum == 70037) && pItemAward->dwSocket0 == 0)
-					{
-						DWORD dwSkillIdx;
-						DWORD dwSkillVnum;
+		int iPos;
+
+		if ((iPos = grid.FindBlank(1, pItemTable->bSize)) == -1)
+			break;
 
-						do
-						{
-							dwSkillIdx = number(0, m_vec_skillTable.size()-1);
+		// DWORD dwSocket2 = 0;
+		DWORD dwSocket2 = pItemAward->dwSocket2; //Fix
 
-							dwSkillVnum = m_vec_skillTable[dwSkillIdx].dwVnum;
+		if (pItemTable->bType == ITEM_UNIQUE)
+		{
+			if (pItemAward->dwSocket2 != 0)
+				dwSocket2 = pItemAward->dwSocket2;
+			else
+				dwSocket2 = pItemTable->alValues[0];
+		}
+		else if ((dwItemVnum == 50300 || dwItemVnum == 70037) && pItemAward->dwSocket0 == 0)
+		{
+			DWORD dwSkillIdx;
+			DWORD dwSkillVnum;
+
+			do
+			{
+				dwSkillIdx = number(0, m_vec_skillTable.size()-1);
 
-							if (dwSkillVnum > 120)
-								continue;
+				dwSkillVnum = m_vec_skillTable[dwSkillIdx].dwVnum;
 
-							break;
-						} while (1);
+				if (dwSkillVnum > 120)
+					continue;
 
-						pItemAward->dwSocket0 = dwSkillVnum;
-					}
-					else
-					{
-						switch (dwItemVnum)
-						{
-							case 72723: case 72724: case 72725: case 72726:
-							case 72727: case 72728: case 72729: case 72730:
-							// 무시무시하지만 이전에 하던 걸 고치기는 무섭고...
-							// 그래서 그냥 하드 코딩. 선물 상자용 자동물약 아이템들.
-							case 76004: case 76005: case 76021: case 76022:
-							case 79012: case 79013:
-								if (pItemAward->dwSocket2 == 0)
-								{
-									dwSocket2 = pItemTable->alValues[0];
-								}
-								else
-								{
-									dwSocket2 = pItemAward->dwSocket2;
-								}
-								break;
-						}
-					}
+				break;
+			} while (1);
 
-					if (GetItemID () > m_itemRange.dwMax)
+			pItemAward->dwSocket0 = dwSkillVnum;
+		}
+		else
+		{
+			switch (dwItemVnum)
+			{
+				case 72723: case 72724: case 72725: case 72726:
+				case 72727: case 72728: case 72729: case 72730:
+				// 무시무시하지만 이전에 하던 걸 고치기는 무섭고...
+				// 그래서 그냥 하드 코딩. 선물 상자용 자동물약 아이템들.
+				case 76004: case 76005: case 76021: case 76022:
+				case 79012: case 79013:
+					if (pItemAward->dwSocket2 == 0)
 					{
-						sys_err("UNIQUE ID OVERFLOW!!");
-						break;
+						dwSocket2 = pItemTable->alValues[0];
 					}
-
+					else
 					{
-						itertype(m_map_itemTableByVnum) it = m_map_itemTableByVnum.find (dwItemVnum);
-						if (it == m_map_itemTableByVnum.end())
-						{
-							sys_err ("Invalid item(vnum : %d). It is not in m_map_itemTableByVnum.", dwItemVnum);
-							continue;
-						}
-						TItemTable* item_table = it->second;
-						if (item_table == NULL)
-						{
-							sys_err ("Invalid item_table (vnum : %d). It's value is NULL in m_map_itemTableByVnum.", dwItemVnum);
-							continue;
-						}
-						if (0 == pItemAward->dwSocket0)
-						{
-							for (int i = 0; i < ITEM_LIMIT_MAX_NUM; i++)
-							{
-								if (LIMIT_REAL_TIME == item_table->aLimits[i].bType)
-								{
-									if (0 == item_table->aLimits[i].lValue)
-										pItemAward->dwSocket0 = time(0) + 60 * 60 * 24 * 7;
-									else
-										pItemAward->dwSocket0 = time(0) + item_table->aLimits[i].lValue;
-
-									break;
-								}
-								else if (LIMIT_REAL_TIME_START_FIRST_USE == item_table->aLimits[i].bType || LIMIT_TIMER_BASED_ON_WEAR == item_table->aLimits[i].bType)
-								{
-									if (0 == item_table->aLimits[i].lValue)
-										pItemAward->dwSocket0 = 60 * 60 * 24 * 7;
-									else
-										pItemAward->dwSocket0 = item_table->aLimits[i].lValue;
-
-									break;
-								}
-							}
-						}
-
-						snprintf(szQuery, sizeof(szQuery), 
-								"INSERT INTO item%s (id, owner_id, window, pos, vnum, count, socket0, socket1, socket2) "
-								"VALUES(%u, %u, '%s', %d, %u, %u, %u, %u, %u)",
-								GetTablePostfix(),
-								GainItemID(),
-								pi->account_id,
-								pi->ip[0] == 0 ? "SAFEBOX" : "MALL",
-								iPos,
-								pItemAward->dwVnum, pItemAward->dwCount, pItemAward->dwSocket0, pItemAward->dwSocket1, dwSocket2);
+						dwSocket2 = pItemAward->dwSocket2;
 					}
+					break;
+			}
+		}
 
-					auto pmsg = CDBManager::instance().DirectQuery(szQuery);
-					SQLResult * pRes = pmsg->Get();
-					sys_log(0, "SAFEBOX Query : [%s]", szQuery);
-
-					if (pRes->uiAffectedRows == 0 || pRes->uiInsertID == 0 || pRes->uiAffectedRows == (uint32_t)-1)
-						break;
-
-					item.id = pmsg->Get()->uiInsertID;
-					item.window = pi->ip[0] == 0 ? SAFEBOX : MALL,
-					item.pos = iPos;
-					item.count = pItemAward->dwCount;
-					item.vnum = pItemAward->dwVnum;
-					item.alSockets[0] = pItemAward->dwSocket0;
-					item.alSockets[1] = pItemAward->dwSocket1;
-					item.alSockets[2] = dwSocket2;
-					s_items.push_back(item);
-
-					vec_dwFinishedAwardID.push_back(std::make_pair(pItemAward->dwID, item.id));
-					grid.Put(iPos, 1, it->second->bSize);
+		if (0 == pItemAward->dwSocket0)
+		{
+			for (int i = 0; i < ITEM_LIMIT_MAX_NUM; i++)
+			{
+				if (LIMIT_REAL_TIME == pItemTable->aLimits[i].bType)
+				{
+					if (0 == pItemTable->aLimits[i].lValue)
+						pItemAward->dwSocket0 = time(0) + 60 * 60 * 24 * 7;
+					else
+						pItemAward->dwSocket0 = time(0) + pItemTable->aLimits[i].lValue;
+
+					break;
 				}
+				else if (LIMIT_REAL_TIME_START_FIRST_USE == pItemTable->aLimits[i].bType || LIMIT_TIMER_BASED_ON_WEAR == pItemTable->aLimits[i].bType)
+				{
+					if (0 == pItemTable->aLimits[i].lValue)
+						pItemAward->dwSocket0 = 60 * 60 * 24 * 7;
+					else
+						pItemAward->dwSocket0 = pItemTable->aLimits[i].lValue;
 
-				for (DWORD i = 0; i < vec_dwFinishedAwardID.size(); ++i)
-					ItemAwardManager::instance().Taken(vec_dwFinishedAwardID[i].first, vec_dwFinishedAwardID[i].second);
+					break;
+				}
 			}
 		}
 
-		pi->pSafebox->wItemCount = s_items.size();
+		TPlayerItem item;
+		memset(&item, 0, sizeof(TPlayerItem));
+
+		item.window = pi->ip[0] == 0 ? SAFEBOX : MALL;
+		item.pos = iPos;
+		item.count = pItemAward->dwCount;
+		item.vnum = pItemAward->dwVnum;
+		item.alSockets[0] = pItemAward->dwSocket0;
+		item.alSockets[1] = pItemAward->dwSocket1;
+		item.alSockets[2] = dwSocket2;
+		vec_item.push_back(item);
+
+		pkInsert->vec_award.push_back(std::make_pair(pItemAward->dwID, 0));
+		vec_pkPlaced.push_back(pItemAward);
+		grid.Put(iPos, 1, pItemTable->bSize);
+	}
+
+	// 아이템 ID는 범위를 한 번만 확인하고 한꺼번에 받는다
+	size_t iCount = pkInsert->vec_award.size();
+	size_t iFirst = vec_item.size() - iCount;
+
+	if (iCount && GetItemID() + iCount - 1 > m_itemRange.dwMax)
+	{
+		sys_err("UNIQUE ID OVERFLOW!!");
+
+		size_t iFit = GetItemID() > m_itemRange.dwMax ? 0 : m_itemRange.dwMax - GetItemID() + 1;
+		vec_item.resize(iFirst + iFit);
+		pkInsert->vec_award.resize(iFit);
+		iCount = iFit;
+	}
+
+	for (size_t i = 0; i < iCount; ++i)
+	{
+		vec_item[iFirst + i].id = GainItemID();
+		pkInsert->vec_award[i].second = vec_item[iFirst + i].id;
+
+		vec_pkPlaced[i]->bTaken = true;
+	}
+}
 
-		pkPeer->EncodeHeader(pi->ip[0] == 0 ? HEADER_DG_SAFEBOX_LOAD : HEADER_DG_MALL_LOAD, dwHandle, sizeof(TSafeboxTable) + sizeof(TPlayerItem) * s_items.size());
+void CClientManager::RESULT_SAFEBOX_AWARD_INSERT(SQLMsg * msg)
+{
+	CQueryInfo * qi = (CQueryInfo *) msg->pvUserData;
+	std::unique_ptr<TSafeboxAwardInsert> pkInsert((TSafeboxAwardInsert *) qi->pvData);
+	std::unique_ptr<ClientHandleInfo> pi(pkInsert->pkInfo);
 
-		pkPeer->Encode(pi->pSafebox, sizeof(TSafeboxTable));
+	SQLResult * pRes = msg->Get();
 
-		if (!s_items.empty())
-			pkPeer->Encode(&s_items[0], sizeof(TPlayerItem) * s_items.size());
+	// 피어가 끊겼어도 taken 기록은 해야 다음에 또 주지 않는다
+	if (pRes->uiAffectedRows == (uint32_t)-1 || pRes->uiAffectedRows != pkInsert->vec_award.size())
+	{
+		sys_err("SAFEBOX: item_award insert for %s stored %d of %u items",
+				pi->login, (int) pRes->uiAffectedRows, pkInsert->vec_award.size());
 
-		delete pi;
+		ItemAwardManager::instance().Release(pkInsert->vec_award);
+		pkInsert->vec_item.resize(pkInsert->vec_item.size() - pkInsert->vec_award.size());
 	}
+	else
+		ItemAwardManager::instance().Taken(pkInsert->vec_award);
+
+	CPeer * pkPeer = GetPeer(qi->dwIdent);
+
+	if (pkPeer)
+		SendSafeboxLoad(pkPeer, pi.get(), pkInsert->vec_item);
+}
+
+void CClientManager::SendSafeboxLoad(CPeer * pkPeer, ClientHandleInfo * pi, std::vector<TPlayerItem> & vec_item)
+{
+	pi->pSafebox->wItemCount = vec_item.size();
+
+	pkPeer->EncodeHeader(pi->ip[0] == 0 ? HEADER_DG_SAFEBOX_LOAD : HEADER_DG_MALL_LOAD, pi->dwHandle, sizeof(TSafeboxTable) + sizeof(TPlayerItem) * vec_item.size());
+
+	pkPeer->Encode(pi->pSafebox, sizeof(TSafeboxTable));
+
+	if (!vec_item.empty())
+		pkPeer->Encode(&vec_item[0], sizeof(TPlayerItem) * vec_item.size());
 }
 
 void CClientManager::QUERY_SAFEBOX_CHANGE_SIZE(CPeer * pkPeer, DWORD dwHandle, TSafeboxChangeSizePacket * p)
@@ -1246,291 +1326,241 @@ void CClientManager::QUERY_ITEM_FLUSH(CPeer * pkPeer, const char * c_pData)
 	if (g_log)
 		sys_log(0, "HEADER_GD_ITEM_FLUSH: %u", dwID);
 
-	CItemCache * c = GetItemCache(dwID);
+	CPlayerShard * pkShard = FindItemShard(dwID);
 
-	if (c)
-		c->Flush();
+	if (!pkShard)
+		return;
+
+	IndexItem(dwID, pkShard, pkShard->Post([pkShard, dwID]()
+	{
+		CItemCache * c = pkShard->GetItemCache(dwID);
+
+		if (c)
+			c->Flush();
+	}));
+}
+
+static void SaveItemToDB(const TPlayerItem * p, DWORD dwPeerHandle)
+{
+	char szQuery[512];
+
+	snprintf(szQuery, sizeof(szQuery), 
+		"REPLACE INTO item%s (id, owner_id, window, pos, count, vnum, socket0, socket1, socket2, "
+		"attrtype0, attrvalue0, "
+		"attrtype1, attrvalue1, "
+		"attrtype2, attrvalue2, "
+		"attrtype3, attrvalue3, "
+		"attrtype4, attrvalue4, "
+		"attrtype5, attrvalue5, "
+		"attrtype6, attrvalue6) "
+		"VALUES(%u, %u, %d, %d, %u, %u, %ld, %ld, %ld, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d)",
+		GetTablePostfix(),
+		p->id,
+		p->owner,
+		p->window,
+		p->pos,
+		p->count,
+		p->vnum,
+		static_cast<long>(p->alSockets[0]),
+		static_cast<long>(p->alSockets[1]),
+		static_cast<long>(p->alSockets[2]),
+		p->aAttr[0].bType, p->aAttr[0].sValue,
+		p->aAttr[1].bType, p->aAttr[1].sValue,
+		p->aAttr[2].bType, p->aAttr[2].sValue,
+		p->aAttr[3].bType, p->aAttr[3].sValue,
+		p->aAttr[4].bType, p->aAttr[4].sValue,
+		p->aAttr[5].bType, p->aAttr[5].sValue,
+		p->aAttr[6].bType, p->aAttr[6].sValue);
+
+	CDBManager::instance().ReturnQuery(szQuery, QID_ITEM_SAVE, dwPeerHandle, NULL);
 }
 
 void CClientManager::QUERY_ITEM_SAVE(CPeer * pkPeer, const char * c_pData)
 {
-	TPlayerItem * p = (TPlayerItem *) c_pData;
+	TPlayerItem item = *(TPlayerItem *) c_pData;
+	DWORD dwPeerHandle = pkPeer->GetHandle();
 
 	// 창고면 캐쉬하지 않고, 캐쉬에 있던 것도 빼버려야 한다.
 
-	if (p->window == SAFEBOX || p->window == MALL)
+	if (item.window == SAFEBOX || item.window == MALL)
 	{
-		CItemCache * c = GetItemCache(p->id);
+		CPlayerShard * pkShard = FindItemShard(item.id);
 
-		if (c)
+		if (!pkShard)
 		{
-			TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(c->Get()->owner);
-
-			if (it != m_map_pkItemCacheSetPtr.end())
-			{
-				if (g_test_server)
-					sys_log(0, "ITEM_CACHE: safebox owner %u id %u", c->Get()->owner, c->Get()->id);
-
-				it->second->erase(c);
-			}
-
-			m_map_itemCache.erase(p->id);
-
-			delete c;
+			SaveItemToDB(&item, dwPeerHandle);
+			return;
 		}
-		char szQuery[512];
 
-		snprintf(szQuery, sizeof(szQuery), 
-			"REPLACE INTO item%s (id, owner_id, window, pos, count, vnum, socket0, socket1, socket2, "
-			"attrtype0, attrvalue0, "
-			"attrtype1, attrvalue1, "
-			"attrtype2, attrvalue2, "
-			"attrtype3, attrvalue3, "
-			"attrtype4, attrvalue4, "
-			"attrtype5, attrvalue5, "
-			"attrtype6, attrvalue6) "
-			"VALUES(%u, %u, %d, %d, %u, %u, %ld, %ld, %ld, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d)",
-			GetTablePostfix(),
-			p->id,
-			p->owner,
-			p->window,
-			p->pos,
-			p->count,
-			p->vnum,
-			static_cast<long>(p->alSockets[0]),
-			static_cast<long>(p->alSockets[1]),
-			static_cast<long>(p->alSockets[2]),
-			p->aAttr[0].bType, p->aAttr[0].sValue,
-			p->aAttr[1].bType, p->aAttr[1].sValue,
-			p->aAttr[2].bType, p->aAttr[2].sValue,
-			p->aAttr[3].bType, p->aAttr[3].sValue,
-			p->aAttr[4].bType, p->aAttr[4].sValue,
-			p->aAttr[5].bType, p->aAttr[5].sValue,
-			p->aAttr[6].bType, p->aAttr[6].sValue);
-
-		CDBManager::instance().ReturnQuery(szQuery, QID_ITEM_SAVE, pkPeer->GetHandle(), NULL);
+		// 캐쉬를 가진 샤드에서 빼고 저장해야 나중의 플러쉬가 덮어쓰지 않는다.
+		IndexItem(item.id, pkShard, pkShard->Post([pkShard, item, dwPeerHandle]()
+		{
+			if (g_test_server && pkShard->GetItemCache(item.id))
+				sys_log(0, "ITEM_CACHE: safebox owner %u id %u", item.owner, item.id);
+
+			pkShard->EraseItemCache(item.id);
+			SaveItemToDB(&item, dwPeerHandle);
+		}));
 	}
 	else
 	{
 		if (g_test_server)
-			sys_log(0, "QUERY_ITEM_SAVE => PutItemCache() owner %d id %d vnum %d ", p->owner, p->id, p->vnum);
+			sys_log(0, "QUERY_ITEM_SAVE => PutItemCache() owner %d id %d vnum %d ", item.owner, item.id, item.vnum);
 
-		PutItemCache(p);
+		CPlayerShard * pkShard = GetShard(item.owner);
+
+		MoveItemToShard(item.id, pkShard);
+		IndexItem(item.id, pkShard, pkShard->Post([pkShard, item]() mutable
+		{
+			pkShard->PutItemCache(&item);
+		}));
 	}
 }
 
-CClientManager::TItemCacheSet * CClientManager::GetItemCacheSet(DWORD pid)
+// MYSHOP_PRICE_LIST
+CItemPriceListTableCache* CClientManager::GetItemPriceListCache(DWORD dwID)
 {
-	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(pid);
+	TItemPriceListCacheMap::iterator it = m_mapItemPriceListCache.find(dwID);
 
-	if (it == m_map_pkItemCacheSetPtr.end())
+	if (it == m_mapItemPriceListCache.end())
 		return NULL;
 
 	return it->second;
 }
 
-void CClientManager::CreateItemCacheSet(DWORD pid)
-{
-	if (m_map_pkItemCacheSetPtr.find(pid) != m_map_pkItemCacheSetPtr.end())
-		return;
-
-	TItemCacheSet * pSet = new TItemCacheSet;
-	m_map_pkItemCacheSetPtr.insert(TItemCacheSetPtrMap::value_type(pid, pSet));
-
-	if (g_log)
-		sys_log(0, "ITEM_CACHE: new cache %u", pid);
-}
-
-void CClientManager::FlushItemCacheSet(DWORD pid)
+void CClientManager::PutItemPriceListCache(const TItemPriceListTable* pItemPriceList)
 {
-	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(pid);
-
-	if (it == m_map_pkItemCacheSetPtr.end())
-	{
-		sys_log(0, "FLUSH_ITEMCACHESET : No ItemCacheSet pid(%d)", pid);
-		return;
-	}
-
-	TItemCacheSet * pSet = it->second;
-	TItemCacheSet::iterator it_set = pSet->begin();
+	CItemPriceListTableCache* pCache = GetItemPriceListCache(pItemPriceList->dwOwnerID);
 
-	while (it_set != pSet->end())
+	if (!pCache)
 	{
-		CItemCache * c = *it_set++;
-		c->Flush();
-
-		m_map_itemCache.erase(c->Get()->id);
-		delete c;
+		pCache = new CItemPriceListTableCache;
+		m_mapItemPriceListCache.insert(TItemPriceListCacheMap::value_type(pItemPriceList->dwOwnerID, pCache));
 	}
 
-	pSet->clear();
-	delete pSet;
+	pCache->Put(const_cast<TItemPriceListTable*>(pItemPriceList), true);
+}
 
-	m_map_pkItemCacheSetPtr.erase(it);
+// END_OF_MYSHOP_PRICE_LIST
 
-	if (g_log)
-		sys_log(0, "FLUSH_ITEMCACHESET : Deleted pid(%d)", pid);
+void CClientManager::SetCacheFlushCountLimit(int iLimit)
+{
+	m_iCacheFlushCountLimit = MAX(10, iLimit);
+	sys_log(0, "CACHE_FLUSH_LIMIT_PER_SECOND: %d", m_iCacheFlushCountLimit);
 }
 
-CItemCache * CClientManager::GetItemCache(DWORD id)
+void CClientManager::InitializeShards(int iCount)
 {
-	TItemCacheMap::iterator it = m_map_itemCache.find(id);
+	// 0이면 스레드 없이 메인 스레드에서 바로 처리한다 (예전과 같다)
+	m_bShardThread = iCount > 0;
 
-	if (it == m_map_itemCache.end())
-		return NULL;
+	if (!m_bShardThread)
+		iCount = 1;
 
-	return it->second;
+	for (int i = 0; i < iCount; ++i)
+		m_vec_pkShard.push_back(new CPlayerShard(i, m_bShardThread));
+
+	sys_log(0, "PLAYER_SHARD: %d shard(s), %s", iCount, m_bShardThread ? "threaded" : "inline");
 }
 
-void CClientManager::PutItemCache(TPlayerItem * pNew, bool bSkipQuery)
-{       
-	CItemCache * c;     
+void CClientManager::DestroyShards()
+{
+	for (size_t i = 0; i < m_vec_pkShard.size(); ++i)
+		m_vec_pkShard[i]->Quit();
 
-	c = GetItemCache(pNew->id);
-	
-	// 아이템 새로 생성
-	if (!c)
-	{
-		if (g_log)
-			sys_log(0, "ITEM_CACHE: PutItemCache ==> New CItemCache id%d vnum%d new owner%d", pNew->id, pNew->vnum, pNew->owner);
+	// 샤드가 마지막으로 넘긴 일 (쿼리, 패킷)
+	ProcessMainTasks();
 
-		c = new CItemCache;
-		m_map_itemCache.insert(TItemCacheMap::value_type(pNew->id, c));
-	}
-	// 있을시
-	else
-	{
-		if (g_log)
-			sys_log(0, "ITEM_CACHE: PutItemCache ==> Have Cache");
-		// 소유자가 틀리면
-		if (pNew->owner != c->Get()->owner)
-		{
-			// 이미 이 아이템을 가지고 있었던 유저로 부터 아이템을 삭제한다.
-			TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(c->Get()->owner);
+	// 스레드가 모두 끝났으므로 여기부터는 메인 스레드에서 처리한다
+	m_bShardThread = false;
 
-			if (it != m_map_pkItemCacheSetPtr.end())
-			{
-				if (g_log)
-				sys_log(0, "ITEM_CACHE: delete owner %u id %u new owner %u", c->Get()->owner, c->Get()->id, pNew->owner);
-				it->second->erase(c);
-			}
-		}
+	for (size_t i = 0; i < m_vec_pkShard.size(); ++i)
+	{
+		m_vec_pkShard[i]->FlushAll();
+		delete m_vec_pkShard[i];
 	}
 
-	// 새로운 정보 업데이트 
-	c->Put(pNew, bSkipQuery);
-	
-	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(c->Get()->owner);
+	m_vec_pkShard.clear();
+	m_map_itemShard.clear();
+}
 
-	if (it != m_map_pkItemCacheSetPtr.end())
+void CClientManager::PostToMain(CPlayerShard::TTask task)
+{
+	if (!m_bShardThread)
 	{
-		if (g_log)
-			sys_log(0, "ITEM_CACHE: save %u id %u", c->Get()->owner, c->Get()->id);
-		else
-			sys_log(1, "ITEM_CACHE: save %u id %u", c->Get()->owner, c->Get()->id);
-		it->second->insert(c);
+		task();
+		return;
 	}
-	else
-	{
-		// 현재 소유자가 없으므로 바로 저장해야 다음 접속이 올 때 SQL에 쿼리하여
-		// 받을 수 있으므로 바로 저장한다.
-		if (g_log)
-			sys_log(0, "ITEM_CACHE: direct save %u id %u", c->Get()->owner, c->Get()->id);
-		else
-			sys_log(1, "ITEM_CACHE: direct save %u id %u", c->Get()->owner, c->Get()->id);
 
-		c->OnFlush();
-	}
+	std::lock_guard<std::mutex> lock(m_lockMainTask);
+	m_vec_mainTask.push_back(std::move(task));
 }
 
-bool CClientManager::DeleteItemCache(DWORD dwID)
+void CClientManager::ProcessMainTasks()
 {
-	CItemCache * c = GetItemCache(dwID);
+	std::vector<CPlayerShard::TTask> vec_task;
 
-	if (!c)
-		return false;
+	{
+		std::lock_guard<std::mutex> lock(m_lockMainTask);
 
-	c->Delete();
-	return true;
+		if (m_vec_mainTask.empty())
+			return;
+
+		vec_task.swap(m_vec_mainTask);
+	}
+
+	M2_TRACE_SCOPE_ARG("shard_completion", vec_task.size());
+
+	for (size_t i = 0; i < vec_task.size(); ++i)
+		vec_task[i]();
 }
 
-// MYSHOP_PRICE_LIST
-CItemPriceListTableCache* CClientManager::GetItemPriceListCache(DWORD dwID)
+CPlayerShard * CClientManager::FindItemShard(DWORD dwID)
 {
-	TItemPriceListCacheMap::iterator it = m_mapItemPriceListCache.find(dwID);
+	if (m_vec_pkShard.size() == 1)
+		return m_vec_pkShard[0];
 
-	if (it == m_mapItemPriceListCache.end())
+	TItemShardMap::iterator it = m_map_itemShard.find(dwID);
+
+	if (it == m_map_itemShard.end())
 		return NULL;
 
-	return it->second;
+	return it->second.pkShard;
 }
 
-void CClientManager::PutItemPriceListCache(const TItemPriceListTable* pItemPriceList)
+void CClientManager::IndexItem(DWORD dwID, CPlayerShard * pkShard, uint64_t qwTicket)
 {
-	CItemPriceListTableCache* pCache = GetItemPriceListCache(pItemPriceList->dwOwnerID);
-
-	if (!pCache)
-	{
-		pCache = new CItemPriceListTableCache;
-		m_mapItemPriceListCache.insert(TItemPriceListCacheMap::value_type(pItemPriceList->dwOwnerID, pCache));
-	}
+	if (m_vec_pkShard.size() == 1)
+		return;
 
-	pCache->Put(const_cast<TItemPriceListTable*>(pItemPriceList), true);
+	TItemShard & r = m_map_itemShard[dwID];
+	r.pkShard = pkShard;
+	r.qwTicket = qwTicket;
 }
 
-void CClientManager::UpdatePlayerCache()
+void CClientManager::UnindexItems(CPlayerShard * pkShard, uint64_t qwTicket, const std::vector<DWORD> & vec_dwID)
 {
-	TPlayerTableCacheMap::iterator it = m_map_playerCache.begin();
-
-	while (it != m_map_playerCache.end())
+	for (size_t i = 0; i < vec_dwID.size(); ++i)
 	{
-		CPlayerTableCache * c = (it++)->second;
-
-		if (c->CheckTimeout())
-		{
-			if (g_log)
-				sys_log(0, "UPDATE : UpdatePlayerCache() ==> FlushPlayerCache %d %s ", c->Get(false)->id, c->Get(false)->name);
-
-			c->Flush();
+		TItemShardMap::iterator it = m_map_itemShard.find(vec_dwID[i]);
 
-			// Item Cache도 업데이트
-			UpdateItemCacheSet(c->Get()->id);
-		}
-		else if (c->CheckFlushTimeout())
-			c->Flush();
+		// 그 뒤에 이 샤드나 다른 샤드로 다시 보낸 아이템은 그대로 둔다
+		if (it != m_map_itemShard.end() && it->second.pkShard == pkShard && it->second.qwTicket <= qwTicket)
+			m_map_itemShard.erase(it);
 	}
 }
-// END_OF_MYSHOP_PRICE_LIST
 
-void CClientManager::SetCacheFlushCountLimit(int iLimit)
+void CClientManager::MoveItemToShard(DWORD dwID, CPlayerShard * pkShard)
 {
-	m_iCacheFlushCountLimit = MAX(10, iLimit);
-	sys_log(0, "CACHE_FLUSH_LIMIT_PER_SECOND: %d", m_iCacheFlushCountLimit);
-}
+	CPlayerShard * pkOld = FindItemShard(dwID);
 
-void CClientManager::UpdateItemCache()
-{
-	if (m_iCacheFlushCount >= m_iCacheFlushCountLimit)
+	if (!pkOld || pkOld == pkShard)
 		return;
 
-	TItemCacheMap::iterator it = m_map_itemCache.begin();
-
-	while (it != m_map_itemCache.end())
-	{
-		CItemCache * c = (it++)->second;
-
-		// 아이템은 Flush만 한다.
-		if (c->CheckFlushTimeout())
-		{
-			if (g_test_server)
-				sys_log(0, "UpdateItemCache ==> Flush() vnum %d id owner %d", c->Get()->vnum, c->Get()->id, c->Get()->owner);
-
-			c->Flush();
-
-			if (++m_iCacheFlushCount >= m_iCacheFlushCountLimit)
-				break;
-		}
-	}
+	// 교환 등으로 다른 샤드의 플레이어에게 넘어간 아이템. 예전 샤드가 캐쉬를
+	// 버린 뒤에 새 샤드가 캐쉬해야 예전 샤드의 플러쉬가 나중에 덮어쓰지 않는다.
+	pkOld->Post([pkOld, dwID]() { pkOld->EraseItemCache(dwID); });
+	pkOld->Wait();
 }
 
 void CClientManager::UpdateItemPriceListCache()
@@ -1551,44 +1581,58 @@ void CClientManager::UpdateItemPriceListCache()
 	}
 }
 
+static void DeleteItemFromDB(DWORD dwID, DWORD dwPID, DWORD dwPeerHandle)
+{
+	char szQuery[64];
+	snprintf(szQuery, sizeof(szQuery), "DELETE FROM item%s WHERE id=%u", GetTablePostfix(), dwID);
+
+	if (g_log)
+		sys_log(0, "HEADER_GD_ITEM_DESTROY: PID %u ID %u", dwPID, dwID);
+
+	if (dwPID == 0) // 아무도 가진 사람이 없었다면, 비동기 쿼리
+		CDBManager::instance().AsyncQuery(szQuery);
+	else
+		CDBManager::instance().ReturnQuery(szQuery, QID_ITEM_DESTROY, dwPeerHandle, NULL);
+}
+
 void CClientManager::QUERY_ITEM_DESTROY(CPeer * pkPeer, const char * c_pData)
 {
 	DWORD dwID = *(DWORD *) c_pData;
 	c_pData += sizeof(DWORD);
 
 	DWORD dwPID = *(DWORD *) c_pData;
+	DWORD dwPeerHandle = pkPeer->GetHandle();
 
-	if (!DeleteItemCache(dwID))
-	{
-		char szQuery[64];
-		snprintf(szQuery, sizeof(szQuery), "DELETE FROM item%s WHERE id=%u", GetTablePostfix(), dwID);
+	CPlayerShard * pkShard = FindItemShard(dwID);
 
-		if (g_log)
-			sys_log(0, "HEADER_GD_ITEM_DESTROY: PID %u ID %u", dwPID, dwID);
-
-		if (dwPID == 0) // 아무도 가진 사람이 없었다면, 비동기 쿼리
-			CDBManager::instance().AsyncQuery(szQuery);
-		else
-			CDBManager::instance().ReturnQuery(szQuery, QID_ITEM_DESTROY, pkPeer->GetHandle(), NULL);
+	if (!pkShard)
+	{
+		DeleteItemFromDB(dwID, dwPID, dwPeerHandle);
+		return;
 	}
+
+	IndexItem(dwID, pkShard, pkShard->Post([pkShard, dwID, dwPID, dwPeerHandle]()
+	{
+		if (!pkShard->DeleteItemCache(dwID))
+			DeleteItemFromDB(dwID, dwPID, dwPeerHandle);
+	}));
 }
 
 void CClientManager::QUERY_FLUSH_CACHE(CPeer * pkPeer, const char * c_pData)
 {
 	DWORD dwPID = *(DWORD *) c_pData;
+	CPlayerShard * pkShard = GetShard(dwPID);
 
-	CPlayerTableCache * pkCache = GetPlayerCache(dwPID);
-
-	if (!pkCache)
-		return;
-
-	sys_log(0, "FLUSH_CACHE: %u", dwPID);
+	pkShard->Post([pkShard, dwPID]()
+	{
+		if (!pkShard->GetPlayerCache(dwPID))
+			return;
 
-	pkCache->Flush();
-	FlushItemCacheSet(dwPID);
+		sys_log(0, "FLUSH_CACHE: %u", dwPID);
 
-	m_map_playerCache.erase(dwPID);
-	delete pkCache;
+		pkShard->FlushPlayerCacheSet(dwPID);
+		pkShard->FlushItemCacheSet(dwPID);
+	});
 }
 
 void CClientManager::QUERY_SMS(CPeer * pkPeer, TPacketGDSMS * pack)
@@ -2101,6 +2145,8 @@ void CClientManager::ProcessPackets(CPeer * peer)
 		m_bLastHeader = header;
 		++iCount;
 
+		M2_TRACE_SCOPE_ARG("gd_packet", header);
+
 #ifdef _TEST	
 		if (header != 10)
 			sys_log(0, " ProcessPacket Header [%d] Handle[%d] Length[%d] iCount[%d]", header, dwHandle, dwLength, iCount);
@@ -2488,6 +2534,11 @@ void CClientManager::ProcessPackets(CPeer * peer)
 				RequestChannelStatus(peer, dwHandle);
 				break;
 
+			case HEADER_GD_RELOAD_ITEM_AWARD:
+				sys_log(0, "HEADER_GD_RELOAD_ITEM_AWARD");
+				ItemAwardManager::instance().RequestLoad();
+				break;
+
 			default:					
 				sys_err("Unknown header (header: %d handle: %d length: %d)", header, dwHandle, dwLength);
 				break;
@@ -2585,6 +2636,11 @@ int CClientManager::AnalyzeQueryResult(SQLMsg * msg)
 			delete qi;
 			return true;
 
+		case QID_SAFEBOX_AWARD_INSERT:
+			RESULT_SAFEBOX_AWARD_INSERT(msg);
+			delete qi;
+			return true;
+
 		case QID_GUILD_RANKING:
 			CGuildManager::instance().ResultRanking(msg->Get()->pSQLResult);
 			break;
@@ -2714,6 +2770,11 @@ int CClientManager::Process()
 	if (!(pulses = thecore_idle()))
 		return 0;
 
+#ifdef ENABLE_SCOPED_TRACE
+	uint64_t qwPulseStartNs = trace_clock_ns();
+	int iPulses = pulses;
+#endif
+
 	while (pulses--)
 	{
 		++thecore_heart->pulse;
@@ -2772,15 +2833,15 @@ int CClientManager::Process()
 			if (!(thecore_heart->pulse % (thecore_heart->passes_per_sec * 3600)))
 				UsageLog();
 
-			m_iCacheFlushCount = 0;
+			//플레이어, 아이템 플러쉬와 로그아웃 캐쉬셋 플러쉬는 샤드마다 한다.
+			//초당 아이템 플러쉬 제한은 샤드끼리 나눈다.
+			int iItemFlushLimit = (m_iCacheFlushCountLimit + m_vec_pkShard.size() - 1) / m_vec_pkShard.size();
 
-
-			//플레이어 플러쉬
-			UpdatePlayerCache();
-			//아이템 플러쉬
-			UpdateItemCache();
-			//로그아웃시 처리- 캐쉬셋 플러쉬
-			UpdateLogoutPlayer();
+			for (size_t i = 0; i < m_vec_pkShard.size(); ++i)
+			{
+				CPlayerShard * pkShard = m_vec_pkShard[i];
+				pkShard->Post([pkShard, iItemFlushLimit]() { pkShard->Update(iItemFlushLimit); });
+			}
 
 			// MYSHOP_PRICE_LIST
 			UpdateItemPriceListCache();
@@ -2791,11 +2852,16 @@ int CClientManager::Process()
 			marriage::CManager::instance().Update();
 		}
 
-		if (!(thecore_heart->pulse % (thecore_heart->passes_per_sec * 5)))
+		// 0이면 어드민 RELOAD_AWARD 로만 읽는다
+		int iAwardRefreshSeconds = ItemAwardManager::instance().GetRefreshSeconds();
+
+		if (iAwardRefreshSeconds && !(thecore_heart->pulse % (thecore_heart->passes_per_sec * iAwardRefreshSeconds)))
 		{
 			ItemAwardManager::instance().RequestLoad();
 		}
 
+		ItemAwardManager::instance().Update();
+
 		if (!(thecore_heart->pulse % (thecore_heart->passes_per_sec * 10)))
 		{
 			/*
@@ -2924,6 +2990,8 @@ int CClientManager::Process()
 		}
 	}
 
+	M2_TRACE_PULSE("db_process", qwPulseStartNs, trace_clock_ns(), iPulses);
+
 #ifdef OS_WINDOWS
 	if (_kbhit()) {
 		int c = _getch();
@@ -3561,30 +3629,6 @@ void CClientManager::BreakMarriage(CPeer * peer, const char * data)
 }
 //END_BREAK_MARIIAGE
 
-void CClientManager::UpdateItemCacheSet(DWORD pid)
-{
-	itertype(m_map_pkItemCacheSetPtr) it = m_map_pkItemCacheSetPtr.find(pid);
-
-	if (it == m_map_pkItemCacheSetPtr.end())
-	{
-		if (g_test_server)
-			sys_log(0, "UPDATE_ITEMCACHESET : UpdateItemCacheSet ==> No ItemCacheSet pid(%d)", pid);
-		return;
-	}
-
-	TItemCacheSet * pSet = it->second;
-	TItemCacheSet::iterator it_set = pSet->begin();
-
-	while (it_set != pSet->end())
-	{
-		CItemCache * c = *it_set++;
-		c->Flush();
-	}
-
-	if (g_log)
-		sys_log(0, "UPDATE_ITEMCACHESET : UpdateItemCachsSet pid(%d)", pid);
-}
-
 void CClientManager::Election(CPeer * peer, DWORD dwHandle, const char* data)
 {
 	DWORD idx;
@@ -3969,20 +4013,10 @@ void CClientManager::DeleteLoginKey(TPacketDC *data)
 void CClientManager::DeleteAwardId(TPacketDeleteAwardID *data)
 {
 	//sys_log(0,"data from game server arrived %d",data->dwID);
-	std::map<DWORD, TItemAward *>::iterator it;
-	it = ItemAwardManager::Instance().GetMapAward().find(data->dwID);
-	if ( it != ItemAwardManager::Instance().GetMapAward().end() )
-	{
-		std::set<TItemAward *> & kSet = ItemAwardManager::Instance().GetMapkSetAwardByLogin()[it->second->szLogin];
-		if(kSet.erase(it->second))
-			sys_log(0,"erase ItemAward id: %d from cache", data->dwID);
-		ItemAwardManager::Instance().GetMapAward().erase(data->dwID);
-	}
+	if (ItemAwardManager::instance().Erase(data->dwID))
+		sys_log(0,"erase ItemAward id: %d from cache", data->dwID);
 	else
-	{
 		sys_log(0,"DELETE_AWARDID : could not find the id: %d", data->dwID);
-	}
-
 }
 
 void CClientManager::UpdateChannelStatus(TChannelStatus* pData)
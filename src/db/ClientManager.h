@@ -11,6 +11,8 @@
 #include "Peer.h"
 #include "DBManager.h"
 #include "LoginData.h"
+#include "PlayerShard.h"
+#include "ItemAwardManager.h"
 
 class CPlayerTableCache;
 class CItemCache;
@@ -31,10 +33,6 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 {
     public:
 	typedef std::list<CPeer *>			TPeerList;
-	typedef std::unordered_map<DWORD, CPlayerTableCache *> TPlayerTableCacheMap;
-	typedef std::unordered_map<DWORD, CItemCache *> TItemCacheMap;
-	typedef std::unordered_set<CItemCache *, std::hash<CItemCache*> > TItemCacheSet;
-	typedef std::unordered_map<DWORD, TItemCacheSet *> TItemCacheSetPtrMap;
 	typedef std::unordered_map<DWORD, CItemPriceListTableCache*> TItemPriceListCacheMap;
 	typedef std::unordered_map<short, BYTE> TChannelStatusMap;
 
@@ -88,6 +86,14 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 		}
 	};
 
+	// 창고/몰에 넣을 item_award 아이템들을 한 번에 INSERT 하는 동안 들고 있는 것
+	struct TSafeboxAwardInsert
+	{
+	    ClientHandleInfo *				pkInfo;
+	    std::vector<TPlayerItem>			vec_item;	// 창고 아이템 + 뒤에 넣을 아이템
+	    std::vector<std::pair<DWORD, DWORD> >	vec_award;	// award id, item id
+	};
+
 	public:
 	CClientManager();
 	~CClientManager();
@@ -112,19 +118,13 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	void	SendAllGuildSkillRechargePacket();
 	void	SendTime();
 
-	CPlayerTableCache *	GetPlayerCache(DWORD id);
-	void			PutPlayerCache(TPlayerTable * pNew);
-
-	void			CreateItemCacheSet(DWORD dwID);
-	TItemCacheSet *		GetItemCacheSet(DWORD dwID);
-	void			FlushItemCacheSet(DWORD dwID);
-
-	CItemCache *		GetItemCache(DWORD id);
-	void			PutItemCache(TPlayerItem * pNew, bool bSkipQuery = false);
-	bool			DeleteItemCache(DWORD id);
+	// Player and item caches live in the shard of their pid (PlayerShard.h).
+	CPlayerShard *		GetShard(DWORD pid)	{ return m_vec_pkShard[pid % m_vec_pkShard.size()]; }
 
-	void			UpdatePlayerCache();
-	void			UpdateItemCache();
+	// Runs the task on the main thread: at once without shard threads,
+	// otherwise at the top of the next main loop iteration.
+	void			PostToMain(CPlayerShard::TTask task);
+	void			UnindexItems(CPlayerShard * pkShard, uint64_t qwTicket, const std::vector<DWORD> & vec_dwID);
 
 	// MYSHOP_PRICE_LIST
 	/// 가격정보 리스트 캐시를 가져온다.
@@ -183,6 +183,11 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	bool		InitializeObjectTable();
 	bool		InitializeMonarch();
 
+	// Binary snapshot of the parsed mob/item proto (see common/proto_snapshot.h).
+	uint32_t	GetProtoSourceStamp();
+	bool		LoadProtoSnapshot();
+	void		SaveProtoSnapshot();
+
 	// mob_proto.txt, item_proto.txt에서 읽은 mob_proto, item_proto를 real db에 반영.
 	//	item_proto, mob_proto를 db에 반영하지 않아도, 게임 돌아가는데는 문제가 없지만,
 	//	운영툴 등에서 db의 item_proto, mob_proto를 읽어 쓰기 때문에 문제가 발생한다.
@@ -200,6 +205,17 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 
         void            ProcessPackets(CPeer * peer);
 
+	void		InitializeShards(int iCount);
+	void		DestroyShards();
+	void		ProcessMainTasks();
+
+	// Which shard may hold an item's cache. Kept by the main thread only; an
+	// entry is dropped once its shard frees the cache and no later task for it
+	// was posted there (see UnindexItems).
+	CPlayerShard *	FindItemShard(DWORD dwID);
+	void		IndexItem(DWORD dwID, CPlayerShard * pkShard, uint64_t qwTicket);
+	void		MoveItemToShard(DWORD dwID, CPlayerShard * pkShard);
+
 	CLoginData *	GetLoginData(DWORD dwKey);
 	CLoginData *	GetLoginDataByLogin(const char * c_pszLogin);
 	CLoginData *	GetLoginDataByAID(DWORD dwAID);
@@ -239,11 +255,13 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	void		RESULT_LOGIN(CPeer * peer, SQLMsg *msg);
 
 	void		QUERY_PLAYER_LOAD(CPeer * peer, DWORD dwHandle, TPlayerLoadPacket*);
+	void		QUERY_PLAYER_LOAD_FROM_DB(CPeer * peer, DWORD dwHandle, TPlayerLoadPacket * packet);
+	void		RESULT_PLAYER_LOAD_FROM_CACHE(CPeer * peer, DWORD dwHandle, DWORD dwAID, TPlayerTable * pTab, std::vector<TPlayerItem> * pVecItem);
 	void		RESULT_COMPOSITE_PLAYER(CPeer * peer, SQLMsg * pMsg, DWORD dwQID);
-	void		RESULT_PLAYER_LOAD(CPeer * peer, MYSQL_RES * pRes, ClientHandleInfo * pkInfo);
-	void		RESULT_ITEM_LOAD(CPeer * peer, MYSQL_RES * pRes, DWORD dwHandle, DWORD dwPID);
-	void		RESULT_QUEST_LOAD(CPeer * pkPeer, MYSQL_RES * pRes, DWORD dwHandle, DWORD dwPID);
-	void		RESULT_AFFECT_LOAD(CPeer * pkPeer, MYSQL_RES * pRes, DWORD dwHandle);
+	void		RESULT_PLAYER_LOAD(CPeer * peer, TPlayerTable * pTab, bool bFound, ClientHandleInfo * pkInfo);
+	void		RESULT_ITEM_LOAD(CPeer * peer, std::vector<TPlayerItem> & vecItem, DWORD dwHandle, DWORD dwPID);
+	void		RESULT_QUEST_LOAD(CPeer * pkPeer, std::vector<TQuestTable> & vecQuest, DWORD dwHandle, DWORD dwPID);
+	void		RESULT_AFFECT_LOAD(CPeer * pkPeer, std::vector<TPacketAffectElement> & vecAffect, DWORD dwHandle, DWORD dwPID);
 
 	// PLAYER_INDEX_CREATE_BUG_FIX
 	void		RESULT_PLAYER_INDEX_CREATE(CPeer *pkPeer, SQLMsg *msg);
@@ -291,6 +309,9 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	void		QUERY_SAFEBOX_CHANGE_PASSWORD(CPeer * pkPeer, DWORD dwHandle, TSafeboxChangePasswordPacket * p);
 
 	void		RESULT_SAFEBOX_LOAD(CPeer * pkPeer, SQLMsg * msg);
+	void		PlaceItemAwards(ClientHandleInfo * pi, ItemAwardManager::TAwardQueue * pQueue, TSafeboxAwardInsert * pkInsert);
+	void		RESULT_SAFEBOX_AWARD_INSERT(SQLMsg * msg);
+	void		SendSafeboxLoad(CPeer * pkPeer, ClientHandleInfo * pi, std::vector<TPlayerItem> & vec_item);
 	void		RESULT_SAFEBOX_CHANGE_SIZE(CPeer * pkPeer, SQLMsg * msg);
 	void		RESULT_SAFEBOX_CHANGE_PASSWORD(CPeer * pkPeer, SQLMsg * msg);
 	void		RESULT_SAFEBOX_CHANGE_PASSWORD_SECOND(CPeer * pkPeer, SQLMsg * msg);
@@ -406,6 +427,9 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	std::vector<TItemTable>			m_vec_itemTable;
 	std::map<DWORD, TItemTable *>		m_map_itemTableByVnum;
 
+	std::string				m_stProtoSnapshotFileName;
+	uint32_t				m_dwProtoSnapshotChecksum;
+
 	int					m_iShopTableSize;
 	TShopTable *				m_pShopTable;
 
@@ -423,10 +447,20 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 
 	bool					m_bShutdowned;
 
-	TPlayerTableCacheMap			m_map_playerCache;  // 플레이어 id가 key
+	std::vector<CPlayerShard *>		m_vec_pkShard;
+	bool					m_bShardThread;
 
-	TItemCacheMap				m_map_itemCache;  // 아이템 id가 key
-	TItemCacheSetPtrMap			m_map_pkItemCacheSetPtr;  // 플레이어 id가 key, 이 플레이어가 어떤 아이템 캐쉬를 가지고 있나?
+	std::mutex				m_lockMainTask;
+	std::vector<CPlayerShard::TTask>	m_vec_mainTask;
+
+	typedef struct SItemShard
+	{
+	    CPlayerShard *	pkShard;
+	    uint64_t		qwTicket;	// last task posted there that touched the item
+	} TItemShard;
+
+	typedef std::unordered_map<DWORD, TItemShard>	TItemShardMap;
+	TItemShardMap				m_map_itemShard;
 
 	// MYSHOP_PRICE_LIST
 	/// 플레이어별 아이템 가격정보 리스트 map. key: 플레이어 ID, value: 가격정보 리스트 캐시
@@ -453,7 +487,6 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	TEventFlagMap m_map_lEventFlag;
 
 	BYTE					m_bLastHeader;
-	int					m_iCacheFlushCount;
 	int					m_iCacheFlushCountLimit;
 
     private :
@@ -486,26 +519,8 @@ class CClientManager : public CNetBase, public singleton<CClientManager>
 	//END_RELOAD_ADMIN
 	void BreakMarriage(CPeer * peer, const char * data);
 
-	struct TLogoutPlayer
-	{
-	    DWORD	pid;
-	    time_t	time;
-
-	    bool operator < (const TLogoutPlayer & r) 
-	    {
-		return (pid < r.pid);
-	    }
-	};
-
-	typedef std::unordered_map<DWORD, TLogoutPlayer*> TLogoutPlayerMap;
-	TLogoutPlayerMap m_map_logout;
-	
 	void InsertLogoutPlayer(DWORD pid);
 	void DeleteLogoutPlayer(DWORD pid);
-	void UpdateLogoutPlayer();
-	void UpdateItemCacheSet(DWORD pid);
-
-	void FlushPlayerCacheSet(DWORD pid);
 
 	//MONARCH
 	void Election(CPeer * peer, DWORD dwHandle, const char * p);
@@ -7,6 +7,7 @@
 #include "Monarch.h"
 #include "CsvReader.h"
 #include "ProtoReader.h"
+#include "common/proto_snapshot.h"
 
 using namespace std;
 
@@ -15,7 +16,9 @@ extern std::string g_stLocaleNameColumn;
 
 bool CClientManager::InitializeTables()
 {
-	if (!InitializeMobTable())
+	bool bFromSnapshot = LoadProtoSnapshot();
+
+	if (!bFromSnapshot && !InitializeMobTable())
 	{
 		sys_err("InitializeMobTable FAILED");
 		return false;
@@ -26,12 +29,15 @@ bool CClientManager::InitializeTables()
 		return false; 
 	}
 
-	if (!InitializeItemTable())
+	if (!bFromSnapshot && !InitializeItemTable())
 	{
 		sys_err("InitializeItemTable FAILED");
 		return false; 
 	}
 
+	if (!bFromSnapshot)
+		SaveProtoSnapshot();
+
 	if (!MirrorItemTableIntoDB())
 	{
 		sys_err("MirrorItemTableIntoDB FAILED");
@@ -102,6 +108,93 @@ bool CClientManager::InitializeTables()
 	return true;
 }
 
+static const char * s_aszProtoSourceFiles[] =
+{
+	"conf/mob_proto.txt",
+	"conf/mob_names.txt",
+	"mob_proto_test.txt",
+	"conf/item_proto.txt",
+	"conf/item_names.txt",
+	"item_proto_test.txt",
+};
+
+uint32_t CClientManager::GetProtoSourceStamp()
+{
+	uint32_t dwStamp = CProtoSnapshot::Hash(NULL, 0);
+
+	for (size_t i = 0; i < sizeof(s_aszProtoSourceFiles) / sizeof(s_aszProtoSourceFiles[0]); ++i)
+	{
+		int64_t aiInfo[2] = { -1, -1 };	// a missing file hashes differently from an empty one
+		struct stat st;
+
+		if (stat(s_aszProtoSourceFiles[i], &st) == 0)
+		{
+			aiInfo[0] = st.st_size;
+			aiInfo[1] = st.st_mtime;
+		}
+
+		dwStamp = CProtoSnapshot::Hash(aiInfo, sizeof(aiInfo), dwStamp);
+	}
+
+	return dwStamp;
+}
+
+bool CClientManager::LoadProtoSnapshot()
+{
+	m_dwProtoSnapshotChecksum = 0;
+
+	if (m_stProtoSnapshotFileName.empty())
+		return false;
+
+	CProtoSnapshot snapshot;
+
+	if (!snapshot.Open(m_stProtoSnapshotFileName.c_str()))
+	{
+		sys_log(0, "PROTO_SNAPSHOT: %s missing or invalid, parsing text tables", m_stProtoSnapshotFileName.c_str());
+		return false;
+	}
+
+	if (snapshot.GetSourceStamp() != GetProtoSourceStamp())
+	{
+		sys_log(0, "PROTO_SNAPSHOT: %s is older than the text tables, parsing text tables", m_stProtoSnapshotFileName.c_str());
+		return false;
+	}
+
+	m_vec_mobTable.assign(snapshot.GetMobTable(), snapshot.GetMobTable() + snapshot.GetMobCount());
+	m_vec_itemTable.assign(snapshot.GetItemTable(), snapshot.GetItemTable() + snapshot.GetItemCount());
+
+	m_map_itemTableByVnum.clear();
+
+	for (itertype(m_vec_itemTable) it = m_vec_itemTable.begin(); it != m_vec_itemTable.end(); ++it)
+		m_map_itemTableByVnum.insert(std::map<DWORD, TItemTable *>::value_type(it->dwVnum, &(*it)));
+
+	m_dwProtoSnapshotChecksum = snapshot.GetChecksum();
+
+	sys_log(0, "PROTO_SNAPSHOT: loaded %s (mob %u item %u checksum %08x)",
+			m_stProtoSnapshotFileName.c_str(), snapshot.GetMobCount(), snapshot.GetItemCount(), m_dwProtoSnapshotChecksum);
+	return true;
+}
+
+void CClientManager::SaveProtoSnapshot()
+{
+	if (m_stProtoSnapshotFileName.empty())
+		return;
+
+	if (!CProtoSnapshot::Save(m_stProtoSnapshotFileName.c_str(), GetProtoSourceStamp(), m_vec_mobTable, m_vec_itemTable))
+	{
+		sys_err("PROTO_SNAPSHOT: cannot write %s", m_stProtoSnapshotFileName.c_str());
+		return;
+	}
+
+	// Re-open what was just written so the checksum matches what game cores will report.
+	CProtoSnapshot snapshot;
+
+	if (snapshot.Open(m_stProtoSnapshotFileName.c_str()))
+		m_dwProtoSnapshotChecksum = snapshot.GetChecksum();
+
+	sys_log(0, "PROTO_SNAPSHOT: wrote %s (checksum %08x)", m_stProtoSnapshotFileName.c_str(), m_dwProtoSnapshotChecksum);
+}
+
 bool CClientManager::InitializeRefineTable()
 {
 	char query[2048];
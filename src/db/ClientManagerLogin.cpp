@@ -274,8 +274,23 @@ void CreateAccountPlayerDataFromRes(MYSQL_RES * pRes, TAccountTable * pkTab)
 		{
 			if (pkTab->players[j].dwID == player_id)
 			{
-				CPlayerTableCache * pc = CClientManager::instance().GetPlayerCache(player_id);
-				TPlayerTable * pt = pc ? pc->Get(false) : NULL;
+				// 샤드의 캐쉬는 잠금만 잡고 읽는다. 로그인이 몰릴 때 메인 스레드가
+				// 샤드의 큐를 기다리지 않도록 하기 위함이며, 아직 처리되지 않은 저장이
+				// 있다면 캐릭터 목록이 몇 ms 늦은 정보일 수 있다.
+				TPlayerTable tab;
+				TPlayerTable * pt = NULL;
+
+				{
+					CPlayerShard * pkShard = CClientManager::instance().GetShard(player_id);
+					std::unique_lock<std::mutex> lock = pkShard->Lock();
+					CPlayerTableCache * pc = pkShard->GetPlayerCache(player_id);
+
+					if (pc)
+					{
+						tab = *pc->Get(false);
+						pt = &tab;
+					}
+				}
 
 				if (pt)
 				{
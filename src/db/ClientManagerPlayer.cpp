@@ -159,8 +159,8 @@ size_t CreatePlayerSaveQuery(char * pszQuery, size_t querySize, TPlayerTable * p
 		pkTab->horse.sStamina,
 		pkTab->horse_skill_point);
 
-	// Binary 로 바꾸기 위한 임시 공간
-	static char text[8192 + 1];
+	// Binary 로 바꾸기 위한 임시 공간. 샤드 스레드마다 동시에 부르므로 static 이면 안 된다.
+	char text[8192 + 1];
 
 	CDBManager::instance().EscapeString(text, pkTab->skills, sizeof(pkTab->skills));
 	queryLen += snprintf(pszQuery + queryLen, querySize - queryLen, "skill_level = '%s', ", text);
@@ -172,44 +172,11 @@ size_t CreatePlayerSaveQuery(char * pszQuery, size_t querySize, TPlayerTable * p
 	return queryLen;
 }
 
-CPlayerTableCache * CClientManager::GetPlayerCache(DWORD id)
-{
-	TPlayerTableCacheMap::iterator it = m_map_playerCache.find(id);
-
-	if (it == m_map_playerCache.end())
-		return NULL;
-
-	TPlayerTable* pTable = it->second->Get(false);
-	pTable->logoff_interval = GetCurrentTime() - it->second->GetLastUpdateTime();
-	return it->second;
-}
-
-void CClientManager::PutPlayerCache(TPlayerTable * pNew)
-{
-	CPlayerTableCache * c;
-
-	c = GetPlayerCache(pNew->id);
-
-	if (!c)
-	{
-		c = new CPlayerTableCache;
-		m_map_playerCache.insert(TPlayerTableCacheMap::value_type(pNew->id, c));
-	}
-
-	if (g_bHotBackup)
-		PlayerHB::instance().Put(pNew->id);
-
-	c->Put(pNew);
-}
-
 /*
  * PLAYER LOAD
  */
 void CClientManager::QUERY_PLAYER_LOAD(CPeer * peer, DWORD dwHandle, TPlayerLoadPacket * packet)
 {
-	CPlayerTableCache * c;
-	TPlayerTable * pTab;
-	
 	//
 	// 한 계정에 속한 모든 캐릭터들 캐쉬처리
 	//
@@ -226,192 +193,221 @@ void CClientManager::QUERY_PLAYER_LOAD(CPeer * peer, DWORD dwHandle, TPlayerLoad
 	// 1. 유저정보가 DBCache 에 존재 : DBCache에서 
 	// 2. 유저정보가 DBCache 에 없음 : DB에서 
 	// ---------------------------------------------------------------
-	
-	//----------------------------------
-	// 1. 유저정보가 DBCache 에 존재 : DBCache에서 
-	//----------------------------------
-	if ((c = GetPlayerCache(packet->player_id)))
+	// 캐쉬는 pid의 샤드에서 찾고, 로그인 정보와 응답은 메인 스레드에서 처리한다.
+	CPlayerShard * pkShard = GetShard(packet->player_id);
+	DWORD dwPeerHandle = peer->GetHandle();
+	TPlayerLoadPacket load = *packet;
+
+	pkShard->Post([this, pkShard, dwPeerHandle, dwHandle, load]()
 	{
-		CLoginData * pkLD = GetLoginDataByAID(packet->account_id);
+		CPlayerTableCache * c = pkShard->GetPlayerCache(load.player_id);
 
-		if (!pkLD || pkLD->IsPlay())
+		if (!c)
 		{
-			sys_log(0, "PLAYER_LOAD_ERROR: LoginData %p IsPlay %d", pkLD, pkLD ? pkLD->IsPlay() : 0);
-			peer->EncodeHeader(HEADER_DG_PLAYER_LOAD_FAILED, dwHandle, 0); 
+			PostToMain([this, dwPeerHandle, dwHandle, load]() mutable
+			{
+				CPeer * peer = GetPeer(dwPeerHandle);
+
+				if (peer)
+					QUERY_PLAYER_LOAD_FROM_DB(peer, dwHandle, &load);
+			});
 			return;
 		}
 
-		pTab = c->Get();
-
-		pkLD->SetPlay(true);
-		thecore_memcpy(pTab->aiPremiumTimes, pkLD->GetPremiumPtr(), sizeof(pTab->aiPremiumTimes));
+		std::shared_ptr<TPlayerTable> pTab = std::make_shared<TPlayerTable>(*c->Get());
+		std::shared_ptr<std::vector<TPlayerItem> > pVecItem;
 
-		peer->EncodeHeader(HEADER_DG_PLAYER_LOAD_SUCCESS, dwHandle, sizeof(TPlayerTable));
-		peer->Encode(pTab, sizeof(TPlayerTable));
+		CPlayerShard::TItemCacheSet * pSet = pkShard->GetItemCacheSet(pTab->id);
 
-		if (packet->player_id != pkLD->GetLastPlayerID())
+		if (pSet)
 		{
-			TPacketNeedLoginLogInfo logInfo;
-			logInfo.dwPlayerID = packet->player_id;
+			pVecItem = std::make_shared<std::vector<TPlayerItem> >();
+			pVecItem->reserve(pSet->size());
 
-			pkLD->SetLastPlayerID( packet->player_id );
+			for (CPlayerShard::TItemCacheSet::iterator it = pSet->begin(); it != pSet->end(); ++it)
+			{
+				TPlayerItem * p = (*it)->Get();
 
-			peer->EncodeHeader( HEADER_DG_NEED_LOGIN_LOG, dwHandle, sizeof(TPacketNeedLoginLogInfo) );
-			peer->Encode( &logInfo, sizeof(TPacketNeedLoginLogInfo) );
+				if (p->vnum) // vnum이 없으면 삭제된 아이템이다.
+					pVecItem->push_back(*p);
+			}
 		}
 
-		char szQuery[1024] = { 0, };
+		PostToMain([this, dwPeerHandle, dwHandle, load, pTab, pVecItem]()
+		{
+			CPeer * peer = GetPeer(dwPeerHandle);
 
-		TItemCacheSet * pSet = GetItemCacheSet(pTab->id);
+			if (peer)
+				RESULT_PLAYER_LOAD_FROM_CACHE(peer, dwHandle, load.account_id, pTab.get(), pVecItem.get());
+		});
+	});
+}
 
-		sys_log(0, "[PLAYER_LOAD] ID %s pid %d gold %d ", pTab->name, pTab->id, pTab->gold);
+//----------------------------------
+// 1. 유저정보가 DBCache 에 존재 : DBCache에서 
+//----------------------------------
+void CClientManager::RESULT_PLAYER_LOAD_FROM_CACHE(CPeer * peer, DWORD dwHandle, DWORD dwAID, TPlayerTable * pTab, std::vector<TPlayerItem> * pVecItem)
+{
+	CLoginData * pkLD = GetLoginDataByAID(dwAID);
 
-		//--------------------------------------------
-		// 아이템 & AFFECT & QUEST 로딩 : 
-		//--------------------------------------------
-		// 1) 아이템이 DBCache 에 존재 : DBCache 에서 가져옴
-		// 2) 아이템이 DBCache 에 없음 : DB 에서 가져옴 
+	if (!pkLD || pkLD->IsPlay())
+	{
+		sys_log(0, "PLAYER_LOAD_ERROR: LoginData %p IsPlay %d", pkLD, pkLD ? pkLD->IsPlay() : 0);
+		peer->EncodeHeader(HEADER_DG_PLAYER_LOAD_FAILED, dwHandle, 0); 
+		return;
+	}
 
-		/////////////////////////////////////////////
-		// 1) 아이템이 DBCache 에 존재 : DBCache 에서 가져옴
-		/////////////////////////////////////////////
-		if (pSet)
-		{
-			static std::vector<TPlayerItem> s_items;
-			s_items.resize(pSet->size());
+	pkLD->SetPlay(true);
+	thecore_memcpy(pTab->aiPremiumTimes, pkLD->GetPremiumPtr(), sizeof(pTab->aiPremiumTimes));
 
-			DWORD dwCount = 0;
-			TItemCacheSet::iterator it = pSet->begin();
+	peer->EncodeHeader(HEADER_DG_PLAYER_LOAD_SUCCESS, dwHandle, sizeof(TPlayerTable));
+	peer->Encode(pTab, sizeof(TPlayerTable));
 
-			while (it != pSet->end())
-			{
-				CItemCache * c = *it++;
-				TPlayerItem * p = c->Get();
+	if (pTab->id != pkLD->GetLastPlayerID())
+	{
+		TPacketNeedLoginLogInfo logInfo;
+		logInfo.dwPlayerID = pTab->id;
 
-				if (p->vnum) // vnum이 없으면 삭제된 아이템이다.
-					thecore_memcpy(&s_items[dwCount++], p, sizeof(TPlayerItem));
-			}
+		pkLD->SetLastPlayerID( pTab->id );
 
-			if (g_test_server)
-				sys_log(0, "ITEM_CACHE: HIT! %s count: %u", pTab->name, dwCount);
+		peer->EncodeHeader( HEADER_DG_NEED_LOGIN_LOG, dwHandle, sizeof(TPacketNeedLoginLogInfo) );
+		peer->Encode( &logInfo, sizeof(TPacketNeedLoginLogInfo) );
+	}
 
-			peer->EncodeHeader(HEADER_DG_ITEM_LOAD, dwHandle, sizeof(DWORD) + sizeof(TPlayerItem) * dwCount);
-			peer->EncodeDWORD(dwCount);
+	char szQuery[1024] = { 0, };
 
-			if (dwCount)
-				peer->Encode(&s_items[0], sizeof(TPlayerItem) * dwCount);
+	sys_log(0, "[PLAYER_LOAD] ID %s pid %d gold %d ", pTab->name, pTab->id, pTab->gold);
 
-			// Quest
-			snprintf(szQuery, sizeof(szQuery),
-					"SELECT dwPID,szName,szState,lValue FROM quest%s WHERE dwPID=%d AND lValue<>0",
-					GetTablePostfix(), pTab->id);
-			
-			CDBManager::instance().ReturnQuery(szQuery, QID_QUEST, peer->GetHandle(), new ClientHandleInfo(dwHandle,0,packet->account_id));
+	//--------------------------------------------
+	// 아이템 & AFFECT & QUEST 로딩 : 
+	//--------------------------------------------
+	// 1) 아이템이 DBCache 에 존재 : DBCache 에서 가져옴
+	// 2) 아이템이 DBCache 에 없음 : DB 에서 가져옴 
 
-			// Affect
-			snprintf(szQuery, sizeof(szQuery),
-					"SELECT dwPID,bType,bApplyOn,lApplyValue,dwFlag,lDuration,lSPCost FROM affect%s WHERE dwPID=%d",
-					GetTablePostfix(), pTab->id);
-			CDBManager::instance().ReturnQuery(szQuery, QID_AFFECT, peer->GetHandle(), new ClientHandleInfo(dwHandle));
-		}
-		/////////////////////////////////////////////
-		// 2) 아이템이 DBCache 에 없음 : DB 에서 가져옴 
-		/////////////////////////////////////////////
-		else
-		{
-			snprintf(szQuery, sizeof(szQuery), 
-					"SELECT id,window+0,pos,count,vnum,socket0,socket1,socket2,attrtype0,attrvalue0,attrtype1,attrvalue1,attrtype2,attrvalue2,attrtype3,attrvalue3,attrtype4,attrvalue4,attrtype5,attrvalue5,attrtype6,attrvalue6 "
-					"FROM item%s WHERE owner_id=%d AND (window < %d or window = %d)",
-					GetTablePostfix(), pTab->id, SAFEBOX, DRAGON_SOUL_INVENTORY);
-
-			CDBManager::instance().ReturnQuery(szQuery,
-					QID_ITEM,
-					peer->GetHandle(),
-					new ClientHandleInfo(dwHandle, pTab->id));
-			snprintf(szQuery, sizeof(szQuery), 
-					"SELECT dwPID, szName, szState, lValue FROM quest%s WHERE dwPID=%d",
-					GetTablePostfix(), pTab->id);
-
-			CDBManager::instance().ReturnQuery(szQuery,
-					QID_QUEST,
-					peer->GetHandle(),
-					new ClientHandleInfo(dwHandle, pTab->id));
-			snprintf(szQuery, sizeof(szQuery), 
-					"SELECT dwPID, bType, bApplyOn, lApplyValue, dwFlag, lDuration, lSPCost FROM affect%s WHERE dwPID=%d",
-					GetTablePostfix(), pTab->id);
-
-			CDBManager::instance().ReturnQuery(szQuery,
-					QID_AFFECT,
-					peer->GetHandle(),
-					new ClientHandleInfo(dwHandle, pTab->id));
-		}
-		//ljw
-		//return;
-	}
-	//----------------------------------
-	// 2. 유저정보가 DBCache 에 없음 : DB에서 
-	//----------------------------------
-	else
+	/////////////////////////////////////////////
+	// 1) 아이템이 DBCache 에 존재 : DBCache 에서 가져옴
+	/////////////////////////////////////////////
+	if (pVecItem)
 	{
-		sys_log(0, "[PLAYER_LOAD] Load from PlayerDB pid[%d]", packet->player_id);
+		DWORD dwCount = pVecItem->size();
 
-		char queryStr[QUERY_MAX_LEN];
+		if (g_test_server)
+			sys_log(0, "ITEM_CACHE: HIT! %s count: %u", pTab->name, dwCount);
 
-		//--------------------------------------------------------------
-		// 캐릭터 정보 얻어오기 : 무조건 DB에서 
-		//--------------------------------------------------------------
-		snprintf(queryStr, sizeof(queryStr),
-				"SELECT "
-				"id,name,job,voice,dir,x,y,z,map_index,exit_x,exit_y,exit_map_index,hp,mp,stamina,random_hp,random_sp,playtime,"
-				"gold,level,level_step,st,ht,dx,iq,exp,"
-				"stat_point,skill_point,sub_skill_point,stat_reset_count,part_base,part_hair,"
-				"skill_level,quickslot,skill_group,alignment,mobile,horse_level,horse_riding,horse_hp,horse_hp_droptime,horse_stamina,"
-				"UNIX_TIMESTAMP(NOW())-UNIX_TIMESTAMP(last_play),horse_skill_point FROM player%s WHERE id=%d",
-				GetTablePostfix(), packet->player_id);
-
-		ClientHandleInfo * pkInfo = new ClientHandleInfo(dwHandle, packet->player_id);
-		pkInfo->account_id = packet->account_id;
-		CDBManager::instance().ReturnQuery(queryStr, QID_PLAYER, peer->GetHandle(), pkInfo);
-
-		//--------------------------------------------------------------
-		// 아이템 가져오기 
-		//--------------------------------------------------------------
-		snprintf(queryStr, sizeof(queryStr),
-				"SELECT id,window+0,pos,count,vnum,socket0,socket1,socket2,attrtype0,attrvalue0,attrtype1,attrvalue1,attrtype2,attrvalue2,attrtype3,attrvalue3,attrtype4,attrvalue4,attrtype5,attrvalue5,attrtype6,attrvalue6 "
-				"FROM item%s WHERE owner_id=%d AND (window < %d or window = %d)",
-				GetTablePostfix(), packet->player_id, SAFEBOX, DRAGON_SOUL_INVENTORY);
-		CDBManager::instance().ReturnQuery(queryStr, QID_ITEM, peer->GetHandle(), new ClientHandleInfo(dwHandle, packet->player_id));
+		peer->EncodeHeader(HEADER_DG_ITEM_LOAD, dwHandle, sizeof(DWORD) + sizeof(TPlayerItem) * dwCount);
+		peer->EncodeDWORD(dwCount);
 
-		//--------------------------------------------------------------
-		// QUEST 가져오기 
-		//--------------------------------------------------------------
-		snprintf(queryStr, sizeof(queryStr),
-				"SELECT dwPID,szName,szState,lValue FROM quest%s WHERE dwPID=%d",
-				GetTablePostfix(), packet->player_id);
-		CDBManager::instance().ReturnQuery(queryStr, QID_QUEST, peer->GetHandle(), new ClientHandleInfo(dwHandle, packet->player_id,packet->account_id));
-		//독일 선물 기능에서 item_award테이블에서 login 정보를 얻기위해 account id도 넘겨준다
-		//--------------------------------------------------------------
-		// AFFECT 가져오기 
-		//--------------------------------------------------------------
-		snprintf(queryStr, sizeof(queryStr),
+		if (dwCount)
+			peer->Encode(&pVecItem->at(0), sizeof(TPlayerItem) * dwCount);
+
+		// Quest
+		snprintf(szQuery, sizeof(szQuery),
+				"SELECT dwPID,szName,szState,lValue FROM quest%s WHERE dwPID=%d AND lValue<>0",
+				GetTablePostfix(), pTab->id);
+		
+		CDBManager::instance().ReturnQuery(szQuery, QID_QUEST, peer->GetHandle(), new ClientHandleInfo(dwHandle, pTab->id, dwAID));
+
+		// Affect
+		snprintf(szQuery, sizeof(szQuery),
 				"SELECT dwPID,bType,bApplyOn,lApplyValue,dwFlag,lDuration,lSPCost FROM affect%s WHERE dwPID=%d",
-				GetTablePostfix(), packet->player_id);
-		CDBManager::instance().ReturnQuery(queryStr, QID_AFFECT, peer->GetHandle(), new ClientHandleInfo(dwHandle, packet->player_id));
+				GetTablePostfix(), pTab->id);
+		CDBManager::instance().ReturnQuery(szQuery, QID_AFFECT, peer->GetHandle(), new ClientHandleInfo(dwHandle, pTab->id));
 	}
-	
-	
+	/////////////////////////////////////////////
+	// 2) 아이템이 DBCache 에 없음 : DB 에서 가져옴 
+	/////////////////////////////////////////////
+	else
+	{
+		snprintf(szQuery, sizeof(szQuery), 
+				"SELECT id,window+0,pos,count,vnum,socket0,socket1,socket2,attrtype0,attrvalue0,attrtype1,attrvalue1,attrtype2,attrvalue2,attrtype3,attrvalue3,attrtype4,attrvalue4,attrtype5,attrvalue5,attrtype6,attrvalue6 "
+				"FROM item%s WHERE owner_id=%d AND (window < %d or window = %d)",
+				GetTablePostfix(), pTab->id, SAFEBOX, DRAGON_SOUL_INVENTORY);
+
+		CDBManager::instance().ReturnQuery(szQuery,
+				QID_ITEM,
+				peer->GetHandle(),
+				new ClientHandleInfo(dwHandle, pTab->id));
+		snprintf(szQuery, sizeof(szQuery), 
+				"SELECT dwPID, szName, szState, lValue FROM quest%s WHERE dwPID=%d",
+				GetTablePostfix(), pTab->id);
+
+		CDBManager::instance().ReturnQuery(szQuery,
+				QID_QUEST,
+				peer->GetHandle(),
+				new ClientHandleInfo(dwHandle, pTab->id));
+		snprintf(szQuery, sizeof(szQuery), 
+				"SELECT dwPID, bType, bApplyOn, lApplyValue, dwFlag, lDuration, lSPCost FROM affect%s WHERE dwPID=%d",
+				GetTablePostfix(), pTab->id);
+
+		CDBManager::instance().ReturnQuery(szQuery,
+				QID_AFFECT,
+				peer->GetHandle(),
+				new ClientHandleInfo(dwHandle, pTab->id));
+	}
+}
+
+//----------------------------------
+// 2. 유저정보가 DBCache 에 없음 : DB에서 
+//----------------------------------
+void CClientManager::QUERY_PLAYER_LOAD_FROM_DB(CPeer * peer, DWORD dwHandle, TPlayerLoadPacket * packet)
+{
+	sys_log(0, "[PLAYER_LOAD] Load from PlayerDB pid[%d]", packet->player_id);
+
+	char queryStr[QUERY_MAX_LEN];
+
+	//--------------------------------------------------------------
+	// 캐릭터 정보 얻어오기 : 무조건 DB에서 
+	//--------------------------------------------------------------
+	snprintf(queryStr, sizeof(queryStr),
+			"SELECT "
+			"id,name,job,voice,dir,x,y,z,map_index,exit_x,exit_y,exit_map_index,hp,mp,stamina,random_hp,random_sp,playtime,"
+			"gold,level,level_step,st,ht,dx,iq,exp,"
+			"stat_point,skill_point,sub_skill_point,stat_reset_count,part_base,part_hair,"
+			"skill_level,quickslot,skill_group,alignment,mobile,horse_level,horse_riding,horse_hp,horse_hp_droptime,horse_stamina,"
+			"UNIX_TIMESTAMP(NOW())-UNIX_TIMESTAMP(last_play),horse_skill_point FROM player%s WHERE id=%d",
+			GetTablePostfix(), packet->player_id);
+
+	ClientHandleInfo * pkInfo = new ClientHandleInfo(dwHandle, packet->player_id);
+	pkInfo->account_id = packet->account_id;
+	CDBManager::instance().ReturnQuery(queryStr, QID_PLAYER, peer->GetHandle(), pkInfo);
+
+	//--------------------------------------------------------------
+	// 아이템 가져오기 
+	//--------------------------------------------------------------
+	snprintf(queryStr, sizeof(queryStr),
+			"SELECT id,window+0,pos,count,vnum,socket0,socket1,socket2,attrtype0,attrvalue0,attrtype1,attrvalue1,attrtype2,attrvalue2,attrtype3,attrvalue3,attrtype4,attrvalue4,attrtype5,attrvalue5,attrtype6,attrvalue6 "
+			"FROM item%s WHERE owner_id=%d AND (window < %d or window = %d)",
+			GetTablePostfix(), packet->player_id, SAFEBOX, DRAGON_SOUL_INVENTORY);
+	CDBManager::instance().ReturnQuery(queryStr, QID_ITEM, peer->GetHandle(), new ClientHandleInfo(dwHandle, packet->player_id));
+
+	//--------------------------------------------------------------
+	// QUEST 가져오기 
+	//--------------------------------------------------------------
+	snprintf(queryStr, sizeof(queryStr),
+			"SELECT dwPID,szName,szState,lValue FROM quest%s WHERE dwPID=%d",
+			GetTablePostfix(), packet->player_id);
+	CDBManager::instance().ReturnQuery(queryStr, QID_QUEST, peer->GetHandle(), new ClientHandleInfo(dwHandle, packet->player_id,packet->account_id));
+	//독일 선물 기능에서 item_award테이블에서 login 정보를 얻기위해 account id도 넘겨준다
+	//--------------------------------------------------------------
+	// AFFECT 가져오기 
+	//--------------------------------------------------------------
+	snprintf(queryStr, sizeof(queryStr),
+			"SELECT dwPID,bType,bApplyOn,lApplyValue,dwFlag,lDuration,lSPCost FROM affect%s WHERE dwPID=%d",
+			GetTablePostfix(), packet->player_id);
+	CDBManager::instance().ReturnQuery(queryStr, QID_AFFECT, peer->GetHandle(), new ClientHandleInfo(dwHandle, packet->player_id));
 }
+
 void CClientManager::ItemAward(CPeer * peer,char* login)
 {
 	char login_t[LOGIN_MAX_LEN + 1] = "";
 	strlcpy(login_t,login,LOGIN_MAX_LEN + 1);	
-	std::set<TItemAward *> * pSet = ItemAwardManager::instance().GetByLogin(login_t);	
-	if(pSet == NULL)
+	ItemAwardManager::TAwardQueue * pQueue = ItemAwardManager::instance().GetByLogin(login_t);	
+	if(pQueue == NULL)
 		return;
-	__typeof(pSet->begin()) it = pSet->begin();	//taken_time이 NULL인것들 읽어옴	
-	while(it != pSet->end() )
+	__typeof(pQueue->begin()) it = pQueue->begin();	//taken_time이 NULL인것들 읽어옴	
+	while(it != pQueue->end() )
 	{				
-		TItemAward * pItemAward = *(it++);		
+		TItemAward * pItemAward = (it++)->second;		
 		char* whyStr = pItemAward->szWhy;	//why 콜룸 읽기
 		char cmdStr[100] = "";	//why콜룸에서 읽은 값을 임시 문자열에 복사해둠
 		strcpy(cmdStr, whyStr);	//명령어 얻는 과정에서 토큰쓰면 원본도 토큰화 되기 때문
@@ -551,99 +547,180 @@ bool CreatePlayerTableFromRes(MYSQL_RES * res, TPlayerTable * pkTab)
 	return true;
 }
 
+static void CreateQuestTableFromRes(MYSQL_RES * res, std::vector<TQuestTable> * pVec)
+{
+	int iNumRows = mysql_num_rows(res);
+
+	pVec->resize(iNumRows);
+
+	MYSQL_ROW row;
+
+	for (int i = 0; i < iNumRows; ++i)
+	{
+		TQuestTable & r = pVec->at(i);
+
+		row = mysql_fetch_row(res);
+
+		str_to_number(r.dwPID, row[0]);
+		strlcpy(r.szName, row[1], sizeof(r.szName));
+		strlcpy(r.szState, row[2], sizeof(r.szState));
+		str_to_number(r.lValue, row[3]);
+	}
+}
+
+static void CreateAffectTableFromRes(MYSQL_RES * res, std::vector<TPacketAffectElement> * pVec)
+{
+	int iNumRows = mysql_num_rows(res);
+
+	pVec->resize(iNumRows);
+
+	MYSQL_ROW row;
+
+	for (int i = 0; i < iNumRows; ++i)
+	{
+		TPacketAffectElement & r = pVec->at(i);
+		row = mysql_fetch_row(res);
+
+		str_to_number(r.dwType, row[1]);
+		str_to_number(r.bApplyOn, row[2]);
+		str_to_number(r.lApplyValue, row[3]);
+		str_to_number(r.dwFlag, row[4]);
+		str_to_number(r.lDuration, row[5]);
+		str_to_number(r.lSPCost, row[6]);
+	}
+}
+
 void CClientManager::RESULT_COMPOSITE_PLAYER(CPeer * peer, SQLMsg * pMsg, DWORD dwQID)
 {
 	CQueryInfo * qi = (CQueryInfo *) pMsg->pvUserData;
-	std::unique_ptr<ClientHandleInfo> info((ClientHandleInfo *) qi->pvData);
+	std::shared_ptr<ClientHandleInfo> info((ClientHandleInfo *) qi->pvData);
 	
-	MYSQL_RES * pSQLResult = pMsg->Get()->pSQLResult;
-	if (!pSQLResult)
+	if (!pMsg->Get()->pSQLResult)
 	{
 		sys_err("null MYSQL_RES QID %u", dwQID);
 		return;
 	}
 
+	//
+	// 결과는 pid의 샤드에서 읽고(아이템은 캐쉬에도 넣는다) 응답은 메인 스레드에서
+	// 보낸다. 한 플레이어의 결과는 모두 같은 샤드를 거치므로 온 순서대로 나간다.
+	//
+	std::shared_ptr<SQLResult> pRes = std::make_shared<SQLResult>(std::move(*pMsg->Get()));
+	CPlayerShard * pkShard = GetShard(info->player_id);
+	DWORD dwPeerHandle = peer->GetHandle();
+
 	switch (dwQID)
 	{
 		case QID_PLAYER:
-			sys_log(0, "QID_PLAYER %u %u", info->dwHandle, info->player_id);
-			RESULT_PLAYER_LOAD(peer, pSQLResult, info.get());
+			pkShard->Post([this, pRes, info, dwPeerHandle]()
+			{
+				std::shared_ptr<TPlayerTable> pTab = std::make_shared<TPlayerTable>();
+				bool bFound = CreatePlayerTableFromRes(pRes->pSQLResult, pTab.get());
+
+				PostToMain([this, pTab, bFound, info, dwPeerHandle]()
+				{
+					CPeer * peer = GetPeer(dwPeerHandle);
 
+					if (!peer)
+						return;
+
+					sys_log(0, "QID_PLAYER %u %u", info->dwHandle, info->player_id);
+					RESULT_PLAYER_LOAD(peer, pTab.get(), bFound, info.get());
+				});
+			});
 			break;
 
 		case QID_ITEM:
-			sys_log(0, "QID_ITEM %u", info->dwHandle);
-			RESULT_ITEM_LOAD(peer, pSQLResult, info->dwHandle, info->player_id);
+			pkShard->Post([this, pkShard, pRes, info, dwPeerHandle]()
+			{
+				std::shared_ptr<std::vector<TPlayerItem> > pVecItem = std::make_shared<std::vector<TPlayerItem> >();
+
+				//DB에서 아이템 정보를 읽어온다.
+				CreateItemTableFromRes(pRes->pSQLResult, pVecItem.get(), info->player_id);
+
+				//CacheSet을 만든다  
+				pkShard->CreateItemCacheSet(info->player_id);
+
+				for (size_t i = 0; i < pVecItem->size(); ++i)
+					pkShard->PutItemCache(&pVecItem->at(i), true); // 로드한 것은 따로 저장할 필요 없으므로, 인자 bSkipQuery에 true를 넣는다.
+
+				uint64_t qwTicket = pkShard->GetCurrentTicket();
+
+				PostToMain([this, pkShard, qwTicket, pVecItem, info, dwPeerHandle]()
+				{
+					for (size_t i = 0; i < pVecItem->size(); ++i)
+					{
+						MoveItemToShard(pVecItem->at(i).id, pkShard);
+						IndexItem(pVecItem->at(i).id, pkShard, qwTicket);
+					}
+
+					CPeer * peer = GetPeer(dwPeerHandle);
+
+					if (!peer)
+						return;
+
+					sys_log(0, "QID_ITEM %u", info->dwHandle);
+					RESULT_ITEM_LOAD(peer, *pVecItem, info->dwHandle, info->player_id);
+				});
+			});
 			break;
 
 		case QID_QUEST:
+			pkShard->Post([this, pRes, info, dwPeerHandle]()
 			{
-				sys_log(0, "QID_QUEST %u", info->dwHandle);
-				RESULT_QUEST_LOAD(peer, pSQLResult, info->dwHandle, info->player_id);
-				//aid얻기
-				ClientHandleInfo*  temp1 = info.get();
-				if (temp1 == NULL)
-					break;
-				
-				CLoginData* pLoginData1 = GetLoginDataByAID(temp1->account_id);
-
-				if (pLoginData1 == NULL)
-					break;
-
-				//독일 선물 기능
-				if (pLoginData1->GetAccountRef().login[0] == '\0')
-					break;
-
-				sys_log(0,"info of pLoginData1 before call ItemAwardfunction %d",pLoginData1);
-				ItemAward(peer,pLoginData1->GetAccountRef().login);
-			}
+				std::shared_ptr<std::vector<TQuestTable> > pVecQuest = std::make_shared<std::vector<TQuestTable> >();
+				CreateQuestTableFromRes(pRes->pSQLResult, pVecQuest.get());
+
+				PostToMain([this, pVecQuest, info, dwPeerHandle]()
+				{
+					CPeer * peer = GetPeer(dwPeerHandle);
+
+					if (!peer)
+						return;
+
+					sys_log(0, "QID_QUEST %u", info->dwHandle);
+					RESULT_QUEST_LOAD(peer, *pVecQuest, info->dwHandle, info->player_id);
+
+					//aid얻기
+					CLoginData* pLoginData1 = GetLoginDataByAID(info->account_id);
+
+					if (pLoginData1 == NULL)
+						return;
+
+					//독일 선물 기능
+					if (pLoginData1->GetAccountRef().login[0] == '\0')
+						return;
+
+					sys_log(0,"info of pLoginData1 before call ItemAwardfunction %d",pLoginData1);
+					ItemAward(peer,pLoginData1->GetAccountRef().login);
+				});
+			});
 			break;
 
 		case QID_AFFECT:
-			sys_log(0, "QID_AFFECT %u", info->dwHandle);
-			RESULT_AFFECT_LOAD(peer, pSQLResult, info->dwHandle);
+			pkShard->Post([this, pRes, info, dwPeerHandle]()
+			{
+				std::shared_ptr<std::vector<TPacketAffectElement> > pVecAffect = std::make_shared<std::vector<TPacketAffectElement> >();
+				CreateAffectTableFromRes(pRes->pSQLResult, pVecAffect.get());
+
+				PostToMain([this, pVecAffect, info, dwPeerHandle]()
+				{
+					CPeer * peer = GetPeer(dwPeerHandle);
+
+					if (!peer)
+						return;
+
+					sys_log(0, "QID_AFFECT %u", info->dwHandle);
+					RESULT_AFFECT_LOAD(peer, *pVecAffect, info->dwHandle, info->player_id);
+				});
+			});
 			break;
-			/*
-			   case QID_PLAYER_ITEM_QUEST_AFFECT:
-			   sys_log(0, "QID_PLAYER_ITEM_QUEST_AFFECT %u", info->dwHandle);
-			   RESULT_PLAYER_LOAD(peer, pSQLResult, info->dwHandle);
-
-			   if (!pMsg->Next())
-			   {
-			   sys_err("RESULT_COMPOSITE_PLAYER: QID_PLAYER_ITEM_QUEST_AFFECT: ITEM FAILED");
-			   return;
-			   }
-
-			   case QID_ITEM_QUEST_AFFECT:
-			   sys_log(0, "QID_ITEM_QUEST_AFFECT %u", info->dwHandle);
-			   RESULT_ITEM_LOAD(peer, pSQLResult, info->dwHandle, info->player_id);
-
-			   if (!pMsg->Next())
-			   {
-			   sys_err("RESULT_COMPOSITE_PLAYER: QID_PLAYER_ITEM_QUEST_AFFECT: QUEST FAILED");
-			   return;
-			   }
-
-			   case QID_QUEST_AFFECT:
-			   sys_log(0, "QID_QUEST_AFFECT %u", info->dwHandle);
-			   RESULT_QUEST_LOAD(peer, pSQLResult, info->dwHandle);
-
-			   if (!pMsg->Next())
-			   sys_err("RESULT_COMPOSITE_PLAYER: QID_PLAYER_ITEM_QUEST_AFFECT: AFFECT FAILED");
-			   else
-			   RESULT_AFFECT_LOAD(peer, pSQLResult, info->dwHandle);
-
-			   break;
-			   */
 	}
-	
 }
 
-void CClientManager::RESULT_PLAYER_LOAD(CPeer * peer, MYSQL_RES * pRes, ClientHandleInfo * pkInfo)
+void CClientManager::RESULT_PLAYER_LOAD(CPeer * peer, TPlayerTable * pTab, bool bFound, ClientHandleInfo * pkInfo)
 {
-	TPlayerTable tab;
-
-	if (!CreatePlayerTableFromRes(pRes, &tab))
+	if (!bFound)
 	{
 		peer->EncodeHeader(HEADER_DG_PLAYER_LOAD_FAILED, pkInfo->dwHandle, 0); 
 		return;
@@ -659,94 +736,56 @@ void CClientManager::RESULT_PLAYER_LOAD(CPeer * peer, MYSQL_RES * pRes, ClientHa
 	}
 
 	pkLD->SetPlay(true);
-	thecore_memcpy(tab.aiPremiumTimes, pkLD->GetPremiumPtr(), sizeof(tab.aiPremiumTimes));
+	thecore_memcpy(pTab->aiPremiumTimes, pkLD->GetPremiumPtr(), sizeof(pTab->aiPremiumTimes));
 
 	peer->EncodeHeader(HEADER_DG_PLAYER_LOAD_SUCCESS, pkInfo->dwHandle, sizeof(TPlayerTable));
-	peer->Encode(&tab, sizeof(TPlayerTable));
+	peer->Encode(pTab, sizeof(TPlayerTable));
 
-	if (tab.id != pkLD->GetLastPlayerID())
+	if (pTab->id != pkLD->GetLastPlayerID())
 	{
 		TPacketNeedLoginLogInfo logInfo;
-		logInfo.dwPlayerID = tab.id;
+		logInfo.dwPlayerID = pTab->id;
 
-		pkLD->SetLastPlayerID( tab.id );
+		pkLD->SetLastPlayerID( pTab->id );
 
 		peer->EncodeHeader( HEADER_DG_NEED_LOGIN_LOG, pkInfo->dwHandle, sizeof(TPacketNeedLoginLogInfo) );
 		peer->Encode( &logInfo, sizeof(TPacketNeedLoginLogInfo) );
 	}
 }
 
-void CClientManager::RESULT_ITEM_LOAD(CPeer * peer, MYSQL_RES * pRes, DWORD dwHandle, DWORD dwPID)
+void CClientManager::RESULT_ITEM_LOAD(CPeer * peer, std::vector<TPlayerItem> & vecItem, DWORD dwHandle, DWORD dwPID)
 {
-	static std::vector<TPlayerItem> s_items;
-	//DB에서 아이템 정보를 읽어온다.
-	CreateItemTableFromRes(pRes, &s_items, dwPID);
-	DWORD dwCount = s_items.size();
+	DWORD dwCount = vecItem.size();
 
 	peer->EncodeHeader(HEADER_DG_ITEM_LOAD, dwHandle, sizeof(DWORD) + sizeof(TPlayerItem) * dwCount);
 	peer->EncodeDWORD(dwCount);
 
-	//CacheSet을 만든다  
-	CreateItemCacheSet(dwPID);
-
 	// ITEM_LOAD_LOG_ATTACH_PID
 	sys_log(0, "ITEM_LOAD: count %u pid %u", dwCount, dwPID);
 	// END_OF_ITEM_LOAD_LOG_ATTACH_PID
 
 	if (dwCount)
-	{
-		peer->Encode(&s_items[0], sizeof(TPlayerItem) * dwCount);
-
-		for (DWORD i = 0; i < dwCount; ++i)
-			PutItemCache(&s_items[i], true); // 로드한 것은 따로 저장할 필요 없으므로, 인자 bSkipQuery에 true를 넣는다.
-	}
+		peer->Encode(&vecItem[0], sizeof(TPlayerItem) * dwCount);
 }
 
-void CClientManager::RESULT_AFFECT_LOAD(CPeer * peer, MYSQL_RES * pRes, DWORD dwHandle)
+void CClientManager::RESULT_AFFECT_LOAD(CPeer * peer, std::vector<TPacketAffectElement> & vecAffect, DWORD dwHandle, DWORD dwPID)
 {
-	int iNumRows;
-
-	if ((iNumRows = mysql_num_rows(pRes)) == 0) // 데이터 없음
+	if (vecAffect.empty()) // 데이터 없음
 		return;
 
-	static std::vector<TPacketAffectElement> s_elements;
-	s_elements.resize(iNumRows);
-
-	DWORD dwPID = 0;
+	sys_log(0, "AFFECT_LOAD: count %d PID %u", vecAffect.size(), dwPID);
 
-	MYSQL_ROW row;
-
-	for (int i = 0; i < iNumRows; ++i)
-	{
-		TPacketAffectElement & r = s_elements[i];
-		row = mysql_fetch_row(pRes);
-
-		if (dwPID == 0)
-			str_to_number(dwPID, row[0]);
-
-		str_to_number(r.dwType, row[1]);
-		str_to_number(r.bApplyOn, row[2]);
-		str_to_number(r.lApplyValue, row[3]);
-		str_to_number(r.dwFlag, row[4]);
-		str_to_number(r.lDuration, row[5]);
-		str_to_number(r.lSPCost, row[6]);
-	}
-
-	sys_log(0, "AFFECT_LOAD: count %d PID %u", s_elements.size(), dwPID);
-
-	DWORD dwCount = s_elements.size();
+	DWORD dwCount = vecAffect.size();
 
 	peer->EncodeHeader(HEADER_DG_AFFECT_LOAD, dwHandle, sizeof(DWORD) + sizeof(DWORD) + sizeof(TPacketAffectElement) * dwCount);
 	peer->Encode(&dwPID, sizeof(DWORD));
 	peer->Encode(&dwCount, sizeof(DWORD));
-	peer->Encode(&s_elements[0], sizeof(TPacketAffectElement) * dwCount);
+	peer->Encode(&vecAffect[0], sizeof(TPacketAffectElement) * dwCount);
 }
 
-void CClientManager::RESULT_QUEST_LOAD(CPeer * peer, MYSQL_RES * pRes, DWORD dwHandle, DWORD pid)
+void CClientManager::RESULT_QUEST_LOAD(CPeer * peer, std::vector<TQuestTable> & vecQuest, DWORD dwHandle, DWORD pid)
 {
-	int iNumRows;
-
-	if ((iNumRows = mysql_num_rows(pRes)) == 0)
+	if (vecQuest.empty())
 	{
 		DWORD dwCount = 0; 
 		peer->EncodeHeader(HEADER_DG_QUEST_LOAD, dwHandle, sizeof(DWORD));
@@ -754,30 +793,13 @@ void CClientManager::RESULT_QUEST_LOAD(CPeer * peer, MYSQL_RES * pRes, DWORD dwH
 		return;
 	}
 
-	static std::vector<TQuestTable> s_table;
-	s_table.resize(iNumRows);
+	sys_log(0, "QUEST_LOAD: count %d PID %u", vecQuest.size(), pid);
 
-	MYSQL_ROW row;
-
-	for (int i = 0; i < iNumRows; ++i)
-	{
-		TQuestTable & r = s_table[i];
-
-		row = mysql_fetch_row(pRes);
-
-		str_to_number(r.dwPID, row[0]);
-		strlcpy(r.szName, row[1], sizeof(r.szName));
-		strlcpy(r.szState, row[2], sizeof(r.szState));
-		str_to_number(r.lValue, row[3]);
-	}
-
-	sys_log(0, "QUEST_LOAD: count %d PID %u", s_table.size(), pid);
-
-	DWORD dwCount = s_table.size();
+	DWORD dwCount = vecQuest.size();
 
 	peer->EncodeHeader(HEADER_DG_QUEST_LOAD, dwHandle, sizeof(DWORD) + sizeof(TQuestTable) * dwCount);
 	peer->Encode(&dwCount, sizeof(DWORD));
-	peer->Encode(&s_table[0], sizeof(TQuestTable) * dwCount);
+	peer->Encode(&vecQuest[0], sizeof(TQuestTable) * dwCount);
 }
 
 /*
@@ -788,7 +810,10 @@ void CClientManager::QUERY_PLAYER_SAVE(CPeer * peer, DWORD dwHandle, TPlayerTabl
 	if (g_test_server)
 		sys_log(0, "PLAYER_SAVE: %s", pkTab->name);
 
-	PutPlayerCache(pkTab);
+	CPlayerShard * pkShard = GetShard(pkTab->id);
+	TPlayerTable tab = *pkTab;
+
+	pkShard->Post([pkShard, tab]() mutable { pkShard->PutPlayerCache(&tab); });
 }
 
 typedef std::map<DWORD, time_t> time_by_id_map_t;
@@ -998,22 +1023,33 @@ void CClientManager::__QUERY_PLAYER_DELETE(CPeer* peer, DWORD dwHandle, TPlayerD
 				return;
 			}
 
-			CPlayerTableCache * pkPlayerCache = GetPlayerCache(packet->player_id);
-			if (pkPlayerCache)
+			// 캐쉬는 샤드에 있으므로 거기서 읽고 기다린다. 캐릭터 삭제는 드물다.
+			CPlayerShard * pkShard = GetShard(packet->player_id);
+			DWORD dwPID = packet->player_id;
+			int iCachedLevel = -1;
+
+			pkShard->Post([pkShard, dwPID, &iCachedLevel]()
 			{
-				TPlayerTable * pTab = pkPlayerCache->Get();
+				CPlayerTableCache * pkPlayerCache = pkShard->GetPlayerCache(dwPID);
 
-				if (pTab->level >= m_iPlayerDeleteLevelLimit)
+				if (pkPlayerCache)
+					iCachedLevel = pkPlayerCache->Get()->level;
+			});
+			pkShard->Wait();
+
+			if (iCachedLevel >= 0)
+			{
+				if (iCachedLevel >= m_iPlayerDeleteLevelLimit)
 				{
-					sys_log(0, "PLAYER_DELETE FAILED LEVEL %u >= DELETE LIMIT %d", pTab->level, m_iPlayerDeleteLevelLimit);
+					sys_log(0, "PLAYER_DELETE FAILED LEVEL %u >= DELETE LIMIT %d", iCachedLevel, m_iPlayerDeleteLevelLimit);
 					peer->EncodeHeader(HEADER_DG_PLAYER_DELETE_FAILED, dwHandle, 1);
 					peer->EncodeBYTE(packet->account_index);
 					return;
 				}
 
-				if (pTab->level < m_iPlayerDeleteLevelLimitLower)
+				if (iCachedLevel < m_iPlayerDeleteLevelLimitLower)
 				{
-					sys_log(0, "PLAYER_DELETE FAILED LEVEL %u < DELETE LIMIT %d", pTab->level, m_iPlayerDeleteLevelLimitLower);
+					sys_log(0, "PLAYER_DELETE FAILED LEVEL %u < DELETE LIMIT %d", iCachedLevel, m_iPlayerDeleteLevelLimitLower);
 					peer->EncodeHeader(HEADER_DG_PLAYER_DELETE_FAILED, dwHandle, 1);
 					peer->EncodeBYTE(packet->account_index);
 					return;
@@ -1092,33 +1128,13 @@ void CClientManager::__RESULT_PLAYER_DELETE(CPeer *peer, SQLMsg* msg)
 
 		snprintf(account_index_string, sizeof(account_index_string), "player_id%d", m_iPlayerIDStart + pi->account_index);
 
-		// 플레이어 테이블을 캐쉬에서 삭제한다.
-		CPlayerTableCache * pkPlayerCache = GetPlayerCache(pi->player_id);
-
-		if (pkPlayerCache)
-		{
-			m_map_playerCache.erase(pi->player_id);
-			delete pkPlayerCache;
-		}
-
-		// 아이템들을 캐쉬에서 삭제한다.
-		TItemCacheSet * pSet = GetItemCacheSet(pi->player_id);
+		// 플레이어 테이블과 아이템들을 캐쉬에서 삭제한다.
+		// 아래 player_index 갱신 전에 끝나야 하므로 기다린다.
+		CPlayerShard * pkShard = GetShard(pi->player_id);
+		DWORD dwDeletePID = pi->player_id;
 
-		if (pSet)
-		{
-			TItemCacheSet::iterator it = pSet->begin();
-
-			while (it != pSet->end())
-			{
-				CItemCache * pkItemCache = *it++;
-				DeleteItemCache(pkItemCache->Get()->id);
-			}
-
-			pSet->clear();
-			delete pSet;
-
-			m_map_pkItemCacheSetPtr.erase(pi->player_id);
-		}
+		pkShard->Post([pkShard, dwDeletePID]() { pkShard->DeletePlayerCacheSet(dwDeletePID); });
+		pkShard->Wait();
 
 		snprintf(queryStr, sizeof(queryStr), "UPDATE player_index%s SET pid%u=0 WHERE pid%u=%d", 
 				GetTablePostfix(), 
@@ -1173,49 +1189,60 @@ void CClientManager::__RESULT_PLAYER_DELETE(CPeer *peer, SQLMsg* msg)
 
 void CClientManager::QUERY_ADD_AFFECT(CPeer * peer, TPacketGDAddAffect * p)
 {
-	char queryStr[QUERY_MAX_LEN];
-	/*
-	   snprintf(queryStr, sizeof(queryStr),
-	   "INSERT INTO affect%s (dwPID, bType, bApplyOn, lApplyValue, dwFlag, lDuration, lSPCost) "
-	   "VALUES(%u, %u, %u, %d, %u, %d, %d) "
-	   "ON DUPLICATE KEY UPDATE lApplyValue=%d, dwFlag=%u, lDuration=%d, lSPCost=%d",
-	   GetTablePostfix(),
-	   p->dwPID,
-	   p->elem.dwType,
-	   p->elem.bApplyOn,
-	   p->elem.lApplyValue,
-	   p->elem.dwFlag,
-	   p->elem.lDuration,
-	   p->elem.lSPCost,
-	   p->elem.lApplyValue,
-	   p->elem.dwFlag,
-	   p->elem.lDuration,
-	   p->elem.lSPCost);
-	   */
-	snprintf(queryStr, sizeof(queryStr),
-			"REPLACE INTO affect%s (dwPID, bType, bApplyOn, lApplyValue, dwFlag, lDuration, lSPCost) "
-			"VALUES(%u, %u, %u, %ld, %u, %ld, %ld)",
-			GetTablePostfix(),
-			p->dwPID,
-			p->elem.dwType,
-			p->elem.bApplyOn,
-			static_cast<long>(p->elem.lApplyValue),
-			p->elem.dwFlag,
-			static_cast<long>(p->elem.lDuration),
-			static_cast<long>(p->elem.lSPCost));
-
-	CDBManager::instance().AsyncQuery(queryStr);
+	TPacketGDAddAffect add = *p;
+
+	// 같은 플레이어의 저장과 순서를 맞추기 위해 pid의 샤드에서 쿼리한다.
+	GetShard(p->dwPID)->Post([add]()
+	{
+		char queryStr[QUERY_MAX_LEN];
+		/*
+		   snprintf(queryStr, sizeof(queryStr),
+		   "INSERT INTO affect%s (dwPID, bType, bApplyOn, lApplyValue, dwFlag, lDuration, lSPCost) "
+		   "VALUES(%u, %u, %u, %d, %u, %d, %d) "
+		   "ON DUPLICATE KEY UPDATE lApplyValue=%d, dwFlag=%u, lDuration=%d, lSPCost=%d",
+		   GetTablePostfix(),
+		   add.dwPID,
+		   add.elem.dwType,
+		   add.elem.bApplyOn,
+		   add.elem.lApplyValue,
+		   add.elem.dwFlag,
+		   add.elem.lDuration,
+		   add.elem.lSPCost,
+		   add.elem.lApplyValue,
+		   add.elem.dwFlag,
+		   add.elem.lDuration,
+		   add.elem.lSPCost);
+		   */
+		snprintf(queryStr, sizeof(queryStr),
+				"REPLACE INTO affect%s (dwPID, bType, bApplyOn, lApplyValue, dwFlag, lDuration, lSPCost) "
+				"VALUES(%u, %u, %u, %ld, %u, %ld, %ld)",
+				GetTablePostfix(),
+				add.dwPID,
+				add.elem.dwType,
+				add.elem.bApplyOn,
+				static_cast<long>(add.elem.lApplyValue),
+				add.elem.dwFlag,
+				static_cast<long>(add.elem.lDuration),
+				static_cast<long>(add.elem.lSPCost));
+
+		CDBManager::instance().AsyncQuery(queryStr);
+	});
 }
 
 void CClientManager::QUERY_REMOVE_AFFECT(CPeer * peer, TPacketGDRemoveAffect * p)
 {
-	char queryStr[QUERY_MAX_LEN];
+	TPacketGDRemoveAffect remove = *p;
 
-	snprintf(queryStr, sizeof(queryStr),
-			"DELETE FROM affect%s WHERE dwPID=%u AND bType=%u AND bApplyOn=%u",
-			GetTablePostfix(), p->dwPID, p->dwType, p->bApplyOn);
+	GetShard(p->dwPID)->Post([remove]()
+	{
+		char queryStr[QUERY_MAX_LEN];
 
-	CDBManager::instance().AsyncQuery(queryStr);
+		snprintf(queryStr, sizeof(queryStr),
+				"DELETE FROM affect%s WHERE dwPID=%u AND bType=%u AND bApplyOn=%u",
+				GetTablePostfix(), remove.dwPID, remove.dwType, remove.bApplyOn);
+
+		CDBManager::instance().AsyncQuery(queryStr);
+	});
 }
 
 
@@ -1290,75 +1317,13 @@ void CClientManager::RESULT_HIGHSCORE_REGISTER(CPeer * pkPeer, SQLMsg * msg)
 
 void CClientManager::InsertLogoutPlayer(DWORD pid)
 {
-	TLogoutPlayerMap::iterator it = m_map_logout.find(pid);
-
-	// 존재하지 않을경우 추가
-	if (it != m_map_logout.end())
-	{
-		// 존재할경우 시간만 갱신
-		if (g_log)
-			sys_log(0, "LOGOUT: Update player time pid(%d)", pid);
-
-		it->second->time = time(0);
-		return;
-	}
-		
-	TLogoutPlayer * pLogout = new TLogoutPlayer;
-	pLogout->pid = pid;
-	pLogout->time = time(0);
-	m_map_logout.insert(std::make_pair(pid, pLogout));
-
-	if (g_log)
-		sys_log(0, "LOGOUT: Insert player pid(%d)", pid);
+	CPlayerShard * pkShard = GetShard(pid);
+	pkShard->Post([pkShard, pid]() { pkShard->InsertLogoutPlayer(pid); });
 }
 
 void CClientManager::DeleteLogoutPlayer(DWORD pid)
 {
-	TLogoutPlayerMap::iterator it = m_map_logout.find(pid);
-
-	if (it != m_map_logout.end())
-	{
-		delete it->second;
-		m_map_logout.erase(it);
-	}
-}
-
-extern int g_iLogoutSeconds;
-
-void CClientManager::UpdateLogoutPlayer()
-{
-	time_t now = time(0);
-
-	TLogoutPlayerMap::iterator it = m_map_logout.begin();
-
-	while (it != m_map_logout.end())
-	{
-		TLogoutPlayer* pLogout = it->second;
-
-		if (now - g_iLogoutSeconds > pLogout->time)
-		{
-			FlushItemCacheSet(pLogout->pid);
-			FlushPlayerCacheSet(pLogout->pid);
-
-			delete pLogout;
-			m_map_logout.erase(it++);
-		}
-		else
-			++it;
-	}
-}
-
-void CClientManager::FlushPlayerCacheSet(DWORD pid)
-{
-	TPlayerTableCacheMap::iterator it = m_map_playerCache.find(pid);
-
-	if (it != m_map_playerCache.end())
-	{
-		CPlayerTableCache * c = it->second;
-		m_map_playerCache.erase(it);
-
-		c->Flush();
-		delete c; 
-	}
+	CPlayerShard * pkShard = GetShard(pid);
+	pkShard->Post([pkShard, pid]() { pkShard->DeleteLogoutPlayer(pid); });
 }
 
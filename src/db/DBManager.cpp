@@ -2,6 +2,8 @@
 #include "DBManager.h"
 #include "ClientManager.h"
 
+#include <atomic>
+
 extern std::string g_stLocale;
 
 CDBManager::CDBManager()
@@ -129,7 +131,7 @@ std::unique_ptr<SQLMsg> CDBManager::DirectQuery(const char* c_pszQuery, int iSlo
 }
 
 extern CPacketInfo g_query_info;
-extern int g_query_count[2];
+extern std::atomic<int> g_query_count[2];
 
 void CDBManager::ReturnQuery(const char * c_pszQuery, int iType, IDENT dwIdent, void * udata, int iSlot)
 {
@@ -10,120 +10,214 @@
 
 DWORD g_dwLastCachedItemAwardID = 0;
 ItemAwardManager::ItemAwardManager()
+	: m_iRefreshSeconds(5), m_bLoading(false), m_bReloadRequested(false), m_dwPendingRows(0), m_dwParsedRows(0)
 {
 }
 
 ItemAwardManager::~ItemAwardManager()
 {
+	for (itertype(m_map_award) it = m_map_award.begin(); it != m_map_award.end(); ++it)
+		delete it->second;
+}
+
+void ItemAwardManager::SetRefreshSeconds(int iSeconds)
+{
+	m_iRefreshSeconds = MAX(0, iSeconds);
+	sys_log(0, "ITEM_AWARD_REFRESH_SECONDS: %d%s", m_iRefreshSeconds, m_iRefreshSeconds ? "" : " (on request only)");
 }
 
 void ItemAwardManager::RequestLoad()
 {
+	// 앞의 결과를 다 읽기 전에 또 가져오면 같은 행이 두 번 온다
+	if (m_bLoading)
+	{
+		m_bReloadRequested = true;
+		return;
+	}
+
+	m_bLoading = true;
+	m_bReloadRequested = false;
+
 	char szQuery[QUERY_MAX_LEN];
-	snprintf(szQuery, sizeof(szQuery), "SELECT id,login,vnum,count,socket0,socket1,socket2,mall,why FROM item_award WHERE taken_time IS NULL and id > %d", g_dwLastCachedItemAwardID);
+	snprintf(szQuery, sizeof(szQuery),
+			"SELECT id,login,vnum,count,socket0,socket1,socket2,mall,why FROM item_award "
+			"WHERE taken_time IS NULL and id > %u ORDER BY id LIMIT %d",
+			g_dwLastCachedItemAwardID, LOAD_LIMIT);
 	CDBManager::instance().ReturnQuery(szQuery, QID_ITEM_AWARD_LOAD, 0, NULL);
 }
 
 void ItemAwardManager::Load(SQLMsg * pMsg)
 {
-	MYSQL_RES * pRes = pMsg->Get()->pSQLResult;
-
-	for (uint i = 0; i < pMsg->Get()->uiNumRows; ++i)
+	if (!pMsg->Get()->pSQLResult)
 	{
-		MYSQL_ROW row = mysql_fetch_row(pRes);
-		int col = 0;
+		m_bLoading = false;
+		return;
+	}
 
-		DWORD dwID = 0;
-		str_to_number(dwID, row[col++]);
+	// 캠페인으로 수만 행이 한 번에 올 수 있으므로 펄스마다 나눠서 읽는다
+	m_pkPendingResult.reset(new SQLResult(std::move(*pMsg->Get())));
+	m_dwPendingRows = m_pkPendingResult->uiNumRows;
+	m_dwParsedRows = 0;
 
-		if (m_map_award.find(dwID) != m_map_award.end())
-			continue;
+	Update();
+}
 
-		TItemAward * kData = new TItemAward;
-		memset(kData, 0, sizeof(TItemAward));
+void ItemAwardManager::Update()
+{
+	if (!m_pkPendingResult)
+		return;
 
-		kData->dwID	= dwID;
-		trim_and_lower(row[col++], kData->szLogin, sizeof(kData->szLogin));
-		str_to_number(kData->dwVnum, row[col++]);
-		str_to_number(kData->dwCount, row[col++]);
-		str_to_number(kData->dwSocket0, row[col++]);
-		str_to_number(kData->dwSocket1, row[col++]);
-		str_to_number(kData->dwSocket2, row[col++]);
-		str_to_number(kData->bMall, row[col++]);
+	DWORD dwEnd = MIN(m_dwPendingRows, m_dwParsedRows + LOAD_ROWS_PER_PULSE);
 
-		if (row[col])
-		{
-			strlcpy(kData->szWhy, row[col], sizeof(kData->szWhy));
-			//게임 중에 why콜룸에 변동이 생기면				
-			char* whyStr = kData->szWhy;	//why 콜룸 읽기
-			char cmdStr[100] = "";	//why콜룸에서 읽은 값을 임시 문자열에 복사해둠
-			strcpy(cmdStr,whyStr);	//명령어 얻는 과정에서 토큰쓰면 원본도 토큰화 되기 때문
-			char command[20] = "";
-			strcpy(command,CClientManager::instance().GetCommand(cmdStr));	// command 얻기
-			//sys_err("%d,  %s",pItemAward->dwID,command);
-			if( !(strcmp(command,"GIFT") ))	// command 가 GIFT이면
-			{
-				TPacketItemAwardInfromer giftData;
-				strcpy(giftData.login, kData->szLogin);	//로그인 아이디 복사
-				strcpy(giftData.command, command);					//명령어 복사
-				giftData.vnum = kData->dwVnum;				//아이템 vnum도 복사
-				CClientManager::instance().ForwardPacket(HEADER_DG_ITEMAWARD_INFORMER,&giftData,sizeof(TPacketItemAwardInfromer));
-			}
-		}
+	for (; m_dwParsedRows < dwEnd; ++m_dwParsedRows)
+		Parse(mysql_fetch_row(m_pkPendingResult->pSQLResult));
+
+	if (m_dwParsedRows < m_dwPendingRows)
+		return;
+
+	if (m_dwPendingRows)
+		sys_log(0, "ITEM_AWARD: loaded %u rows, last id %u, %u waiting", m_dwPendingRows, g_dwLastCachedItemAwardID, m_map_award.size());
 
-		m_map_award.insert(std::make_pair(dwID, kData));
+	m_pkPendingResult.reset();
+	m_bLoading = false;
+
+	// LIMIT만큼 왔으면 남은 것이 더 있다
+	if (m_bReloadRequested || m_dwPendingRows >= LOAD_LIMIT)
+		RequestLoad();
+}
+
+void ItemAwardManager::Parse(MYSQL_ROW row)
+{
+	int col = 0;
 
-		printf("ITEM_AWARD load id %u bMall %d \n", kData->dwID, kData->bMall);
-		sys_log(0, "ITEM_AWARD: load id %lu login %s vnum %lu count %u socket %lu", kData->dwID, kData->szLogin, kData->dwVnum, kData->dwCount, kData->dwSocket0);
-		std::set<TItemAward *> & kSet = m_map_kSetAwardByLogin[kData->szLogin];
-		kSet.insert(kData);
+	DWORD dwID = 0;
+	str_to_number(dwID, row[col++]);
 
-		if (dwID > g_dwLastCachedItemAwardID)
-			g_dwLastCachedItemAwardID = dwID;
+	// ORDER BY id 이므로 워터마크는 행마다 올려도 된다
+	if (dwID > g_dwLastCachedItemAwardID)
+		g_dwLastCachedItemAwardID = dwID;
+
+	if (m_map_award.find(dwID) != m_map_award.end())
+		return;
+
+	TItemAward * kData = new TItemAward;
+	memset(kData, 0, sizeof(TItemAward));
+
+	kData->dwID	= dwID;
+	trim_and_lower(row[col++], kData->szLogin, sizeof(kData->szLogin));
+	str_to_number(kData->dwVnum, row[col++]);
+	str_to_number(kData->dwCount, row[col++]);
+	str_to_number(kData->dwSocket0, row[col++]);
+	str_to_number(kData->dwSocket1, row[col++]);
+	str_to_number(kData->dwSocket2, row[col++]);
+	str_to_number(kData->bMall, row[col++]);
+
+	if (row[col])
+	{
+		strlcpy(kData->szWhy, row[col], sizeof(kData->szWhy));
+		//게임 중에 why콜룸에 변동이 생기면
+		char* whyStr = kData->szWhy;	//why 콜룸 읽기
+		char cmdStr[100] = "";	//why콜룸에서 읽은 값을 임시 문자열에 복사해둠
+		strcpy(cmdStr,whyStr);	//명령어 얻는 과정에서 토큰쓰면 원본도 토큰화 되기 때문
+		char command[20] = "";
+		strcpy(command,CClientManager::instance().GetCommand(cmdStr));	// command 얻기
+		//sys_err("%d,  %s",pItemAward->dwID,command);
+		if( !(strcmp(command,"GIFT") ))	// command 가 GIFT이면
+		{
+			TPacketItemAwardInfromer giftData;
+			strcpy(giftData.login, kData->szLogin);	//로그인 아이디 복사
+			strcpy(giftData.command, command);					//명령어 복사
+			giftData.vnum = kData->dwVnum;				//아이템 vnum도 복사
+			CClientManager::instance().ForwardPacket(HEADER_DG_ITEMAWARD_INFORMER,&giftData,sizeof(TPacketItemAwardInfromer));
+		}
 	}
+
+	m_map_award.insert(std::make_pair(dwID, kData));
+
+	sys_log(1, "ITEM_AWARD: load id %lu login %s vnum %lu count %u socket %lu mall %d", kData->dwID, kData->szLogin, kData->dwVnum, kData->dwCount, kData->dwSocket0, kData->bMall);
+	m_map_kQueueByLogin[kData->szLogin].insert(std::make_pair(dwID, kData));
 }
 
-std::set<TItemAward *> * ItemAwardManager::GetByLogin(const char * c_pszLogin)
+ItemAwardManager::TAwardQueue * ItemAwardManager::GetByLogin(const char * c_pszLogin)
 {
-	itertype(m_map_kSetAwardByLogin) it = m_map_kSetAwardByLogin.find(c_pszLogin);
+	itertype(m_map_kQueueByLogin) it = m_map_kQueueByLogin.find(c_pszLogin);
 
-	if (it == m_map_kSetAwardByLogin.end())
+	if (it == m_map_kQueueByLogin.end())
 		return NULL;
 
 	return &it->second;
 }
 
-void ItemAwardManager::Taken(DWORD dwAwardID, DWORD dwItemID)
+void ItemAwardManager::Remove(TItemAward * pkAward)
 {
-	itertype(m_map_award) it = m_map_award.find(dwAwardID);
+	itertype(m_map_kQueueByLogin) it = m_map_kQueueByLogin.find(pkAward->szLogin);
 
-	if (it == m_map_award.end())
+	if (it != m_map_kQueueByLogin.end())
 	{
-		sys_log(0, "ITEM_AWARD: Taken ID not exist %lu", dwAwardID);
-		return;
+		it->second.erase(pkAward->dwID);
+
+		if (it->second.empty())
+			m_map_kQueueByLogin.erase(it);
 	}
 
-	TItemAward * k = it->second;
-	k->bTaken = true;
+	m_map_award.erase(pkAward->dwID);
+	delete pkAward;
+}
+
+void ItemAwardManager::Taken(const std::vector<std::pair<DWORD, DWORD> > & vec_award)
+{
+	if (vec_award.empty())
+		return;
 
 	//
 	// Update taken_time in database to prevent not to give him again.
-	// 
-	char szQuery[QUERY_MAX_LEN];
+	//
+	std::string stCase, stIn;
+	char szBuf[64];
+
+	for (size_t i = 0; i < vec_award.size(); ++i)
+	{
+		snprintf(szBuf, sizeof(szBuf), " WHEN %u THEN %u", vec_award[i].first, vec_award[i].second);
+		stCase += szBuf;
+
+		snprintf(szBuf, sizeof(szBuf), "%s%u", i ? "," : "", vec_award[i].first);
+		stIn += szBuf;
 
-	snprintf(szQuery, sizeof(szQuery), 
-			"UPDATE item_award SET taken_time=NOW(),item_id=%u WHERE id=%u AND taken_time IS NULL", 
-			dwItemID, dwAwardID);
+		itertype(m_map_award) it = m_map_award.find(vec_award[i].first);
 
-	CDBManager::instance().ReturnQuery(szQuery, QID_ITEM_AWARD_TAKEN, 0, NULL);
+		if (it == m_map_award.end())
+		{
+			sys_log(0, "ITEM_AWARD: Taken ID not exist %lu", vec_award[i].first);
+			continue;
+		}
+
+		Remove(it->second);
+	}
+
+	std::string stQuery = "UPDATE item_award SET taken_time=NOW(),item_id=CASE id" + stCase +
+		" END WHERE id IN (" + stIn + ") AND taken_time IS NULL";
+
+	CDBManager::instance().ReturnQuery(stQuery.c_str(), QID_ITEM_AWARD_TAKEN, 0, NULL);
 }
 
-std::map<DWORD, TItemAward *>& ItemAwardManager::GetMapAward()
+void ItemAwardManager::Release(const std::vector<std::pair<DWORD, DWORD> > & vec_award)
 {
-	return m_map_award;
+	for (size_t i = 0; i < vec_award.size(); ++i)
+	{
+		itertype(m_map_award) it = m_map_award.find(vec_award[i].first);
+
+		if (it != m_map_award.end())
+			it->second->bTaken = false;
+	}
 }
 
-std::map<std::string, std::set<TItemAward *> >& ItemAwardManager::GetMapkSetAwardByLogin()
+bool ItemAwardManager::Erase(DWORD dwAwardID)
 {
-	return m_map_kSetAwardByLogin;
-}
\ No newline at end of file
+	itertype(m_map_award) it = m_map_award.find(dwAwardID);
+
+	if (it == m_map_award.end())
+		return false;
+
+	Remove(it->second);
+	return true;
+}
@@ -2,7 +2,8 @@
 #ifndef __INC_ITEM_AWARD_H
 #define __INC_ITEM_AWARD_H
 #include <map>
-#include <set>
+#include <memory>
+#include <vector>
 #include "Peer.h"
 
 typedef struct SItemAward
@@ -15,29 +16,57 @@ typedef struct SItemAward
     DWORD	dwSocket1;
     DWORD	dwSocket2;
     char	szWhy[ITEM_AWARD_WHY_MAX_LEN+1];
-    bool	bTaken;
+    bool	bTaken;		// 창고에 넣는 중이거나 넣었다
     bool	bMall;
 } TItemAward;
 
 class ItemAwardManager : public singleton<ItemAwardManager>
 {
     public:
+	// 한 로그인의 받지 않은 아이템들, ID 순
+	typedef std::map<DWORD, TItemAward *>	TAwardQueue;
+
+	enum
+	{
+	    LOAD_LIMIT		= 10000,	// 한 번의 SELECT로 가져오는 행 수
+	    LOAD_ROWS_PER_PULSE	= 500,		// 한 펄스에 읽는 행 수
+	};
+
 	ItemAwardManager();
 	virtual ~ItemAwardManager();
 
+	void				SetRefreshSeconds(int iSeconds);
+	int				GetRefreshSeconds() const	{ return m_iRefreshSeconds; }
+
+	// 새로 들어온 item_award 행을 가져온다. 가져오는 중이면 끝난 뒤 한 번 더 한다.
 	void				RequestLoad();
 	void				Load(SQLMsg * pMsg);
-	std::set<TItemAward *> *	GetByLogin(const char * c_pszLogin);
+	void				Update();	// 매 펄스, 가져온 결과를 조금씩 읽는다
+
+	TAwardQueue *			GetByLogin(const char * c_pszLogin);
+
+	// 창고에 넣은 것들. taken_time은 한 쿼리로 기록하고 메모리에서 지운다.
+	void				Taken(const std::vector<std::pair<DWORD, DWORD> > & vec_award);	// award id, item id
+	// 넣지 못한 것들은 다시 받을 수 있게 한다.
+	void				Release(const std::vector<std::pair<DWORD, DWORD> > & vec_award);
+	bool				Erase(DWORD dwAwardID);
 
-	void				Taken(DWORD dwAwardID, DWORD dwItemID);
-	// gift notify
-	std::map<DWORD, TItemAward *>& GetMapAward();
-	std::map<std::string, std::set<TItemAward *> >& GetMapkSetAwardByLogin();
     private:
+	void				Parse(MYSQL_ROW row);
+	void				Remove(TItemAward * pkAward);
+
 	// ID, ItemAward pair
 	std::map<DWORD, TItemAward *>			m_map_award;
-	// PID, ItemAward pair
-	std::map<std::string, std::set<TItemAward *> >	m_map_kSetAwardByLogin;
+	// login, ItemAward queue pair
+	std::map<std::string, TAwardQueue>		m_map_kQueueByLogin;
+
+	int				m_iRefreshSeconds;
+	bool				m_bLoading;
+	bool				m_bReloadRequested;
+
+	std::unique_ptr<SQLResult>	m_pkPendingResult;	// 아직 다 읽지 않은 결과
+	DWORD				m_dwPendingRows;
+	DWORD				m_dwParsedRows;
 };
 
 #endif
@@ -224,6 +224,17 @@ int Start()
 		CClientManager::instance().SetCacheFlushCountLimit(dwVal);
 	}
 
+	// 펄스가 TRACE_SPIKE_MS 를 넘으면 최근 TRACE_WINDOW_SEC 초의 트레이스를 TRACE_DIR 에 남긴다
+	int iTraceSpikeMs = 0;
+	int iTraceWindowSec = 3;
+	CConfig::instance().GetValue("TRACE_SPIKE_MS", &iTraceSpikeMs);
+	CConfig::instance().GetValue("TRACE_WINDOW_SEC", &iTraceWindowSec);
+
+	if (!CConfig::instance().GetValue("TRACE_DIR", szBuf, 256))
+		strlcpy(szBuf, "trace", sizeof(szBuf));
+
+	M2_TRACE_SET_TRIGGER(iTraceSpikeMs, iTraceWindowSec, szBuf);
+
 	int iIDStart;
 	if (!CConfig::instance().GetValue("PLAYER_ID_START", &iIDStart))
 	{
@@ -0,0 +1,525 @@
+﻿#include "stdafx.h"
+#include "PlayerShard.h"
+
+#include "ClientManager.h"
+#include "Main.h"
+#include "HB.h"
+#include "Cache.h"
+
+extern bool g_bHotBackup;
+extern int g_test_server;
+extern int g_log;
+extern int g_iLogoutSeconds;
+
+CPlayerShard::CPlayerShard(int iIndex, bool bThread) :
+	m_iIndex(iIndex), m_bEnd(false), m_qwPosted(0), m_qwDone(0), m_qwCurrentTicket(0)
+{
+	if (bThread)
+		m_thread = std::make_unique<std::thread>([this]() { Loop(); });
+}
+
+CPlayerShard::~CPlayerShard()
+{
+	Quit();
+}
+
+uint64_t CPlayerShard::Post(TTask task)
+{
+	if (!m_thread)
+	{
+		m_qwCurrentTicket = ++m_qwPosted;
+		task();
+		m_vec_dwFreedItem.clear();	// a single shard keeps no item index
+		++m_qwDone;
+		return m_qwCurrentTicket;
+	}
+
+	std::lock_guard<std::mutex> lock(m_lockQueue);
+	m_deque_task.push_back(std::make_pair(++m_qwPosted, std::move(task)));
+
+	if (m_deque_task.size() == 1)
+		m_cvQueue.notify_one();
+
+	return m_qwPosted;
+}
+
+void CPlayerShard::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_lockQueue);
+	m_cvIdle.wait(lock, [this]() { return m_qwDone == m_qwPosted; });
+}
+
+void CPlayerShard::Quit()
+{
+	if (!m_thread)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_lockQueue);
+		m_bEnd = true;
+	}
+
+	m_cvQueue.notify_one();
+	m_thread->join();
+	m_thread.reset();
+}
+
+DWORD CPlayerShard::GetQueueLength()
+{
+	std::lock_guard<std::mutex> lock(m_lockQueue);
+	return m_qwPosted - m_qwDone;
+}
+
+void CPlayerShard::Loop()
+{
+	std::deque<std::pair<uint64_t, TTask> > deque_task;
+	std::unique_lock<std::mutex> lock(m_lockQueue);
+
+	while (true)
+	{
+		m_cvQueue.wait(lock, [this]() { return m_bEnd || !m_deque_task.empty(); });
+
+		if (m_deque_task.empty())
+			break;
+
+		deque_task.swap(m_deque_task);
+		lock.unlock();
+
+		{
+			M2_TRACE_SCOPE_ARG("shard_batch", deque_task.size());
+
+			for (size_t i = 0; i < deque_task.size(); ++i)
+			{
+				// per task, so a main thread reader waits for one task at most
+				std::lock_guard<std::mutex> lockCache(m_lockCache);
+
+				m_qwCurrentTicket = deque_task[i].first;
+				deque_task[i].second();
+
+				if (!m_vec_dwFreedItem.empty())
+				{
+					std::vector<DWORD> vec_dwID;
+					vec_dwID.swap(m_vec_dwFreedItem);
+
+					CPlayerShard * pkShard = this;
+					uint64_t qwTicket = m_qwCurrentTicket;
+
+					CClientManager::instance().PostToMain([pkShard, qwTicket, vec_dwID]()
+					{
+						CClientManager::instance().UnindexItems(pkShard, qwTicket, vec_dwID);
+					});
+				}
+			}
+		}
+
+		deque_task.clear();
+
+		lock.lock();
+		m_qwDone = m_qwCurrentTicket;
+
+		if (m_qwDone == m_qwPosted)
+			m_cvIdle.notify_all();
+	}
+}
+
+CPlayerTableCache * CPlayerShard::GetPlayerCache(DWORD id)
+{
+	TPlayerTableCacheMap::iterator it = m_map_playerCache.find(id);
+
+	if (it == m_map_playerCache.end())
+		return NULL;
+
+	TPlayerTable* pTable = it->second->Get(false);
+	pTable->logoff_interval = time(0) - it->second->GetLastUpdateTime();
+	return it->second;
+}
+
+void CPlayerShard::PutPlayerCache(TPlayerTable * pNew)
+{
+	CPlayerTableCache * c;
+
+	c = GetPlayerCache(pNew->id);
+
+	if (!c)
+	{
+		c = new CPlayerTableCache;
+		m_map_playerCache.insert(TPlayerTableCacheMap::value_type(pNew->id, c));
+	}
+
+	if (g_bHotBackup)
+	{
+		DWORD dwPID = pNew->id;
+		CClientManager::instance().PostToMain([dwPID]() { PlayerHB::instance().Put(dwPID); });
+	}
+
+	c->Put(pNew);
+}
+
+void CPlayerShard::FlushPlayerCacheSet(DWORD pid)
+{
+	TPlayerTableCacheMap::iterator it = m_map_playerCache.find(pid);
+
+	if (it != m_map_playerCache.end())
+	{
+		CPlayerTableCache * c = it->second;
+		m_map_playerCache.erase(it);
+
+		c->Flush();
+		delete c;
+	}
+}
+
+void CPlayerShard::ErasePlayerCache(DWORD pid)
+{
+	TPlayerTableCacheMap::iterator it = m_map_playerCache.find(pid);
+
+	if (it != m_map_playerCache.end())
+	{
+		delete it->second;
+		m_map_playerCache.erase(it);
+	}
+}
+
+void CPlayerShard::DeletePlayerCacheSet(DWORD pid)
+{
+	ErasePlayerCache(pid);
+
+	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(pid);
+
+	if (it == m_map_pkItemCacheSetPtr.end())
+		return;
+
+	TItemCacheSet * pSet = it->second;
+	TItemCacheSet::iterator it_set = pSet->begin();
+
+	while (it_set != pSet->end())
+	{
+		CItemCache * pkItemCache = *it_set++;
+		DeleteItemCache(pkItemCache->Get()->id);
+	}
+
+	pSet->clear();
+	delete pSet;
+
+	m_map_pkItemCacheSetPtr.erase(it);
+}
+
+CPlayerShard::TItemCacheSet * CPlayerShard::GetItemCacheSet(DWORD pid)
+{
+	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(pid);
+
+	if (it == m_map_pkItemCacheSetPtr.end())
+		return NULL;
+
+	return it->second;
+}
+
+void CPlayerShard::CreateItemCacheSet(DWORD pid)
+{
+	if (m_map_pkItemCacheSetPtr.find(pid) != m_map_pkItemCacheSetPtr.end())
+		return;
+
+	TItemCacheSet * pSet = new TItemCacheSet;
+	m_map_pkItemCacheSetPtr.insert(TItemCacheSetPtrMap::value_type(pid, pSet));
+
+	if (g_log)
+		sys_log(0, "ITEM_CACHE: new cache %u", pid);
+}
+
+void CPlayerShard::FlushItemCacheSet(DWORD pid)
+{
+	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(pid);
+
+	if (it == m_map_pkItemCacheSetPtr.end())
+	{
+		sys_log(0, "FLUSH_ITEMCACHESET : No ItemCacheSet pid(%d)", pid);
+		return;
+	}
+
+	TItemCacheSet * pSet = it->second;
+	TItemCacheSet::iterator it_set = pSet->begin();
+
+	while (it_set != pSet->end())
+	{
+		CItemCache * c = *it_set++;
+		c->Flush();
+
+		m_map_itemCache.erase(c->Get()->id);
+		FreeItemCache(c);
+	}
+
+	pSet->clear();
+	delete pSet;
+
+	m_map_pkItemCacheSetPtr.erase(it);
+
+	if (g_log)
+		sys_log(0, "FLUSH_ITEMCACHESET : Deleted pid(%d)", pid);
+}
+
+void CPlayerShard::UpdateItemCacheSet(DWORD pid)
+{
+	itertype(m_map_pkItemCacheSetPtr) it = m_map_pkItemCacheSetPtr.find(pid);
+
+	if (it == m_map_pkItemCacheSetPtr.end())
+	{
+		if (g_test_server)
+			sys_log(0, "UPDATE_ITEMCACHESET : UpdateItemCacheSet ==> No ItemCacheSet pid(%d)", pid);
+		return;
+	}
+
+	TItemCacheSet * pSet = it->second;
+	TItemCacheSet::iterator it_set = pSet->begin();
+
+	while (it_set != pSet->end())
+	{
+		CItemCache * c = *it_set++;
+		c->Flush();
+	}
+
+	if (g_log)
+		sys_log(0, "UPDATE_ITEMCACHESET : UpdateItemCachsSet pid(%d)", pid);
+}
+
+CItemCache * CPlayerShard::GetItemCache(DWORD id)
+{
+	TItemCacheMap::iterator it = m_map_itemCache.find(id);
+
+	if (it == m_map_itemCache.end())
+		return NULL;
+
+	return it->second;
+}
+
+void CPlayerShard::PutItemCache(TPlayerItem * pNew, bool bSkipQuery)
+{
+	CItemCache * c;
+
+	c = GetItemCache(pNew->id);
+
+	// 아이템 새로 생성
+	if (!c)
+	{
+		if (g_log)
+			sys_log(0, "ITEM_CACHE: PutItemCache ==> New CItemCache id%d vnum%d new owner%d", pNew->id, pNew->vnum, pNew->owner);
+
+		c = new CItemCache;
+		m_map_itemCache.insert(TItemCacheMap::value_type(pNew->id, c));
+	}
+	// 있을시
+	else
+	{
+		if (g_log)
+			sys_log(0, "ITEM_CACHE: PutItemCache ==> Have Cache");
+		// 소유자가 틀리면
+		if (pNew->owner != c->Get()->owner)
+		{
+			// 이미 이 아이템을 가지고 있었던 유저로 부터 아이템을 삭제한다.
+			TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(c->Get()->owner);
+
+			if (it != m_map_pkItemCacheSetPtr.end())
+			{
+				if (g_log)
+				sys_log(0, "ITEM_CACHE: delete owner %u id %u new owner %u", c->Get()->owner, c->Get()->id, pNew->owner);
+				it->second->erase(c);
+			}
+		}
+	}
+
+	// 새로운 정보 업데이트
+	c->Put(pNew, bSkipQuery);
+
+	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(c->Get()->owner);
+
+	if (it != m_map_pkItemCacheSetPtr.end())
+	{
+		if (g_log)
+			sys_log(0, "ITEM_CACHE: save %u id %u", c->Get()->owner, c->Get()->id);
+		else
+			sys_log(1, "ITEM_CACHE: save %u id %u", c->Get()->owner, c->Get()->id);
+		it->second->insert(c);
+	}
+	else
+	{
+		// 현재 소유자가 없으므로 바로 저장해야 다음 접속이 올 때 SQL에 쿼리하여
+		// 받을 수 있으므로 바로 저장한다.
+		if (g_log)
+			sys_log(0, "ITEM_CACHE: direct save %u id %u", c->Get()->owner, c->Get()->id);
+		else
+			sys_log(1, "ITEM_CACHE: direct save %u id %u", c->Get()->owner, c->Get()->id);
+
+		c->OnFlush();
+	}
+}
+
+bool CPlayerShard::DeleteItemCache(DWORD dwID)
+{
+	CItemCache * c = GetItemCache(dwID);
+
+	if (!c)
+		return false;
+
+	c->Delete();
+	return true;
+}
+
+void CPlayerShard::EraseItemCache(DWORD dwID)
+{
+	CItemCache * c = GetItemCache(dwID);
+
+	if (!c)
+		return;
+
+	TItemCacheSetPtrMap::iterator it = m_map_pkItemCacheSetPtr.find(c->Get()->owner);
+
+	if (it != m_map_pkItemCacheSetPtr.end())
+		it->second->erase(c);
+
+	m_map_itemCache.erase(dwID);
+	FreeItemCache(c);
+}
+
+void CPlayerShard::FreeItemCache(CItemCache * c)
+{
+	m_vec_dwFreedItem.push_back(c->Get(false)->id);
+	delete c;
+}
+
+void CPlayerShard::InsertLogoutPlayer(DWORD pid)
+{
+	TLogoutPlayerMap::iterator it = m_map_logout.find(pid);
+
+	// 존재할경우 시간만 갱신
+	if (it != m_map_logout.end())
+	{
+		if (g_log)
+			sys_log(0, "LOGOUT: Update player time pid(%d)", pid);
+
+		it->second = time(0);
+		return;
+	}
+
+	// 존재하지 않을경우 추가
+	m_map_logout.insert(std::make_pair(pid, time(0)));
+
+	if (g_log)
+		sys_log(0, "LOGOUT: Insert player pid(%d)", pid);
+}
+
+void CPlayerShard::DeleteLogoutPlayer(DWORD pid)
+{
+	m_map_logout.erase(pid);
+}
+
+void CPlayerShard::UpdateLogoutPlayer()
+{
+	time_t now = time(0);
+
+	TLogoutPlayerMap::iterator it = m_map_logout.begin();
+
+	while (it != m_map_logout.end())
+	{
+		DWORD pid = it->first;
+
+		if (now - g_iLogoutSeconds > it->second)
+		{
+			FlushItemCacheSet(pid);
+			FlushPlayerCacheSet(pid);
+
+			m_map_logout.erase(it++);
+		}
+		else
+			++it;
+	}
+}
+
+void CPlayerShard::UpdatePlayerCache()
+{
+	TPlayerTableCacheMap::iterator it = m_map_playerCache.begin();
+
+	while (it != m_map_playerCache.end())
+	{
+		CPlayerTableCache * c = (it++)->second;
+
+		if (c->CheckTimeout())
+		{
+			if (g_log)
+				sys_log(0, "UPDATE : UpdatePlayerCache() ==> FlushPlayerCache %d %s ", c->Get(false)->id, c->Get(false)->name);
+
+			c->Flush();
+
+			// Item Cache도 업데이트
+			UpdateItemCacheSet(c->Get()->id);
+		}
+		else if (c->CheckFlushTimeout())
+			c->Flush();
+	}
+}
+
+void CPlayerShard::UpdateItemCache(int iItemFlushLimit)
+{
+	int iFlushCount = 0;
+
+	TItemCacheMap::iterator it = m_map_itemCache.begin();
+
+	while (it != m_map_itemCache.end())
+	{
+		CItemCache * c = (it++)->second;
+
+		// 아이템은 Flush만 한다.
+		if (c->CheckFlushTimeout())
+		{
+			if (g_test_server)
+				sys_log(0, "UpdateItemCache ==> Flush() vnum %d id owner %d", c->Get()->vnum, c->Get()->id, c->Get()->owner);
+
+			c->Flush();
+
+			if (++iFlushCount >= iItemFlushLimit)
+				break;
+		}
+	}
+}
+
+void CPlayerShard::Update(int iItemFlushLimit)
+{
+	M2_TRACE_SCOPE_ARG("shard_update", m_iIndex);
+
+	//플레이어 플러쉬
+	UpdatePlayerCache();
+	//아이템 플러쉬
+	UpdateItemCache(iItemFlushLimit);
+	//로그아웃시 처리- 캐쉬셋 플러쉬
+	UpdateLogoutPlayer();
+}
+
+void CPlayerShard::FlushAll()
+{
+	itertype(m_map_playerCache) it = m_map_playerCache.begin();
+
+	//플레이어 테이블 캐쉬 플러쉬
+	while (it != m_map_playerCache.end())
+	{
+		CPlayerTableCache * c = (it++)->second;
+
+		c->Flush();
+		delete c;
+	}
+	m_map_playerCache.clear();
+
+	itertype(m_map_itemCache) it2 = m_map_itemCache.begin();
+	//아이템 플러쉬
+	while (it2 != m_map_itemCache.end())
+	{
+		CItemCache * c = (it2++)->second;
+
+		c->Flush();
+		delete c;
+	}
+	m_map_itemCache.clear();
+
+	for (itertype(m_map_pkItemCacheSetPtr) it3 = m_map_pkItemCacheSetPtr.begin(); it3 != m_map_pkItemCacheSetPtr.end(); ++it3)
+		delete it3->second;
+
+	m_map_pkItemCacheSetPtr.clear();
+	m_map_logout.clear();
+}
@@ -0,0 +1,119 @@
+﻿// vim:ts=8 sw=4
+#ifndef __INC_DB_PLAYERSHARD_H__
+#define __INC_DB_PLAYERSHARD_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class CPlayerTableCache;
+class CItemCache;
+
+//
+// One slice (pid % PLAYER_SHARD_COUNT) of the player and item caches, with the
+// worker thread that runs every pid-scoped request for it.
+//
+// Only the main thread posts. Every request of a pid goes to the same shard,
+// so its load, saves and logout run in the order they arrived. Each task
+// carries a ticket, the shard's post count at the time it was posted.
+//
+// A task may only touch its own shard. Peer output and login data go back to
+// the main thread via CClientManager::PostToMain. A task may queue SQL itself
+// (cache flushes, SaveItemToDB, DeleteItemFromDB call CDBManager::ReturnQuery
+// directly): CAsyncSQL locks its query queue, and the results are still popped
+// and handled on the main thread.
+// The main thread may touch a shard directly only after Wait() (nothing is
+// queued or running) or while holding Lock() for a short read.
+//
+// Without worker threads (PLAYER_SHARD_COUNT 0) there is a single shard and
+// Post runs the task on the spot, as the serial code did.
+//
+class CPlayerShard
+{
+    public:
+	typedef std::function<void ()>				TTask;
+
+	typedef std::unordered_map<DWORD, CPlayerTableCache *>	TPlayerTableCacheMap;
+	typedef std::unordered_map<DWORD, CItemCache *>		TItemCacheMap;
+	typedef std::unordered_set<CItemCache *, std::hash<CItemCache*> > TItemCacheSet;
+	typedef std::unordered_map<DWORD, TItemCacheSet *>	TItemCacheSetPtrMap;
+
+	// pid, logout time
+	typedef std::unordered_map<DWORD, time_t>		TLogoutPlayerMap;
+
+    public:
+	CPlayerShard(int iIndex, bool bThread);
+	~CPlayerShard();
+
+	int		GetIndex() const	{ return m_iIndex; }
+
+	uint64_t	Post(TTask task);	// returns the task's ticket
+	void		Wait();
+	std::unique_lock<std::mutex>	Lock()	{ return std::unique_lock<std::mutex>(m_lockCache); }
+	void		Quit();			// runs what is still queued, then joins
+
+	uint64_t	GetCurrentTicket() const	{ return m_qwCurrentTicket; }
+	DWORD		GetQueueLength();
+
+	CPlayerTableCache *	GetPlayerCache(DWORD id);
+	void			PutPlayerCache(TPlayerTable * pNew);
+	void			FlushPlayerCacheSet(DWORD pid);
+	void			ErasePlayerCache(DWORD pid);	// drops it without flushing
+	void			DeletePlayerCacheSet(DWORD pid);	// deleted character: drops it, deletes its items
+
+	void			CreateItemCacheSet(DWORD pid);
+	TItemCacheSet *		GetItemCacheSet(DWORD pid);
+	void			FlushItemCacheSet(DWORD pid);
+	void			UpdateItemCacheSet(DWORD pid);
+
+	CItemCache *		GetItemCache(DWORD id);
+	void			PutItemCache(TPlayerItem * pNew, bool bSkipQuery = false);
+	bool			DeleteItemCache(DWORD id);
+	void			EraseItemCache(DWORD id);	// drops it without flushing
+
+	void			InsertLogoutPlayer(DWORD pid);
+	void			DeleteLogoutPlayer(DWORD pid);
+
+	// once a second: player/item flush timeouts and logged out players
+	void			Update(int iItemFlushLimit);
+	void			FlushAll();
+
+    protected:
+	void			Loop();
+	void			UpdatePlayerCache();
+	void			UpdateItemCache(int iItemFlushLimit);
+	void			UpdateLogoutPlayer();
+	void			FreeItemCache(CItemCache * c);
+
+    private:
+	int				m_iIndex;
+
+	TPlayerTableCacheMap		m_map_playerCache;		// 플레이어 id가 key
+	TItemCacheMap			m_map_itemCache;		// 아이템 id가 key
+	TItemCacheSetPtrMap		m_map_pkItemCacheSetPtr;	// 플레이어 id가 key, 이 플레이어가 어떤 아이템 캐쉬를 가지고 있나?
+	TLogoutPlayerMap		m_map_logout;
+
+	// ids of item caches freed by the current task, handed back to the
+	// main thread's item index when the task ends
+	std::vector<DWORD>		m_vec_dwFreedItem;
+
+	std::unique_ptr<std::thread>	m_thread;
+	bool				m_bEnd;
+
+	std::mutex			m_lockQueue;
+	std::condition_variable		m_cvQueue;
+	std::condition_variable		m_cvIdle;
+	std::deque<std::pair<uint64_t, TTask> >	m_deque_task;
+	uint64_t			m_qwPosted;
+	uint64_t			m_qwDone;
+
+	std::mutex			m_lockCache;	// held while a task runs
+	uint64_t			m_qwCurrentTicket;
+};
+
+#endif
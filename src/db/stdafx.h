@@ -15,5 +15,6 @@
 #include "common/utils.h"
 #include "common/stl.h"
 #include "common/service.h"
+#include "libthecore/trace.h"
 
 #include <memory>
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿#include "stdafx.h"
 #include "affect.h"
+#include "char.h"
 
 CAffect* CAffect::Acquire()
 {
@@ -11,3 +12,104 @@ void CAffect::Release(CAffect* p)
 	M2_DELETE(p);
 }
 
+
+long CAffect::GetDuration() const
+{
+	if (iExpireSlot < 0)
+		return 0;
+
+	return (long) (dwExpireSec - CAffectExpiryWheel::instance().GetCurrentSec());
+}
+
+CAffectExpiryWheel::CAffectExpiryWheel() : m_dwCurrentSec(0), m_dwScheduledCount(0)
+{
+	memset(m_apkSlot, 0, sizeof(m_apkSlot));
+}
+
+void CAffectExpiryWheel::Link(CAffect * pkAff, int iSlot)
+{
+	pkAff->iExpireSlot = iSlot;
+	pkAff->pkExpirePrev = NULL;
+	pkAff->pkExpireNext = m_apkSlot[iSlot];
+
+	if (m_apkSlot[iSlot])
+		m_apkSlot[iSlot]->pkExpirePrev = pkAff;
+
+	m_apkSlot[iSlot] = pkAff;
+}
+
+void CAffectExpiryWheel::Schedule(CAffect * pkAff, long lDuration)
+{
+	Cancel(pkAff);
+
+	// An affect always lives through at least one more tick, as it did when
+	// durations were decremented by the per-character event.
+	if (lDuration < 1)
+		lDuration = 1;
+
+	pkAff->dwExpireSec = m_dwCurrentSec + lDuration;
+
+	if ((DWORD) lDuration < SLOT_COUNT)
+		Link(pkAff, pkAff->dwExpireSec & SLOT_MASK);
+	else
+		Link(pkAff, SLOT_OVERFLOW);
+
+	++m_dwScheduledCount;
+}
+
+void CAffectExpiryWheel::Cancel(CAffect * pkAff)
+{
+	if (pkAff->iExpireSlot < 0)
+		return;
+
+	if (pkAff->pkExpirePrev)
+		pkAff->pkExpirePrev->pkExpireNext = pkAff->pkExpireNext;
+	else
+		m_apkSlot[pkAff->iExpireSlot] = pkAff->pkExpireNext;
+
+	if (pkAff->pkExpireNext)
+		pkAff->pkExpireNext->pkExpirePrev = pkAff->pkExpirePrev;
+
+	pkAff->iExpireSlot = -1;
+	pkAff->pkExpirePrev = pkAff->pkExpireNext = NULL;
+
+	--m_dwScheduledCount;
+}
+
+void CAffectExpiryWheel::Update()
+{
+	++m_dwCurrentSec;
+
+	// Pull overflow entries that now fall inside the wheel before the slot runs.
+	if ((m_dwCurrentSec & SLOT_MASK) == 0)
+	{
+		CAffect * pkAff = m_apkSlot[SLOT_OVERFLOW];
+
+		while (pkAff)
+		{
+			CAffect * pkNext = pkAff->pkExpireNext;
+
+			if (pkAff->dwExpireSec - m_dwCurrentSec < SLOT_COUNT)
+			{
+				Cancel(pkAff);
+				Link(pkAff, pkAff->dwExpireSec & SLOT_MASK);
+				++m_dwScheduledCount;
+			}
+
+			pkAff = pkNext;
+		}
+	}
+
+	CAffect ** ppkSlot = &m_apkSlot[m_dwCurrentSec & SLOT_MASK];
+
+	// The owner may remove or renew other affects while handling this one, so
+	// always detach the current head instead of walking the list.
+	while (*ppkSlot)
+	{
+		CAffect * pkAff = *ppkSlot;
+		Cancel(pkAff);
+
+		if (pkAff->pkOwner)
+			pkAff->pkOwner->ExpireAffect(pkAff);
+	}
+}
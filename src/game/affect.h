@@ -8,13 +8,63 @@ class CAffect
 		BYTE    bApplyOn;
 		long    lApplyValue;
 		DWORD   dwFlag;
-		long	lDuration;
 		long	lSPCost;
 
+		// Expiry is tracked by CAffectExpiryWheel as an absolute second instead
+		// of counting lDuration down every second on every character.
+		LPCHARACTER	pkOwner;
+		DWORD		dwExpireSec;
+		int			iExpireSlot;	// -1 when not scheduled
+		CAffect *	pkExpirePrev;
+		CAffect *	pkExpireNext;
+
+		CAffect() : dwType(0), bApplyOn(0), lApplyValue(0), dwFlag(0), lSPCost(0),
+			pkOwner(NULL), dwExpireSec(0), iExpireSlot(-1), pkExpirePrev(NULL), pkExpireNext(NULL)
+		{
+		}
+
+		long	GetDuration() const;	// remaining seconds
+
 		static CAffect* Acquire();
 		static void Release(CAffect* p);
 };
 
+//
+// One shared timing wheel for every affect on the server.
+// Slots are one second wide; affects further away than the wheel span wait in
+// an overflow list that is cascaded once per revolution, so long buffs cost
+// nothing until they are about to expire.
+//
+class CAffectExpiryWheel : public singleton<CAffectExpiryWheel>
+{
+	public:
+		enum
+		{
+			SLOT_BITS	= 12,
+			SLOT_COUNT	= 1 << SLOT_BITS,	// ~68 minutes
+			SLOT_MASK	= SLOT_COUNT - 1,
+			SLOT_OVERFLOW	= SLOT_COUNT,
+		};
+
+		CAffectExpiryWheel();
+
+		DWORD	GetCurrentSec() const	{ return m_dwCurrentSec; }
+
+		void	Schedule(CAffect * pkAff, long lDuration);
+		void	Cancel(CAffect * pkAff);
+
+		void	Update();	// once per second from heartbeat
+
+		size_t	GetScheduledCount() const	{ return m_dwScheduledCount; }
+
+	private:
+		void	Link(CAffect * pkAff, int iSlot);
+
+		DWORD		m_dwCurrentSec;
+		size_t		m_dwScheduledCount;
+		CAffect *	m_apkSlot[SLOT_COUNT + 1];	// [SLOT_OVERFLOW] is the overflow list
+};
+
 enum EAffectTypes
 {
 	AFFECT_NONE,
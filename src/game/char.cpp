@@ -57,6 +57,12 @@
 #include "PetSystem.h"
 #endif
 #include "DragonSoul.h"
+#include "metrics.h"
+#include "pathfinder.h"
+#include "packet_writer.h"
+
+static quest::CEventFlagRef s_flagArenaPotionLimitCount("arena_potion_limit_count");
+static quest::CEventFlagRef s_flagPoly("poly");
 
 extern const BYTE g_aBuffOnAttrPoints;
 extern bool RaceToJob(unsigned race, unsigned *ret_job);
@@ -192,6 +198,9 @@ void CHARACTER::Initialize()
 
 	memset(&m_points, 0, sizeof(m_points));
 	memset(&m_pointsInstant, 0, sizeof(m_pointsInstant));
+	m_vec_pointContribution.clear();
+	m_set_inventoryVnumCell.clear();
+	memset(&m_mapLink, 0, sizeof(m_mapLink));
 	memset(&m_quickslot, 0, sizeof(m_quickslot));
 
 	m_bCharType = CHAR_TYPE_MONSTER;
@@ -206,6 +215,12 @@ void CHARACTER::Initialize()
 	m_dwLastAttackTime = get_dword_time() - 20000;
 
 	m_bAddChrState = 0;
+	m_bPendingBroadcast = 0;
+	m_bPendingBroadcastClosed = false;
+	m_bIdleHuntingLoaded = false;
+	m_pkFarMove = NULL;
+	m_bFarMovePending = false;
+	m_dwLastFarMoveTime = 0;
 
 	m_pkChrStone = NULL;
 
@@ -313,7 +328,7 @@ void CHARACTER::Initialize()
 
 	// ARENA
 	m_pArena = NULL;
-	m_nPotionLimit = quest::CQuestManager::instance().GetEventFlag("arena_potion_limit_count");
+	m_nPotionLimit = s_flagArenaPotionLimitCount.Get();
 	// END_ARENA
 
 	//PREVENT_TRADE_WINDOW
@@ -413,6 +428,14 @@ void CHARACTER::Destroy()
 		SetDungeon(NULL);
 	}
 
+	if (m_pkFarMove)
+	{
+		M2_DELETE(m_pkFarMove);
+		m_pkFarMove = NULL;
+	}
+
+	m_vec_pkFarMoveSent.clear();
+
 #ifdef __PET_SYSTEM__
 	if (m_petSystem)
 	{
@@ -553,6 +576,9 @@ void CHARACTER::Destroy()
 	if (GetSectree())
 		GetSectree()->RemoveEntity(this);
 
+	if (m_mapLink.pkMap)
+		m_mapLink.pkMap->UnregisterCharacter(this);
+
 	if (m_bMonsterLog)
 		CHARACTER_MANAGER::instance().UnregisterForMonsterLog(this);
 }
@@ -855,48 +881,49 @@ void CHARACTER::EncodeInsertPacket(LPENTITY entity)
 	ch->SendGuildName(GetGuild());
 	// 길드이름 버그 수정 코드
 
-	TPacketGCCharacterAdd pack;
+	// 보는 사람마다 따로 만드는 패킷이므로 출력 버퍼에 바로 만든다.
+	CPacketWriter<TPacketGCCharacterAdd> pack(d);
 
-	pack.header		= HEADER_GC_CHARACTER_ADD;
-	pack.dwVID		= m_vid;
-	pack.bType		= GetCharType();
-	pack.angle		= GetRotation();
-	pack.x		= GetX();
-	pack.y		= GetY();
-	pack.z		= GetZ();
-	pack.wRaceNum	= GetRaceNum();
+	pack->dwVID		= m_vid;
+	pack->bType		= GetCharType();
+	pack->angle		= GetRotation();
+	pack->x		= GetX();
+	pack->y		= GetY();
+	pack->z		= GetZ();
+	pack->wRaceNum	= GetRaceNum();
 	if (IsPet())
 	{
-		pack.bMovingSpeed	= 150;
+		pack->bMovingSpeed	= 150;
 	}
 	else
 	{
-		pack.bMovingSpeed	= GetLimitPoint(POINT_MOV_SPEED);
+		pack->bMovingSpeed	= GetLimitPoint(POINT_MOV_SPEED);
 	}
-	pack.bAttackSpeed	= GetLimitPoint(POINT_ATT_SPEED);
-	pack.dwAffectFlag[0] = m_afAffectFlag.bits[0];
-	pack.dwAffectFlag[1] = m_afAffectFlag.bits[1];
+	pack->bAttackSpeed	= GetLimitPoint(POINT_ATT_SPEED);
+	pack->dwAffectFlag[0] = m_afAffectFlag.bits[0];
+	pack->dwAffectFlag[1] = m_afAffectFlag.bits[1];
 
-	pack.bStateFlag = m_bAddChrState;
+	pack->bStateFlag = m_bAddChrState;
 
 	int iDur = 0;
 
-	if (m_posDest.x != pack.x || m_posDest.y != pack.y)
+	if (m_posDest.x != GetX() || m_posDest.y != GetY())
 	{
 		iDur = (m_dwMoveStartTime + m_dwMoveDuration) - get_dword_time();
 
 		if (iDur <= 0)
 		{
-			pack.x = m_posDest.x;
-			pack.y = m_posDest.y;
+			pack->x = m_posDest.x;
+			pack->y = m_posDest.y;
 		}
 	}
 
-	d->Packet(&pack, sizeof(pack));
+	pack.Commit();
 
 	if (IsPC() == true || m_bCharType == CHAR_TYPE_NPC)
 	{
-		TPacketGCCharacterAdditionalInfo addPacket;
+		CPacketWriter<TPacketGCCharacterAdditionalInfo> w(d);
+		TPacketGCCharacterAdditionalInfo & addPacket = *w;
 		memset(&addPacket, 0, sizeof(TPacketGCCharacterAdditionalInfo));
 
 		addPacket.header = HEADER_GC_CHAR_ADDITIONAL_INFO;
@@ -952,21 +979,19 @@ void CHARACTER::EncodeInsertPacket(LPENTITY entity)
 			addPacket.sAlignment = m_iAlignment / 10;
 		}
 
-		d->Packet(&addPacket, sizeof(TPacketGCCharacterAdditionalInfo));
+		w.Commit();
 	}
 
 	if (iDur)
 	{
-		TPacketGCMove pack;
-		EncodeMovePacket(pack, GetVID(), FUNC_MOVE, 0, m_posDest.x, m_posDest.y, iDur, 0, (BYTE) (GetRotation() / 5));
-		d->Packet(&pack, sizeof(pack));
+		CPacketWriter<TPacketGCMove> pack(d);
+		EncodeMovePacket(*pack, GetVID(), FUNC_MOVE, 0, m_posDest.x, m_posDest.y, iDur, 0, (BYTE) (GetRotation() / 5));
+		pack.Commit();
 
-		TPacketGCWalkMode p;
-		p.vid = GetVID();
-		p.header = HEADER_GC_WALK_MODE;
-		p.mode = m_bNowWalking ? WALKMODE_WALK : WALKMODE_RUN;
-
-		d->Packet(&p, sizeof(p));
+		CPacketWriter<TPacketGCWalkMode> p(d);
+		p->vid = GetVID();
+		p->mode = m_bNowWalking ? WALKMODE_WALK : WALKMODE_RUN;
+		p.Commit();
 	}
 
 	if (entity->IsType(ENTITY_CHARACTER) && GetDesc())
@@ -984,13 +1009,12 @@ void CHARACTER::EncodeInsertPacket(LPENTITY entity)
 
 	if (GetMyShop())
 	{
-		TPacketGCShopSign p;
+		CPacketWriter<TPacketGCShopSign> p(d);
 
-		p.bHeader = HEADER_GC_SHOP_SIGN;
-		p.dwVID = GetVID();
-		strlcpy(p.szSign, m_stShopSign.c_str(), sizeof(p.szSign));
+		p->dwVID = GetVID();
+		strlcpy(p->szSign, m_stShopSign.c_str(), sizeof(p->szSign));
 
-		d->Packet(&p, sizeof(TPacketGCShopSign));
+		p.Commit();
 	}
 
 	if (entity->IsType(ENTITY_CHARACTER))
@@ -1022,6 +1046,157 @@ void CHARACTER::EncodeRemovePacket(LPENTITY entity)
 }
 
 void CHARACTER::UpdatePacket()
+{
+	MarkPendingBroadcast(PENDING_BROADCAST_UPDATE);
+}
+
+void CHARACTER::MarkPendingBroadcast(BYTE bKind)
+{
+	if (m_bPendingBroadcastClosed)
+		return;
+
+	CMetrics::instance().AddBroadcastRequest(bKind);
+	QueuePendingBroadcast(bKind);
+}
+
+void CHARACTER::QueuePendingBroadcast(BYTE bKind)
+{
+	if (m_bPendingBroadcastClosed)
+		return;
+
+	if (!m_bPendingBroadcast)
+		CHARACTER_MANAGER::instance().AddToPendingBroadcast(this);
+
+	m_bPendingBroadcast |= (1 << bKind);
+}
+
+void CHARACTER::FlushPendingBroadcast()
+{
+	BYTE bPending = m_bPendingBroadcast;
+	m_bPendingBroadcast = 0;
+
+	if (IS_SET(bPending, 1 << PENDING_BROADCAST_TARGET))
+	{
+		CMetrics::instance().AddBroadcastSent(PENDING_BROADCAST_TARGET);
+		BroadcastTargetPacket();
+	}
+
+	if (IS_SET(bPending, 1 << PENDING_BROADCAST_PARTY) && GetParty())
+	{
+		CMetrics::instance().AddBroadcastSent(PENDING_BROADCAST_PARTY);
+		GetParty()->SendPartyInfoOneToAll(this);
+	}
+
+	if (IS_SET(bPending, 1 << PENDING_BROADCAST_UPDATE))
+	{
+		CMetrics::instance().AddBroadcastSent(PENDING_BROADCAST_UPDATE);
+		SendUpdatePacket();
+	}
+
+	if (IS_SET(bPending, 1 << PENDING_BROADCAST_POINTS))
+	{
+		CMetrics::instance().AddBroadcastSent(PENDING_BROADCAST_POINTS);
+		PointsPacket();
+	}
+
+	if (IS_SET(bPending, 1 << PENDING_BROADCAST_FAR_MOVE) && m_bFarMovePending)
+	{
+		// 창이 아직 안 끝났으면 다음 pulse 에 다시 본다
+		if (get_dword_time() - m_dwLastFarMoveTime >= g_dwMoveTierFarInterval)
+			FlushFarMovePacket();
+		else
+			QueuePendingBroadcast(PENDING_BROADCAST_FAR_MOVE);
+	}
+}
+
+void CHARACTER::PacketMoveView(const TPacketGCMove & pack)
+{
+	if (!GetSectree())
+		return;
+
+	bool bMergeable = pack.bFunc == FUNC_MOVE || pack.bFunc == FUNC_WAIT;
+
+	if (!bMergeable || m_bIsObserver || g_setMoveTierMapIndex.empty() ||
+			g_setMoveTierMapIndex.find(GetMapIndex() >= 10000 ? GetMapIndex() / 10000 : GetMapIndex()) == g_setMoveTierMapIndex.end())
+	{
+		// 공격/스킬 전에 묵혀 둔 이동을 먼저 보내야 순서가 맞는다
+		FlushFarMovePacket();
+		PacketView(&pack, sizeof(TPacketGCMove), this);
+		return;
+	}
+
+	DWORD dwNow = get_dword_time();
+	bool bFarDue = dwNow - m_dwLastFarMoveTime >= g_dwMoveTierFarInterval;
+
+	// 묵혀 둘 때는 이번 패킷을 이미 받은 관찰자를 기억해 둔다
+	m_vec_pkFarMoveSent.clear();
+
+	for (ENTITY_MAP::iterator it = m_map_view.begin(); it != m_map_view.end(); ++it)
+	{
+		LPENTITY ent = it->first;
+
+		if (!ent->GetDesc())
+			continue;
+
+		if (bFarDue || DISTANCE_APPROX(ent->GetX() - GetX(), ent->GetY() - GetY()) <= g_iMoveTierNearRange)
+		{
+			ent->GetDesc()->Packet(&pack, sizeof(TPacketGCMove));
+
+			if (!bFarDue)
+				m_vec_pkFarMoveSent.push_back(ent);
+		}
+	}
+
+	if (bFarDue)
+	{
+		m_bFarMovePending = false;
+		m_dwLastFarMoveTime = dwNow;
+		return;
+	}
+
+	std::sort(m_vec_pkFarMoveSent.begin(), m_vec_pkFarMoveSent.end());
+
+	if (!m_pkFarMove)
+		m_pkFarMove = M2_NEW TPacketGCMove;
+
+	*m_pkFarMove = pack;
+	CMetrics::instance().AddBroadcastRequest(PENDING_BROADCAST_FAR_MOVE);
+
+	if (!m_bFarMovePending)
+	{
+		m_bFarMovePending = true;
+		QueuePendingBroadcast(PENDING_BROADCAST_FAR_MOVE);
+	}
+}
+
+void CHARACTER::FlushFarMovePacket()
+{
+	if (!m_bFarMovePending)
+		return;
+
+	m_bFarMovePending = false;
+	m_dwLastFarMoveTime = get_dword_time();
+
+	if (!GetSectree())
+		return;
+
+	CMetrics::instance().AddBroadcastSent(PENDING_BROADCAST_FAR_MOVE);
+
+	// 지금 멀리 있는지가 아니라 묵힌 패킷을 받았는지로 고른다. 그 사이에
+	// 다가온 관찰자도 받아야 한다. 새로 들어온 관찰자는 삽입 패킷으로 이미
+	// 지금 위치를 알지만 한 번 더 받아도 해가 없다.
+	for (ENTITY_MAP::iterator it = m_map_view.begin(); it != m_map_view.end(); ++it)
+	{
+		LPENTITY ent = it->first;
+
+		if (ent->GetDesc() && !std::binary_search(m_vec_pkFarMoveSent.begin(), m_vec_pkFarMoveSent.end(), ent))
+			ent->GetDesc()->Packet(m_pkFarMove, sizeof(TPacketGCMove));
+	}
+
+	m_vec_pkFarMoveSent.clear();
+}
+
+void CHARACTER::SendUpdatePacket()
 {
 	if (GetSectree() == NULL) return;
 
@@ -2185,36 +2360,7 @@ void CHARACTER::ComputeBattlePoints()
 		// DEF = LEV + CON + ARMOR
 		int iShowDef = GetLevel() + GetPoint(POINT_HT); // For Ymir(천마)
 		int iDef = GetLevel() + (int) (GetPoint(POINT_HT) / 1.25); // For Other
-		int iArmor = 0;
-
-		LPITEM pkItem;
-
-		for (int i = 0; i < WEAR_MAX_NUM; ++i)
-			if ((pkItem = GetWear(i)) && pkItem->GetType() == ITEM_ARMOR)
-			{
-				if (pkItem->GetSubType() == ARMOR_BODY || pkItem->GetSubType() == ARMOR_HEAD || pkItem->GetSubType() == ARMOR_FOOTS || pkItem->GetSubType() == ARMOR_SHIELD)
-				{
-					iArmor += pkItem->GetValue(1);
-					iArmor += (2 * pkItem->GetValue(5));
-				}
-			}
-
-		// 말 타고 있을 때 방어력이 말의 기준 방어력보다 낮으면 기준 방어력으로 설정
-		if( true == IsHorseRiding() )
-		{
-			if (iArmor < GetHorseArmor())
-				iArmor = GetHorseArmor();
-
-			const char* pHorseName = CHorseNameManager::instance().GetHorseName(GetPlayerID());
-
-			if (pHorseName != NULL && strlen(pHorseName))
-			{
-				iArmor += 20;
-			}
-		}
-
-		iArmor += GetPoint(POINT_DEF_GRADE_BONUS);
-		iArmor += GetPoint(POINT_PARTY_DEFENDER_BONUS);
+		int iArmor = ComputeArmorGrade();
 
 		// INTERNATIONAL_VERSION
 		if (LC_IsYMIR())
@@ -2245,6 +2391,41 @@ void CHARACTER::ComputeBattlePoints()
 	}
 }
 
+int CHARACTER::ComputeArmorGrade()
+{
+	int iArmor = 0;
+
+	LPITEM pkItem;
+
+	for (int i = 0; i < WEAR_MAX_NUM; ++i)
+		if ((pkItem = GetWear(i)) && pkItem->GetType() == ITEM_ARMOR)
+		{
+			if (pkItem->GetSubType() == ARMOR_BODY || pkItem->GetSubType() == ARMOR_HEAD || pkItem->GetSubType() == ARMOR_FOOTS || pkItem->GetSubType() == ARMOR_SHIELD)
+			{
+				iArmor += pkItem->GetValue(1);
+				iArmor += (2 * pkItem->GetValue(5));
+			}
+		}
+
+	// 말 타고 있을 때 방어력이 말의 기준 방어력보다 낮으면 기준 방어력으로 설정
+	if( true == IsHorseRiding() )
+	{
+		if (iArmor < GetHorseArmor())
+			iArmor = GetHorseArmor();
+
+		const char* pHorseName = CHorseNameManager::instance().GetHorseName(GetPlayerID());
+
+		if (pHorseName != NULL && strlen(pHorseName))
+		{
+			iArmor += 20;
+		}
+	}
+
+	iArmor += GetPoint(POINT_DEF_GRADE_BONUS);
+	iArmor += GetPoint(POINT_PARTY_DEFENDER_BONUS);
+	return iArmor;
+}
+
 void CHARACTER::ComputePoints()
 {
 	long lStat = GetPoint(POINT_STAT);
@@ -2254,13 +2435,6 @@ void CHARACTER::ComputePoints()
 	long lSkillHorse = GetPoint(POINT_HORSE_SKILL);
 	long lLevelStep = GetPoint(POINT_LEVEL_STEP);
 
-	long lAttackerBonus = GetPoint(POINT_PARTY_ATTACKER_BONUS);
-	long lTankerBonus = GetPoint(POINT_PARTY_TANKER_BONUS);
-	long lBufferBonus = GetPoint(POINT_PARTY_BUFFER_BONUS);
-	long lSkillMasterBonus = GetPoint(POINT_PARTY_SKILL_MASTER_BONUS);
-	long lHasteBonus = GetPoint(POINT_PARTY_HASTE_BONUS);
-	long lDefenderBonus = GetPoint(POINT_PARTY_DEFENDER_BONUS);
-
 	long lHPRecovery = GetPoint(POINT_HP_RECOVERY);
 	long lSPRecovery = GetPoint(POINT_SP_RECOVERY);
 
@@ -2285,12 +2459,11 @@ void CHARACTER::ComputePoints()
 	SetPart(PART_HEAD, GetOriginalPart(PART_HEAD));
 	SetPart(PART_HAIR, GetOriginalPart(PART_HAIR));
 
-	SetPoint(POINT_PARTY_ATTACKER_BONUS, lAttackerBonus);
-	SetPoint(POINT_PARTY_TANKER_BONUS, lTankerBonus);
-	SetPoint(POINT_PARTY_BUFFER_BONUS, lBufferBonus);
-	SetPoint(POINT_PARTY_SKILL_MASTER_BONUS, lSkillMasterBonus);
-	SetPoint(POINT_PARTY_HASTE_BONUS, lHasteBonus);
-	SetPoint(POINT_PARTY_DEFENDER_BONUS, lDefenderBonus);
+	for (size_t i = 0; i < m_vec_pointContribution.size(); ++i)
+	{
+		const SPointContribution & c = m_vec_pointContribution[i];
+		SetPoint(c.bPointType, GetPoint(c.bPointType) + c.lValue);
+	}
 
 	SetPoint(POINT_HP_RECOVERY, lHPRecovery);
 	SetPoint(POINT_SP_RECOVERY, lSPRecovery);
@@ -2315,7 +2488,7 @@ void CHARACTER::ComputePoints()
 
 			if (NULL != pkSk)
 			{
-				pkSk->SetPointVar("k", 1.0f * GetSkillPower(SKILL_ADD_HP) / 100.0f);
+				pkSk->SetPointVar(SKILL_VAR_K, 1.0f * GetSkillPower(SKILL_ADD_HP) / 100.0f);
 
 				iMaxHP += static_cast<int>(pkSk->kPointPoly.Eval());
 			}
@@ -2439,6 +2612,123 @@ void CHARACTER::ComputePoints()
 	UpdatePacket();
 }
 
+long CHARACTER::GetPointContribution(BYTE bSource, BYTE bPointType) const
+{
+	for (size_t i = 0; i < m_vec_pointContribution.size(); ++i)
+	{
+		const SPointContribution & c = m_vec_pointContribution[i];
+
+		if (c.bSource == bSource && c.bPointType == bPointType)
+			return c.lValue;
+	}
+
+	return 0;
+}
+
+void CHARACTER::SetPointContribution(BYTE bSource, BYTE bPointType, long lValue)
+{
+	long lOldValue = 0;
+	size_t i;
+
+	for (i = 0; i < m_vec_pointContribution.size(); ++i)
+		if (m_vec_pointContribution[i].bSource == bSource && m_vec_pointContribution[i].bPointType == bPointType)
+			break;
+
+	if (i < m_vec_pointContribution.size())
+	{
+		lOldValue = m_vec_pointContribution[i].lValue;
+
+		if (lValue)
+			m_vec_pointContribution[i].lValue = lValue;
+		else
+			m_vec_pointContribution.erase(m_vec_pointContribution.begin() + i);
+	}
+	else if (lValue)
+	{
+		SPointContribution c;
+		c.bSource = bSource;
+		c.bPointType = bPointType;
+		c.lValue = lValue;
+		m_vec_pointContribution.push_back(c);
+	}
+
+	long lDelta = lValue - lOldValue;
+
+	if (!lDelta)
+		return;
+
+	PointChange(bPointType, lDelta);
+	RefreshDependentPoints(bPointType, lDelta);
+	CheckIncrementalPoints(bPointType);
+}
+
+// Mirrors how ComputePoints()/ComputeBattlePoints() consume each point, so a
+// single contribution change does not need a full recompute.
+void CHARACTER::RefreshDependentPoints(BYTE bPointType, long lDelta)
+{
+	switch (bPointType)
+	{
+		case POINT_PARTY_ATTACKER_BONUS:	// read directly by battle.cpp
+		case POINT_PARTY_BUFFER_BONUS:
+			break;
+
+		case POINT_PARTY_TANKER_BONUS:
+			PointChange(POINT_MAX_HP, 0);
+			break;
+
+		case POINT_PARTY_SKILL_MASTER_BONUS:
+			PointChange(POINT_MAX_SP, 0);
+			break;
+
+		case POINT_PARTY_HASTE_BONUS:
+			if (IsPC())
+			{
+				PointChange(POINT_ATT_SPEED, lDelta);
+				UpdatePacket();
+			}
+			break;
+
+		case POINT_PARTY_DEFENDER_BONUS:
+			if (IsPC() && !IsPolymorphed())
+			{
+				int iArmor = ComputeArmorGrade();
+				int iOldArmor = iArmor - lDelta;
+
+				PointChange(POINT_DEF_GRADE, lDelta);
+				PointChange(POINT_MAGIC_DEF_GRADE, iArmor / 2 - iOldArmor / 2);
+			}
+			break;
+
+		default:
+			ComputePoints();
+			break;
+	}
+}
+
+// check_incremental_points: verify the incremental result against a full
+// recompute and log every point that differs.
+void CHARACTER::CheckIncrementalPoints(BYTE bPointType)
+{
+	if (!g_bCheckIncrementalPoints)
+		return;
+
+	long alPoints[POINT_MAX_NUM];
+	thecore_memcpy(alPoints, m_pointsInstant.points, sizeof(alPoints));
+	int iMaxHP = GetMaxHP();
+	int iMaxSP = GetMaxSP();
+
+	ComputePoints();
+
+	for (int i = 0; i < POINT_MAX_NUM; ++i)
+		if (alPoints[i] != m_pointsInstant.points[i])
+			sys_err("INCREMENTAL_POINTS: %s source point %d: point %d incremental %ld full %ld",
+					GetName(), bPointType, i, alPoints[i], m_pointsInstant.points[i]);
+
+	if (iMaxHP != GetMaxHP() || iMaxSP != GetMaxSP())
+		sys_err("INCREMENTAL_POINTS: %s source point %d: max hp %d/%d max sp %d/%d",
+				GetName(), bPointType, iMaxHP, GetMaxHP(), iMaxSP, GetMaxSP());
+}
+
 // m_dwPlayStartTime의 단위는 milisecond다. 데이터베이스에는 분단위로 기록하기
 // 때문에 플레이시간을 계산할 때 / 60000 으로 나눠서 하는데, 그 나머지 값이 남았
 // 을 때 여기에 dwTimeRemain으로 넣어서 제대로 계산되도록 해주어야 한다.
@@ -2945,7 +3235,7 @@ void CHARACTER::SendMovePacket(BYTE bFunc, BYTE bArg, DWORD x, DWORD y, DWORD dw
 	}
 
 	EncodeMovePacket(pack, GetVID(), bFunc, bArg, x, y, dwDuration, dwTime, iRot == -1 ? (int) GetRotation() / 5 : iRot);
-	PacketView(&pack, sizeof(TPacketGCMove), this);
+	PacketMoveView(pack);
 }
 
 int CHARACTER::GetRealPoint(BYTE type) const
@@ -3325,10 +3615,10 @@ void CHARACTER::PointChange(BYTE type, int amount, bool bAmount, bool bBroadcast
 				SetHP(GetHP() + amount);
 				val = GetHP();
 
-				BroadcastTargetPacket();
+				MarkPendingBroadcast(PENDING_BROADCAST_TARGET);
 
 				if (GetParty() && IsPC() && val != prev_hp)
-					GetParty()->SendPartyInfoOneToAll(this);
+					MarkPendingBroadcast(PENDING_BROADCAST_PARTY);
 			}
 			break;
 
@@ -4032,29 +4322,25 @@ void CHARACTER::ChatPacket(BYTE type, const char * format, ...)
 	if (!d || !format)
 		return;
 
-	char chatbuf[CHAT_MAX_LEN + 1];
+	// 문자열을 출력 버퍼의 헤더 뒤에 바로 쓴다.
+	CPacketWriter<TPacketGCChat> pack_chat(d, CHAT_MAX_LEN + 1);
+	char * chatbuf = pack_chat.GetExtra();
 	va_list args;
 
 	va_start(args, format);
-	int len = vsnprintf(chatbuf, sizeof(chatbuf), format, args);
+	int len = vsnprintf(chatbuf, CHAT_MAX_LEN + 1, format, args);
 	va_end(args);
 
-	struct packet_chat pack_chat;
-
-	pack_chat.header    = HEADER_GC_CHAT;
-	pack_chat.size      = sizeof(struct packet_chat) + len;
-	pack_chat.type      = type;
-	pack_chat.id        = 0;
-	pack_chat.bEmpire   = d->GetEmpire();
+	len = MINMAX(0, len, CHAT_MAX_LEN);
 
-	TEMP_BUFFER buf;
-	buf.write(&pack_chat, sizeof(struct packet_chat));
-	buf.write(chatbuf, len);
-
-	d->Packet(buf.read_peek(), buf.size());
+	pack_chat->type      = type;
+	pack_chat->id        = 0;
+	pack_chat->bEmpire   = d->GetEmpire();
 
 	if (type == CHAT_TYPE_COMMAND && test_server)
 		sys_log(0, "SEND_COMMAND %s %s", GetName(), chatbuf);
+
+	pack_chat.Commit(len);
 }
 
 // MINING
@@ -4202,6 +4488,8 @@ void CHARACTER::UpdateStateMachine(DWORD dwPulse)
 	if (IsDead())
 		return;
 
+	M2_TRACE_SCOPE_ARG(IsPC() ? "chr_state_pc" : "chr_state_npc", IsPC() ? GetPlayerID() : GetRaceNum());
+
 	// tw1x1: POS_FIGHTING timer fix
 	if (IsPC() && IsPosition(POS_FIGHTING))
 	{
@@ -5502,9 +5790,7 @@ bool CHARACTER::Return()
 	x = m_pkMobInst->m_posLastAttacked.x;
 	y = m_pkMobInst->m_posLastAttacked.y;
 
-	SetRotationToXY(x, y);
-
-	if (!Goto(x, y))
+	if (!ReturnByPath())
 		return false;
 
 	SendMovePacket(FUNC_WAIT, 0, 0, 0, 0);
@@ -5518,6 +5804,31 @@ bool CHARACTER::Return()
 	return true;
 }
 
+// 마지막 맞은 곳으로 간다. 직선이 막혀 있으면 A* 경로의 다음 지점까지만 가고
+// m_bReturnByPath 를 남겨 idle 상태에서 이어서 간다.
+bool CHARACTER::ReturnByPath()
+{
+	long x = m_pkMobInst->m_posLastAttacked.x;
+	long y = m_pkMobInst->m_posLastAttacked.y;
+
+	m_pkMobInst->m_bReturnByPath = false;
+
+	if (CPathFinder::instance().IsEnabled() && !CPathFinder::instance().IsStraightPath(GetMapIndex(), GetX(), GetY(), x, y))
+	{
+		long sx, sy;
+
+		if (CPathFinder::instance().GetPathStep(GetMapIndex(), GetX(), GetY(), x, y, sx, sy))
+		{
+			m_pkMobInst->m_bReturnByPath = (sx != x || sy != y);
+			x = sx;
+			y = sy;
+		}
+	}
+
+	SetRotationToXY(x, y);
+	return Goto(x, y);
+}
+
 bool CHARACTER::Follow(LPCHARACTER pkChr, float fMinDistance)
 {
 	if (IsPC())
@@ -5659,8 +5970,18 @@ bool CHARACTER::Follow(LPCHARACTER pkChr, float fMinDistance)
 		float fDistToGo = fDist - fMinDistance;
 		GetDeltaByDegree(GetRotation(), fDistToGo, &fx, &fy);
 
+		long dx = GetX() + (int) fx;
+		long dy = GetY() + (int) fy;
+
+		// 막혀 있으면 대상의 flow field 를 따라 돌아간다 (같은 대상을 쫓는 몹끼리 공유)
+		if (CPathFinder::instance().IsEnabled() && !CPathFinder::instance().IsStraightPath(GetMapIndex(), GetX(), GetY(), dx, dy))
+		{
+			if (CPathFinder::instance().GetChaseStep(pkChr->GetVID(), GetMapIndex(), pkChr->GetX(), pkChr->GetY(), GetX(), GetY(), dx, dy))
+				SetRotationToXY(dx, dy);
+		}
+
 		//sys_log(0, "직선으로 이동 %s", GetName());
-		if (!Goto(GetX() + (int) fx, GetY() + (int) fy))
+		if (!Goto(dx, dy))
 			return false;
 	}
 
@@ -6294,7 +6615,7 @@ int CHARACTER::GetPolymorphPower() const
 {
 	if (test_server)
 	{
-		int value = quest::CQuestManager::instance().GetEventFlag("poly");
+		int value = s_flagPoly.Get();
 		if (value)
 			return value;
 	}
@@ -6684,6 +7005,7 @@ void CHARACTER::SyncPacket()
 	buf.write(&pack, sizeof(pack));
 	buf.write(&elem, sizeof(elem));
 
+	FlushFarMovePacket();
 	PacketAround(buf.read_peek(), buf.size());
 }
 
@@ -2,6 +2,8 @@
 #define __INC_METIN_II_CHAR_H__
 
 #include <unordered_map>
+#include <bitset>
+#include <functional>
 
 #include "common/stl.h"
 #include "entity.h"
@@ -288,6 +290,44 @@ enum EPointTypes
 	//POINT_MAX_NUM = 129	common/length.h
 };
 
+enum EInventoryPages
+{
+	INVENTORY_PAGE_COLUMN	= 5,
+	INVENTORY_PAGE_SIZE		= INVENTORY_MAX_NUM / 2,
+	INVENTORY_PAGE_COUNT	= INVENTORY_MAX_NUM / INVENTORY_PAGE_SIZE,
+	DRAGON_SOUL_BOX_COUNT	= (int) DRAGON_SOUL_INVENTORY_MAX_NUM / DRAGON_SOUL_BOX_SIZE,
+};
+
+// Sources kept in the CHARACTER::SetPointContribution ledger. Only party roles
+// are tracked there; the other sources stay outside it:
+// - items: CItem::ModifyPoints already adds/removes the applies on equip and
+//   unequip, together with parts, immune flags and the dragon soul deck.
+// - affects: ComputeAffect adds on attach, but RemoveAffect keeps its full
+//   ComputePoints() on purpose (see the polymorph note there).
+// - horse: riding raises ST/DX/HT/IQ and the armor grade to the horse's floor
+//   (a max, not a sum), so it has no fixed delta; mount/dismount recompute.
+enum EPointSources
+{
+	POINT_SOURCE_PARTY_ROLE,
+	POINT_SOURCE_MAX_NUM
+};
+
+// State packets a character can owe its viewers; CHARACTER::MarkPendingBroadcast
+// records them and CHARACTER_MANAGER::Update sends each once per pulse.
+// Immediate packets sent in the same pulse go out first: a deferred target HP or
+// character update reaches viewers after the HEADER_GC_DEAD/CHARACTER_DEL sent
+// for the same change. Once DestroyCharacter has started, nothing is recorded
+// any more, so a removed character owes nothing.
+enum EPendingBroadcasts
+{
+	PENDING_BROADCAST_TARGET,		// HEADER_GC_TARGET hp% to m_set_pkChrTargetedBy
+	PENDING_BROADCAST_PARTY,		// CParty::SendPartyInfoOneToAll
+	PENDING_BROADCAST_UPDATE,		// HEADER_GC_CHARACTER_UPDATE to the view
+	PENDING_BROADCAST_POINTS,		// HEADER_GC_CHARACTER_POINTS to the owner
+	PENDING_BROADCAST_FAR_MOVE,		// merged HEADER_GC_MOVE to distant viewers, see PacketMoveView
+	PENDING_BROADCAST_MAX_NUM
+};
+
 enum EPKModes
 {
 	PK_MODE_PEACE,
@@ -396,10 +436,12 @@ typedef struct character_point_instant
 
 	LPITEM			pItems[INVENTORY_AND_EQUIP_SLOT_MAX];
 	BYTE			bItemGrid[INVENTORY_AND_EQUIP_SLOT_MAX];
+	uint64_t		qwInventoryPageBits[INVENTORY_PAGE_COUNT];	// occupied cells of bItemGrid, one bit per cell
 
 	// 용혼석 인벤토리.
 	LPITEM			pDSItems[DRAGON_SOUL_INVENTORY_MAX_NUM];
 	WORD			wDSItemGrid[DRAGON_SOUL_INVENTORY_MAX_NUM];
+	uint32_t		dwDSBoxBits[DRAGON_SOUL_BOX_COUNT];			// occupied cells of wDSItemGrid, one bit per cell
 
 	// by mhh
 	LPITEM			pCubeItems[CUBE_MAX_NUM];
@@ -471,6 +513,9 @@ struct TSkillUseInfo
 };
 
 typedef struct packet_party_update TPacketGCPartyUpdate;
+typedef struct packet_move TPacketGCMove;
+struct _SQLMsg;
+typedef struct _SQLMsg SQLMsg;
 class CExchange;
 class CSkillProto;
 class CParty;
@@ -514,7 +559,32 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 
 	public:
 		LPCHARACTER			FindCharacterInView(const char * name, bool bFindPCOnly);
-		void				UpdatePacket();
+		void				UpdatePacket();			// 이번 pulse 끝에 한 번만 보낸다
+		void				SendUpdatePacket();
+
+		void				MarkPendingBroadcast(BYTE bKind);
+		void				FlushPendingBroadcast();
+		bool				IsPendingBroadcast() const	{ return m_bPendingBroadcast != 0; }
+		// DestroyCharacter: 소멸자의 ClearAffect 등이 다시 줄을 서지 않게 막는다
+		void				ClosePendingBroadcast()		{ m_bPendingBroadcastClosed = true; m_bPendingBroadcast = 0; }
+
+		// move_tier_map 맵에서는 move_tier_near_range 밖의 관찰자에게 FUNC_MOVE/FUNC_WAIT 를
+		// move_tier_far_interval 마다 마지막 것만 보낸다. 공격/스킬 패킷은 그대로 다 보낸다.
+		void				PacketMoveView(const TPacketGCMove & pack);
+		void				FlushFarMovePacket();
+
+	protected:
+		void				QueuePendingBroadcast(BYTE bKind);
+
+		BYTE				m_bPendingBroadcast;	// 1 << EPendingBroadcasts
+		bool				m_bPendingBroadcastClosed;
+
+		TPacketGCMove *		m_pkFarMove;			// 처음 묵힐 때 만든다
+		bool				m_bFarMovePending;
+		std::vector<LPENTITY>	m_vec_pkFarMoveSent;		// 묵힌 패킷을 이미 받은 관찰자, 정렬됨. 비교만 하고 따라가지 않는다
+		DWORD				m_dwLastFarMoveTime;
+
+	public:
 
 		//////////////////////////////////////////////////////////////////////////////////
 		// FSM (Finite State Machine) 관련
@@ -605,9 +675,15 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 		bool			ChangeSex();
 
 		DWORD			GetAID() const;
+		// DirectQuery 로 바로 결과를 돌려준다.
 		int				GetChangeEmpireCount() const;
-		void			SetChangeEmpireCount();
 		int				ChangeEmpire(BYTE empire);
+		// 아래는 결과를 ContinueQuery 로 받는다. f 는 캐릭터가 아직 있을 때만 불린다.
+		// 물어볼 계정이 없으면 false 를 돌려주고 f 는 불리지 않는다.
+		bool			LoadChangeEmpireCount(std::function<void (LPCHARACTER, int)> f);
+		void			SetChangeEmpireCount();
+		// 바로 정해지면 그 값을, 아니면 -1 을 돌려주고 결과는 f 로 준다.
+		int				ChangeEmpire(BYTE empire, std::function<void (LPCHARACTER, int)> f);
 
 		BYTE			GetJob() const;
 		BYTE			GetCharType() const;
@@ -622,6 +698,21 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 		bool			IsGoto() const		{ return m_bCharType == CHAR_TYPE_GOTO; }
 //		bool			IsPet() const		{ return m_bCharType == CHAR_TYPE_PET; }
 
+		// Intrusive link into the per-kind character registry of the SECTREE_MAP
+		// this character stands on; maintained by SECTREE_MAP only.
+		struct SMapLink
+		{
+			LPSECTREE_MAP	pkMap;
+			LPCHARACTER		pkPrev;
+			LPCHARACTER		pkNext;
+			DWORD			dwVnum;
+			BYTE			bKind;
+			bool			bAlive;
+		};
+
+		SMapLink &		GetMapLink()			{ return m_mapLink; }
+		const SMapLink &	GetMapLink() const	{ return m_mapLink; }
+
 		DWORD			GetLastShoutPulse() const	{ return m_pointsInstant.dwLastShoutPulse; }
 		void			SetLastShoutPulse(DWORD pulse) { m_pointsInstant.dwLastShoutPulse = pulse; }
 		int				GetLevel() const		{ return m_points.level;	}
@@ -722,7 +813,14 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 		void			ComputePoints();
 		void			ComputeBattlePoints();
 		void			PointChange(BYTE type, int amount, bool bAmount = false, bool bBroadcast = false);
+
+		// Points owned by an independent source (see EPointSources). Changing one
+		// applies only its delta and refreshes the points derived from it;
+		// ComputePoints() replays the ledger instead of recomputing the source.
+		void			SetPointContribution(BYTE bSource, BYTE bPointType, long lValue);
+		long			GetPointContribution(BYTE bSource, BYTE bPointType) const;
 		void			PointsPacket();
+		void			PointsPacketDeferred()		{ MarkPendingBroadcast(PENDING_BROADCAST_POINTS); }
 		void			ApplyPoint(BYTE bApplyType, int iVal);
 		void			CheckMaximumPoints();	// HP, SP 등의 현재 값이 최대값 보다 높은지 검사하고 높다면 낮춘다.
 
@@ -784,6 +882,28 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 
 		CHARACTER_POINT		m_points;
 		CHARACTER_POINT_INSTANT	m_pointsInstant;
+		SMapLink		m_mapLink;
+
+		struct SPointContribution
+		{
+			BYTE	bSource;
+			BYTE	bPointType;
+			long	lValue;
+		};
+
+		std::vector<SPointContribution>	m_vec_pointContribution;
+
+		// (vnum, cell) of every item in the main inventory, so stacking and
+		// counting by vnum do not have to walk all INVENTORY_MAX_NUM cells.
+		typedef std::set<std::pair<DWORD, BYTE> >	TInventoryVnumIndex;
+		TInventoryVnumIndex	m_set_inventoryVnumCell;
+
+		void			SetInventoryCellBit(int iCell, bool bSet);
+		void			SetDragonSoulCellBit(int iCell, bool bSet);
+
+		void			RefreshDependentPoints(BYTE bPointType, long lDelta);
+		void			CheckIncrementalPoints(BYTE bPointType);
+		int				ComputeArmorGrade();
 
 		int				m_iMoveCount;
 		DWORD			m_dwPlayStartTime;
@@ -900,6 +1020,7 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 
 		bool			UpdateAffect();	// called from EVENT
 		int				ProcessAffect();
+		void			ExpireAffect(CAffect * pkAff);	// called from CAffectExpiryWheel
 
 		void			LoadAffect(DWORD dwCount, TPacketAffectElement * pElements);
 		void			SaveAffect();
@@ -913,13 +1034,24 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 		void			RemoveBadAffect();
 
 		CAffect *		FindAffect(DWORD dwType, BYTE bApply=APPLY_NONE) const;
-		const std::list<CAffect *> & GetAffectContainer() const	{ return m_list_pkAffect; }
+		const std::vector<CAffect *> & GetAffectContainer() const	{ return m_vec_pkAffect; }
 		bool			RemoveAffect(CAffect * pkAff);
 
 	protected:
+		void			AttachAffect(CAffect * pkAff, long lDuration);
+		bool			DetachAffect(CAffect * pkAff);
+		void			EndAffect(CAffect * pkAff);
+		bool			IsTickingAffect(const CAffect * pkAff) const;
+		long			GetAffectRenewSeconds(const CAffect * pkAff);
+
+		enum { AFFECT_TYPE_FILTER_SIZE = 1024 };
+
 		bool			m_bIsLoadedAffect;
 		TAffectFlag		m_afAffectFlag;
-		std::list<CAffect *>	m_list_pkAffect;
+		std::vector<CAffect *>	m_vec_pkAffect;
+		// bit (type % AFFECT_TYPE_FILTER_SIZE) is set while an affect of a type
+		// mapping to it exists, so FindAffect misses without scanning
+		std::bitset<AFFECT_TYPE_FILTER_SIZE>	m_bitsetAffectType;
 
 	public:
 		// PARTY_JOIN_BUG_FIX
@@ -1128,6 +1260,7 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 		int				GetEmptyInventoryWithPreference(BYTE size, int preferredCell) const;
 		int				GetEmptyDragonSoulInventory(LPITEM pItem) const;
 		void			CopyDragonSoulItemGrid(std::vector<WORD>& vDragonSoulItemGrid) const;
+		uint64_t		GetInventoryPageBits(int iPage) const	{ return m_pointsInstant.qwInventoryPageBits[iPage]; }
 
 		int				CountEmptyInventory() const;
 
@@ -1465,6 +1598,7 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 
 		bool			Follow(LPCHARACTER pkChr, float fMinimumDistance = 150.0f);
 		bool			Return();
+		bool			ReturnByPath();
 		bool			IsGuardNPC() const;
 		bool			IsChangeAttackPosition(LPCHARACTER target) const;
 		void			ResetChangeAttackPositionTime() { m_dwLastChangeAttackPositionTime = get_dword_time() - AI_CHANGE_ATTACK_POISITION_TIME_NEAR;}
@@ -2058,6 +2192,7 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 	// Idle Hunting System
 	public:
 		void LoadIdleHunting();
+		void OnLoadIdleHunting(SQLMsg * pMsg);
 		void StartIdleHunting(DWORD groupId);
 		void StopIdleHunting();
 		void CalculateIdleRewards();
@@ -2091,6 +2226,7 @@ class CHARACTER : public CEntity, public CFSM, public CHorseRider
 				strcpy(lastResetDate, "2000-01-01");
 			}
 		} m_idleHunting;
+		bool m_bIdleHuntingLoaded;	// OnLoadIdleHunting 전에는 m_idleHunting 이 기본값이므로 저장하면 안 된다
 
 	private:
 		void SaveIdleHunting();
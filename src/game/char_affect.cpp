@@ -44,7 +44,7 @@ void SendAffectAddPacket(LPDESC d, CAffect * pkAff)
 	ptoc.elem.bApplyOn		= pkAff->bApplyOn;
 	ptoc.elem.lApplyValue	= pkAff->lApplyValue;
 	ptoc.elem.dwFlag		= pkAff->dwFlag;
-	ptoc.elem.lDuration		= pkAff->lDuration;
+	ptoc.elem.lDuration		= pkAff->GetDuration();
 	ptoc.elem.lSPCost		= pkAff->lSPCost;
 	d->Packet(&ptoc, sizeof(TPacketGCAffectAdd));
 }
@@ -52,11 +52,12 @@ void SendAffectAddPacket(LPDESC d, CAffect * pkAff)
 // Affect
 CAffect * CHARACTER::FindAffect(DWORD dwType, BYTE bApply) const
 {
-	itertype(m_list_pkAffect) it = m_list_pkAffect.begin();
+	if (!m_bitsetAffectType.test(dwType % AFFECT_TYPE_FILTER_SIZE))
+		return NULL;
 
-	while (it != m_list_pkAffect.end())
+	for (size_t i = 0; i < m_vec_pkAffect.size(); ++i)
 	{
-		CAffect * pkAffect = *it++;
+		CAffect * pkAffect = m_vec_pkAffect[i];
 
 		if (pkAffect->dwType == dwType && (bApply == APPLY_NONE || bApply == pkAffect->bApplyOn))
 			return pkAffect;
@@ -65,6 +66,131 @@ CAffect * CHARACTER::FindAffect(DWORD dwType, BYTE bApply) const
 	return NULL;
 }
 
+void CHARACTER::AttachAffect(CAffect * pkAff, long lDuration)
+{
+	pkAff->pkOwner = this;
+	m_vec_pkAffect.push_back(pkAff);
+	m_bitsetAffectType.set(pkAff->dwType % AFFECT_TYPE_FILTER_SIZE);
+
+	CAffectExpiryWheel::instance().Schedule(pkAff, lDuration);
+}
+
+bool CHARACTER::DetachAffect(CAffect * pkAff)
+{
+	auto it = std::find(m_vec_pkAffect.begin(), m_vec_pkAffect.end(), pkAff);
+
+	if (it == m_vec_pkAffect.end())
+		return false;
+
+	m_vec_pkAffect.erase(it);
+
+	CAffectExpiryWheel::instance().Cancel(pkAff);
+	pkAff->pkOwner = NULL;
+
+	// Other affects may share the filter bit, only clear it when none is left.
+	const DWORD dwBit = pkAff->dwType % AFFECT_TYPE_FILTER_SIZE;
+
+	for (size_t i = 0; i < m_vec_pkAffect.size(); ++i)
+		if (m_vec_pkAffect[i]->dwType % AFFECT_TYPE_FILTER_SIZE == dwBit)
+			return true;
+
+	m_bitsetAffectType.reset(dwBit);
+	return true;
+}
+
+// Detach an affect whose time ran out, without the ComputePoints() done by RemoveAffect.
+// The caller refreshes the packet / maximum points.
+void CHARACTER::EndAffect(CAffect * pkAff)
+{
+	DetachAffect(pkAff);
+	ComputeAffect(pkAff, false);
+
+	if (IsPC())
+	{
+		SendAffectRemovePacket(GetDesc(), GetPlayerID(), pkAff->dwType, pkAff->bApplyOn);
+	}
+
+	CAffect::Release(pkAff);
+}
+
+// Affects that still need the per-character one second event.
+bool CHARACTER::IsTickingAffect(const CAffect * pkAff) const
+{
+	if (pkAff->lSPCost > 0)
+		return true;
+
+	if (pkAff->dwType >= GUILD_SKILL_START && pkAff->dwType <= GUILD_SKILL_END)
+		return true;
+
+	if (pkAff->dwType == AFFECT_AUTO_HP_RECOVERY || pkAff->dwType == AFFECT_AUTO_SP_RECOVERY)
+		return true;
+
+	return pkAff->bApplyOn == POINT_HP_RECOVER_CONTINUE || pkAff->bApplyOn == POINT_SP_RECOVER_CONTINUE;
+}
+
+// Affects bound to an external end time (premium, hair, horse name) are
+// re-validated when their duration runs out instead of every second.
+long CHARACTER::GetAffectRenewSeconds(const CAffect * pkAff)
+{
+	long lEndTime = 0;
+
+	if (pkAff->dwType >= AFFECT_PREMIUM_START && pkAff->dwType <= AFFECT_PREMIUM_END)
+		return MAX(0, GetPremiumRemainSeconds(pkAff->dwType - AFFECT_PREMIUM_START));
+	else if (pkAff->dwType == AFFECT_HAIR)
+		lEndTime = GetQuestFlag("hair.limit_time");
+	else if (pkAff->dwType == AFFECT_HORSE_NAME)
+		lEndTime = GetQuestFlag("horse_name.valid_till");
+	else
+		return 0;
+
+	if (lEndTime < get_global_time())
+		return 0;
+
+	return lEndTime - get_global_time() + 1;
+}
+
+void CHARACTER::ExpireAffect(CAffect * pkAff)
+{
+	long lRenew = GetAffectRenewSeconds(pkAff);
+
+	if (lRenew > 0)
+	{
+		CAffectExpiryWheel::instance().Schedule(pkAff, lRenew);
+		return;
+	}
+
+	switch (pkAff->dwType)
+	{
+		case AFFECT_HAIR:
+			SetPart(PART_HAIR, 0);
+			RemoveAffect(pkAff);
+			return;
+
+		case AFFECT_HORSE_NAME:
+			// re-summons the horse without the name and removes the affect
+			CHorseNameManager::instance().Validate(this);
+
+			if (FindAffect(AFFECT_HORSE_NAME) == pkAff)
+				RemoveAffect(pkAff);
+			return;
+	}
+
+	TAffectFlag afOld = m_afAffectFlag;
+	long lMovSpd = GetPoint(POINT_MOV_SPEED);
+	long lAttSpd = GetPoint(POINT_ATT_SPEED);
+
+	EndAffect(pkAff);
+
+	if (afOld != m_afAffectFlag ||
+			lMovSpd != GetPoint(POINT_MOV_SPEED) ||
+			lAttSpd != GetPoint(POINT_ATT_SPEED))
+	{
+		UpdatePacket();
+	}
+
+	CheckMaximumPoints();
+}
+
 EVENTFUNC(affect_event)
 {
 	char_event_info* info = dynamic_cast<char_event_info*>( event->info );
@@ -155,7 +281,7 @@ bool CHARACTER::UpdateAffect()
 	}
 
 
-	// ProcessAffect는 affect가 없으면 true를 리턴한다.
+	// ProcessAffect returns true when no affect needs the one second tick.
 	if (ProcessAffect())
 		if (GetPoint(POINT_HP_RECOVERY) == 0 && GetPoint(POINT_SP_RECOVERY) == 0 && GetStamina() == GetMaxStamina())
 		{
@@ -183,17 +309,17 @@ void CHARACTER::ClearAffect(bool bSave)
 	WORD	wMovSpd = GetPoint(POINT_MOV_SPEED);
 	WORD	wAttSpd = GetPoint(POINT_ATT_SPEED);
 
-	itertype(m_list_pkAffect) it = m_list_pkAffect.begin();
+	size_t i = 0;
 
-	while (it != m_list_pkAffect.end())
+	while (i < m_vec_pkAffect.size())
 	{
-		CAffect * pkAff = *it;
+		CAffect * pkAff = m_vec_pkAffect[i];
 
 		if (bSave)
 		{
 			if ( IS_NO_CLEAR_ON_DEATH_AFFECT(pkAff->dwType) || IS_NO_SAVE_AFFECT(pkAff->dwType) )
 			{
-				++it;
+				++i;
 				continue;
 			}
 
@@ -205,7 +331,7 @@ void CHARACTER::ClearAffect(bool bSave)
 
 		ComputeAffect(pkAff, false);
 
-		it = m_list_pkAffect.erase(it);
+		DetachAffect(pkAff);
 		CAffect::Release(pkAff);
 	}
 
@@ -216,70 +342,26 @@ void CHARACTER::ClearAffect(bool bSave)
 
 	CheckMaximumPoints();
 
-	if (m_list_pkAffect.empty())
+	if (m_vec_pkAffect.empty())
 		event_cancel(&m_pkAffectEvent);
 }
 
 int CHARACTER::ProcessAffect()
 {
-	bool	bDiff	= false;
-	CAffect	*pkAff	= NULL;
-
-	//
-	// 프리미엄 처리
-	//
-	for (int i = 0; i <= PREMIUM_MAX_NUM; ++i)
-	{
-		int aff_idx = i + AFFECT_PREMIUM_START;
-
-		pkAff = FindAffect(aff_idx);
-
-		if (!pkAff)
-			continue;
-
-		int remain = GetPremiumRemainSeconds(i);
-
-		if (remain < 0)
-		{
-			RemoveAffect(aff_idx);
-			bDiff = true;
-		}
-		else
-			pkAff->lDuration = remain + 1;
-	}
-
-	////////// HAIR_AFFECT
-	pkAff = FindAffect(AFFECT_HAIR);
-	if (pkAff)
-	{
-		// IF HAIR_LIMIT_TIME() < CURRENT_TIME()
-		if ( this->GetQuestFlag("hair.limit_time") < get_global_time())
-		{
-			// SET HAIR NORMAL
-			this->SetPart(PART_HAIR, 0);
-			// REMOVE HAIR AFFECT
-			RemoveAffect(AFFECT_HAIR);
-		}
-		else
-		{
-			// INCREASE AFFECT DURATION
-			++(pkAff->lDuration);
-		}
-	}
-	////////// HAIR_AFFECT
-	//
-
-	CHorseNameManager::instance().Validate(this);
+	bool	bDiff		= false;
+	bool	bTicking	= false;
 
 	TAffectFlag afOld = m_afAffectFlag;
 	long lMovSpd = GetPoint(POINT_MOV_SPEED);
 	long lAttSpd = GetPoint(POINT_ATT_SPEED);
 
-	auto it = m_list_pkAffect.begin();
+	// Durations are handled by CAffectExpiryWheel; only affects with a
+	// per-second cost or condition are looked at here.
+	size_t i = 0;
 
-	while (it != m_list_pkAffect.end())
+	while (i < m_vec_pkAffect.size())
 	{
-		pkAff = *it;
+		CAffect * pkAff = m_vec_pkAffect[i];
 
 		bool bEnd = false;
 
@@ -297,31 +379,17 @@ int CHARACTER::ProcessAffect()
 				PointChange(POINT_SP, -pkAff->lSPCost);
 		}
 
-		// AFFECT_DURATION_BUG_FIX
-		// 무한 효과 아이템도 시간을 줄인다.
-		// 시간을 매우 크게 잡기 때문에 상관 없을 것이라 생각됨.
-		if ( --pkAff->lDuration <= 0 )
-		{
-			bEnd = true;
-		}
-		// END_AFFECT_DURATION_BUG_FIX
-
 		if (bEnd)
 		{
-			it = m_list_pkAffect.erase(it);
-			ComputeAffect(pkAff, false);
+			EndAffect(pkAff);
 			bDiff = true;
-			if (IsPC())
-			{
-				SendAffectRemovePacket(GetDesc(), GetPlayerID(), pkAff->dwType, pkAff->bApplyOn);
-			}
-
-			CAffect::Release(pkAff);
-
 			continue;
 		}
 
-		++it;
+		if (IsTickingAffect(pkAff))
+			bTicking = true;
+
+		++i;
 	}
 
 	if (bDiff)
@@ -336,7 +404,7 @@ int CHARACTER::ProcessAffect()
 		CheckMaximumPoints();
 	}
 
-	if (m_list_pkAffect.empty())
+	if (!bTicking)
 		return true;
 
 	return false;
@@ -346,23 +414,21 @@ void CHARACTER::SaveAffect()
 {
 	TPacketGDAddAffect p;
 
-	itertype(m_list_pkAffect) it = m_list_pkAffect.begin();
-
-	while (it != m_list_pkAffect.end())
+	for (size_t i = 0; i < m_vec_pkAffect.size(); ++i)
 	{
-		CAffect * pkAff = *it++;
+		CAffect * pkAff = m_vec_pkAffect[i];
 
 		if (IS_NO_SAVE_AFFECT(pkAff->dwType))
 			continue;
 
-		sys_log(1, "AFFECT_SAVE: %u %u %d %d", pkAff->dwType, pkAff->bApplyOn, pkAff->lApplyValue, pkAff->lDuration);
+		sys_log(1, "AFFECT_SAVE: %u %u %d %d", pkAff->dwType, pkAff->bApplyOn, pkAff->lApplyValue, pkAff->GetDuration());
 
 		p.dwPID			= GetPlayerID();
 		p.elem.dwType		= pkAff->dwType;
 		p.elem.bApplyOn		= pkAff->bApplyOn;
 		p.elem.lApplyValue	= pkAff->lApplyValue;
 		p.elem.dwFlag		= pkAff->dwFlag;
-		p.elem.lDuration	= pkAff->lDuration;
+		p.elem.lDuration	= pkAff->GetDuration();
 		p.elem.lSPCost		= pkAff->lSPCost;
 		db_clientdesc->DBPacket(HEADER_GD_ADD_AFFECT, 0, &p, sizeof(p));
 	}
@@ -497,15 +563,15 @@ void CHARACTER::LoadAffect(DWORD dwCount, TPacketAffectElement * pElements)
 		}
 
 		CAffect* pkAff = CAffect::Acquire();
-		m_list_pkAffect.push_back(pkAff);
 
 		pkAff->dwType		= pElements->dwType;
 		pkAff->bApplyOn		= pElements->bApplyOn;
 		pkAff->lApplyValue	= pElements->lApplyValue;
 		pkAff->dwFlag		= pElements->dwFlag;
-		pkAff->lDuration	= pElements->lDuration;
 		pkAff->lSPCost		= pElements->lSPCost;
 
+		AttachAffect(pkAff, pElements->lDuration);
+
 		SendAffectAddPacket(GetDesc(), pkAff);
 
 		ComputeAffect(pkAff, true);
@@ -549,6 +615,7 @@ bool CHARACTER::AddAffect(DWORD dwType, BYTE bApplyOn, long lApplyValue, DWORD d
 	}
 
 	CAffect * pkAff = NULL;
+	bool bNew = false;
 
 	if (IsCube)
 		pkAff = FindAffect(dwType,bApplyOn);
@@ -583,8 +650,7 @@ bool CHARACTER::AddAffect(DWORD dwType, BYTE bApplyOn, long lApplyValue, DWORD d
 		// NOTE: 따라서 같은 type 으로도 여러 에펙트를 붙을 수 있다.
 		// 
 		pkAff = CAffect::Acquire();
-		m_list_pkAffect.push_back(pkAff);
-
+		bNew = true;
 	}
 
 	sys_log(1, "AddAffect %s type %d apply %d %d flag %u duration %d", GetName(), dwType, bApplyOn, lApplyValue, dwFlag, lDuration);
@@ -594,9 +660,13 @@ bool CHARACTER::AddAffect(DWORD dwType, BYTE bApplyOn, long lApplyValue, DWORD d
 	pkAff->bApplyOn	= bApplyOn;
 	pkAff->lApplyValue	= lApplyValue;
 	pkAff->dwFlag	= dwFlag;
-	pkAff->lDuration	= lDuration;
 	pkAff->lSPCost	= lSPCost;
 
+	if (bNew)
+		AttachAffect(pkAff, lDuration);
+	else
+		CAffectExpiryWheel::instance().Schedule(pkAff, lDuration);
+
 	WORD wMovSpd = GetPoint(POINT_MOV_SPEED);
 	WORD wAttSpd = GetPoint(POINT_ATT_SPEED);
 
@@ -620,7 +690,7 @@ bool CHARACTER::AddAffect(DWORD dwType, BYTE bApplyOn, long lApplyValue, DWORD d
 		p.elem.bApplyOn		= pkAff->bApplyOn;
 		p.elem.lApplyValue	= pkAff->lApplyValue;
 		p.elem.dwFlag		= pkAff->dwFlag;
-		p.elem.lDuration	= pkAff->lDuration;
+		p.elem.lDuration	= pkAff->GetDuration();
 		p.elem.lSPCost		= pkAff->lSPCost;
 		db_clientdesc->DBPacket(HEADER_GD_ADD_AFFECT, 0, &p, sizeof(p));
 	}
@@ -630,13 +700,8 @@ bool CHARACTER::AddAffect(DWORD dwType, BYTE bApplyOn, long lApplyValue, DWORD d
 
 void CHARACTER::RefreshAffect()
 {
-	itertype(m_list_pkAffect) it = m_list_pkAffect.begin();
-
-	while (it != m_list_pkAffect.end())
-	{
-		CAffect * pkAff = *it++;
-		ComputeAffect(pkAff, true);
-	}
+	for (size_t i = 0; i < m_vec_pkAffect.size(); ++i)
+		ComputeAffect(m_vec_pkAffect[i], true);
 }
 
 void CHARACTER::ComputeAffect(CAffect * pkAff, bool bAdd)
@@ -678,7 +743,7 @@ bool CHARACTER::RemoveAffect(CAffect * pkAff)
 		return false;
 
 	// AFFECT_BUF_FIX
-	m_list_pkAffect.remove(pkAff);
+	DetachAffect(pkAff);
 	// END_OF_AFFECT_BUF_FIX
 
 	ComputeAffect(pkAff, false);
@@ -38,9 +38,12 @@
 #include "threeway_war.h"
 #include "BlueDragon.h"
 #include "DragonLair.h"
+#include "sectree_manager.h"
 #include <random>
 #include <algorithm>
 
+static quest::CEventFlagRef s_flagExpBonusLog("exp_bonus_log");
+
 DWORD AdjustExpByLevel(const LPCHARACTER ch, const DWORD exp)
 {
 	if (PLAYER_EXP_TABLE_MAX < ch->GetLevel())
@@ -1335,6 +1338,11 @@ void CHARACTER::Dead(LPCHARACTER pkKiller, bool bImmediateDead)
 	}
 
 	SetPosition(POS_DEAD);
+
+	// PCs revive in place, so only non-PC deaths leave the map's live counts
+	if (m_mapLink.pkMap && m_mapLink.bKind != MAP_CHARACTER_KIND_PC)
+		m_mapLink.pkMap->OnCharacterDead(this);
+
 	ClearAffect(true);
 
 	if (pkKiller && IsPC())
@@ -1502,10 +1510,8 @@ void CHARACTER::Dead(LPCHARACTER pkKiller, bool bImmediateDead)
 		//
 		// 클라이언트에 에펙트 패킷을 다시 보낸다.
 		//
-		itertype(m_list_pkAffect) it = m_list_pkAffect.begin();
-
-		while (it != m_list_pkAffect.end())
-			SendAffectAddPacket(GetDesc(), *it++);
+		for (size_t i = 0; i < m_vec_pkAffect.size(); ++i)
+			SendAffectAddPacket(GetDesc(), m_vec_pkAffect[i]);
 	}
 
 	//
@@ -1825,7 +1831,7 @@ bool CHARACTER::Damage(LPCHARACTER pAttacker, int dam, EDamageType type) // retu
 
 					if (NULL != pkSk)
 					{
-						pkSk->SetPointVar("k", 1.0f * GetSkillPower(SKILL_RESIST_PENETRATE) / 100.0f);
+						pkSk->SetPointVar(SKILL_VAR_K, 1.0f * GetSkillPower(SKILL_RESIST_PENETRATE) / 100.0f);
 
 						iPenetratePct -= static_cast<int>(pkSk->kPointPoly.Eval());
 					}
@@ -1958,7 +1964,7 @@ bool CHARACTER::Damage(LPCHARACTER pAttacker, int dam, EDamageType type) // retu
 
 				if (NULL != pkSk)
 				{
-					pkSk->SetPointVar("k", 1.0f * GetSkillPower(SKILL_RESIST_PENETRATE) / 100.0f);
+					pkSk->SetPointVar(SKILL_VAR_K, 1.0f * GetSkillPower(SKILL_RESIST_PENETRATE) / 100.0f);
 
 					iPenetratePct -= static_cast<int>(pkSk->kPointPoly.Eval());
 				}
@@ -2562,7 +2568,7 @@ static void GiveExp(LPCHARACTER from, LPCHARACTER to, int iExp)
 
 	if (test_server)
 	{
-		if (quest::CQuestManager::instance().GetEventFlag("exp_bonus_log") && iBaseExp>0)
+		if (s_flagExpBonusLog.Get() && iBaseExp>0)
 			to->ChatPacket(CHAT_TYPE_INFO, "exp bonus %d%%", (iExp-iBaseExp)*100/iBaseExp);
 	}
 
@@ -2691,7 +2697,7 @@ typedef struct SDamageInfo
 
 			if (test_server)
 			{
-				if (quest::CQuestManager::instance().GetEventFlag("exp_bonus_log") && pParty->GetExpBonusPercent())
+				if (s_flagExpBonusLog.Get() && pParty->GetExpBonusPercent())
 					pParty->ChatPacketToAllMember(CHAT_TYPE_INFO, "exp party bonus %d%%", pParty->GetExpBonusPercent());
 			}
 
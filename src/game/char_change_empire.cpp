@@ -6,6 +6,58 @@
 #include "db.h"
 #include "guild_manager.h"
 #include "marriage.h"
+#include "desc.h"
+
+static void AddChangeEmpireCount(DWORD dwAID)
+{
+	DBManager::instance().ContinueQuery(0, 0,
+		[dwAID] (LPCHARACTER, CGuild *, SQLMsg * pMsg)
+		{
+			int count = 0;
+
+			if (pMsg->Get()->uiNumRows > 0)
+			{
+				MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
+				str_to_number(count, row[0]);
+			}
+
+			if (count == 0)
+				DBManager::instance().Query("INSERT INTO change_empire VALUES(%u, %d, NOW())", dwAID, count + 1);
+			else
+				DBManager::instance().Query("UPDATE change_empire SET change_count=%d WHERE account_id=%u", count + 1, dwAID);
+		},
+		"SELECT change_count FROM change_empire WHERE account_id = %u", dwAID);
+}
+
+static int DirectGetChangeEmpireCount(DWORD dwAID)
+{
+	auto pMsg = DBManager::instance().DirectQuery("SELECT change_count FROM change_empire WHERE account_id = %u", dwAID);
+
+	if (pMsg->Get()->uiNumRows == 0)
+		return 0;
+
+	MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
+
+	int count = 0;
+	str_to_number(count, row[0]);
+	return count;
+}
+
+// 계정의 모든 pid 를 vec_dwPID 에, SQL IN 목록을 stIn 에 채운다
+static void GetAccountPIDs(const TAccountTable & c_rTable, std::vector<DWORD> & vec_dwPID, std::string & stIn)
+{
+	char szPID[16];
+
+	for (int i = 0; i < PLAYER_PER_ACCOUNT; ++i)
+	{
+		if (!c_rTable.players[i].dwID)
+			continue;
+
+		vec_dwPID.push_back(c_rTable.players[i].dwID);
+		snprintf(szPID, sizeof(szPID), "%s%u", stIn.empty() ? "" : ",", c_rTable.players[i].dwID);
+		stIn += szPID;
+	}
+}
 
 /*
    Return Value
@@ -21,178 +73,196 @@ int CHARACTER::ChangeEmpire(BYTE empire)
 	if (GetEmpire() == empire)
 		return 1;
 
-	char szQuery[1024+1];
-	DWORD dwAID;
-	DWORD dwPID[4];
-	memset(dwPID, 0, sizeof(dwPID));
+	if (!GetDesc())
+		return 0;
 
-	{
-		// 1. 내 계정의 모든 pid를 얻어 온다
-		snprintf(szQuery, sizeof(szQuery), 
-				"SELECT id, pid1, pid2, pid3, pid4 FROM player_index%s WHERE pid1=%u OR pid2=%u OR pid3=%u OR pid4=%u AND empire=%u", 
-				get_table_postfix(), GetPlayerID(), GetPlayerID(), GetPlayerID(), GetPlayerID(), GetEmpire());
+	// 1. 내 계정의 모든 pid 는 로그인할 때 받은 계정 정보에 있다
+	const TAccountTable & c_rTable = GetDesc()->GetAccountTable();
+	std::vector<DWORD> vec_dwPID;
+	std::string stIn;
+	GetAccountPIDs(c_rTable, vec_dwPID, stIn);
 
-		auto msg = DBManager::instance().DirectQuery(szQuery);
+	if (vec_dwPID.empty())
+		return 0;
+
+	{
+		// 2. 각 캐릭터의 길드 정보를 얻어온다.
+		//   한 캐릭터라도 길드에 가입 되어 있다면, 제국 이동을 할 수 없다.
+		auto pMsg = DBManager::instance().DirectQuery("SELECT guild_id FROM guild_member%s WHERE pid IN (%s)", get_table_postfix(), stIn.c_str());
 
-		if (msg->Get()->uiNumRows == 0)
+		if (pMsg->Get()->pSQLResult)
 		{
-			return 0;
-		}
+			MYSQL_ROW row;
 
-		MYSQL_ROW row = mysql_fetch_row(msg->Get()->pSQLResult);
+			while ((row = mysql_fetch_row(pMsg->Get()->pSQLResult)))
+			{
+				DWORD dwGuildID = 0;
+				str_to_number(dwGuildID, row[0]);
 
-		str_to_number(dwAID, row[0]);
-		str_to_number(dwPID[0], row[1]);
-		str_to_number(dwPID[1], row[2]);
-		str_to_number(dwPID[2], row[3]);
-		str_to_number(dwPID[3], row[4]);
+				if (CGuildManager::instance().FindGuild(dwGuildID))
+					return 2;
+			}
+		}
 	}
 
-	const int loop = 4;
-
+	// 3. 각 캐릭터의 결혼 정보를 얻어온다.
+	//   한 캐릭터라도 결혼 상태라면 제국 이동을 할 수 없다.
+	for (size_t i = 0; i < vec_dwPID.size(); ++i)
 	{
-		// 2. 각 캐릭터의 길드 정보를 얻어온다.
-		//   한 캐릭터라도 길드에 가입 되어 있다면, 제국 이동을 할 수 없다.
-		DWORD dwGuildID[4];
-		CGuild * pGuild[4];
-		
-		for (int i = 0; i < loop; ++i)
-		{
-			snprintf(szQuery, sizeof(szQuery), "SELECT guild_id FROM guild_member%s WHERE pid=%u", get_table_postfix(), dwPID[i]);
+		if (marriage::CManager::instance().IsEngagedOrMarried(vec_dwPID[i]) == true)
+			return 3;
+	}
 
-			auto pMsg = DBManager::instance().DirectQuery(szQuery);
+	// 4. db의 제국 정보를 업데이트 한다.
+	auto msg = DBManager::instance().DirectQuery("UPDATE player_index%s SET empire=%u WHERE pid1=%u OR pid2=%u OR pid3=%u OR pid4=%u AND empire=%u",
+			get_table_postfix(), empire, GetPlayerID(), GetPlayerID(), GetPlayerID(), GetPlayerID(), GetEmpire());
 
-			if (pMsg != NULL)
-			{
-				if (pMsg->Get()->uiNumRows > 0)
-				{
-					MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
+	if (msg->Get()->uiAffectedRows == 0)
+		return 0;
+
+	// 5. 제국 변경 이력을 추가한다.
+	//   바로 뒤에 get_change_empire_count 가 읽어도 맞도록 이것도 기다린다.
+	DWORD dwAID = c_rTable.id;
+	int count = DirectGetChangeEmpireCount(dwAID);
 
-					str_to_number(dwGuildID[i], row[0]);
+	if (count == 0)
+		DBManager::instance().DirectQuery("INSERT INTO change_empire VALUES(%u, %d, NOW())", dwAID, count + 1);
+	else
+		DBManager::instance().DirectQuery("UPDATE change_empire SET change_count=%d WHERE account_id=%u", count + 1, dwAID);
+
+	return 999;
+}
+
+int CHARACTER::ChangeEmpire(BYTE empire, std::function<void (LPCHARACTER, int)> f)
+{
+	if (GetEmpire() == empire)
+		return 1;
+
+	if (!GetDesc())
+		return 0;
 
-					pGuild[i] = CGuildManager::instance().FindGuild(dwGuildID[i]);
+	// 1. 내 계정의 모든 pid 는 로그인할 때 받은 계정 정보에 있다
+	const TAccountTable & c_rTable = GetDesc()->GetAccountTable();
+	std::vector<DWORD> vec_dwPID;
+	std::string stIn;
+	GetAccountPIDs(c_rTable, vec_dwPID, stIn);
 
-					if (pGuild[i] != NULL)
+	if (vec_dwPID.empty())
+		return 0;
+
+	// 2. 각 캐릭터의 길드 정보를 얻어온다.
+	//   한 캐릭터라도 길드에 가입 되어 있다면, 제국 이동을 할 수 없다.
+	DWORD dwAID = c_rTable.id;
+	BYTE bOldEmpire = GetEmpire();
+
+	DBManager::instance().ContinueQuery(GetPlayerID(), 0,
+		[f, vec_dwPID, dwAID, bOldEmpire, empire] (LPCHARACTER ch, CGuild *, SQLMsg * pMsg)
+		{
+			if (pMsg->Get()->pSQLResult)
+			{
+				MYSQL_ROW row;
+
+				while ((row = mysql_fetch_row(pMsg->Get()->pSQLResult)))
+				{
+					DWORD dwGuildID = 0;
+					str_to_number(dwGuildID, row[0]);
+
+					if (CGuildManager::instance().FindGuild(dwGuildID))
 					{
-						return 2;
+						f(ch, 2);
+						return;
 					}
 				}
-				else
+			}
+
+			// 3. 각 캐릭터의 결혼 정보를 얻어온다.
+			//   한 캐릭터라도 결혼 상태라면 제국 이동을 할 수 없다.
+			for (size_t i = 0; i < vec_dwPID.size(); ++i)
+			{
+				if (marriage::CManager::instance().IsEngagedOrMarried(vec_dwPID[i]) == true)
 				{
-					dwGuildID[i] = 0;
-					pGuild[i] = NULL;
+					f(ch, 3);
+					return;
 				}
 			}
-		}
-	}
 
-	{
-		// 3. 각 캐릭터의 결혼 정보를 얻어온다.
-		//   한 캐릭터라도 결혼 상태라면 제국 이동을 할 수 없다.
-		for (int i = 0; i < loop; ++i)
-		{
-			if (marriage::CManager::instance().IsEngagedOrMarried(dwPID[i]) == true)
-				return 3;
-		}
-	}
-	
-	{
-		// 4. db의 제국 정보를 업데이트 한다.
-		snprintf(szQuery, sizeof(szQuery), "UPDATE player_index%s SET empire=%u WHERE pid1=%u OR pid2=%u OR pid3=%u OR pid4=%u AND empire=%u", 
-				get_table_postfix(), empire, GetPlayerID(), GetPlayerID(), GetPlayerID(), GetPlayerID(), GetEmpire());
+			// 4. db의 제국 정보를 업데이트 한다.
+			//   나가도 변경 이력은 남겨야 하므로 캐릭터에 묶지 않는다.
+			DWORD dwPID = ch->GetPlayerID();
 
-		auto msg = DBManager::instance().DirectQuery(szQuery);
+			DBManager::instance().ContinueQuery(0, 0,
+				[f, dwPID, dwAID] (LPCHARACTER, CGuild *, SQLMsg * pMsg)
+				{
+					int iResult = 0;
 
-		if (msg->Get()->uiAffectedRows > 0)
-		{
-			// 5. 제국 변경 이력을 추가한다.
-			SetChangeEmpireCount();
+					if (pMsg->Get()->uiAffectedRows > 0)
+					{
+						// 5. 제국 변경 이력을 추가한다.
+						AddChangeEmpireCount(dwAID);
+						iResult = 999;
+					}
 
-			return 999;
-		}
-	}
+					LPCHARACTER ch = CHARACTER_MANAGER::instance().FindByPID(dwPID);
+
+					if (ch)
+						f(ch, iResult);
+				},
+				"UPDATE player_index%s SET empire=%u WHERE pid1=%u OR pid2=%u OR pid3=%u OR pid4=%u AND empire=%u",
+				get_table_postfix(), empire, dwPID, dwPID, dwPID, dwPID, bOldEmpire);
+		},
+		"SELECT guild_id FROM guild_member%s WHERE pid IN (%s)", get_table_postfix(), stIn.c_str());
 
-	return 0;
+	return -1;
 }
 
 int CHARACTER::GetChangeEmpireCount() const
 {
-	char szQuery[1024+1];
 	DWORD dwAID = GetAID();
 
 	if (dwAID == 0)
 		return 0;
 
-	snprintf(szQuery, sizeof(szQuery), "SELECT change_count FROM change_empire WHERE account_id = %u", dwAID);
-
-	auto pMsg = DBManager::instance().DirectQuery(szQuery);
+	return DirectGetChangeEmpireCount(dwAID);
+}
 
-	if (pMsg != NULL)
-	{
-		if (pMsg->Get()->uiNumRows == 0)
-		{
-			return 0;
-		}
+bool CHARACTER::LoadChangeEmpireCount(std::function<void (LPCHARACTER, int)> f)
+{
+	DWORD dwAID = GetAID();
 
-		MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
+	if (dwAID == 0)
+		return false;
 
-		DWORD count = 0;
-		str_to_number(count, row[0]);
+	DBManager::instance().ContinueQuery(GetPlayerID(), 0,
+		[f] (LPCHARACTER ch, CGuild *, SQLMsg * pMsg)
+		{
+			DWORD count = 0;
 
-		return count;
-	}
+			if (pMsg->Get()->uiNumRows > 0)
+			{
+				MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
+				str_to_number(count, row[0]);
+			}
 
-	return 0;
+			f(ch, count);
+		},
+		"SELECT change_count FROM change_empire WHERE account_id = %u", dwAID);
+	return true;
 }
 
 void CHARACTER::SetChangeEmpireCount()
 {
-	char szQuery[1024+1];
-
 	DWORD dwAID = GetAID();
 
 	if (dwAID == 0) return;
 
-	int count = GetChangeEmpireCount();
-
-	if (count == 0)
-	{
-		count++;
-		snprintf(szQuery, sizeof(szQuery), "INSERT INTO change_empire VALUES(%u, %d, NOW())", dwAID, count);
-	}
-	else
-	{
-		count++;
-		snprintf(szQuery, sizeof(szQuery), "UPDATE change_empire SET change_count=%d WHERE account_id=%u", count, dwAID);
-	}
-
-	DBManager::instance().DirectQuery(szQuery);
+	AddChangeEmpireCount(dwAID);
 }
 
 DWORD CHARACTER::GetAID() const
 {
-	char szQuery[1024+1];
-	DWORD dwAID = 0;
-
-	snprintf(szQuery, sizeof(szQuery), "SELECT id FROM player_index%s WHERE pid1=%u OR pid2=%u OR pid3=%u OR pid4=%u AND empire=%u", 
-			get_table_postfix(), GetPlayerID(), GetPlayerID(), GetPlayerID(), GetPlayerID(), GetEmpire());
-
-	auto pMsg = DBManager::instance().DirectQuery(szQuery);
-
-	if (pMsg)
-	{
-		if (pMsg->Get()->uiNumRows == 0)
-			return 0;
-
-		MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
-
-		str_to_number(dwAID, row[0]);
-
-		return dwAID;
-	}
-	else
-	{
+	// 로그인할 때 받은 계정 정보에 있으므로 player_index 를 다시 읽지 않는다
+	if (!GetDesc())
 		return 0;
-	}
-}
 
+	return GetDesc()->GetAccountTable().id;
+}
@@ -21,11 +21,17 @@ void CHARACTER::LoadIdleHunting()
     if (!IsPC())
         return;
 
-    std::unique_ptr<SQLMsg> pMsg(DBManager::instance().DirectQuery(
+    DBManager::instance().ContinueQuery(GetPlayerID(), 0,
+        [] (LPCHARACTER ch, CGuild *, SQLMsg * pMsg) { ch->OnLoadIdleHunting(pMsg); },
         "SELECT mob_group_id, start_time, end_time, last_claim_time, total_time_today, last_reset_date, is_active, max_daily_seconds "
         "FROM idle_hunting WHERE pid = %u", 
-        GetPlayerID()));
-    
+        GetPlayerID());
+}
+
+void CHARACTER::OnLoadIdleHunting(SQLMsg * pMsg)
+{
+    m_bIdleHuntingLoaded = true;
+
     if (pMsg->Get()->uiNumRows > 0)
     {
         MYSQL_ROW row = mysql_fetch_row(pMsg->Get()->pSQLResult);
@@ -109,6 +115,14 @@ void CHARACTER::StartIdleHunting(DWORD groupId)
         return;
     }
 
+    // 아직 불러오지 않았으면 기존 설정을 모르므로 받지 않는다
+    if (!m_bIdleHuntingLoaded)
+    {
+        sys_log(0, "IDLE_HUNT: Not loaded yet for player %u, returning", GetPlayerID());
+        ChatPacket(CHAT_TYPE_INFO, LC_TEXT("IDLE_HUNT_SYSTEM_ERROR"));
+        return;
+    }
+
     const IdleHuntingGroup* group = CIdleHuntingManager::instance().GetGroup(groupId);
     if (!group)
     {
@@ -550,6 +564,13 @@ void CHARACTER::SaveIdleHunting()
         sys_log(0, "IDLE_HUNT_SAVE: Early return - not a PC");
         return;
     }
+
+    // 불러오기 전에 끊기면 기본값으로 행을 덮어써 하루 사용량이 초기화된다
+    if (!m_bIdleHuntingLoaded)
+    {
+        sys_log(0, "IDLE_HUNT_SAVE: Early return - not loaded yet for player %u", GetPlayerID());
+        return;
+    }
     
     sys_log(0, "IDLE_HUNT_SAVE: IsPC check passed, building query");
 
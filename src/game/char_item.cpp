@@ -2,6 +2,7 @@
 
 #include <stack>
 
+#include "libgame/grid.h"
 #include "utils.h"
 #include "config.h"
 #include "char.h"
@@ -295,6 +296,8 @@ void CHARACTER::SetItem(TItemPos Cell, LPITEM pItem)
 			{
 				if (wCell < INVENTORY_MAX_NUM)
 				{
+					m_set_inventoryVnumCell.erase(std::make_pair(pOld->GetVnum(), (BYTE) wCell));
+
 					for (int i = 0; i < pOld->GetSize(); ++i)
 					{
 						int p = wCell + (i * 5);
@@ -306,6 +309,7 @@ void CHARACTER::SetItem(TItemPos Cell, LPITEM pItem)
 							continue;
 
 						m_pointsInstant.bItemGrid[p] = 0;
+						SetInventoryCellBit(p, false);
 					}
 				}
 				else
@@ -316,6 +320,8 @@ void CHARACTER::SetItem(TItemPos Cell, LPITEM pItem)
 			{
 				if (wCell < INVENTORY_MAX_NUM)
 				{
+					m_set_inventoryVnumCell.insert(std::make_pair(pItem->GetVnum(), (BYTE) wCell));
+
 					for (int i = 0; i < pItem->GetSize(); ++i)
 					{
 						int p = wCell + (i * 5);
@@ -326,6 +332,7 @@ void CHARACTER::SetItem(TItemPos Cell, LPITEM pItem)
 						// wCell + 1 로 하는 것은 빈곳을 체크할 때 같은
 						// 아이템은 예외처리하기 위함
 						m_pointsInstant.bItemGrid[p] = wCell + 1;
+						SetInventoryCellBit(p, true);
 					}
 				}
 				else
@@ -355,6 +362,7 @@ void CHARACTER::SetItem(TItemPos Cell, LPITEM pItem)
 							continue;
 
 						m_pointsInstant.wDSItemGrid[p] = 0;
+						SetDragonSoulCellBit(p, false);
 					}
 				}
 				else
@@ -381,6 +389,7 @@ void CHARACTER::SetItem(TItemPos Cell, LPITEM pItem)
 						// wCell + 1 로 하는 것은 빈곳을 체크할 때 같은
 						// 아이템은 예외처리하기 위함
 						m_pointsInstant.wDSItemGrid[p] = wCell + 1;
+						SetDragonSoulCellBit(p, true);
 					}
 				}
 				else
@@ -685,13 +694,40 @@ bool CHARACTER::IsEmptyItemGrid(TItemPos Cell, BYTE bSize, int iExceptionCell) c
 	}
 }
 
+void CHARACTER::SetInventoryCellBit(int iCell, bool bSet)
+{
+	uint64_t qwBit = (uint64_t) 1 << (iCell % INVENTORY_PAGE_SIZE);
+
+	if (bSet)
+		m_pointsInstant.qwInventoryPageBits[iCell / INVENTORY_PAGE_SIZE] |= qwBit;
+	else
+		m_pointsInstant.qwInventoryPageBits[iCell / INVENTORY_PAGE_SIZE] &= ~qwBit;
+}
+
+void CHARACTER::SetDragonSoulCellBit(int iCell, bool bSet)
+{
+	uint32_t dwBit = (uint32_t) 1 << (iCell % DRAGON_SOUL_BOX_SIZE);
+
+	if (bSet)
+		m_pointsInstant.dwDSBoxBits[iCell / DRAGON_SOUL_BOX_SIZE] |= dwBit;
+	else
+		m_pointsInstant.dwDSBoxBits[iCell / DRAGON_SOUL_BOX_SIZE] &= ~dwBit;
+}
+
 int CHARACTER::GetEmptyInventory(BYTE size) const
 {
 	// NOTE: 현재 이 함수는 아이템 지급, 획득 등의 행위를 할 때 인벤토리의 빈 칸을 찾기 위해 사용되고 있는데,
 	//		벨트 인벤토리는 특수 인벤토리이므로 검사하지 않도록 한다. (기본 인벤토리: INVENTORY_MAX_NUM 까지만 검사)
-	for ( int i = 0; i < INVENTORY_MAX_NUM; ++i)
-		if (IsEmptyItemGrid(TItemPos (INVENTORY, i), size))
-			return i;
+	// Each page is one 45-bit board, so the first cell with `size` free cells
+	// stacked below it is a couple of shifts and a countr_zero.
+	for (int iPage = 0; iPage < INVENTORY_PAGE_COUNT; ++iPage)
+	{
+		int iCell = FindBlankColumnBits(m_pointsInstant.qwInventoryPageBits[iPage], INVENTORY_PAGE_SIZE, INVENTORY_PAGE_COLUMN, size);
+
+		if (iCell >= 0)
+			return iPage * INVENTORY_PAGE_SIZE + iCell;
+	}
+
 	return -1;
 }
 
@@ -722,11 +758,13 @@ int CHARACTER::GetEmptyDragonSoulInventory(LPITEM pItem) const
 	if (WORD_MAX == wBaseCell)
 		return -1;
 
-	for (int i = 0; i < DRAGON_SOUL_BOX_SIZE; ++i)
-		if (IsEmptyItemGrid(TItemPos(DRAGON_SOUL_INVENTORY, i + wBaseCell), bSize))
-			return i + wBaseCell;
+	// Dragon soul stones take one cell, so the search never needs to leave the box.
+	int iCell = FindBlankColumnBits(m_pointsInstant.dwDSBoxBits[wBaseCell / DRAGON_SOUL_BOX_SIZE], DRAGON_SOUL_BOX_SIZE, DRAGON_SOUL_BOX_COLUMN_NUM, bSize);
 
-	return -1;
+	if (iCell < 0)
+		return -1;
+
+	return wBaseCell + iCell;
 }
 
 void CHARACTER::CopyDragonSoulItemGrid(std::vector<WORD>& vDragonSoulItemGrid) const
@@ -6449,10 +6487,11 @@ int CHARACTER::CountSpecifyItem(DWORD vnum) const
 	int	count = 0;
 	LPITEM item;
 
-	for (int i = 0; i < INVENTORY_MAX_NUM; ++i)
+	for (TInventoryVnumIndex::const_iterator it = m_set_inventoryVnumCell.lower_bound(std::make_pair(vnum, (BYTE) 0));
+			it != m_set_inventoryVnumCell.end() && it->first == vnum; ++it)
 	{
-		item = GetInventoryItem(i);
-		if (NULL != item && item->GetVnum() == vnum)
+		item = GetInventoryItem(it->second);
+		if (NULL != item)
 		{
 			// 개인 상점에 등록된 물건이면 넘어간다.
 			if (m_pkMyShop && m_pkMyShop->IsSellingItem(item->GetID()))
@@ -6474,8 +6513,17 @@ void CHARACTER::RemoveSpecifyItem(DWORD vnum, DWORD count)
 	if (0 == count)
 		return;
 
-	for (UINT i = 0; i < INVENTORY_MAX_NUM; ++i)
+	// SetCount(0) removes the item and its index entry, so walk a copy of the cells
+	std::vector<BYTE> vecCells;
+
+	for (TInventoryVnumIndex::const_iterator it = m_set_inventoryVnumCell.lower_bound(std::make_pair(vnum, (BYTE) 0));
+			it != m_set_inventoryVnumCell.end() && it->first == vnum; ++it)
+		vecCells.push_back(it->second);
+
+	for (size_t n = 0; n < vecCells.size(); ++n)
 	{
+		BYTE i = vecCells[n];
+
 		if (NULL == GetInventoryItem(i))
 			continue;
 
@@ -6645,14 +6693,15 @@ LPITEM CHARACTER::AutoGiveItem(DWORD dwItemVnum, BYTE bCount, int iRarePct, bool
 		// Skip stacking logic for infinite potions
 		if (dwItemVnum != 27200 && dwItemVnum != 27201)
 		{
-			for (int i = 0; i < INVENTORY_MAX_NUM; ++i)
+			for (TInventoryVnumIndex::const_iterator it = m_set_inventoryVnumCell.lower_bound(std::make_pair(dwItemVnum, (BYTE) 0));
+					it != m_set_inventoryVnumCell.end() && it->first == dwItemVnum; ++it)
 			{
-				LPITEM item = GetInventoryItem(i);
+				LPITEM item = GetInventoryItem(it->second);
 
 				if (!item)
 					continue;
 
-				if (item->GetVnum() == dwItemVnum && FN_check_item_socket(item))
+				if (FN_check_item_socket(item))
 				{
 					if (IS_SET(p->dwFlags, ITEM_FLAG_MAKECOUNT))
 					{
@@ -16,6 +16,10 @@
 #include "questlua.h"
 #include "locale_service.h"
 
+static quest::CEventFlagRef s_flagJapanRegen("japan_regen");
+static quest::CEventFlagRef s_flagNewyearMob("newyear_mob");
+static quest::CEventFlagRef s_flagIndependenceDay("independence_day");
+
 CHARACTER_MANAGER::CHARACTER_MANAGER() :
 	m_iVIDCount(0),
 	m_pkChrSelectedStone(NULL),
@@ -47,11 +51,16 @@ CHARACTER_MANAGER::~CHARACTER_MANAGER()
 
 void CHARACTER_MANAGER::Destroy()
 {
-	itertype(m_map_pkChrByVID) it = m_map_pkChrByVID.begin();
-	while (it != m_map_pkChrByVID.end()) {
-		LPCHARACTER ch = it->second;
-		M2_DESTROY_CHARACTER(ch); // m_map_pkChrByVID is changed here
-		it = m_map_pkChrByVID.begin();
+	// destroying one character may take others (horse, pets) with it
+	std::vector<DWORD> vecVID;
+	m_slabCharacter.ForEach([&vecVID] (LPCHARACTER ch) { vecVID.push_back(ch->GetVID()); });
+
+	for (size_t i = 0; i < vecVID.size(); ++i)
+	{
+		LPCHARACTER ch = Find(vecVID[i]);
+
+		if (ch)
+			M2_DESTROY_CHARACTER(ch);
 	}
 }
 
@@ -63,24 +72,23 @@ void CHARACTER_MANAGER::GracefulShutdown()
 		(it++)->second->Disconnect("GracefulShutdown");
 }
 
+// VIDs for objects that share the character VID space (buildings). Character
+// VIDs are slab handles, which never have the top bit set.
 DWORD CHARACTER_MANAGER::AllocVID()
 {
 	++m_iVIDCount;
-	return m_iVIDCount;
+	return 0x80000000 | m_iVIDCount;
 }
 
 LPCHARACTER CHARACTER_MANAGER::CreateCharacter(const char * name, DWORD dwPID)
 {
-	DWORD dwVID = AllocVID();
+	DWORD dwVID;
+	LPCHARACTER ch = m_slabCharacter.Construct(&dwVID);
 
-#ifdef M2_USE_POOL
-	LPCHARACTER ch = pool_.Construct();
-#else
-	LPCHARACTER ch = M2_NEW CHARACTER;
-#endif
-	ch->Create(name, dwVID, dwPID ? true : false);
+	if (!ch)
+		return NULL;
 
-	m_map_pkChrByVID.insert(std::make_pair(dwVID, ch));
+	ch->Create(name, dwVID, dwPID ? true : false);
 
 	if (dwPID)
 	{
@@ -104,8 +112,7 @@ void CHARACTER_MANAGER::DestroyCharacter(LPCHARACTER ch, const char* file, size_
 		return;
 
 	// <Factor> Check whether it has been already deleted or not.
-	itertype(m_map_pkChrByVID) it = m_map_pkChrByVID.find(ch->GetVID());
-	if (it == m_map_pkChrByVID.end()) {
+	if (m_slabCharacter.Get(ch->GetVID()) != ch) {
 		sys_err("[CHARACTER_MANAGER::DestroyCharacter] <Factor> %d not found", (long)(ch->GetVID()));
 		return; // prevent duplicated destrunction
 	}
@@ -125,8 +132,6 @@ void CHARACTER_MANAGER::DestroyCharacter(LPCHARACTER ch, const char* file, size_
 		return;
 	}
 
-	m_map_pkChrByVID.erase(it);
-
 	if (true == ch->IsPC())
 	{
 		char szName[CHARACTER_NAME_MAX_LEN + 1];
@@ -153,31 +158,26 @@ void CHARACTER_MANAGER::DestroyCharacter(LPCHARACTER ch, const char* file, size_
 
 	RemoveFromStateList(ch);
 
-#ifdef M2_USE_POOL
-	pool_.Destroy(ch);
-#else
-#ifndef DEBUG_ALLOC
-	M2_DELETE(ch);
-#else
-	M2_DELETE_EX(ch, file, line);
-#endif
-#endif
+	// 아래 소멸자에서 ClearAffect -> UpdatePacket/PointChange 가 다시 mark 하면
+	// 지워진 캐릭터가 줄에 남으므로 먼저 막고 뺀다.
+	bool bQueued = ch->IsPendingBroadcast();
+	ch->ClosePendingBroadcast();
+
+	if (bQueued)
+	{
+		CHARACTER_VECTOR::iterator it = std::find(m_vec_pkChrPendingBroadcast.begin(), m_vec_pkChrPendingBroadcast.end(), ch);
+
+		if (it != m_vec_pkChrPendingBroadcast.end())
+			m_vec_pkChrPendingBroadcast.erase(it);
+	}
+
+	m_slabCharacter.Destroy(ch);
 }
 
 LPCHARACTER CHARACTER_MANAGER::Find(DWORD dwVID)
 {
-	itertype(m_map_pkChrByVID) it = m_map_pkChrByVID.find(dwVID);
-
-	if (m_map_pkChrByVID.end() == it)
-		return NULL;
-	
-	// <Factor> Added sanity check
-	LPCHARACTER found = it->second;
-	if (found != NULL && dwVID != (DWORD)found->GetVID()) {
-		sys_err("[CHARACTER_MANAGER::Find] <Factor> %u != %u", dwVID, (DWORD)found->GetVID());
-		return NULL;
-	}
-	return found;
+	// the slab rejects stale VIDs by generation, no sanity check needed
+	return m_slabCharacter.Get(dwVID);
 }
 
 LPCHARACTER CHARACTER_MANAGER::Find(const VID & vid)
@@ -228,7 +228,7 @@ LPCHARACTER CHARACTER_MANAGER::SpawnMobRandomPosition(DWORD dwVnum, long lMapInd
 {
 	// 왜구 스폰할지말지를 결정할 수 있게함
 	{
-		if (dwVnum == 5001 && !quest::CQuestManager::instance().GetEventFlag("japan_regen"))
+		if (dwVnum == 5001 && !s_flagJapanRegen.Get())
 		{
 			sys_log(1, "WAEGU[5001] regen disabled.");
 			return NULL;
@@ -237,7 +237,7 @@ LPCHARACTER CHARACTER_MANAGER::SpawnMobRandomPosition(DWORD dwVnum, long lMapInd
 
 	// 해태를 스폰할지 말지를 결정할 수 있게 함
 	{
-		if (dwVnum == 5002 && !quest::CQuestManager::instance().GetEventFlag("newyear_mob"))
+		if (dwVnum == 5002 && !s_flagNewyearMob.Get())
 		{
 			sys_log(1, "HAETAE (new-year-mob) [5002] regen disabled.");
 			return NULL;
@@ -246,7 +246,7 @@ LPCHARACTER CHARACTER_MANAGER::SpawnMobRandomPosition(DWORD dwVnum, long lMapInd
 
 	// 광복절 이벤트 
 	{
-		if (dwVnum == 5004 && !quest::CQuestManager::instance().GetEventFlag("independence_day"))
+		if (dwVnum == 5004 && !s_flagIndependenceDay.Get())
 		{
 			sys_log(1, "INDEPENDECE DAY [5004] regen disabled.");
 			return NULL;
@@ -697,12 +697,35 @@ void CHARACTER_MANAGER::Update(int iPulse)
 
 	// 테스트 서버에서는 60초마다 캐릭터 개수를 센다
 	if (test_server && 0 == (iPulse % PASSES_PER_SEC(60)))
-		sys_log(0, "CHARACTER COUNT vid %zu pid %zu", m_map_pkChrByVID.size(), m_map_pkChrByPID.size());
+		sys_log(0, "CHARACTER COUNT vid %zu pid %zu", m_slabCharacter.Size(), m_map_pkChrByPID.size());
+
+	// 이번 pulse 에 쌓인 HP/파티/업데이트 패킷을 최종 상태로 한 번씩
+	FlushPendingBroadcast();
 
 	// 지연된 DestroyCharacter 하기
 	FlushPendingDestroy();
 }
 
+void CHARACTER_MANAGER::FlushPendingBroadcast()
+{
+	if (m_vec_pkChrPendingBroadcast.empty())
+		return;
+
+	// flush 중에 다시 mark 되는 캐릭터는 다음 pulse 로 넘긴다.
+	CHARACTER_VECTOR v;
+	v.swap(m_vec_pkChrPendingBroadcast);
+
+	for (itertype(v) it = v.begin(); it != v.end(); ++it)
+		(*it)->FlushPendingBroadcast();
+
+	if (m_vec_pkChrPendingBroadcast.empty())
+	{
+		// 벡터 용량을 재사용한다
+		v.clear();
+		v.swap(m_vec_pkChrPendingBroadcast);
+	}
+}
+
 void CHARACTER_MANAGER::ProcessDelayedSave()
 {
 	CHARACTER_SET::iterator it = m_set_pkChrForDelayedSave.begin();
@@ -1,14 +1,11 @@
 ﻿#ifndef __INC_METIN_II_GAME_CHARACTER_MANAGER_H__
 #define __INC_METIN_II_GAME_CHARACTER_MANAGER_H__
 
-#ifdef M2_USE_POOL
-#include "pool.h"
-#endif
-
 #include "common/stl.h"
 #include "common/length.h"
 
 #include "vid.h"
+#include "slab.h"
 
 class CDungeon;
 class CHARACTER;
@@ -56,6 +53,9 @@ class CHARACTER_MANAGER : public singleton<CHARACTER_MANAGER>
 		bool			AddToStateList(LPCHARACTER ch);
 		void			RemoveFromStateList(LPCHARACTER ch);
 
+		void			AddToPendingBroadcast(LPCHARACTER ch)	{ m_vec_pkChrPendingBroadcast.push_back(ch); }
+		void			FlushPendingBroadcast();
+
 		// DelayedSave: 어떠한 루틴 내에서 저장을 해야 할 짓을 많이 하면 저장
 		// 쿼리가 너무 많아지므로 "저장을 한다" 라고 표시만 해두고 잠깐
 		// (예: 1 frame) 후에 저장시킨다.
@@ -103,6 +103,8 @@ class CHARACTER_MANAGER : public singleton<CHARACTER_MANAGER>
 		bool			BeginPendingDestroy();
 		void			FlushPendingDestroy();
 
+		size_t			GetCharacterCount() const	{ return m_slabCharacter.Size(); }
+
 	private:
 		int					m_iMobItemRate;
 		int					m_iMobDamageRate;
@@ -119,12 +121,14 @@ class CHARACTER_MANAGER : public singleton<CHARACTER_MANAGER>
 		int					m_iUserDamageRatePremium;
 		int					m_iVIDCount;
 
-		std::unordered_map<DWORD, LPCHARACTER> m_map_pkChrByVID;
+		// every live character; the slab handle is the character's VID
+		CObjectSlab<CHARACTER>	m_slabCharacter;
 		std::unordered_map<DWORD, LPCHARACTER> m_map_pkChrByPID;
 		NAME_MAP			m_map_pkPCChr;
 
 		char				dummy1[1024];	// memory barrier
 		CHARACTER_SET		m_set_pkChrState;	// FSM이 돌아가고 있는 놈들
+		CHARACTER_VECTOR	m_vec_pkChrPendingBroadcast;	// MarkPendingBroadcast 된 놈들, 한 번씩만 들어 있다
 		CHARACTER_SET		m_set_pkChrForDelayedSave;
 		CHARACTER_SET		m_set_pkChrMonsterLog;
 
@@ -137,10 +141,6 @@ class CHARACTER_MANAGER : public singleton<CHARACTER_MANAGER>
 
 		bool				m_bUsePendingDestroy;
 		CHARACTER_SET		m_set_pkChrPendingDestroy;
-
-#ifdef M2_USE_POOL
-		ObjectPool<CHARACTER> pool_;
-#endif
 };
 
 	template<class Func>	
@@ -22,6 +22,9 @@
 #include "unique_item.h"
 #include "questmanager.h"
 
+static quest::CEventFlagRef s_flagNoReadDelay("no_read_delay");
+static quest::CEventFlagRef s_flagNoGrandMaster("no_grand_master");
+
 extern int test_server;
 
 static const DWORD s_adwSubSkillVnums[] =
@@ -290,7 +293,7 @@ bool CHARACTER::LearnGrandMasterSkill(DWORD dwSkillVnum)
 	/*
 	   if (get_global_time() < GetSkillNextReadTime(dwSkillVnum))
 	   {
-	   if (!(test_server && quest::CQuestManager::instance().GetEventFlag("no_read_delay")))
+	   if (!(test_server && s_flagNoReadDelay.Get()))
 	   {
 	   if (FindAffect(AFFECT_SKILL_NO_BOOK_DELAY))
 	   {
@@ -467,7 +470,7 @@ bool CHARACTER::LearnSkillByBook(DWORD dwSkillVnum, BYTE bProb)
 
 	if (get_global_time() < GetSkillNextReadTime(dwSkillVnum))
 	{
-		if (!(test_server && quest::CQuestManager::instance().GetEventFlag("no_read_delay")))
+		if (!(test_server && s_flagNoReadDelay.Get()))
 		{
 			if (FindAffect(AFFECT_SKILL_NO_BOOK_DELAY))
 			{
@@ -914,7 +917,7 @@ void CHARACTER::ComputePassiveSkill(DWORD dwVnum)
 		return;
 
 	CSkillProto * pkSk = CSkillManager::instance().Get(dwVnum);
-	pkSk->SetPointVar("k", GetSkillLevel(dwVnum));
+	pkSk->SetPointVar(SKILL_VAR_K, GetSkillLevel(dwVnum));
 	int iAmount = (int) pkSk->kPointPoly.Eval();
 
 	sys_log(2, "%s passive #%d on %d amount %d", GetName(), dwVnum, pkSk->bPointOn, iAmount);
@@ -1056,23 +1059,23 @@ void SetPolyVarForAttack(LPCHARACTER ch, CSkillProto * pkSk, LPITEM pkWeapon)
 			int iMtk = number(pkWeapon->GetValue(1), pkWeapon->GetValue(2));
 			iMtk += pkWeapon->GetValue(5);
 
-			pkSk->SetPointVar("wep", iWep);
-			pkSk->SetPointVar("mtk", iMtk);
-			pkSk->SetPointVar("mwep", iMtk);
+			pkSk->SetPointVar(SKILL_VAR_WEP, iWep);
+			pkSk->SetPointVar(SKILL_VAR_MTK, iMtk);
+			pkSk->SetPointVar(SKILL_VAR_MWEP, iMtk);
 		}
 		else
 		{
-			pkSk->SetPointVar("wep", 0);
-			pkSk->SetPointVar("mtk", 0);
-			pkSk->SetPointVar("mwep", 0);
+			pkSk->SetPointVar(SKILL_VAR_WEP, 0);
+			pkSk->SetPointVar(SKILL_VAR_MTK, 0);
+			pkSk->SetPointVar(SKILL_VAR_MWEP, 0);
 		}
 	}
 	else
 	{
 		int iWep = number(ch->GetMobDamageMin(), ch->GetMobDamageMax());
-		pkSk->SetPointVar("wep", iWep);
-		pkSk->SetPointVar("mwep", iWep);
-		pkSk->SetPointVar("mtk", iWep);
+		pkSk->SetPointVar(SKILL_VAR_WEP, iWep);
+		pkSk->SetPointVar(SKILL_VAR_MWEP, iWep);
+		pkSk->SetPointVar(SKILL_VAR_MTK, iWep);
 	}
 }
 
@@ -1125,15 +1128,15 @@ struct FuncSplashDamage
 		////////////////////////////////////////////////////////////////////////////////
 		//float k = 1.0f * m_pkChr->GetSkillPower(m_pkSk->dwVnum) * m_pkSk->bMaxLevel / 100;
 		//m_pkSk->kPointPoly2.SetVar("k", 1.0 * m_bUseSkillPower * m_pkSk->bMaxLevel / 100);
-		m_pkSk->SetPointVar("k", 1.0 * m_bUseSkillPower * m_pkSk->bMaxLevel / 100);
-		m_pkSk->SetPointVar("lv", m_pkChr->GetLevel());
-		m_pkSk->SetPointVar("iq", m_pkChr->GetPoint(POINT_IQ));
-		m_pkSk->SetPointVar("str", m_pkChr->GetPoint(POINT_ST));
-		m_pkSk->SetPointVar("dex", m_pkChr->GetPoint(POINT_DX));
-		m_pkSk->SetPointVar("con", m_pkChr->GetPoint(POINT_HT));
-		m_pkSk->SetPointVar("def", m_pkChr->GetPoint(POINT_DEF_GRADE));
-		m_pkSk->SetPointVar("odef", m_pkChr->GetPoint(POINT_DEF_GRADE) - m_pkChr->GetPoint(POINT_DEF_GRADE_BONUS));
-		m_pkSk->SetPointVar("horse_level", m_pkChr->GetHorseLevel());
+		m_pkSk->SetPointVar(SKILL_VAR_K, 1.0 * m_bUseSkillPower * m_pkSk->bMaxLevel / 100);
+		m_pkSk->SetPointVar(SKILL_VAR_LV, m_pkChr->GetLevel());
+		m_pkSk->SetPointVar(SKILL_VAR_IQ, m_pkChr->GetPoint(POINT_IQ));
+		m_pkSk->SetPointVar(SKILL_VAR_STR, m_pkChr->GetPoint(POINT_ST));
+		m_pkSk->SetPointVar(SKILL_VAR_DEX, m_pkChr->GetPoint(POINT_DX));
+		m_pkSk->SetPointVar(SKILL_VAR_CON, m_pkChr->GetPoint(POINT_HT));
+		m_pkSk->SetPointVar(SKILL_VAR_DEF, m_pkChr->GetPoint(POINT_DEF_GRADE));
+		m_pkSk->SetPointVar(SKILL_VAR_ODEF, m_pkChr->GetPoint(POINT_DEF_GRADE) - m_pkChr->GetPoint(POINT_DEF_GRADE_BONUS));
+		m_pkSk->SetPointVar(SKILL_VAR_HORSE_LEVEL, m_pkChr->GetHorseLevel());
 
 		//int iPenetratePct = (int)(1 + k*4);
 		bool bIgnoreDefense = false;
@@ -1156,32 +1159,32 @@ struct FuncSplashDamage
 				bIgnoreTargetRating = true;
 		}
 
-		m_pkSk->SetPointVar("ar", CalcAttackRating(m_pkChr, pkChrVictim, bIgnoreTargetRating));
+		m_pkSk->SetPointVar(SKILL_VAR_AR, CalcAttackRating(m_pkChr, pkChrVictim, bIgnoreTargetRating));
 
 		if (IS_SET(m_pkSk->dwFlag, SKILL_FLAG_USE_MELEE_DAMAGE))
-			m_pkSk->SetPointVar("atk", CalcMeleeDamage(m_pkChr, pkChrVictim, true, bIgnoreTargetRating));
+			m_pkSk->SetPointVar(SKILL_VAR_ATK, CalcMeleeDamage(m_pkChr, pkChrVictim, true, bIgnoreTargetRating));
 		else if (IS_SET(m_pkSk->dwFlag, SKILL_FLAG_USE_ARROW_DAMAGE))
 		{
 			LPITEM pkBow, pkArrow;
 
 			if (1 == m_pkChr->GetArrowAndBow(&pkBow, &pkArrow, 1))
-				m_pkSk->SetPointVar("atk", CalcArrowDamage(m_pkChr, pkChrVictim, pkBow, pkArrow, true));
+				m_pkSk->SetPointVar(SKILL_VAR_ATK, CalcArrowDamage(m_pkChr, pkChrVictim, pkBow, pkArrow, true));
 			else
-				m_pkSk->SetPointVar("atk", 0);
+				m_pkSk->SetPointVar(SKILL_VAR_ATK, 0);
 		}
 
 		if (m_pkSk->bPointOn == POINT_MOV_SPEED)
 			m_pkSk->kPointPoly.SetVar("maxv", pkChrVictim->GetLimitPoint(POINT_MOV_SPEED));
 
-		m_pkSk->SetPointVar("maxhp", pkChrVictim->GetMaxHP());
-		m_pkSk->SetPointVar("maxsp", pkChrVictim->GetMaxSP());
+		m_pkSk->SetPointVar(SKILL_VAR_MAXHP, pkChrVictim->GetMaxHP());
+		m_pkSk->SetPointVar(SKILL_VAR_MAXSP, pkChrVictim->GetMaxSP());
 
-		m_pkSk->SetPointVar("chain", m_pkChr->GetChainLightningIndex());
+		m_pkSk->SetPointVar(SKILL_VAR_CHAIN, m_pkChr->GetChainLightningIndex());
 		m_pkChr->IncChainLightningIndex();
 
 		bool bUnderEunhyung = m_pkChr->GetAffectedEunhyung() > 0; // 이건 왜 여기서 하지??
 
-		m_pkSk->SetPointVar("ek", m_pkChr->GetAffectedEunhyung()*1./100);
+		m_pkSk->SetPointVar(SKILL_VAR_EK, m_pkChr->GetAffectedEunhyung()*1./100);
 		//m_pkChr->ClearAffectedEunhyung();
 		SetPolyVarForAttack(m_pkChr, m_pkSk, m_pkWeapon);
 
@@ -1398,7 +1401,7 @@ struct FuncSplashDamage
 					}
 					else
 					{
-						pkSk->SetPointVar("k", 1.0f * pkChrVictim->GetSkillPower(AntiSkillID) * pkSk->bMaxLevel / 100);
+						pkSk->SetPointVar(SKILL_VAR_K, 1.0f * pkChrVictim->GetSkillPower(AntiSkillID) * pkSk->bMaxLevel / 100);
 
 						double ResistAmount = pkSk->kPointPoly.Eval();
 
@@ -1442,8 +1445,8 @@ struct FuncSplashDamage
 				}
 				else if (IS_SET(m_pkSk->dwFlag, SKILL_FLAG_FIRE_CONT))
 				{
-					m_pkSk->SetDurationVar("k", 1.0 * m_bUseSkillPower * m_pkSk->bMaxLevel / 100);
-					m_pkSk->SetDurationVar("iq", m_pkChr->GetPoint(POINT_IQ));
+					m_pkSk->SetDurationVar(SKILL_VAR_K, 1.0 * m_bUseSkillPower * m_pkSk->bMaxLevel / 100);
+					m_pkSk->SetDurationVar(SKILL_VAR_IQ, m_pkChr->GetPoint(POINT_IQ));
 
 					iDur = (int)m_pkSk->kDurationPoly2.Eval();
 					int bonus = m_pkChr->GetPoint(POINT_PARTY_BUFFER_BONUS);
@@ -1711,47 +1714,47 @@ int CHARACTER::ComputeSkillAtPosition(DWORD dwVnum, const PIXEL_POSITION& posTar
 
 	const float k = 1.0 * GetSkillPower(pkSk->dwVnum, bSkillLevel) * pkSk->bMaxLevel / 100;
 
-	pkSk->SetPointVar("k", k);
+	pkSk->SetPointVar(SKILL_VAR_K, k);
 	pkSk->kSplashAroundDamageAdjustPoly.SetVar("k", k);
 
 	if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_MELEE_DAMAGE))
 	{
-		pkSk->SetPointVar("atk", CalcMeleeDamage(this, this, true, false));
+		pkSk->SetPointVar(SKILL_VAR_ATK, CalcMeleeDamage(this, this, true, false));
 	}
 	else if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_MAGIC_DAMAGE))
 	{
-		pkSk->SetPointVar("atk", CalcMagicDamage(this, this));
+		pkSk->SetPointVar(SKILL_VAR_ATK, CalcMagicDamage(this, this));
 	}
 	else if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_ARROW_DAMAGE))
 	{
 		LPITEM pkBow, pkArrow;
 		if (1 == GetArrowAndBow(&pkBow, &pkArrow, 1))
 		{
-			pkSk->SetPointVar("atk", CalcArrowDamage(this, this, pkBow, pkArrow, true));
+			pkSk->SetPointVar(SKILL_VAR_ATK, CalcArrowDamage(this, this, pkBow, pkArrow, true));
 		}
 		else
 		{
-			pkSk->SetPointVar("atk", 0);
+			pkSk->SetPointVar(SKILL_VAR_ATK, 0);
 		}
 	}
 
 	if (pkSk->bPointOn == POINT_MOV_SPEED)
 	{
-		pkSk->SetPointVar("maxv", this->GetLimitPoint(POINT_MOV_SPEED));
+		pkSk->SetPointVar(SKILL_VAR_MAXV, this->GetLimitPoint(POINT_MOV_SPEED));
 	}
 
-	pkSk->SetPointVar("lv", GetLevel());
-	pkSk->SetPointVar("iq", GetPoint(POINT_IQ));
-	pkSk->SetPointVar("str", GetPoint(POINT_ST));
-	pkSk->SetPointVar("dex", GetPoint(POINT_DX));
-	pkSk->SetPointVar("con", GetPoint(POINT_HT));
-	pkSk->SetPointVar("maxhp", this->GetMaxHP());
-	pkSk->SetPointVar("maxsp", this->GetMaxSP());
-	pkSk->SetPointVar("chain", 0);
-	pkSk->SetPointVar("ar", CalcAttackRating(this, this));
-	pkSk->SetPointVar("def", GetPoint(POINT_DEF_GRADE));
-	pkSk->SetPointVar("odef", GetPoint(POINT_DEF_GRADE) - GetPoint(POINT_DEF_GRADE_BONUS));
-	pkSk->SetPointVar("horse_level", GetHorseLevel());
+	pkSk->SetPointVar(SKILL_VAR_LV, GetLevel());
+	pkSk->SetPointVar(SKILL_VAR_IQ, GetPoint(POINT_IQ));
+	pkSk->SetPointVar(SKILL_VAR_STR, GetPoint(POINT_ST));
+	pkSk->SetPointVar(SKILL_VAR_DEX, GetPoint(POINT_DX));
+	pkSk->SetPointVar(SKILL_VAR_CON, GetPoint(POINT_HT));
+	pkSk->SetPointVar(SKILL_VAR_MAXHP, this->GetMaxHP());
+	pkSk->SetPointVar(SKILL_VAR_MAXSP, this->GetMaxSP());
+	pkSk->SetPointVar(SKILL_VAR_CHAIN, 0);
+	pkSk->SetPointVar(SKILL_VAR_AR, CalcAttackRating(this, this));
+	pkSk->SetPointVar(SKILL_VAR_DEF, GetPoint(POINT_DEF_GRADE));
+	pkSk->SetPointVar(SKILL_VAR_ODEF, GetPoint(POINT_DEF_GRADE) - GetPoint(POINT_DEF_GRADE_BONUS));
+	pkSk->SetPointVar(SKILL_VAR_HORSE_LEVEL, GetHorseLevel());
 
 	if (pkSk->bSkillAttrType != SKILL_ATTR_TYPE_NORMAL)
 		OnMove(true);
@@ -1760,7 +1763,7 @@ int CHARACTER::ComputeSkillAtPosition(DWORD dwVnum, const PIXEL_POSITION& posTar
 
 	SetPolyVarForAttack(this, pkSk, pkWeapon);
 
-	pkSk->SetDurationVar("k", k/*bSkillLevel*/);
+	pkSk->SetDurationVar(SKILL_VAR_K, k/*bSkillLevel*/);
 
 	int iAmount = (int) pkSk->kPointPoly.Eval();
 	int iAmount2 = (int) pkSk->kPointPoly2.Eval();
@@ -2038,7 +2041,7 @@ int CHARACTER::ComputeSkill(DWORD dwVnum, LPCHARACTER pkVictim, BYTE bSkillLevel
 
 	const float k = 1.0 * GetSkillPower(pkSk->dwVnum, bSkillLevel) * pkSk->bMaxLevel / 100;
 
-	pkSk->SetPointVar("k", k);
+	pkSk->SetPointVar(SKILL_VAR_K, k);
 	pkSk->kSplashAroundDamageAdjustPoly.SetVar("k", k);
 
 	if (pkSk->dwType == SKILL_TYPE_HORSE)
@@ -2046,51 +2049,51 @@ int CHARACTER::ComputeSkill(DWORD dwVnum, LPCHARACTER pkVictim, BYTE bSkillLevel
 		LPITEM pkBow, pkArrow;
 		if (1 == GetArrowAndBow(&pkBow, &pkArrow, 1))
 		{
-			pkSk->SetPointVar("atk", CalcArrowDamage(this, pkVictim, pkBow, pkArrow, true));
+			pkSk->SetPointVar(SKILL_VAR_ATK, CalcArrowDamage(this, pkVictim, pkBow, pkArrow, true));
 		}
 		else
 		{
-			pkSk->SetPointVar("atk", CalcMeleeDamage(this, pkVictim, true, false));
+			pkSk->SetPointVar(SKILL_VAR_ATK, CalcMeleeDamage(this, pkVictim, true, false));
 		}
 	}
 	else if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_MELEE_DAMAGE))
 	{
-		pkSk->SetPointVar("atk", CalcMeleeDamage(this, pkVictim, true, false));
+		pkSk->SetPointVar(SKILL_VAR_ATK, CalcMeleeDamage(this, pkVictim, true, false));
 	}
 	else if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_MAGIC_DAMAGE))
 	{
-		pkSk->SetPointVar("atk", CalcMagicDamage(this, pkVictim));
+		pkSk->SetPointVar(SKILL_VAR_ATK, CalcMagicDamage(this, pkVictim));
 	}
 	else if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_ARROW_DAMAGE))
 	{
 		LPITEM pkBow, pkArrow;
 		if (1 == GetArrowAndBow(&pkBow, &pkArrow, 1))
 		{
-			pkSk->SetPointVar("atk", CalcArrowDamage(this, pkVictim, pkBow, pkArrow, true));
+			pkSk->SetPointVar(SKILL_VAR_ATK, CalcArrowDamage(this, pkVictim, pkBow, pkArrow, true));
 		}
 		else
 		{
-			pkSk->SetPointVar("atk", 0);
+			pkSk->SetPointVar(SKILL_VAR_ATK, 0);
 		}
 	}
 
 	if (pkSk->bPointOn == POINT_MOV_SPEED)
 	{
-		pkSk->SetPointVar("maxv", pkVictim->GetLimitPoint(POINT_MOV_SPEED));
+		pkSk->SetPointVar(SKILL_VAR_MAXV, pkVictim->GetLimitPoint(POINT_MOV_SPEED));
 	}
 
-	pkSk->SetPointVar("lv", GetLevel());
-	pkSk->SetPointVar("iq", GetPoint(POINT_IQ));
-	pkSk->SetPointVar("str", GetPoint(POINT_ST));
-	pkSk->SetPointVar("dex", GetPoint(POINT_DX));
-	pkSk->SetPointVar("con", GetPoint(POINT_HT));
-	pkSk->SetPointVar("maxhp", pkVictim->GetMaxHP());
-	pkSk->SetPointVar("maxsp", pkVictim->GetMaxSP());
-	pkSk->SetPointVar("chain", 0);
-	pkSk->SetPointVar("ar", CalcAttackRating(this, pkVictim));
-	pkSk->SetPointVar("def", GetPoint(POINT_DEF_GRADE));
-	pkSk->SetPointVar("odef", GetPoint(POINT_DEF_GRADE) - GetPoint(POINT_DEF_GRADE_BONUS));
-	pkSk->SetPointVar("horse_level", GetHorseLevel());
+	pkSk->SetPointVar(SKILL_VAR_LV, GetLevel());
+	pkSk->SetPointVar(SKILL_VAR_IQ, GetPoint(POINT_IQ));
+	pkSk->SetPointVar(SKILL_VAR_STR, GetPoint(POINT_ST));
+	pkSk->SetPointVar(SKILL_VAR_DEX, GetPoint(POINT_DX));
+	pkSk->SetPointVar(SKILL_VAR_CON, GetPoint(POINT_HT));
+	pkSk->SetPointVar(SKILL_VAR_MAXHP, pkVictim->GetMaxHP());
+	pkSk->SetPointVar(SKILL_VAR_MAXSP, pkVictim->GetMaxSP());
+	pkSk->SetPointVar(SKILL_VAR_CHAIN, 0);
+	pkSk->SetPointVar(SKILL_VAR_AR, CalcAttackRating(this, pkVictim));
+	pkSk->SetPointVar(SKILL_VAR_DEF, GetPoint(POINT_DEF_GRADE));
+	pkSk->SetPointVar(SKILL_VAR_ODEF, GetPoint(POINT_DEF_GRADE) - GetPoint(POINT_DEF_GRADE_BONUS));
+	pkSk->SetPointVar(SKILL_VAR_HORSE_LEVEL, GetHorseLevel());
 
 	if (pkSk->bSkillAttrType != SKILL_ATTR_TYPE_NORMAL)
 		OnMove(true);
@@ -2429,7 +2432,7 @@ bool CHARACTER::UseSkill(DWORD dwVnum, LPCHARACTER pkVictim, bool bUseGrandMaste
 	// NO_GRANDMASTER
 	if (test_server)
 	{
-		if (quest::CQuestManager::instance().GetEventFlag("no_grand_master"))
+		if (s_flagNoGrandMaster.Get())
 		{
 			bUseGrandMaster = false;
 		}
@@ -2542,7 +2545,7 @@ bool CHARACTER::UseSkill(DWORD dwVnum, LPCHARACTER pkVictim, bool bUseGrandMaste
 
 	const float k = 1.0 * GetSkillPower(pkSk->dwVnum) * pkSk->bMaxLevel / 100;
 
-	pkSk->SetPointVar("k", k);
+	pkSk->SetPointVar(SKILL_VAR_K, k);
 	pkSk->kSplashAroundDamageAdjustPoly.SetVar("k", k);
 
 	// 쿨타임 체크
@@ -2550,7 +2553,7 @@ bool CHARACTER::UseSkill(DWORD dwVnum, LPCHARACTER pkVictim, bool bUseGrandMaste
 	int iCooltime = (int) pkSk->kCooldownPoly.Eval();
 	int lMaxHit = pkSk->lMaxHit ? pkSk->lMaxHit : -1;
 
-	pkSk->SetSPCostVar("k", k);
+	pkSk->SetSPCostVar(SKILL_VAR_K, k);
 
 	DWORD dwCur = get_dword_time();
 
@@ -2564,8 +2567,8 @@ bool CHARACTER::UseSkill(DWORD dwVnum, LPCHARACTER pkVictim, bool bUseGrandMaste
 
 	if (IS_SET(pkSk->dwFlag, SKILL_FLAG_USE_HP_AS_COST))
 	{
-		pkSk->SetSPCostVar("maxhp", GetMaxHP());
-		pkSk->SetSPCostVar("v", GetHP());
+		pkSk->SetSPCostVar(SKILL_VAR_MAXHP, GetMaxHP());
+		pkSk->SetSPCostVar(SKILL_VAR_V, GetHP());
 		iNeededSP = (int) pkSk->kSPCostPoly.Eval();
 
 		// ADD_GRANDMASTER_SKILL
@@ -2583,9 +2586,9 @@ bool CHARACTER::UseSkill(DWORD dwVnum, LPCHARACTER pkVictim, bool bUseGrandMaste
 	else
 	{
 		// SKILL_FOMULA_REFACTORING
-		pkSk->SetSPCostVar("maxhp", GetMaxHP());
-		pkSk->SetSPCostVar("maxv", GetMaxSP());
-		pkSk->SetSPCostVar("v", GetSP());
+		pkSk->SetSPCostVar(SKILL_VAR_MAXHP, GetMaxHP());
+		pkSk->SetSPCostVar(SKILL_VAR_MAXV, GetMaxSP());
+		pkSk->SetSPCostVar(SKILL_VAR_V, GetSP());
 
 		iNeededSP = (int) pkSk->kSPCostPoly.Eval();
 
@@ -24,6 +24,11 @@
 
 #include "common/VnumHelper.h"
 
+static quest::CEventFlagRef s_flagNoguard("noguard");
+static quest::CEventFlagRef s_flagXmasTree("xmas_tree");
+static quest::CEventFlagRef s_flagMobChaseDistance("mob_chase_distance");
+static quest::CEventFlagRef s_flagMobChaseDistanceCourage("mob_chase_distance_courage");
+
 BOOL g_test_server;
 extern LPCHARACTER FindVictim(LPCHARACTER pkChr, int iMaxDistance);
 
@@ -511,7 +516,7 @@ void CHARACTER::__StateIdle_NPC()
 		return;
 	else if (IsGuardNPC())
 	{
-		if (!quest::CQuestManager::instance().GetEventFlag("noguard"))
+		if (!s_flagNoguard.Get())
 		{
 			FuncFindGuardVictim f(this, 50000);
 
@@ -661,7 +666,7 @@ void CHARACTER::__StateIdle_Monster()
 		// 선공 몬스터 처리
 		else if (!no_wander && IsAggressive())
 		{
-			if (GetMapIndex() == 61 && quest::CQuestManager::instance().GetEventFlag("xmas_tree"));
+			if (GetMapIndex() == 61 && s_flagXmasTree.Get());
 			// 서한산에서 나무가 있으면 선공하지않는다.
 			else
 				victim = FindVictim(this, m_pkMobData->m_table.wAggressiveSight);
@@ -676,6 +681,16 @@ void CHARACTER::__StateIdle_Monster()
 		return;
 	}
 
+	// 길을 돌아서 복귀하는 중이면 남은 경로를 마저 간다.
+	if (m_pkMobInst->m_bReturnByPath && !IS_SET(m_pointsInstant.dwAIFlag, AIFLAG_NOMOVE))
+	{
+		if (ReturnByPath())
+		{
+			SendMovePacket(FUNC_WAIT, 0, 0, 0, 0);
+			return;
+		}
+	}
+
 	if (IsAggressive() && !victim)
 		m_dwStateDuration = PASSES_PER_SEC(number(1, 3));
 	else
@@ -1064,11 +1079,11 @@ void CHARACTER::StateBattle()
 	float fNormalChaseDistance = 4000.0f;
 	float fCouragePlusChaseDistance = 6000.0f;
 
-	int customNormal = quest::CQuestManager::instance().GetEventFlag("mob_chase_distance");
+	int customNormal = s_flagMobChaseDistance.Get();
 	if (customNormal > 0)
 		fNormalChaseDistance = (float)customNormal;
 
-	int customCourage = quest::CQuestManager::instance().GetEventFlag("mob_chase_distance_courage");
+	int customCourage = s_flagMobChaseDistanceCourage.Get();
 	if (customCourage > 0)
 		fCouragePlusChaseDistance = (float)customCourage;
 
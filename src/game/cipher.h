@@ -31,6 +31,15 @@ class Cipher {
     }
     encoder_->ProcessData((byte*)buffer, (const byte*)buffer, length);
   }
+  // Encrypts src into dest without touching src, so one packet can be sent
+  // to many peers without copying it first. (no padding required)
+  void Encrypt(void* dest, const void* src, size_t length) {
+    assert(activated_);
+    if (!activated_) {
+      return;
+    }
+    encoder_->ProcessData((byte*)dest, (const byte*)src, length);
+  }
   // Decrypts the given block of data. (no padding required)
   void Decrypt(void* buffer, size_t length) {
     assert(activated_);
@@ -254,6 +254,10 @@ ACMD (do_ds_list);
 ACMD (do_clear_affect);
 
 ACMD (do_premium_hand);
+ACMD (do_path_bench);
+ACMD (do_packet_bench);
+ACMD (do_drop_bench);
+ACMD (do_vnum_bench);
 
 struct command_info cmd_info[] =
 {
@@ -549,6 +553,10 @@ struct command_info cmd_info[] =
 	{ "do_clear_affect", do_clear_affect, 	0, POS_DEAD,		GM_LOW_WIZARD},
 
 	{ "premium_hand",		do_premium_hand,			0,	POS_DEAD,	GM_PLAYER	},
+	{ "path_bench",			do_path_bench,				0,	POS_DEAD,	GM_IMPLEMENTOR	},
+	{ "packet_bench",		do_packet_bench,			0,	POS_DEAD,	GM_IMPLEMENTOR	},
+	{ "drop_bench",			do_drop_bench,				0,	POS_DEAD,	GM_IMPLEMENTOR	},
+	{ "vnum_bench",			do_vnum_bench,				0,	POS_DEAD,	GM_IMPLEMENTOR	},
 
 	{ "\n",		NULL,			0,			POS_DEAD,	GM_IMPLEMENTOR	}  /* 반드시 이 것이 마지막이어야 한다. */
 };
@@ -35,6 +35,8 @@
 #include "threeway_war.h"
 #include "unique_item.h"
 #include "DragonSoul.h"
+#include "pathfinder.h"
+#include "packet_writer.h"
 
 extern bool DropEvent_RefineBox_SetValue(const std::string& name, int value);
 
@@ -1587,8 +1589,13 @@ ACMD(do_makeguild)
 		return;
 	}
 
-	gm.CreateGuild(cp);
-	ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("(%s) 길드가 생성되었습니다. [임시]"), cp.name);
+	std::string stName(cp.name);
+
+	gm.CreateGuild(cp, [stName] (LPCHARACTER ch, DWORD dwGuildID)
+	{
+		if (dwGuildID)
+			ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("(%s) 길드가 생성되었습니다. [임시]"), stName.c_str());
+	});
 }
 
 ACMD(do_deleteguild)
@@ -3259,7 +3266,7 @@ ACMD(do_affect_remove)
 		ch->ChatPacket(CHAT_TYPE_INFO, "-- Affect List of %s -------------------------------", tch->GetName());
 		ch->ChatPacket(CHAT_TYPE_INFO, "Type Point Modif Duration Flag");
 
-		const std::list<CAffect *> & cont = tch->GetAffectContainer();
+		const std::vector<CAffect *> & cont = tch->GetAffectContainer();
 
 		itertype(cont) it = cont.begin();
 
@@ -3268,7 +3275,7 @@ ACMD(do_affect_remove)
 			CAffect * pkAff = *it++;
 
 			ch->ChatPacket(CHAT_TYPE_INFO, "%4d %5d %5d %8d %u", 
-					pkAff->dwType, pkAff->bApplyOn, pkAff->lApplyValue, pkAff->lDuration, pkAff->dwFlag);
+					pkAff->dwType, pkAff->bApplyOn, pkAff->lApplyValue, pkAff->GetDuration(), pkAff->dwFlag);
 		}
 		return;
 	}
@@ -4415,10 +4422,10 @@ ACMD(do_premium_hand)
     DWORD account_id = ch->GetDesc()->GetAccountTable().id;
     
     // Update database
-    std::unique_ptr<SQLMsg> pmsg(DBManager::instance().DirectQuery(
+    DBManager::instance().Query(
         "UPDATE account.account SET autoloot_expire = DATE_ADD(NOW(), INTERVAL 10 YEAR) WHERE id = %u",
         account_id
-    ));
+    );
     
     ch->ChatPacket(CHAT_TYPE_INFO, "Premium Hand activated for 10 years! Please relog for changes to take effect.");
     
@@ -4428,4 +4435,90 @@ ACMD(do_premium_hand)
     SendNotice(buf);
     
     LogManager::instance().CharLog(ch, 0, "PREMIUM_HAND", "activated for 10 years");
-}
\ No newline at end of file
+}
+
+// 벤치 명령 공통: c_pszCount 를 [1, iMax] 횟수로 읽어 f 를 돌리고 결과를 GM 과 syslog 에 남긴다.
+// 벤치는 게임 스레드에서 돌므로 각자 CBenchBudget 안에서 멈추고, 실제로 돈 횟수로 결과를 낸다.
+static void RunBench(LPCHARACTER ch, const char * c_pszCount, int iDefault, int iMax, const std::function<void (int, std::string &)> & f)
+{
+	int iCount = iDefault;
+
+	if (*c_pszCount)
+		str_to_number(iCount, c_pszCount);
+
+	iCount = MINMAX(1, iCount, iMax);
+
+	std::string stResult;
+	f(iCount, stResult);
+
+	ch->ChatPacket(CHAT_TYPE_INFO, "%s", stResult.c_str());
+	sys_log(0, "%s", stResult.c_str());
+}
+
+// path_bench [count]: 지금 맵의 주변에서 flow field 생성과 A* 탐색 비용을 잰다
+ACMD(do_path_bench)
+{
+	char arg1[256];
+	one_argument(argument, arg1, sizeof(arg1));
+
+	RunBench(ch, arg1, 100, 200, [ch] (int iCount, std::string & rstResult)
+			{
+				CPathFinder::instance().Benchmark(ch->GetMapIndex(), ch->GetX(), ch->GetY(), iCount, rstResult);
+			});
+
+	const CPathFinder::TPathStat & c_rStat = CPathFinder::instance().GetStat();
+
+	ch->ChatPacket(CHAT_TYPE_INFO, "since boot: flow build %u reuse %u, A* %u (failed %u), path cache hit %u, budget skip %u",
+			c_rStat.dwFlowBuild, c_rStat.dwFlowReuse, c_rStat.dwSearch, c_rStat.dwSearchFail, c_rStat.dwCacheHit, c_rStat.dwBudgetSkip);
+}
+
+// packet_bench [count] [viewers]: 브로드캐스트/삽입/채팅 패킷의 복사 횟수와 시간을 예전 방식과 비교한다
+ACMD(do_packet_bench)
+{
+	char arg1[256], arg2[256];
+	two_arguments(argument, arg1, sizeof(arg1), arg2, sizeof(arg2));
+
+	int iViewers = 30;
+
+	if (*arg2)
+		str_to_number(iViewers, arg2);
+
+	iViewers = MINMAX(1, iViewers, 200);
+
+	RunBench(ch, arg1, 1000, 10000, [iViewers] (int iCount, std::string & rstResult)
+			{
+				packet_writer_benchmark(iCount, iViewers, rstResult);
+			});
+}
+
+// drop_bench [kills]: 지금 고른 몹을 내가 잡을 때의 드롭 굴림 비용을 잰다
+ACMD(do_drop_bench)
+{
+	char arg1[256];
+	one_argument(argument, arg1, sizeof(arg1));
+
+	LPCHARACTER mob = ch->GetTarget();
+
+	if (!mob || !mob->IsMonster())
+	{
+		ch->ChatPacket(CHAT_TYPE_INFO, "usage: select a monster, then drop_bench [kills]");
+		return;
+	}
+
+	RunBench(ch, arg1, 10000, 100000, [ch, mob] (int iCount, std::string & rstResult)
+			{
+				ITEM_MANAGER::instance().DropBenchmark(mob, ch, iCount, rstResult);
+			});
+}
+
+// vnum_bench [count]: 킬 루프에서 찾는 proto 를 map/이진 탐색과 vnum 테이블로 각각 찾아 비교한다
+ACMD(do_vnum_bench)
+{
+	char arg1[256];
+	one_argument(argument, arg1, sizeof(arg1));
+
+	RunBench(ch, arg1, 100000, 1000000, [] (int iCount, std::string & rstResult)
+			{
+				ITEM_MANAGER::instance().VnumTableBenchmark(iCount, rstResult);
+			});
+}
@@ -30,6 +30,7 @@ int		save_event_second_cycle = passes_per_sec * 120;	// 3분
 int		ping_event_second_cycle = passes_per_sec * 60;
 bool	g_bNoMoreClient = false;
 bool	g_bNoRegen = false;
+int		g_iRegenSpawnBudget = 64;	// per map per pulse, 0 = spawn the whole regen at once
 
 // TRAFFIC_PROFILER
 bool		g_bTrafficProfileOn = false;
@@ -53,6 +54,7 @@ std::string	g_stProxyIP = "";
 #endif
 
 bool		g_bSkillDisable = false;
+bool		g_bCheckIncrementalPoints = false;
 int			g_iFullUserCount = 1200;
 int			g_iBusyUserCount = 650;
 //Canada
@@ -77,6 +79,13 @@ string g_stHostname = "";
 string g_table_postfix = "";
 
 string g_stQuestDir = "./quest";
+string g_stProtoSnapshotFileName = "";
+string g_stPacketCaptureFileName = "";
+
+// 펄스가 g_iTraceSpikeMs 를 넘으면 최근 g_iTraceWindowSec 초의 트레이스를 g_stTraceDir 에 남긴다 (0: 끔)
+int g_iTraceSpikeMs = 0;
+int g_iTraceWindowSec = 3;
+string g_stTraceDir = "trace";
 //string g_stQuestObjectDir = "./quest/object";
 string g_stDefaultQuestObjectDir = "./quest/object";
 std::set<string> g_setQuestObjectDir;
@@ -95,8 +104,16 @@ int g_iSyncHackLimitCount = 20; // 10 -> 20 2013 09 11 CYH
 //시야 = VIEW_RANGE + VIEW_BONUS_RANGE
 //VIEW_BONUSE_RANGE : 클라이언트와 시야 처리에서너무 딱 떨어질경우 문제가 발생할수있어 500CM의 여분을 항상준다.
 int VIEW_RANGE = 5000;
+
+// 거리별 이동 패킷 (move_tier_map 에 있는 맵만)
+std::set<long> g_setMoveTierMapIndex;
+int g_iMoveTierNearRange = 2500;		// 이 안의 관찰자는 모든 이동 패킷을 받는다
+DWORD g_dwMoveTierFarInterval = 300;	// 그 밖은 이 간격(ms)마다 마지막 이동만 받는다
 int VIEW_BONUS_RANGE = 500;
 
+// 몬스터 길찾기가 한 펄스에 펼칠 수 있는 셀 수 (flow field 하나가 129x129), 0 이면 직선 이동만
+int g_iPathBudget = 40000;
+
 int g_server_id = 0;
 string g_strWebMallURL = "www.metin2.de";
 
@@ -644,12 +661,48 @@ void config_init(const string& st_localeServiceName)
 			continue;
 		}
 
+		TOKEN("check_incremental_points")
+		{
+			str_to_number(g_bCheckIncrementalPoints, value_string);
+			continue;
+		}
+
 		TOKEN("quest_dir")
 		{
 			sys_log(0, "QUEST_DIR SETTING : %s", value_string);
 			g_stQuestDir = value_string;
 		}
 
+		TOKEN("proto_snapshot")
+		{
+			sys_log(0, "PROTO_SNAPSHOT SETTING : %s", value_string);
+			g_stProtoSnapshotFileName = value_string;
+		}
+
+		TOKEN("packet_capture")
+		{
+			sys_log(0, "PACKET_CAPTURE SETTING : %s", value_string);
+			g_stPacketCaptureFileName = value_string;
+		}
+
+		TOKEN("trace_spike_ms")
+		{
+			str_to_number(g_iTraceSpikeMs, value_string);
+			continue;
+		}
+
+		TOKEN("trace_window_sec")
+		{
+			str_to_number(g_iTraceWindowSec, value_string);
+			continue;
+		}
+
+		TOKEN("trace_dir")
+		{
+			g_stTraceDir = value_string;
+			continue;
+		}
+
 		TOKEN("quest_object_dir")
 		{
 			//g_stQuestObjectDir = value_string;
@@ -696,6 +749,45 @@ void config_init(const string& st_localeServiceName)
 			str_to_number(VIEW_RANGE, value_string);
 		}
 
+		TOKEN("sql_inject_latency")
+		{
+			int iMs = 0;
+			str_to_number(iMs, value_string);
+			DBManager::instance().SetInjectedLatency(iMs);
+			fprintf(stderr, "SQL_INJECT_LATENCY: %d ms per query (test only)\n", iMs);
+		}
+
+		TOKEN("move_tier_map")
+		{
+			std::istringstream iss(value_string);
+			long lMapIndex;
+
+			while (iss >> lMapIndex)
+				g_setMoveTierMapIndex.insert(lMapIndex);
+		}
+
+		TOKEN("move_tier_near_range")
+		{
+			str_to_number(g_iMoveTierNearRange, value_string);
+		}
+
+		TOKEN("move_tier_far_interval")
+		{
+			str_to_number(g_dwMoveTierFarInterval, value_string);
+		}
+
+		TOKEN("path_budget")
+		{
+			str_to_number(g_iPathBudget, value_string);
+			g_iPathBudget = MAX(0, g_iPathBudget);
+		}
+
+		TOKEN("regen_spawn_budget")
+		{
+			str_to_number(g_iRegenSpawnBudget, value_string);
+			g_iRegenSpawnBudget = MAX(0, g_iRegenSpawnBudget);
+		}
+
 		TOKEN("spam_block_duration")
 		{
 			str_to_number(g_uiSpamBlockDuration, value_string);
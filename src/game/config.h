@@ -28,6 +28,7 @@ extern bool	china_event_server;
 
 extern bool	g_bNoMoreClient;
 extern bool	g_bNoRegen;
+extern int	g_iRegenSpawnBudget;
 
 extern bool	g_bTrafficProfileOn;		///< true 이면 TrafficProfiler 를 켠다.
 
@@ -57,6 +58,7 @@ extern int (*is_twobyte) (const char * str);
 extern int (*check_name) (const char * str);
 
 extern bool		g_bSkillDisable;
+extern bool		g_bCheckIncrementalPoints;	// cross-check incremental point updates with ComputePoints()
 
 extern int		g_iFullUserCount;
 extern int		g_iBusyUserCount;
@@ -80,6 +82,12 @@ extern bool		g_bCheckClientVersion;
 extern void		CheckClientVersion();
 
 extern std::string	g_stQuestDir;
+extern std::string	g_stProtoSnapshotFileName;
+extern std::string	g_stPacketCaptureFileName;
+
+extern int			g_iTraceSpikeMs;
+extern int			g_iTraceWindowSec;
+extern std::string	g_stTraceDir;
 //extern std::string	g_stQuestObjectDir;
 extern std::set<std::string> g_setQuestObjectDir;
 
@@ -98,6 +106,12 @@ extern std::string g_strWebMallURL;
 extern int VIEW_RANGE;
 extern int VIEW_BONUS_RANGE;
 
+extern std::set<long> g_setMoveTierMapIndex;
+extern int g_iMoveTierNearRange;
+extern DWORD g_dwMoveTierFarInterval;
+
+extern int g_iPathBudget;
+
 extern bool g_bCheckMultiHack;
 extern bool g_protectNormalPlayer;      // 범법자가 "평화모드" 인 일반유저를 공격하지 못함
 extern bool g_noticeBattleZone;         // 중립지대에 입장하면 안내메세지를 알려줌
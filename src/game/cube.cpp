@@ -30,6 +30,22 @@ extern int test_server;
 static std::vector<CUBE_DATA*>	s_cube_proto;
 static bool s_isInitializedCubeMaterialInformation = false;
 
+// 레시피 인덱스 (Cube_init 에서 cube.txt 를 읽은 뒤 다시 만든다)
+// A recipe is filed once per npc under its first material vnum: the cube can only
+// satisfy it when that vnum is in the cube, so a lookup probes one bucket per
+// distinct vnum in the cube and verifies just those recipes.
+// Buckets hold s_cube_proto indices in ascending order, so the first recipe in
+// cube.txt still wins when several match.
+typedef std::vector<DWORD>	TCubeRecipeList;
+
+static std::unordered_map<uint64_t, TCubeRecipeList>	s_map_cube_by_anchor;	// (npc << 32 | anchor vnum)
+static std::unordered_set<DWORD>						s_set_cube_npc;
+
+static inline uint64_t FN_cube_anchor_key(DWORD npc_vnum, DWORD item_vnum)
+{
+	return ((uint64_t) npc_vnum << 32) | item_vnum;
+}
+
 
 
 /*--------------------------------------------------------*/
@@ -142,32 +158,108 @@ static void FN_remove_material (LPITEM *items, DWORD item_vnum, int need_count)
 }
 
 
-static CUBE_DATA* FN_find_cube (LPITEM *items, WORD npc_vnum)
+static void FN_build_cube_index ()
 {
-	DWORD	i, end_index;
+	s_map_cube_by_anchor.clear();
+	s_set_cube_npc.clear();
 
-	if (0==npc_vnum)	return NULL;
+	for (DWORD i=0; i<s_cube_proto.size(); ++i)
+	{
+		CUBE_DATA * cube = s_cube_proto[i];
+		DWORD anchor = cube->item.empty() ? 0 : cube->item[0].vnum;
 
-	// FOR ALL CUBE_PROTO
-	end_index = s_cube_proto.size();
-	for (i=0; i<end_index; ++i)
+		for (DWORD j=0; j<cube->npc_vnum.size(); ++j)
+		{
+			TCubeRecipeList & recipes = s_map_cube_by_anchor[FN_cube_anchor_key(cube->npc_vnum[j], anchor)];
+
+			if (recipes.empty() || recipes.back() != i)
+				recipes.push_back(i);
+
+			s_set_cube_npc.insert(cube->npc_vnum[j]);
+		}
+	}
+
+	sys_log(0, "CUBE: indexed %u recipes, %u anchors, %u npcs",
+			s_cube_proto.size(), s_map_cube_by_anchor.size(), s_set_cube_npc.size());
+}
+
+// 큐브 안의 아이템을 vnum 별로 합친 수량이 레시피 재료를 모두 만족하는가?
+static bool FN_check_cube_content (const CUBE_DATA * cube, const CUBE_VALUE * content, int content_count)
+{
+	for (DWORD i=0; i<cube->item.size(); ++i)
 	{
-		if ( s_cube_proto[i]->can_make_item(items, npc_vnum) )
-			return s_cube_proto[i];
+		int j = 0;
+
+		while (j < content_count && content[j].vnum != cube->item[i].vnum)
+			++j;
+
+		if (j == content_count || content[j].count < cube->item[i].count)
+			return false;
 	}
 
-	return NULL;
+	return true;
 }
 
-static bool FN_check_valid_npc( WORD vnum )
+// Lowest index in recipes that is below best and satisfied by content, or best.
+static DWORD FN_probe_cube_recipes (DWORD npc_vnum, DWORD anchor, const CUBE_VALUE * content, int content_count, DWORD best)
 {
-	for ( std::vector<CUBE_DATA*>::iterator iter = s_cube_proto.begin(); iter != s_cube_proto.end(); iter++ )
+	std::unordered_map<uint64_t, TCubeRecipeList>::const_iterator it = s_map_cube_by_anchor.find(FN_cube_anchor_key(npc_vnum, anchor));
+
+	if (it == s_map_cube_by_anchor.end())
+		return best;
+
+	const TCubeRecipeList & recipes = it->second;
+
+	for (DWORD i=0; i<recipes.size() && recipes[i] < best; ++i)
 	{
-		if ( std::find((*iter)->npc_vnum.begin(), (*iter)->npc_vnum.end(), vnum) != (*iter)->npc_vnum.end() )
-			return true;
+		if (FN_check_cube_content(s_cube_proto[recipes[i]], content, content_count))
+			return recipes[i];
 	}
 
-	return false;
+	return best;
+}
+
+static CUBE_DATA* FN_find_cube (LPITEM *items, WORD npc_vnum)
+{
+	if (0==npc_vnum)	return NULL;
+
+	CUBE_VALUE	content[CUBE_MAX_NUM];
+	int			content_count = 0;
+
+	for (int i=0; i<CUBE_MAX_NUM; ++i)
+	{
+		if (NULL==items[i])	continue;
+
+		DWORD vnum = items[i]->GetVnum();
+		int j = 0;
+
+		while (j < content_count && content[j].vnum != vnum)
+			++j;
+
+		if (j == content_count)
+		{
+			content[j].vnum = vnum;
+			content[j].count = 0;
+			++content_count;
+		}
+
+		content[j].count += items[i]->GetCount();
+	}
+
+	DWORD best = s_cube_proto.size();
+
+	// recipes without materials are filed under vnum 0
+	best = FN_probe_cube_recipes(npc_vnum, 0, content, content_count, best);
+
+	for (int j=0; j<content_count; ++j)
+		best = FN_probe_cube_recipes(npc_vnum, content[j].vnum, content, content_count, best);
+
+	return best < s_cube_proto.size() ? s_cube_proto[best] : NULL;
+}
+
+static bool FN_check_valid_npc( WORD vnum )
+{
+	return s_set_cube_npc.find(vnum) != s_set_cube_npc.end();
 }
 
 // 큐브데이타가 올바르게 초기화 되었는지 체크한다.
@@ -365,6 +457,8 @@ void Cube_init()
 
 	if (false == Cube_load(file_name))
 		sys_err("Cube_Init failed");
+
+	FN_build_cube_index();
 }
 
 bool Cube_load (const char *file)
@@ -9,6 +9,7 @@
 #include "desc_manager.h"
 #include "char.h"
 #include "char_manager.h"
+#include "guild_manager.h"
 #include "item.h"
 #include "item_manager.h"
 #include "p2p.h"
@@ -66,6 +67,12 @@ std::unique_ptr<SQLMsg> DBManager::DirectQuery(const char* c_pszFormat, ...)
 
 	//return m_sql_direct.DirectQuery(szQuery);
 
+#ifdef _DEBUG
+	// 게임 루프 전체가 이 쿼리를 기다린다. ContinueQuery 로 옮길 것.
+	if (g_bInHeartbeat)
+		sys_err("[SYNC-QUERY] DirectQuery inside heartbeat: %s", szQuery);
+#endif
+
 	// DirectQuery LPHeart debuging trace 15/11/2015 06:38AM GMT
 	DWORD t = get_dword_time();
 	auto msg = m_sql_direct.DirectQuery(szQuery);
@@ -78,6 +85,47 @@ std::unique_ptr<SQLMsg> DBManager::DirectQuery(const char* c_pszFormat, ...)
 	return msg;
 }
 
+void DBManager::ContinueQuery(DWORD dwPID, DWORD dwGuildID, std::function<void (LPCHARACTER, CGuild *, SQLMsg *)> f, const char * c_pszFormat, ...)
+{
+	char szQuery[4096];
+	va_list args;
+
+	va_start(args, c_pszFormat);
+	vsnprintf(szQuery, sizeof(szQuery), c_pszFormat, args);
+	va_end(args);
+
+	CFuncQueryInfo * p = M2_NEW CFuncQueryInfo;
+
+	p->iQueryType = QUERY_TYPE_FUNCTION;
+	p->f = [dwPID, dwGuildID, f] (SQLMsg * pmsg)
+	{
+		LPCHARACTER ch = NULL;
+		CGuild * pGuild = NULL;
+
+		if (dwPID && !(ch = CHARACTER_MANAGER::instance().FindByPID(dwPID)))
+		{
+			sys_log(1, "ContinueQuery: player %u is gone, dropping result", dwPID);
+			return;
+		}
+
+		if (dwGuildID && !(pGuild = CGuildManager::instance().FindGuild(dwGuildID)))
+		{
+			sys_log(1, "ContinueQuery: guild %u is gone, dropping result", dwGuildID);
+			return;
+		}
+
+		f(ch, pGuild, pmsg);
+	};
+
+	m_sql.ReturnQuery(szQuery, p);
+}
+
+void DBManager::SetInjectedLatency(int iMs)
+{
+	m_sql.SetInjectedLatency(iMs);
+	m_sql_direct.SetInjectedLatency(iMs);
+}
+
 bool DBManager::IsConnected()
 {
 	return m_bIsConnect;
@@ -1,6 +1,8 @@
 ﻿#ifndef __INC_METIN_II_DB_MANAGER_H__
 #define __INC_METIN_II_DB_MANAGER_H__
 
+#include <functional>
+
 #include "libsql/AsyncSQL.h"
 #include "any_function.h"
 
@@ -60,6 +62,10 @@ class CFuncAfterQueryInfo : public CQueryInfo
 };
 
 class CLoginData;
+class CGuild;
+
+// heartbeat() 안이면 true. _DEBUG 빌드에서 DirectQuery 가 이걸 보고 경고한다.
+extern bool g_bInHeartbeat;
 
 
 class DBManager : public singleton<DBManager>
@@ -100,6 +106,15 @@ class DBManager : public singleton<DBManager>
 		template<class Functor> void FuncQuery(Functor f, const char * c_pszFormat, ...); // 결과를 f인자로 호출함 (SQLMsg *) 알아서 해제됨
 		template<class Functor> void FuncAfterQuery(Functor f, const char * c_pszFormat, ...); // 끝나고 나면 f가 호출됨 void			f(void) 형태
 
+		// Continuation instead of a blocking DirectQuery: the query runs on the async
+		// connection and f(ch, pGuild, pmsg) is called from Process() with the result.
+		// The player and guild are looked up again by id at that point; if either is
+		// gone the continuation is dropped. Pass 0 to skip a lookup (its argument is NULL).
+		void			ContinueQuery(DWORD dwPID, DWORD dwGuildID, std::function<void (LPCHARACTER, CGuild *, SQLMsg *)> f, const char * c_pszFormat, ...);
+
+		// sql_inject_latency 설정. 두 연결의 모든 쿼리를 iMs 만큼 늦춘다.
+		void			SetInjectedLatency(int iMs);
+
 		size_t EscapeString(char* dst, size_t dstSize, const char *src, size_t srcSize);
 
 	private:
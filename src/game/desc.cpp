@@ -17,6 +17,8 @@
 #include "TrafficProfiler.h"
 #include "locale_service.h"
 #include "log.h"
+#include "metrics.h"
+#include "packet_writer.h"
 
 extern int max_bytes_written;
 extern int current_bytes_written;
@@ -280,6 +282,7 @@ int DESC::ProcessInput()
 		return 0;
 
 	buffer_write_proceed(m_lpInputBuffer, bytes_read);
+	CMetrics::instance().AddBytesIn(bytes_read);
 
 	if (!m_pInputProcessor)
 		sys_err("no input processor");
@@ -390,6 +393,7 @@ int DESC::ProcessOutput()
 
 		total_bytes_written += bytes_to_write;
 		current_bytes_written += bytes_to_write;
+		CMetrics::instance().AddBytesOut(bytes_to_write);
 
 		buffer_read_proceed(m_lpOutputBuffer, bytes_to_write);
 
@@ -476,18 +480,22 @@ void DESC::Packet(const void * c_pvData, int iSize)
 		// END_OF_TRAFFIC_PROFILER
 
 #ifdef _IMPROVED_PACKET_ENCRYPTION_
-		int write_point_pos = m_lpOutputBuffer->write_point_pos;
-		if (packet_encode(m_lpOutputBuffer, c_pvData, iSize))
+		if (!cipher_.activated())
 		{
-			void* buf = m_lpOutputBuffer->mem_data + write_point_pos;
-			if (cipher_.activated()) {
-				cipher_.Encrypt(buf, iSize);
-			}
+			if (!packet_encode(m_lpOutputBuffer, c_pvData, iSize))
+				m_iPhase = PHASE_CLOSE;
 		}
-		else
+		else if (buffer_has_space(m_lpOutputBuffer) < iSize)
 		{
 			m_iPhase = PHASE_CLOSE;
 		}
+		else
+		{
+			// 복사한 뒤 제자리에서 암호화하지 않고 원본에서 바로 암호화해 쓴다.
+			// 브로드캐스트는 같은 원본을 받는 사람마다 여기로 보낸다.
+			cipher_.Encrypt(buffer_write_peek(m_lpOutputBuffer), c_pvData, iSize);
+			buffer_write_proceed(m_lpOutputBuffer, iSize);
+		}
 #else
 		if (!m_bEncrypted)
 		{
@@ -507,17 +515,10 @@ void DESC::Packet(const void * c_pvData, int iSize)
 			}
 			else
 			{
-				// 암호화에 필요한 충분한 버퍼 크기를 확보한다.
-				/* buffer_adjust_size(m_lpOutputBuffer, iSize + 8); */
-				DWORD * pdwWritePoint = (DWORD *) buffer_write_peek(m_lpOutputBuffer);
-
-				if (packet_encode(m_lpOutputBuffer, c_pvData, iSize))
-				{
-					int iSize2 = TEA_Encrypt(pdwWritePoint, pdwWritePoint, GetEncryptionKey(), iSize);
-
-					if (iSize2 > iSize)
-						buffer_write_proceed(m_lpOutputBuffer, iSize2 - iSize);
-				}
+				// 복사한 뒤 제자리에서 암호화하지 않고 원본에서 바로 암호화해 쓴다.
+				// 브로드캐스트는 같은 원본을 받는 사람마다 여기로 보낸다.
+				int iSize2 = packet_encrypt_copy(buffer_write_peek(m_lpOutputBuffer), c_pvData, iSize, GetEncryptionKey());
+				buffer_write_proceed(m_lpOutputBuffer, iSize2);
 			}
 		}
 #endif // _IMPROVED_PACKET_ENCRYPTION_
@@ -530,6 +531,55 @@ void DESC::Packet(const void * c_pvData, int iSize)
 		fdwatch_add_fd(m_lpFdw, m_sock, this, FDW_WRITE, true);
 }
 
+void * DESC::BeginPacket(int iMaxSize)
+{
+	assert(iMaxSize > 0);
+
+	if (m_iPhase == PHASE_CLOSE || !m_lpOutputBuffer)
+		return NULL;
+
+	// Relay 헤더를 앞에 붙이거나 모아 둔 패킷과 합쳐야 하면 Packet()이 한다.
+	if (m_stRelayName.length() != 0 || m_lpBufferedOutputBuffer)
+		return NULL;
+
+	// 모자라면 Packet()이 실제 크기로 다시 보고 끊을지 정한다.
+	if (buffer_has_space(m_lpOutputBuffer) < iMaxSize + 8)
+		return NULL;
+
+	return buffer_write_peek(m_lpOutputBuffer);
+}
+
+void DESC::CommitPacket(int iSize)
+{
+	assert(iSize > 0);
+
+	void * pvData = buffer_write_peek(m_lpOutputBuffer);
+
+#ifdef _DEBUG
+	const std::string stName = GetCharacter() ? GetCharacter()->GetName() : GetHostName();
+	const auto kHeader = *(static_cast<const uint8_t*>(pvData));
+	sys_log(0, "[W] SENT HEADER : %u(0x%X) to %s  (size %d) ", kHeader, kHeader, stName.c_str(), iSize);
+#endif
+
+	// TRAFFIC_PROFILE
+	if (g_bTrafficProfileOn)
+		TrafficProfiler::instance().Report(TrafficProfiler::IODIR_OUTPUT, *(BYTE *) pvData, iSize);
+	// END_OF_TRAFFIC_PROFILER
+
+#ifdef _IMPROVED_PACKET_ENCRYPTION_
+	if (cipher_.activated())
+		cipher_.Encrypt(pvData, iSize);
+#else
+	if (m_bEncrypted)
+		iSize = TEA_Encrypt((DWORD *) pvData, (DWORD *) pvData, GetEncryptionKey(), iSize);
+#endif
+
+	buffer_write_proceed(m_lpOutputBuffer, iSize);
+
+	if (m_iPhase != PHASE_CLOSE)
+		fdwatch_add_fd(m_lpFdw, m_sock, this, FDW_WRITE, true);
+}
+
 void DESC::LargePacket(const void * c_pvData, int iSize)
 {
 	buffer_adjust_size(m_lpOutputBuffer, iSize);
@@ -95,6 +95,11 @@ class DESC
 		void			Packet(const void * c_pvData, int iSize);
 		void			LargePacket(const void * c_pvData, int iSize);
 
+		// 출력 버퍼에 iMaxSize 만큼 자리를 잡아 돌려준다. NULL 이면 Packet()으로 보내야 한다.
+		// 채운 뒤 CommitPacket 으로 실제 크기만큼 보낸다. (packet_writer.h)
+		void *			BeginPacket(int iMaxSize);
+		void			CommitPacket(int iSize);
+
 		int			ProcessInput();		// returns -1 if error
 		int			ProcessOutput();	// returns -1 if error
 
@@ -9,6 +9,7 @@
 #include "buffer_manager.h"
 #include "guild_manager.h"
 #include "db.h"
+#include "input.h"
 
 #include "party.h"
 
@@ -140,6 +141,7 @@ void CLIENT_DESC::SetPhase(int iPhase)
 						p.dwItemIDRange[0] = 0;
 						p.dwItemIDRange[1] = 0;
 						memcpy(p.szIP, g_szPublicIP, 16);
+						p.dwProtoSnapshotChecksum = CInputDB::OpenProtoSnapshot();
 						DBPacket(HEADER_GD_BOOT, 0, &p, sizeof(p));
 					}
 				}
@@ -14,6 +14,35 @@
 #include "utils.h"
 #include "questmanager.h"
 
+namespace
+{
+	// Visit one kind of the map's character registry instead of snapshotting
+	// every entity on the map; the snapshot keeps it safe against f destroying.
+	template <typename Func>
+	void ForEachCharacterKind(LPSECTREE_MAP pMap, BYTE bKind, Func & f)
+	{
+		std::vector<LPCHARACTER> v;
+		pMap->GetCharacters(bKind, v);
+
+		for (size_t i = 0; i < v.size(); ++i)
+			f(v[i]);
+	}
+
+	template <typename Func>
+	void ForEachPC(LPSECTREE_MAP pMap, Func & f)
+	{
+		ForEachCharacterKind(pMap, MAP_CHARACTER_KIND_PC, f);
+	}
+
+	template <typename Func>
+	void ForEachNonPC(LPSECTREE_MAP pMap, Func & f)
+	{
+		ForEachCharacterKind(pMap, MAP_CHARACTER_KIND_MONSTER, f);
+		ForEachCharacterKind(pMap, MAP_CHARACTER_KIND_STONE, f);
+		ForEachCharacterKind(pMap, MAP_CHARACTER_KIND_NPC, f);
+	}
+}
+
 CDungeon::CDungeon(IdType id, long lOriginalMapIndex, long lMapIndex)
 	: m_id(id),
 	m_lOrigMapIndex(lOriginalMapIndex),
@@ -330,8 +359,7 @@ void CDungeon::JumpAll(long lFromMapIndex, int x, int y)
 
 	FWarpToPosition f(m_lMapIndex, x, y);
 
-	// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-	pMap->for_each(f);
+	ForEachPC(pMap, f);
 }
 
 void CDungeon::WarpAll(long lFromMapIndex, int x, int y)
@@ -349,8 +377,7 @@ void CDungeon::WarpAll(long lFromMapIndex, int x, int y)
 
 	FWarpToPositionForce f(m_lMapIndex, x, y);
 
-	// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-	pMap->for_each(f);
+	ForEachPC(pMap, f);
 }
 
 void CDungeon::JumpParty(LPPARTY pParty, long lFromMapIndex, int x, int y)
@@ -946,12 +973,19 @@ namespace
 					M2_DESTROY_CHARACTER(ch);
 				}
 			}
-			else if (ent->IsType(ENTITY_ITEM))
+		}
+	};
+
+	struct FPurgeItems
+	{
+		void operator () (LPENTITY ent)
+		{
+			if (ent->IsType(ENTITY_ITEM))
 			{
 				LPITEM item = (LPITEM) ent;
 				M2_DESTROY_ITEM(item);
 			}
-			else
+			else if (!ent->IsType(ENTITY_CHARACTER))
 				sys_err("unknown entity type %d is in dungeon", ent->GetType());
 		}
 	};
@@ -966,7 +1000,7 @@ void CDungeon::KillAll()
 		return;
 	}
 	FKillSectree f;
-	pkMap->for_each(f);
+	ForEachNonPC(pkMap, f);
 }
 // END_OF_DUNGEON_KILL_ALL_BUG_FIX
 
@@ -978,7 +1012,11 @@ void CDungeon::Purge()
 		return;
 	}
 	FPurgeSectree f;
-	pkMap->for_each(f);
+	ForEachNonPC(pkMap, f);
+
+	// dropped items are not in the character registry
+	FPurgeItems fItems;
+	pkMap->for_each(fItems);
 }
 
 void CDungeon::IncKillCount(LPCHARACTER pkKiller, LPCHARACTER pkVictim)
@@ -1018,21 +1056,6 @@ int CDungeon::GetKillStoneCount()
 	return m_iStoneKill;
 }
 
-struct FCountMonster
-{
-	int n;
-	FCountMonster() : n(0) {};
-	void operator()(LPENTITY ent)
-	{
-		if (ent->IsType(ENTITY_CHARACTER))
-		{
-			LPCHARACTER ch = (LPCHARACTER) ent;
-			if (!ch->IsPC())
-				n++;
-		}
-	}
-};
-
 int CDungeon::CountRealMonster()
 {
 	LPSECTREE_MAP pMap = SECTREE_MANAGER::instance().GetMap(m_lOrigMapIndex);
@@ -1043,11 +1066,10 @@ int CDungeon::CountRealMonster()
 		return 0;
 	}
 
-	FCountMonster f;
-
-	// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-	pMap->for_each(f);
-	return f.n;
+	// every non-PC character still alive on the map
+	return pMap->GetLiveCount(MAP_CHARACTER_KIND_MONSTER)
+		+ pMap->GetLiveCount(MAP_CHARACTER_KIND_STONE)
+		+ pMap->GetLiveCount(MAP_CHARACTER_KIND_NPC);
 }
 
 struct FExitDungeon
@@ -1076,8 +1098,7 @@ void CDungeon::ExitAll()
 
 	FExitDungeon f;
 
-	// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-	pMap->for_each(f);
+	ForEachPC(pMap, f);
 }
 
 // DUNGEON_NOTICE
@@ -1114,7 +1135,7 @@ void CDungeon::Notice(const char* msg)
 	}
 
 	FNotice f(msg);
-	pMap->for_each(f);
+	ForEachPC(pMap, f);
 }
 // END_OF_DUNGEON_NOTICE
 
@@ -1152,8 +1173,7 @@ void CDungeon::ExitAllToStartPosition()
 
 	FExitDungeonToStartPosition f;
 
-	// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-	pMap->for_each(f);
+	ForEachPC(pMap, f);
 }
 
 EVENTFUNC(dungeon_jump_to_event)
@@ -1291,8 +1311,7 @@ void CDungeon::JumpToEliminateLocation()
 
 		FWarpToPosition f(m_lWarpMapIndex, m_lWarpX * 100, m_lWarpY * 100);
 
-		// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-		pMap->for_each(f);
+		ForEachPC(pMap, f);
 	}
 }
 
@@ -1338,8 +1357,7 @@ bool CDungeon::IsAllPCNearTo(int x, int y, int dist)
 
 	FNearPosition f(x, y, dist);
 
-	// <Factor> SECTREE::for_each -> SECTREE::for_each_entity
-	pMap->for_each(f);
+	ForEachPC(pMap, f);
 
 	return f.ret;
 }
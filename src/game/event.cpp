@@ -19,7 +19,7 @@ static ObjectPool<EVENT> event_pool;
 static CEventQueue cxx_q;
 
 /* 이벤트를 생성하고 리턴한다 */
-LPEVENT event_create_ex(TEVENTFUNC func, event_info_data* info, long when)
+LPEVENT event_create_ex(TEVENTFUNC func, event_info_data* info, long when, const char * c_pszName)
 {
 	LPEVENT new_event = NULL;
 
@@ -36,6 +36,7 @@ LPEVENT event_create_ex(TEVENTFUNC func, event_info_data* info, long when)
 	assert(NULL != new_event);
 
 	new_event->func = func;
+	new_event->name = c_pszName;
 	new_event->info	= info;
 	new_event->q_el	= cxx_q.Enqueue(new_event, when, thecore_heart->pulse);
 	new_event->is_processing = FALSE;
@@ -137,6 +138,7 @@ int event_process(int pulse)
 		else
 		{
 			//sys_log(0, "EVENT: %s %d event %p info %p", the_event->file, the_event->line, the_event, the_event->info);
+			M2_TRACE_SCOPE(the_event->name);
 			new_time = (the_event->func) (the_event, processing_time);
 			
 			if (new_time <= 0 || the_event->is_force_to_end)
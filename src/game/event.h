@@ -44,7 +44,7 @@ struct TQueueElement;
 
 struct event
 {
-	event() : func(NULL), info(NULL), q_el(NULL), ref_count(0) {}
+	event() : func(NULL), name(NULL), info(NULL), q_el(NULL), ref_count(0) {}
 	~event() {
 		if (info != NULL) {
 #ifdef M2_USE_POOL
@@ -55,6 +55,7 @@ struct event
 		}
 	}
 	TEVENTFUNC			func;
+	const char *		name;	// event_create 에 넘긴 함수 이름, 트레이스용
 	event_info_data* 	info;
 	TQueueElement *		q_el;
 	char				is_force_to_end;
@@ -79,8 +80,8 @@ extern void		event_destroy();
 extern int		event_process(int pulse);
 extern int		event_count();
 
-#define event_create(func, info, when) event_create_ex(func, info, when)
-extern LPEVENT	event_create_ex(TEVENTFUNC func, event_info_data* info, long when);
+#define event_create(func, info, when) event_create_ex(func, info, when, #func)
+extern LPEVENT	event_create_ex(TEVENTFUNC func, event_info_data* info, long when, const char * c_pszName = "event");
 extern void		event_cancel(LPEVENT * event);			// 이벤트 취소
 extern long		event_processing_time(LPEVENT event);	// 수행 시간 리턴
 extern long		event_time(LPEVENT event);			// 남은 시간 리턴
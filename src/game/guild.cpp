@@ -1036,18 +1036,19 @@ void CGuild::AddComment(LPCHARACTER ch, const std::string& str)
 
 void CGuild::DeleteComment(LPCHARACTER ch, DWORD comment_id)
 {
-	std::unique_ptr<SQLMsg> pmsg{};
+	auto f = [] (LPCHARACTER ch, CGuild * pGuild, SQLMsg * pmsg)
+	{
+		auto* res = pmsg ? pmsg->Get() : nullptr;
+		if (!res || res->uiAffectedRows == 0 || res->uiAffectedRows == (uint32_t)-1)
+			ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 삭제할 수 없는 글입니다."));
+		else
+			pGuild->RefreshCommentForce(ch->GetPlayerID());
+	};
 
 	if (GetMember(ch->GetPlayerID())->grade == GUILD_LEADER_GRADE)
-		pmsg = DBManager::instance().DirectQuery("DELETE FROM guild_comment%s WHERE id = %u AND guild_id = %u",get_table_postfix(), comment_id, m_data.guild_id);
-	else
-		pmsg = DBManager::instance().DirectQuery("DELETE FROM guild_comment%s WHERE id = %u AND guild_id = %u AND name = '%s'",get_table_postfix(), comment_id, m_data.guild_id, ch->GetName());
-
-	auto* res = pmsg ? pmsg->Get() : nullptr;
-	if (!res || res->uiAffectedRows == 0 || res->uiAffectedRows == (uint32_t)-1)
-		ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 삭제할 수 없는 글입니다."));
+		DBManager::instance().ContinueQuery(ch->GetPlayerID(), GetID(), f, "DELETE FROM guild_comment%s WHERE id = %u AND guild_id = %u",get_table_postfix(), comment_id, m_data.guild_id);
 	else
-		RefreshCommentForce(ch->GetPlayerID());
+		DBManager::instance().ContinueQuery(ch->GetPlayerID(), GetID(), f, "DELETE FROM guild_comment%s WHERE id = %u AND guild_id = %u AND name = '%s'",get_table_postfix(), comment_id, m_data.guild_id, ch->GetName());
 }
 
 void CGuild::RefreshComment(LPCHARACTER ch)
@@ -1057,13 +1058,16 @@ void CGuild::RefreshComment(LPCHARACTER ch)
 
 void CGuild::RefreshCommentForce(DWORD player_id)
 {
-	LPCHARACTER ch = CHARACTER_MANAGER::instance().FindByPID(player_id);
-	if (ch == NULL) {
+	if (!CHARACTER_MANAGER::instance().FindByPID(player_id))
 		return;
-	}
 
-	auto pmsg = DBManager::instance().DirectQuery("SELECT id, name, content FROM guild_comment%s WHERE guild_id = %u ORDER BY notice DESC, id DESC LIMIT %d", get_table_postfix(), m_data.guild_id, GUILD_COMMENT_MAX_COUNT);
+	DBManager::instance().ContinueQuery(player_id, GetID(),
+			[] (LPCHARACTER ch, CGuild * pGuild, SQLMsg * pmsg) { pGuild->SendComments(ch, pmsg); },
+			"SELECT id, name, content FROM guild_comment%s WHERE guild_id = %u ORDER BY notice DESC, id DESC LIMIT %d", get_table_postfix(), m_data.guild_id, GUILD_COMMENT_MAX_COUNT);
+}
 
+void CGuild::SendComments(LPCHARACTER ch, SQLMsg * pmsg)
+{
 	TPacketGCGuild pack;
 	pack.header = HEADER_GC_GUILD;
 	pack.size = sizeof(pack)+1;
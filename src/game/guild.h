@@ -238,6 +238,7 @@ class CGuild
 
 		void		RefreshComment(LPCHARACTER ch);
 		void		RefreshCommentForce(DWORD player_id);
+		void		SendComments(LPCHARACTER ch, SQLMsg * pmsg);
 
 		int			GetSkillLevel(DWORD vnum);
 		void		SkillLevelUp(DWORD dwVnum);
@@ -70,41 +70,83 @@ int CGuildManager::GetWithdrawDelay()
 	return quest::CQuestManager::instance().GetEventFlag("guild_withdraw_delay") * (test_server ? 60 : 86400);
 }
 
-DWORD CGuildManager::CreateGuild(TGuildCreateParameter& gcp)
+void CGuildManager::CreateGuild(TGuildCreateParameter& gcp, std::function<void (LPCHARACTER, DWORD)> f,
+		std::function<bool (LPCHARACTER)> fCheck)
 {
 	if (!gcp.master)
-		return 0;
+		return;
 
 	if (!check_name(gcp.name))
 	{
 		gcp.master->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 길드 이름이 적합하지 않습니다."));
-		return 0;
+		f(gcp.master, 0);
+		return;
 	}
 
-	auto pmsg = DBManager::instance().DirectQuery("SELECT COUNT(*) FROM guild%s WHERE name = '%s'",
-				get_table_postfix(), gcp.name);
+	DWORD dwMasterPID = gcp.master->GetPlayerID();
+	std::string stName(gcp.name);
 
-	if (pmsg->Get()->uiNumRows > 0)
+	// 결과를 기다리는 동안 같은 길드장이나 같은 이름으로 또 만들지 못하게 한다
+	if (m_set_dwCreatingMaster.find(dwMasterPID) != m_set_dwCreatingMaster.end() ||
+			m_set_stCreatingName.find(stName) != m_set_stCreatingName.end())
 	{
-		MYSQL_ROW row = mysql_fetch_row(pmsg->Get()->pSQLResult);
+		gcp.master->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 이미 같은 이름의 길드가 있습니다."));
+		f(gcp.master, 0);
+		return;
+	}
+
+	m_set_dwCreatingMaster.insert(dwMasterPID);
+	m_set_stCreatingName.insert(stName);
 
-		if (!(row[0] && row[0][0] == '0'))
+	// 길드장이 나가도 기다리는 목록은 비워야 하므로 pid 로 묶지 않는다
+	DBManager::instance().ContinueQuery(0, 0,
+		[this, dwMasterPID, stName, f, fCheck] (LPCHARACTER, CGuild *, SQLMsg * pmsg)
 		{
-			gcp.master->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 이미 같은 이름의 길드가 있습니다."));
-			return 0;
-		}
-	}
-	else
-	{
-		gcp.master->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 길드를 생성할 수 없습니다."));
-		return 0;
-	}
+			m_set_dwCreatingMaster.erase(dwMasterPID);
+			m_set_stCreatingName.erase(stName);
+
+			LPCHARACTER ch = CHARACTER_MANAGER::instance().FindByPID(dwMasterPID);
+
+			if (!ch)
+				return;
+
+			if (ch->GetGuild() || (fCheck && !fCheck(ch)))
+			{
+				f(ch, 0);
+				return;
+			}
+
+			if (pmsg->Get()->uiNumRows > 0)
+			{
+				MYSQL_ROW row = mysql_fetch_row(pmsg->Get()->pSQLResult);
+
+				if (!(row[0] && row[0][0] == '0'))
+				{
+					ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 이미 같은 이름의 길드가 있습니다."));
+					f(ch, 0);
+					return;
+				}
+			}
+			else
+			{
+				ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 길드를 생성할 수 없습니다."));
+				f(ch, 0);
+				return;
+			}
+
+			TGuildCreateParameter cp;
+			memset(&cp, 0, sizeof(cp));
+
+			cp.master = ch;
+			strlcpy(cp.name, stName.c_str(), sizeof(cp.name));
 
-	// new CGuild(gcp) queries guild tables and tell dbcache to notice other game servers.
-	// other game server calls CGuildManager::LoadGuild to load guild.
-	CGuild * pg = M2_NEW CGuild(gcp);
-	m_mapGuild.insert(std::make_pair(pg->GetID(), pg));
-	return pg->GetID();
+			// new CGuild(gcp) queries guild tables and tell dbcache to notice other game servers.
+			// other game server calls CGuildManager::LoadGuild to load guild.
+			CGuild * pg = M2_NEW CGuild(cp);
+			m_mapGuild.insert(std::make_pair(pg->GetID(), pg));
+			f(ch, pg->GetID());
+		},
+		"SELECT COUNT(*) FROM guild%s WHERE name = '%s'", get_table_postfix(), gcp.name);
 }
 
 void CGuildManager::Unlink(DWORD pid)
@@ -19,7 +19,11 @@ class CGuildManager : public singleton<CGuildManager>
 		CGuildManager();
 		virtual ~CGuildManager();
 
-		DWORD		CreateGuild(TGuildCreateParameter& gcp);
+		// 이름 확인은 ContinueQuery 로 한다. f 는 길드장이 아직 있을 때만
+		// 만든 길드 ID(실패하면 0)로 불린다. fCheck 가 있으면 만들기 직전에
+		// 다시 물어 false 면 만들지 않는다.
+		void		CreateGuild(TGuildCreateParameter& gcp, std::function<void (LPCHARACTER, DWORD)> f,
+					std::function<bool (LPCHARACTER)> fCheck = nullptr);
 		CGuild *	FindGuild(DWORD guild_id);
 		CGuild *	FindGuildByName(const std::string guild_name);
 		void		LoadGuild(DWORD guild_id);
@@ -92,6 +96,10 @@ class CGuildManager : public singleton<CGuildManager>
 		std::map<DWORD, CGuildWarReserveForGame *>	m_map_kReserveWar;
 		std::vector<CGuildWarReserveForGame *>		m_vec_kReserveWar;
 
+		// 이름 확인 결과를 기다리는 길드장과 이름
+		std::set<DWORD>				m_set_dwCreatingMaster;
+		std::set<std::string>			m_set_stCreatingName;
+
 		friend class CGuild;
 };
 
@@ -68,10 +68,6 @@ void CHorseNameManager::Validate(LPCHARACTER pChar)
 			UpdateHorseName(pChar->GetPlayerID(), "", true);
 			pChar->HorseSummon(true, true);
 		}
-		else
-		{
-			++(pkAff->lDuration);
-		}
 	}
 }
 
@@ -16,6 +16,8 @@
 #include "TrafficProfiler.h"
 #include "priv_manager.h"
 #include "castle.h"
+#include "metrics.h"
+#include "common/packet_capture.h"
 
 extern time_t get_global_time();
 
@@ -34,6 +36,70 @@ bool IsAdminPage(const char * ip)
 	return 0;
 }
 
+// PACKET_CAPTURE
+// In-game client packets, for replay by the loadsim tool (see common/packet_capture.h).
+static CPacketCaptureWriter s_kPacketCapture;
+
+// Whispers, and chat commands that carry a safebox or mall password, are never written.
+static bool IsPacketCaptureFiltered(const char * c_pData, int iPacketLen)
+{
+	switch ((BYTE) *c_pData)
+	{
+		case HEADER_CG_WHISPER:
+			return true;
+
+		case HEADER_CG_CHAT:
+			{
+				if (iPacketLen <= (int) sizeof(TPacketCGChat))
+					return false;
+
+				const char * c_pszText = c_pData + sizeof(TPacketCGChat);
+				size_t len = iPacketLen - sizeof(TPacketCGChat);
+
+				if (*c_pszText != '/')
+					return false;
+
+				++c_pszText;
+				--len;
+
+				// safebox_password, safebox_change_password, mall_password and their abbreviations
+				static const char * sc_apszPrefix[] = { "safebox_", "mall_" };
+
+				for (size_t i = 0; i < sizeof(sc_apszPrefix) / sizeof(sc_apszPrefix[0]); ++i)
+				{
+					size_t prefix_len = strlen(sc_apszPrefix[i]);
+
+					if (len >= prefix_len && !strncmp(c_pszText, sc_apszPrefix[i], prefix_len))
+						return true;
+				}
+			}
+			return false;
+	}
+
+	return false;
+}
+
+static void CapturePacket(LPDESC d, bool bSequence, const char * c_pData, int iPacketLen)
+{
+	if (IsPacketCaptureFiltered(c_pData, iPacketLen))
+		return;
+
+	if (!s_kPacketCapture.IsOpen())
+	{
+		if (!s_kPacketCapture.Open(g_stPacketCaptureFileName.c_str()))
+		{
+			sys_err("PACKET_CAPTURE: cannot open %s, capture disabled", g_stPacketCaptureFileName.c_str());
+			g_stPacketCaptureFileName.clear();
+			return;
+		}
+
+		sys_log(0, "PACKET_CAPTURE: writing to %s", g_stPacketCaptureFileName.c_str());
+	}
+
+	s_kPacketCapture.Write(d->GetHandle(), get_dword_time(), bSequence, c_pData, iPacketLen);
+}
+// END_OF_PACKET_CAPTURE
+
 CInputProcessor::CInputProcessor() : m_pPacketInfo(NULL), m_iBufferLeft(0)
 {
 	if (!m_pPacketInfo)
@@ -104,6 +170,8 @@ bool CInputProcessor::Process(LPDESC lpDesc, const void * c_pvOrig, int iBytes,
 			if (test_server && bHeader != HEADER_CG_MOVE)
 				sys_log(0, "Packet Analyze [Header %d][bufferLeft %d] ", bHeader, m_iBufferLeft);
 
+			// c_pszName lives in the packet info table until shutdown, so it can name the scope.
+			M2_TRACE_SCOPE_ARG(c_pszName, lpDesc->GetHandle());
 			m_pPacketInfo->Start();
 
 			int iExtraPacketSize = Analyze(lpDesc, bHeader, c_pData);
@@ -128,6 +196,9 @@ bool CInputProcessor::Process(LPDESC lpDesc, const void * c_pvOrig, int iBytes,
 			TrafficProfiler::instance().Report(TrafficProfiler::IODIR_INPUT, bHeader, iPacketLen);
 		// END_OF_TRAFFIC_PROFILER
 
+		if (bHeader && !g_stPacketCaptureFileName.empty() && GetType() == INPROC_MAIN)
+			CapturePacket(lpDesc, m_pPacketInfo->IsSequence(bHeader), c_pData, iPacketLen);
+
 		if (bHeader == HEADER_CG_PONG)
 			sys_log(0, "PONG! %u %u", m_pPacketInfo->IsSequence(bHeader), *(BYTE *) (c_pData + iPacketLen - sizeof(BYTE)));
 
@@ -348,6 +419,17 @@ int CInputHandshake::Analyze(LPDESC d, BYTE bHeader, const char * c_pData)
 			CProfiler::instance().Log("profile.txt");
 			stResult = "OK";
 		}
+		else if (!stBuf.compare("METRICS"))
+		{
+			if (!IsEmptyAdminPage() && !IsAdminPage(inet_ntoa(d->GetAddr().sin_addr)))
+			{
+				char szTmp[64];
+				snprintf(szTmp, sizeof(szTmp), "WEBADMIN : Wrong Connector : %s", inet_ntoa(d->GetAddr().sin_addr));
+				stResult += szTmp;
+			}
+			else
+				stResult = CMetrics::instance().Render();
+		}
 		//gift notify delete command
 		else if (!stBuf.compare(0,15,"DELETE_AWARDID "))
 			{
@@ -426,6 +508,12 @@ int CInputHandshake::Analyze(LPDESC d, BYTE bHeader, const char * c_pData)
 					P2P_MANAGER::instance().Send(&bHeader, sizeof(BYTE));
 					stResult = "OK";
 				}
+				else if (!stBuf.compare("RELOAD_AWARD"))
+				{
+					// 웹샵이 item_award 에 넣은 뒤 바로 읽게 한다
+					db_clientdesc->DBPacket(HEADER_GD_RELOAD_ITEM_AWARD, 0, NULL, 0);
+					stResult = "OK";
+				}
 				else if (!stBuf.compare(0, 6, "RELOAD"))
 				{
 					if (stBuf.size() == 6)
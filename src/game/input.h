@@ -290,6 +290,9 @@ protected:
 
 	void		RespondChannelStatus(LPDESC desc, const char* pcData);
 
+	public:
+		static DWORD	OpenProtoSnapshot();
+
 	protected:
 		DWORD		m_dwHandle;
 };
@@ -42,6 +42,7 @@
 #include "map_location.h"
 
 #include "DragonSoul.h"
+#include "common/proto_snapshot.h"
 
 extern BYTE		g_bAuthServer;
 extern void gm_insert(const char * name, BYTE level);
@@ -50,6 +51,24 @@ extern void gm_host_insert(const char * host);
 
 #define MAPNAME_DEFAULT	"none"
 
+static CProtoSnapshot s_kProtoSnapshot;
+
+DWORD CInputDB::OpenProtoSnapshot()
+{
+	if (g_stProtoSnapshotFileName.empty())
+		return 0;
+
+	if (!s_kProtoSnapshot.Open(g_stProtoSnapshotFileName.c_str()))
+	{
+		sys_log(0, "PROTO_SNAPSHOT: %s missing or invalid, tables will come from db", g_stProtoSnapshotFileName.c_str());
+		return 0;
+	}
+
+	sys_log(0, "PROTO_SNAPSHOT: opened %s (mob %u item %u checksum %08x)", g_stProtoSnapshotFileName.c_str(),
+			s_kProtoSnapshot.GetMobCount(), s_kProtoSnapshot.GetItemCount(), s_kProtoSnapshot.GetChecksum());
+	return s_kProtoSnapshot.GetChecksum();
+}
+
 bool GetServerLocation(TAccountTable & rTab, BYTE bEmpire)
 {
 	bool bFound = false;
@@ -491,12 +510,25 @@ void CInputDB::Boot(const char* data)
 
 	sys_log(0, "BOOT: PACKET: %d", dwPacketSize);
 	sys_log(0, "BOOT: VERSION: %d", bVersion);
-	if (bVersion != 6)
+	if (bVersion != 7)
 	{
 		sys_err("boot version error");
 		thecore_shutdown();
 	}
 
+	// mob/item tables are left out only when the db confirmed our snapshot checksum.
+	DWORD dwProtoSnapshotChecksum = decode_4bytes(data);
+	data += 4;
+
+	bool bUseProtoSnapshot = dwProtoSnapshotChecksum && s_kProtoSnapshot.IsOpen() && s_kProtoSnapshot.GetChecksum() == dwProtoSnapshotChecksum;
+
+	if (dwProtoSnapshotChecksum && !bUseProtoSnapshot)
+	{
+		sys_err("proto snapshot checksum mismatch (db %08x local %08x)", dwProtoSnapshotChecksum, s_kProtoSnapshot.GetChecksum());
+		thecore_shutdown();
+		return;
+	}
+
 	sys_log(0, "sizeof(TMobTable) = %d", sizeof(TMobTable));
 	sys_log(0, "sizeof(TItemTable) = %d", sizeof(TItemTable));
 	sys_log(0, "sizeof(TShopTable) = %d", sizeof(TShopTable));
@@ -530,7 +562,12 @@ void CInputDB::Boot(const char* data)
 	data += 2;
 	sys_log(0, "BOOT: MOB: %d", size);
 
-	if (size)
+	if (bUseProtoSnapshot)
+	{
+		sys_log(0, "BOOT: MOB: %u (snapshot)", s_kProtoSnapshot.GetMobCount());
+		CMobManager::instance().Initialize(const_cast<TMobTable *>(s_kProtoSnapshot.GetMobTable()), s_kProtoSnapshot.GetMobCount());
+	}
+	else if (size)
 	{
 		CMobManager::instance().Initialize((TMobTable *) data, size);
 		data += size * sizeof(TMobTable);
@@ -553,12 +590,20 @@ void CInputDB::Boot(const char* data)
 	sys_log(0, "BOOT: ITEM: %d", size);
 
 
-	if (size)
+	if (bUseProtoSnapshot)
+	{
+		sys_log(0, "BOOT: ITEM: %u (snapshot)", s_kProtoSnapshot.GetItemCount());
+		ITEM_MANAGER::instance().Initialize(const_cast<TItemTable *>(s_kProtoSnapshot.GetItemTable()), s_kProtoSnapshot.GetItemCount());
+	}
+	else if (size)
 	{
 		ITEM_MANAGER::instance().Initialize((TItemTable *) data, size);
 		data += size * sizeof(TItemTable);
 	}
 
+	// The managers keep their own copies, so the mapping can go.
+	s_kProtoSnapshot.Close();
+
 	/*
 	 * SHOP
 	 */
@@ -968,6 +1013,8 @@ void CInputDB::Boot(const char* data)
 		return;
 	}
 
+	ITEM_MANAGER::instance().BuildDropPlans();
+
 	sys_log(0, "LoadLocaleFile: MapIndex: %s", szMapIndexFileName);
 	if (!SECTREE_MANAGER::instance().Build(szMapIndexFileName, LocaleService_GetMapPath().c_str()))
 	{
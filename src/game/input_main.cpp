@@ -696,7 +696,7 @@ int CInputMain::Chat(LPCHARACTER ch, const char * data, size_t uiBytes)
 
 	if (pAffect != NULL)
 	{
-		SendBlockChatInfo(ch, pAffect->lDuration);
+		SendBlockChatInfo(ch, pAffect->GetDuration());
 		return iExtraLen;
 	}
 
@@ -1740,7 +1740,7 @@ void CInputMain::Move(LPCHARACTER ch, const char * data)
 	pack.dwTime       = get_dword_time();
 	pack.dwDuration   = (pinfo->bFunc == FUNC_MOVE) ? ch->GetCurrentMoveDuration() : 0;
 
-	ch->PacketAround(&pack, sizeof(TPacketGCMove), ch);
+	ch->PacketMoveView(pack);
 /*
 	if (pinfo->dwTime == 10653691) // 디버거 발견
 	{
@@ -2539,11 +2539,17 @@ void CInputMain::AnswerMakeGuild(LPCHARACTER ch, const char* c_pData)
 		return;
 	}
 
-	DWORD dwGuildID = gm.CreateGuild(cp);
+	std::string stName(cp.name);
 
-	if (dwGuildID)
+	gm.CreateGuild(cp, [stName] (LPCHARACTER ch, DWORD dwGuildID)
 	{
-		ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> [%s] 길드가 생성되었습니다."), cp.name);
+		if (!dwGuildID)
+		{
+			ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 길드 생성에 실패하였습니다."));
+			return;
+		}
+
+		ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> [%s] 길드가 생성되었습니다."), stName.c_str());
 
 		int GuildCreateFee;
 
@@ -2560,15 +2566,18 @@ void CInputMain::AnswerMakeGuild(LPCHARACTER ch, const char* c_pData)
 		DBManager::instance().SendMoneyLog(MONEY_LOG_GUILD, ch->GetPlayerID(), -GuildCreateFee);
 
 		char Log[128];
-		snprintf(Log, sizeof(Log), "GUILD_NAME %s MASTER %s", cp.name, ch->GetName());
+		snprintf(Log, sizeof(Log), "GUILD_NAME %s MASTER %s", stName.c_str(), ch->GetName());
 		LogManager::instance().CharLog(ch, 0, "MAKE_GUILD", Log);
 
 		if (g_iUseLocale)
 			ch->RemoveSpecifyItem(GUILD_CREATE_ITEM_VNUM, 1);
 		//ch->SendGuildName(dwGuildID);
-	}
-	else
-		ch->ChatPacket(CHAT_TYPE_INFO, LC_TEXT("<길드> 길드 생성에 실패하였습니다."));
+	},
+	[] (LPCHARACTER ch)
+	{
+		// 기다리는 동안 돈을 썼을 수 있다
+		return ch->GetGold() >= 200000;
+	});
 }
 
 void CInputMain::PartyUseSkill(LPCHARACTER ch, const char* c_pData)
@@ -20,9 +20,36 @@
 #include "common/VnumHelper.h"
 #include "DragonSoul.h"
 #include "cube.h"
+#include "mob_manager.h"
+#include "metrics.h"
+
+static quest::CEventFlagRef s_flagHorseSkillBookDrop("horse_skill_book_drop");
+static quest::CEventFlagRef s_flagLottoDrop("lotto_drop");
+static quest::CEventFlagRef s_flagLottoRound("lotto_round");
+static quest::CEventFlagRef s_flagXmasSock("xmas_sock");
+static quest::CEventFlagRef s_flagDropMoon("drop_moon");
+static quest::CEventFlagRef s_flagHcDrop("hc_drop");
+static quest::CEventFlagRef s_flag2006Drop("2006_drop");
+static quest::CEventFlagRef s_flag2007Drop("2007_drop");
+static quest::CEventFlagRef s_flagNewyearFire("newyear_fire");
+static quest::CEventFlagRef s_flagNewyearMoon("newyear_moon");
+static quest::CEventFlagRef s_flagValentineDrop("valentine_drop");
+static quest::CEventFlagRef s_flagIcecreamDrop("icecream_drop");
+static quest::CEventFlagRef s_flagNewXmasEvent("new_xmas_event");
+static quest::CEventFlagRef s_flagHalloweenDrop("halloween_drop");
+static quest::CEventFlagRef s_flagRamadanDrop("ramadan_drop");
+static quest::CEventFlagRef s_flagEasterDrop("easter_drop");
+static quest::CEventFlagRef s_flagFootballDrop("football_drop");
+static quest::CEventFlagRef s_flagWhitedayDrop("whiteday_drop");
+static quest::CEventFlagRef s_flagKidsDayDropHigh("kids_day_drop_high");
+static quest::CEventFlagRef s_flagKidsDayDrop("kids_day_drop");
+static quest::CEventFlagRef s_flagMedalPartDrop("medal_part_drop");
+static quest::CEventFlagRef s_flagThreeSkillItem("three_skill_item");
+static quest::CEventFlagRef s_flagDragonBoatFestivalDrop("dragon_boat_festival_drop");
+static quest::CEventFlagRef s_flagMarsDrop("mars_drop");
 
 ITEM_MANAGER::ITEM_MANAGER()
-	: m_iTopOfTable(0), m_dwVIDCount(0), m_dwCurrentID(0)
+	: m_iTopOfTable(0), m_dwCurrentID(0)
 {
 	m_ItemIDRange.dwMin = m_ItemIDRange.dwMax = m_ItemIDRange.dwUsableItemIDMin = 0;
 	m_ItemIDSpareRange.dwMin = m_ItemIDSpareRange.dwMax = m_ItemIDSpareRange.dwUsableItemIDMin = 0;
@@ -35,15 +62,7 @@ ITEM_MANAGER::~ITEM_MANAGER()
 
 void ITEM_MANAGER::Destroy()
 {
-	itertype(m_VIDMap) it = m_VIDMap.begin();
-	for ( ; it != m_VIDMap.end(); ++it) {
-#ifdef M2_USE_POOL
-		pool_.Destroy(it->second);
-#else
-		M2_DELETE(it->second);
-#endif
-	}
-	m_VIDMap.clear();
+	m_slabItem.ForEach([this] (LPITEM item) { m_slabItem.Destroy(item); });
 }
 
 void ITEM_MANAGER::GracefulShutdown()
@@ -65,14 +84,55 @@ bool ITEM_MANAGER::Initialize(TItemTable * table, int size)
 
 	m_vec_prototype.resize(size);
 	thecore_memcpy(&m_vec_prototype[0], table, sizeof(TItemTable) * size);
+
+	m_tableProto.Clear();
+	m_vec_item_vnum_range_info.clear();
+
+	// Exact vnums first so they win over any range covering them, then ranges in
+	// table order so the first matching range wins, as the old linear scan did.
+	// A wide range stays in the linear fallback, so a later narrow range leaves
+	// the vnums it shares with an earlier wide range unset and the fallback finds
+	// the wide one first.
+	for (int i = 0; i < size; i++)
+		m_tableProto.Set(m_vec_prototype[i].dwVnum, &m_vec_prototype[i]);
+
 	for (int i = 0; i < size; i++)
 	{
-		if (0 != m_vec_prototype[i].dwVnumRange)
+		TItemTable * p = &m_vec_prototype[i];
+
+		if (0 == p->dwVnumRange)
+			continue;
+
+		if (p->dwVnumRange > ITEM_VNUM_RANGE_DIRECT_MAX)
+		{
+			m_vec_item_vnum_range_info.push_back(p);
+			continue;
+		}
+
+		if (m_vec_item_vnum_range_info.empty())
 		{
-			m_vec_item_vnum_range_info.push_back( &m_vec_prototype[i]);
+			m_tableProto.SetRange(p->dwVnum + 1, p->dwVnumRange - 1, p);
+			continue;
+		}
+
+		for (DWORD dwVnum = p->dwVnum + 1; dwVnum < p->dwVnum + p->dwVnumRange; ++dwVnum)
+		{
+			bool bWide = false;
+
+			for (size_t j = 0; j < m_vec_item_vnum_range_info.size() && !bWide; ++j)
+			{
+				const TItemTable * w = m_vec_item_vnum_range_info[j];
+				bWide = w->dwVnum < dwVnum && dwVnum < w->dwVnum + w->dwVnumRange;
+			}
+
+			if (!bWide)
+				m_tableProto.SetRange(dwVnum, 1, p);
 		}
 	}
 
+	sys_log(0, "ITEM_MANAGER: %d protos, %u vnum pages, %u wide ranges",
+			size, (unsigned) m_tableProto.GetPageCount(), (unsigned) m_vec_item_vnum_range_info.size());
+
 	m_map_ItemRefineFrom.clear();
 	for (i = 0; i < size; ++i)
 	{
@@ -120,15 +180,10 @@ bool ITEM_MANAGER::Initialize(TItemTable * table, int size)
 			sys_log(0, "%s", buf);
 	}
 
-	ITEM_VID_MAP::iterator it = m_VIDMap.begin();
+	sys_log (1, "ITEM_VID_MAP %zu", m_slabItem.Size() );
 
-	sys_log (1, "ITEM_VID_MAP %d", m_VIDMap.size() );
-
-	while (it != m_VIDMap.end())
+	m_slabItem.ForEach([this] (LPITEM item)
 	{
-		LPITEM item = it->second;
-		++it;
-
 		const TItemTable* tableInfo = GetTable(item->GetOriginalVnum());
 
 		if (NULL == tableInfo)
@@ -138,7 +193,7 @@ bool ITEM_MANAGER::Initialize(TItemTable * table, int size)
 		}
 
 		item->SetProto(tableInfo);
-	}
+	});
 
 	return true;
 }
@@ -194,11 +249,11 @@ LPITEM ITEM_MANAGER::CreateItem(DWORD vnum, DWORD count, DWORD id, bool bTryMagi
 	}
 
 	//아이템 하나 할당하고
-#ifdef M2_USE_POOL
-	item = pool_.Construct();
-#else
-	item = M2_NEW CItem(vnum);
-#endif
+	DWORD dwVID;
+	item = m_slabItem.Construct(&dwVID, vnum);
+
+	if (!item)
+		return NULL;
 
 	bool bIsNewItem = (0 == id);
 
@@ -270,10 +325,7 @@ LPITEM ITEM_MANAGER::CreateItem(DWORD vnum, DWORD count, DWORD id, bool bTryMagi
 	else
 		count = 1;
 
-	item->SetVID(++m_dwVIDCount);
-
-	if (bSkipSave == false)
-		m_VIDMap.insert(ITEM_VID_MAP::value_type(item->GetVID(), item));
+	item->SetVID(dwVID);
 
 	if (item->GetID() != 0 && bSkipSave == false)
 		m_map_pkItemByID.insert(std::map<DWORD, LPITEM>::value_type(item->GetID(), item));
@@ -573,17 +625,7 @@ void ITEM_MANAGER::DestroyItem(LPITEM item, const char* file, size_t line)
 	if (dwID)
 		m_map_pkItemByID.erase(dwID);
 
-	m_VIDMap.erase(item->GetVID());
-
-#ifdef M2_USE_POOL
-	pool_.Destroy(item);
-#else
-#ifndef DEBUG_ALLOC
-	M2_DELETE(item);
-#else
-	M2_DELETE_EX(item, file, line);
-#endif
-#endif
+	m_slabItem.Destroy(item);
 }
 
 LPITEM ITEM_MANAGER::Find(DWORD id)
@@ -596,61 +638,27 @@ LPITEM ITEM_MANAGER::Find(DWORD id)
 
 LPITEM ITEM_MANAGER::FindByVID(DWORD vid)
 {
-	ITEM_VID_MAP::iterator it = m_VIDMap.find(vid);
-
-	if (it == m_VIDMap.end())
-		return NULL;
-
-	return (it->second);
+	return m_slabItem.Get(vid);
 }
 
 TItemTable * ITEM_MANAGER::GetTable(DWORD vnum)
 {
-	int rnum = RealNumber(vnum);
+	TItemTable * pTable = m_tableProto.Get(vnum);
+
+	if (pTable || m_vec_item_vnum_range_info.empty())
+		return pTable;
 
-	if (rnum < 0)
+	for (size_t i = 0; i < m_vec_item_vnum_range_info.size(); i++)
 	{
-		for (int i = 0; i < m_vec_item_vnum_range_info.size(); i++)
+		TItemTable* p = m_vec_item_vnum_range_info[i];
+		if ((p->dwVnum < vnum) &&
+			vnum < (p->dwVnum + p->dwVnumRange))
 		{
-			TItemTable* p = m_vec_item_vnum_range_info[i];
-			if ((p->dwVnum < vnum) &&
-				vnum < (p->dwVnum + p->dwVnumRange))
-			{
-				return p;
-			}
+			return p;
 		}
-			
-		return NULL;
-	}
-
-	return &m_vec_prototype[rnum];
-}
-
-int ITEM_MANAGER::RealNumber(DWORD vnum)
-{
-	if (m_vec_prototype.empty())
-		return -1;
-
-	int left = 0;
-	int right = m_vec_prototype.size() - 1;
-
-	while (left <= right)
-	{
-		int mid = (left + right) / 2;
-
-		if (mid < 0 || mid >= static_cast<int>(m_vec_prototype.size()))
-			return -1;
-
-		if (m_vec_prototype[mid].dwVnum == vnum)
-			return mid;
-
-		if (m_vec_prototype[mid].dwVnum > vnum)
-			right = mid - 1;
-		else
-			left = mid + 1;
 	}
 
-	return -1;
+	return NULL;
 }
 
 bool ITEM_MANAGER::GetVnum(const char * c_pszName, DWORD & r_dwVnum)
@@ -776,11 +784,11 @@ extern std::vector<CItemDropInfo> g_vec_pkCommonDropItem[MOB_RANK_MAX_NUM];
 // 20050503.ipkn.
 // iMinimum 보다 작으면 iDefault 세팅 (단, iMinimum은 0보다 커야함)
 // 1, 0 식으로 ON/OFF 되는 방식을 지원하기 위해 존재
-int GetDropPerKillPct(int iMinimum, int iDefault, int iDeltaPercent, const char * c_pszFlag)
+int GetDropPerKillPct(int iMinimum, int iDefault, int iDeltaPercent, quest::CEventFlagRef & rFlag)
 {
 	int iVal = 0;
 
-	if ((iVal = quest::CQuestManager::instance().GetEventFlag(c_pszFlag)))
+	if ((iVal = rFlag.Get()))
 	{
 		if (!test_server && !LC_IsJapan())
 		{
@@ -842,16 +850,153 @@ bool ITEM_MANAGER::GetDropPct(LPCHARACTER pkChr, LPCHARACTER pkKiller, OUT int&
 	return true;
 }
 
-bool ITEM_MANAGER::CreateDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, std::vector<LPITEM> & vec_item)
+bool CDropAliasTable::Build(const std::vector<int> & c_rvecWeight)
 {
-	int iLevel = pkKiller->GetLevel();
+	m_iTotal = 0;
+	m_vecThreshold.clear();
+	m_vecAlias.clear();
 
-	int iDeltaPercent, iRandRange;
-	if (!GetDropPct(pkChr, pkKiller, iDeltaPercent, iRandRange))
+	int n = c_rvecWeight.size();
+	long long llTotal = 0;
+
+	for (int i = 0; i < n; ++i)
+	{
+		if (c_rvecWeight[i] < 0)
+			return false;
+
+		llTotal += c_rvecWeight[i];
+	}
+
+	if (n == 0 || llTotal == 0 || llTotal * n > INT_MAX)
 		return false;
 
+	// 칸마다 용량은 total, 무게는 weight * n 으로 키워서 정수로만 나눈다.
+	std::vector<long long> vecScaled(n);
+	std::vector<int> vecSmall, vecLarge;
+
+	for (int i = 0; i < n; ++i)
+	{
+		vecScaled[i] = (long long) c_rvecWeight[i] * n;
+
+		if (vecScaled[i] < llTotal)
+			vecSmall.push_back(i);
+		else
+			vecLarge.push_back(i);
+	}
+
+	m_iTotal = (int) llTotal;
+	m_vecThreshold.assign(n, m_iTotal);
+	m_vecAlias.resize(n);
+
+	for (int i = 0; i < n; ++i)
+		m_vecAlias[i] = i;
+
+	while (!vecSmall.empty() && !vecLarge.empty())
+	{
+		int s = vecSmall.back();
+		int l = vecLarge.back();
+		vecSmall.pop_back();
+
+		m_vecThreshold[s] = (int) vecScaled[s];
+		m_vecAlias[s] = l;
+
+		vecScaled[l] -= llTotal - vecScaled[s];
+
+		if (vecScaled[l] < llTotal)
+		{
+			vecLarge.pop_back();
+			vecSmall.push_back(l);
+		}
+	}
+
+	// 남은 칸은 정수 나눗셈이라 정확히 total 로 채워져 있다.
+	return true;
+}
+
+void ITEM_MANAGER::BuildDropPlans()
+{
+	std::map<DWORD, TDropPlan> map_plan;
+
+	for (itertype(m_map_pkDropItemGroup) it = m_map_pkDropItemGroup.begin(); it != m_map_pkDropItemGroup.end(); ++it)
+	{
+		const std::vector<CDropItemGroup::SDropItemGroupInfo> & v = it->second->GetVector();
+		TDropPlan & plan = map_plan[it->first];
+
+		for (size_t i = 0; i < v.size(); ++i)
+		{
+			TItemTable * table = GetTable(v[i].dwVnum);
+			TDropPlanEntry entry = { v[i].dwVnum, v[i].dwPct, v[i].iCount, table && table->bType == ITEM_POLYMORPH };
+			plan.vec_group.push_back(entry);
+		}
+	}
+
+	for (itertype(m_map_pkMobItemGroup) it = m_map_pkMobItemGroup.begin(); it != m_map_pkMobItemGroup.end(); ++it)
+	{
+		// MOB_DROP_ITEM_BUG_FIX
+		if (it->second && !it->second->IsEmpty())
+			map_plan[it->first].pkMobItemGroup = it->second;
+	}
+
+	for (itertype(m_map_pkLevelItemGroup) it = m_map_pkLevelItemGroup.begin(); it != m_map_pkLevelItemGroup.end(); ++it)
+	{
+		TDropPlan & plan = map_plan[it->first];
+		plan.dwLevelLimit = it->second->GetLevelLimit();
+
+		for (auto & info : it->second->GetVector())
+		{
+			TDropPlanEntry entry = { info.dwVNum, info.dwPct, info.iCount, false };
+			plan.vec_level.push_back(entry);
+		}
+	}
+
+	for (itertype(m_map_pkGloveItemGroup) it = m_map_pkGloveItemGroup.begin(); it != m_map_pkGloveItemGroup.end(); ++it)
+	{
+		TDropPlan & plan = map_plan[it->first];
+
+		for (auto & info : it->second->GetVector())
+		{
+			TDropPlanEntry entry = { info.dwVnum, info.dwPct, info.iCount, false };
+			plan.vec_glove.push_back(entry);
+		}
+	}
+
+	for (CMobManager::iterator it = CMobManager::instance().begin(); it != CMobManager::instance().end(); ++it)
+	{
+		DWORD dwEtcVnum = it->second->m_table.dwDropItemVnum;
+
+		if (!dwEtcVnum)
+			continue;
+
+		itertype(m_map_dwEtcItemDropProb) it_etc = m_map_dwEtcItemDropProb.find(dwEtcVnum);
+
+		if (it_etc == m_map_dwEtcItemDropProb.end())
+			continue;
+
+		TDropPlan & plan = map_plan[it->first];
+		plan.dwEtcVnum = dwEtcVnum;
+		plan.dwEtcPct = it_etc->second;
+	}
+
+	// m_tableDropPlan 이 원소 주소를 들고 있으므로 벡터는 다 채운 뒤에 등록한다.
+	m_tableDropPlan.Clear();
+	m_vec_dropPlan.clear();
+	m_vec_dropPlan.reserve(map_plan.size());
+
+	for (itertype(map_plan) it = map_plan.begin(); it != map_plan.end(); ++it)
+		m_vec_dropPlan.push_back(it->second);
+
+	DWORD i = 0;
+
+	for (itertype(map_plan) it = map_plan.begin(); it != map_plan.end(); ++it, ++i)
+		m_tableDropPlan.Set(it->first, &m_vec_dropPlan[i]);
+
+	sys_log(0, "BuildDropPlans: %u mobs", (DWORD) m_vec_dropPlan.size());
+}
+
+void ITEM_MANAGER::RollDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, int iDeltaPercent, int iRandRange, std::vector<TDropRoll> & vec_roll)
+{
+	int iLevel = pkKiller->GetLevel();
 	BYTE bRank = pkChr->GetMobRank();
-	LPITEM item = NULL;
 
 	// Common Drop Items
 	std::vector<CItemDropInfo>::iterator it = g_vec_pkCommonDropItem[bRank].begin();
@@ -873,144 +1018,95 @@ bool ITEM_MANAGER::CreateDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, std::
 			if (!table)
 				continue;
 
-			item = NULL;
-
 			if (table->bType == ITEM_POLYMORPH)
 			{
 				if (c_rInfo.m_dwVnum == pkChr->GetPolymorphItemVnum())
-				{
-					item = CreateItem(c_rInfo.m_dwVnum, 1, 0, true);
-
-					if (item)
-						item->SetSocket(0, pkChr->GetRaceNum());
-				}
+					vec_roll.push_back(TDropRoll(c_rInfo.m_dwVnum, 1, -1, pkChr->GetRaceNum()));
 			}
 			else
-				item = CreateItem(c_rInfo.m_dwVnum, 1, 0, true);
-
-			if (item) vec_item.push_back(item);
+				vec_roll.push_back(TDropRoll(c_rInfo.m_dwVnum, 1));
 		}
 	}
 
-	// Drop Item Group
-	{
-		auto it = m_map_pkDropItemGroup.find(pkChr->GetRaceNum());
+	// 몹별 드롭 그룹 (BuildDropPlans 에서 미리 펼쳐 둠)
+	const TDropPlan * pkPlan = GetDropPlan(pkChr->GetRaceNum());
 
-		if (it != m_map_pkDropItemGroup.end())
+	if (pkPlan)
+	{
+		// Drop Item Group
+		for (auto & entry : pkPlan->vec_group)
 		{
-			__typeof(it->second->GetVector()) v = it->second->GetVector();
+			int iPercent = (entry.dwPct * iDeltaPercent) / 100;
 
-			for (DWORD i = 0; i < v.size(); ++i)
+			if (iPercent >= number(1, iRandRange))
 			{
-				int iPercent = (v[i].dwPct * iDeltaPercent) / 100;
-
-				if (iPercent >= number(1, iRandRange))
-				{
-					item = CreateItem(v[i].dwVnum, v[i].iCount, 0, true);
-
-					if (item)
-					{
-						if (item->GetType() == ITEM_POLYMORPH)
-						{
-							if (item->GetVnum() == pkChr->GetPolymorphItemVnum())
-							{
-								item->SetSocket(0, pkChr->GetRaceNum());
-							}
-						}
-
-						vec_item.push_back(item);
-					}
-				}
+				if (entry.bPolymorph && entry.dwVnum == pkChr->GetPolymorphItemVnum())
+					vec_roll.push_back(TDropRoll(entry.dwVnum, entry.iCount, -1, pkChr->GetRaceNum()));
+				else
+					vec_roll.push_back(TDropRoll(entry.dwVnum, entry.iCount));
 			}
 		}
-	}
-
-	// MobDropItem Group
-	{
-		auto it = m_map_pkMobItemGroup.find(pkChr->GetRaceNum());
 
-		if ( it != m_map_pkMobItemGroup.end() )
+		// MobDropItem Group
+		if (pkPlan->pkMobItemGroup)
 		{
-			CMobItemGroup* pGroup = it->second;
+			CMobItemGroup * pGroup = pkPlan->pkMobItemGroup;
+			int iPercent = 40000 * iDeltaPercent / pGroup->GetKillPerDrop();
 
-			// MOB_DROP_ITEM_BUG_FIX
-			// 20050805.myevan.MobDropItem 에 아이템이 없을 경우 CMobItemGroup::GetOne() 접근시 문제 발생 수정
-			if (pGroup && !pGroup->IsEmpty())
+			if (iPercent >= number(1, iRandRange))
 			{
-				int iPercent = 40000 * iDeltaPercent / pGroup->GetKillPerDrop();
-				if (iPercent >= number(1, iRandRange))
-				{
-					const CMobItemGroup::SMobItemGroupInfo& info = pGroup->GetOne();
-					item = CreateItem(info.dwItemVnum, info.iCount, 0, true, info.iRarePct);
-
-					if (item) vec_item.push_back(item);
-				}
+				const CMobItemGroup::SMobItemGroupInfo& info = pGroup->GetOne();
+				vec_roll.push_back(TDropRoll(info.dwItemVnum, info.iCount, info.iRarePct));
 			}
-			// END_OF_MOB_DROP_ITEM_BUG_FIX
 		}
-	}
-
-	// Level Item Group
-	{
-		auto it = m_map_pkLevelItemGroup.find(pkChr->GetRaceNum());
 
-		if ( it != m_map_pkLevelItemGroup.end() )
+		// Level Item Group
+		if (!pkPlan->vec_level.empty() && pkPlan->dwLevelLimit <= (DWORD)iLevel)
 		{
-			if ( it->second->GetLevelLimit() <= (DWORD)iLevel )
+			for (auto & entry : pkPlan->vec_level)
 			{
-				auto v = it->second->GetVector();
-
-				for ( DWORD i=0; i < v.size(); i++ )
-				{
-					if ( v[i].dwPct >= (DWORD)number(1, 1000000/*iRandRange*/) )
-					{
-						DWORD dwVnum = v[i].dwVNum;
-						item = CreateItem(dwVnum, v[i].iCount, 0, true);
-						if ( item ) vec_item.push_back(item);
-					}
-				}
+				if (entry.dwPct >= (DWORD)number(1, 1000000/*iRandRange*/))
+					vec_roll.push_back(TDropRoll(entry.dwVnum, entry.iCount));
 			}
 		}
-	}
-	
-	// BuyerTheitGloves Item Group
-	{
-		if (pkKiller->GetPremiumRemainSeconds(PREMIUM_ITEM) > 0 ||
-				pkKiller->IsEquipUniqueGroup(UNIQUE_GROUP_DOUBLE_ITEM))
+
+		// BuyerTheitGloves Item Group
+		if (!pkPlan->vec_glove.empty() &&
+				(pkKiller->GetPremiumRemainSeconds(PREMIUM_ITEM) > 0 ||
+				 pkKiller->IsEquipUniqueGroup(UNIQUE_GROUP_DOUBLE_ITEM)))
 		{
-			auto it = m_map_pkGloveItemGroup.find(pkChr->GetRaceNum());
-			if (it != m_map_pkGloveItemGroup.end())
+			for (auto & entry : pkPlan->vec_glove)
 			{
-				auto v = it->second->GetVector();
-				for (DWORD i = 0; i < v.size(); ++i)
-				{
-					int iPercent = (v[i].dwPct * iDeltaPercent) / 100;
+				int iPercent = (entry.dwPct * iDeltaPercent) / 100;
 
-					if (iPercent >= number(1, iRandRange))
-					{
-						DWORD dwVnum = v[i].dwVnum;
-						item = CreateItem(dwVnum, v[i].iCount, 0, true);
-						if (item) vec_item.push_back(item);
-					}
-				}
+				if (iPercent >= number(1, iRandRange))
+					vec_roll.push_back(TDropRoll(entry.dwVnum, entry.iCount));
 			}
 		}
 	}
-	
+
 	// 잡템
 	if (pkChr->GetMobDropItemVnum())
 	{
-		itertype(m_map_dwEtcItemDropProb) it = m_map_dwEtcItemDropProb.find(pkChr->GetMobDropItemVnum());
+		DWORD dwEtcPct = 0;
 
-		if (it != m_map_dwEtcItemDropProb.end())
+		if (pkPlan && pkPlan->dwEtcVnum == pkChr->GetMobDropItemVnum())
+			dwEtcPct = pkPlan->dwEtcPct;
+		else
+		{
+			// 플랜을 만든 뒤에 바뀐 몹 proto
+			itertype(m_map_dwEtcItemDropProb) it = m_map_dwEtcItemDropProb.find(pkChr->GetMobDropItemVnum());
+
+			if (it != m_map_dwEtcItemDropProb.end())
+				dwEtcPct = it->second;
+		}
+
+		if (dwEtcPct)
 		{
-			int iPercent = (it->second * iDeltaPercent) / 100;
+			int iPercent = (dwEtcPct * iDeltaPercent) / 100;
 
 			if (iPercent >= number(1, iRandRange))
-			{
-				item = CreateItem(pkChr->GetMobDropItemVnum(), 1, 0, true);
-				if (item) vec_item.push_back(item);
-			}
+				vec_roll.push_back(TDropRoll(pkChr->GetMobDropItemVnum(), 1));
 		}
 	}
 
@@ -1021,30 +1117,251 @@ bool ITEM_MANAGER::CreateDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, std::
 			int iPercent = (pkChr->GetDropMetinStonePct() * iDeltaPercent) * 400;
 
 			if (iPercent >= number(1, iRandRange))
-			{
-				item = CreateItem(pkChr->GetDropMetinStoneVnum(), 1, 0, true);
-				if (item) vec_item.push_back(item);
-			}
+				vec_roll.push_back(TDropRoll(pkChr->GetDropMetinStoneVnum(), 1));
 		}
 	}
 
 	if (pkKiller->IsHorseRiding() && 
-			GetDropPerKillPct(1000, 1000000, iDeltaPercent, "horse_skill_book_drop") >= number(1, iRandRange))
+			GetDropPerKillPct(1000, 1000000, iDeltaPercent, s_flagHorseSkillBookDrop) >= number(1, iRandRange))
 	{
 		sys_log(0, "EVENT HORSE_SKILL_BOOK_DROP");
+		vec_roll.push_back(TDropRoll(ITEM_HORSE_SKILL_TRAIN_BOOK, 1));
+	}
+}
 
-		if ((item = CreateItem(ITEM_HORSE_SKILL_TRAIN_BOOK, 1, 0, true)))
-			vec_item.push_back(item);
+void ITEM_MANAGER::CreateRolledItem(const std::vector<TDropRoll> & c_rvec_roll, std::vector<LPITEM> & vec_item)
+{
+	for (size_t i = 0; i < c_rvec_roll.size(); ++i)
+	{
+		const TDropRoll & c_rRoll = c_rvec_roll[i];
+		LPITEM item = CreateItem(c_rRoll.dwVnum, c_rRoll.iCount, 0, true, c_rRoll.iRarePct);
+
+		if (!item)
+			continue;
+
+		if (c_rRoll.iPolymorphRace >= 0)
+			item->SetSocket(0, c_rRoll.iPolymorphRace);
+
+		vec_item.push_back(item);
 	}
+}
+
+namespace
+{
+	// RealNumber() 와 넓은 range 선형 탐색: vnum_table 이전의 GetTable
+	TItemTable * BenchOldGetTable(std::vector<TItemTable> & rvec_proto, const std::vector<TItemTable *> & c_rvec_range, DWORD vnum)
+	{
+		int left = 0;
+		int right = rvec_proto.size() - 1;
+
+		while (left <= right)
+		{
+			int mid = (left + right) / 2;
+
+			if (rvec_proto[mid].dwVnum == vnum)
+				return &rvec_proto[mid];
+
+			if (rvec_proto[mid].dwVnum > vnum)
+				right = mid - 1;
+			else
+				left = mid + 1;
+		}
+
+		for (size_t i = 0; i < c_rvec_range.size(); ++i)
+		{
+			TItemTable * p = c_rvec_range[i];
+
+			if (p->dwVnum < vnum && vnum < p->dwVnum + p->dwVnumRange)
+				return p;
+		}
+
+		return NULL;
+	}
+}
+
+void ITEM_MANAGER::VnumTableBenchmark(int iCount, std::string & rstResult)
+{
+	// 킬 루프에서 찾는 것들: 죽은 몹, 드롭으로 나오는 아이템, 데미지 계산의 스킬
+	std::vector<DWORD> vec_dwItem, vec_dwMob, vec_dwSkill;
+	std::vector<TItemTable *> vec_pkRange;
+
+	for (size_t i = 0; i < m_vec_dropPlan.size(); ++i)
+	{
+		const TDropPlan & c_rPlan = m_vec_dropPlan[i];
+
+		for (auto & entry : c_rPlan.vec_group)	vec_dwItem.push_back(entry.dwVnum);
+		for (auto & entry : c_rPlan.vec_level)	vec_dwItem.push_back(entry.dwVnum);
+		for (auto & entry : c_rPlan.vec_glove)	vec_dwItem.push_back(entry.dwVnum);
+
+		if (c_rPlan.dwEtcVnum)
+			vec_dwItem.push_back(c_rPlan.dwEtcVnum);
+	}
+
+	for (int i = 0; i < MOB_RANK_MAX_NUM; ++i)
+		for (size_t j = 0; j < g_vec_pkCommonDropItem[i].size(); ++j)
+			vec_dwItem.push_back(g_vec_pkCommonDropItem[i][j].m_dwVnum);
+
+	for (size_t i = 0; i < m_vec_prototype.size(); ++i)
+		if (m_vec_prototype[i].dwVnumRange)
+			vec_pkRange.push_back(&m_vec_prototype[i]);
+
+	std::map<DWORD, const CMob *> map_mob;
+	std::map<DWORD, CSkillProto *> map_skill;
+
+	for (CMobManager::iterator it = CMobManager::instance().begin(); it != CMobManager::instance().end(); ++it)
+	{
+		vec_dwMob.push_back(it->first);
+		map_mob.insert(std::make_pair(it->first, it->second));
+	}
+
+	for (DWORD dwVnum = 1; dwVnum <= SKILL_MAX_NUM; ++dwVnum)
+	{
+		CSkillProto * pkSk = CSkillManager::instance().Get(dwVnum);
+
+		if (pkSk)
+		{
+			vec_dwSkill.push_back(dwVnum);
+			map_skill.insert(std::make_pair(dwVnum, pkSk));
+		}
+	}
+
+	if (vec_dwItem.empty() || vec_dwMob.empty() || vec_dwSkill.empty())
+	{
+		rstResult = "vnum_bench: drop, mob or skill tables are empty";
+		return;
+	}
+
+	// 같은 순서로 두 방식을 잰다. 표본은 BENCH_SAMPLE_NUM 개를 돌려 쓰고,
+	// 표본 한 바퀴마다 시간 한도를 본다.
+	const int BENCH_SAMPLE_NUM = 4096;
+	DWORD adwItemSample[BENCH_SAMPLE_NUM], adwMobSample[BENCH_SAMPLE_NUM], adwSkillSample[BENCH_SAMPLE_NUM];
+
+	for (int i = 0; i < BENCH_SAMPLE_NUM; ++i)
+	{
+		adwItemSample[i] = vec_dwItem[number(0, vec_dwItem.size() - 1)];
+		adwMobSample[i] = vec_dwMob[number(0, vec_dwMob.size() - 1)];
+		adwSkillSample[i] = vec_dwSkill[number(0, vec_dwSkill.size() - 1)];
+	}
+
+	DWORD dwOldHit = 0, dwNewHit = 0;
+	uint64_t qwItemOld = 0, qwItemNew = 0, qwMobOld = 0, qwMobNew = 0, qwSkillOld = 0, qwSkillNew = 0;
+	CBenchBudget kBudget;
+	int iDone = 0;
+
+	while (iDone < iCount && !kBudget.IsOver())
+	{
+		const int n = MIN(BENCH_SAMPLE_NUM, iCount - iDone);
+
+		uint64_t ns = CMetrics::GetClockNs();
+		for (int i = 0; i < n; ++i)
+			if (BenchOldGetTable(m_vec_prototype, vec_pkRange, adwItemSample[i]))
+				++dwOldHit;
+		qwItemOld += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		for (int i = 0; i < n; ++i)
+			if (GetTable(adwItemSample[i]))
+				++dwNewHit;
+		qwItemNew += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		for (int i = 0; i < n; ++i)
+			if (map_mob.find(adwMobSample[i]) != map_mob.end())
+				++dwOldHit;
+		qwMobOld += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		for (int i = 0; i < n; ++i)
+			if (CMobManager::instance().Get(adwMobSample[i]))
+				++dwNewHit;
+		qwMobNew += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		for (int i = 0; i < n; ++i)
+			if (map_skill.find(adwSkillSample[i]) != map_skill.end())
+				++dwOldHit;
+		qwSkillOld += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		for (int i = 0; i < n; ++i)
+			if (CSkillManager::instance().Get(adwSkillSample[i]))
+				++dwNewHit;
+		qwSkillNew += CMetrics::GetClockNs() - ns;
+
+		iDone += n;
+	}
+
+	char szBuf[512];
+	snprintf(szBuf, sizeof(szBuf),
+			"vnum_bench %d lookups, ns per 1000: item (%u drop vnums, %u protos) binary search %llu -> table %llu; "
+			"mob (%u) map %llu -> table %llu; skill (%u) map %llu -> table %llu; hits %u/%u",
+			iDone,
+			(DWORD) vec_dwItem.size(), (DWORD) m_vec_prototype.size(),
+			(unsigned long long) (qwItemOld * 1000 / iDone), (unsigned long long) (qwItemNew * 1000 / iDone),
+			(DWORD) vec_dwMob.size(),
+			(unsigned long long) (qwMobOld * 1000 / iDone), (unsigned long long) (qwMobNew * 1000 / iDone),
+			(DWORD) vec_dwSkill.size(),
+			(unsigned long long) (qwSkillOld * 1000 / iDone), (unsigned long long) (qwSkillNew * 1000 / iDone),
+			dwOldHit, dwNewHit);
+	rstResult = szBuf;
+}
+
+void ITEM_MANAGER::DropBenchmark(LPCHARACTER pkChr, LPCHARACTER pkKiller, int iCount, std::string & rstResult)
+{
+	int iDeltaPercent, iRandRange;
+
+	if (!GetDropPct(pkChr, pkKiller, iDeltaPercent, iRandRange))
+	{
+		rstResult = "drop_bench: this mob drops nothing for you";
+		return;
+	}
+
+	// 굴림만 잰다. 아이템을 만들면 실제 아이템 ID 를 쓰게 된다.
+	std::vector<TDropRoll> vec_roll;
+	DWORD dwDrops = 0;
+	CBenchBudget kBudget;
+	int iKills = 0;
+
+	uint64_t ns = CMetrics::GetClockNs();
+
+	for (int i = 0; i < iCount && !kBudget.IsOver(); ++i, ++iKills)
+	{
+		vec_roll.clear();
+		RollDropItem(pkChr, pkKiller, iDeltaPercent, iRandRange, vec_roll);
+		dwDrops += vec_roll.size();
+	}
+
+	uint64_t qwRollNs = CMetrics::GetClockNs() - ns;
+
+	char szBuf[512];
+	snprintf(szBuf, sizeof(szBuf),
+			"drop_bench mob %u, %d kills (delta %d%%, range %d): rolls %llu ns per kill, %u drops",
+			pkChr->GetRaceNum(), iKills, iDeltaPercent, iRandRange,
+			(unsigned long long) (qwRollNs / iKills), dwDrops);
+	rstResult = szBuf;
+}
+
+bool ITEM_MANAGER::CreateDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, std::vector<LPITEM> & vec_item)
+{
+	int iDeltaPercent, iRandRange;
+	if (!GetDropPct(pkChr, pkKiller, iDeltaPercent, iRandRange))
+		return false;
+
+	LPITEM item = NULL;
+
+	// 굴린 드롭은 모두 만든다. 굴림만 따로 떼어 두어 drop_bench 가 그것만 잴 수 있다.
+	std::vector<TDropRoll> vec_roll;
 
+	RollDropItem(pkChr, pkKiller, iDeltaPercent, iRandRange, vec_roll);
+	CreateRolledItem(vec_roll, vec_item);
 
-	if (GetDropPerKillPct(100, 1000, iDeltaPercent, "lotto_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, 1000, iDeltaPercent, s_flagLottoDrop) >= number(1, iRandRange))
 	{
 		DWORD * pdw = M2_NEW DWORD[3];
 
 		pdw[0] = 50001;
 		pdw[1] = 1;
-		pdw[2] = quest::CQuestManager::instance().GetEventFlag("lotto_round");
+		pdw[2] = s_flagLottoRound.Get();
 
 		// 행운의 서는 소켓을 설정한다
 		DBManager::instance().ReturnQuery(QID_LOTTO, pkKiller->GetPlayerID(), pdw,
@@ -1396,7 +1713,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	__DropEvent_RefineBox_DropItem(*pkKiller, *pkChr, *this, vec_item);
 
 	// 크리스마스 양말
-	if (quest::CQuestManager::instance().GetEventFlag("xmas_sock"))
+	if (s_flagXmasSock.Get())
 	{
 		//const DWORD SOCK_ITEM_VNUM = 50010;
 		DWORD	SOCK_ITEM_VNUM	= 0;
@@ -1438,7 +1755,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 월광 보합
-	if (quest::CQuestManager::instance().GetEventFlag("drop_moon"))
+	if (s_flagDropMoon.Get())
 	{
 		const DWORD ITEM_VNUM = 50011;
 
@@ -1468,7 +1785,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	{
 		if (pkKiller->GetLevel() >= 15 && abs(pkKiller->GetLevel() - pkChr->GetLevel()) <= 5)
 		{
-			int pct = quest::CQuestManager::instance().GetEventFlag("hc_drop");
+			int pct = s_flagHcDrop.Get();
 
 			if (pct > 0)
 			{
@@ -1484,7 +1801,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	//육각보합
-	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "2006_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flag2006Drop) >= number(1, iRandRange))
 	{
 		sys_log(0, "육각보합 DROP EVENT ");
 
@@ -1496,7 +1813,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	//육각보합+
-	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "2007_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flag2007Drop) >= number(1, iRandRange))
 	{
 		sys_log(0, "육각보합 DROP EVENT ");
 
@@ -1507,7 +1824,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 새해 폭죽 이벤트
-	if (GetDropPerKillPct(/* minimum */ 100, /* default */ 1000, iDeltaPercent, "newyear_fire") >= number(1, iRandRange))
+	if (GetDropPerKillPct(/* minimum */ 100, /* default */ 1000, iDeltaPercent, s_flagNewyearFire) >= number(1, iRandRange))
 	{
 		// 중국은 폭죽, 한국 팽이
 		const DWORD ITEM_VNUM_FIRE = g_iUseLocale ? 50107 : 50108;
@@ -1517,7 +1834,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 새해 대보름 원소 이벤트
-	if (GetDropPerKillPct(100, 500, iDeltaPercent, "newyear_moon") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, 500, iDeltaPercent, s_flagNewyearMoon) >= number(1, iRandRange))
 	{
 		sys_log(0, "EVENT NEWYEAR_MOON DROP");
 
@@ -1529,7 +1846,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 발렌타인 데이 이벤트. OGE의 요구에 따라 event 최소값을 1로 변경.(다른 이벤트는 일단 그대로 둠.)
-	if (GetDropPerKillPct(1, g_iUseLocale ? 2000 : 800, iDeltaPercent, "valentine_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(1, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagValentineDrop) >= number(1, iRandRange))
 	{
 		sys_log(0, "EVENT VALENTINE_DROP");
 
@@ -1541,7 +1858,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 아이스크림 이벤트
-	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "icecream_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagIcecreamDrop) >= number(1, iRandRange))
 	{
 		const static DWORD icecream = 50123;
 
@@ -1551,13 +1868,13 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 
 	// new 크리스마스 이벤트
 	// 53002 : 아기 순록 소환권
-	if ((pkKiller->CountSpecifyItem(53002) > 0) && (GetDropPerKillPct(50, 100, iDeltaPercent, "new_xmas_event") >= number(1, iRandRange)))
+	if ((pkKiller->CountSpecifyItem(53002) > 0) && (GetDropPerKillPct(50, 100, iDeltaPercent, s_flagNewXmasEvent) >= number(1, iRandRange)))
 	{
 		const static DWORD xmas_sock = 50010;
 		pkKiller->AutoGiveItem (xmas_sock, 1);
 	}
 
-	if ((pkKiller->CountSpecifyItem(53007) > 0) && (GetDropPerKillPct(50, 100, iDeltaPercent, "new_xmas_event") >= number(1, iRandRange)))
+	if ((pkKiller->CountSpecifyItem(53007) > 0) && (GetDropPerKillPct(50, 100, iDeltaPercent, s_flagNewXmasEvent) >= number(1, iRandRange)))
 	{
 		const static DWORD xmas_sock = 50010;
 		pkKiller->AutoGiveItem (xmas_sock, 1);
@@ -1570,7 +1887,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	//		vec_item.push_back(item);
 	//}
 
-	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "halloween_drop") >= number(1, iRandRange) )
+	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagHalloweenDrop) >= number(1, iRandRange) )
 	{
 		const static DWORD halloween_item = 30321;
 
@@ -1578,7 +1895,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 			vec_item.push_back(item);
 	}
 	
-	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "ramadan_drop") >= number(1, iRandRange) )
+	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagRamadanDrop) >= number(1, iRandRange) )
 	{
 		const static DWORD ramadan_item = 30315;
 
@@ -1586,7 +1903,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 			vec_item.push_back(item);
 	}
 
-	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "easter_drop") >= number(1, iRandRange) )
+	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagEasterDrop) >= number(1, iRandRange) )
 	{
 		const static DWORD easter_item_base = 50160;
 
@@ -1595,7 +1912,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 월드컵 이벤트
-	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "football_drop") >= number(1, iRandRange) )
+	if ( GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagFootballDrop) >= number(1, iRandRange) )
 	{
 		const static DWORD football_item = 50096;
 
@@ -1604,7 +1921,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 화이트 데이 이벤트
-	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, "whiteday_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, g_iUseLocale ? 2000 : 800, iDeltaPercent, s_flagWhitedayDrop) >= number(1, iRandRange))
 	{
 		sys_log(0, "EVENT WHITEDAY_DROP");
 		const static DWORD whiteday_items[2] = { ITEM_WHITEDAY_ROSE, ITEM_WHITEDAY_CANDY };
@@ -1617,7 +1934,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	// 어린이날 수수께끼 상자 이벤트
 	if (pkKiller->GetLevel()>=50)
 	{
-		if (GetDropPerKillPct(100, 1000, iDeltaPercent, "kids_day_drop_high") >= number(1, iRandRange))
+		if (GetDropPerKillPct(100, 1000, iDeltaPercent, s_flagKidsDayDropHigh) >= number(1, iRandRange))
 		{
 			DWORD ITEM_QUIZ_BOX = 50034;
 
@@ -1627,7 +1944,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 	else
 	{
-		if (GetDropPerKillPct(100, 1000, iDeltaPercent, "kids_day_drop") >= number(1, iRandRange))
+		if (GetDropPerKillPct(100, 1000, iDeltaPercent, s_flagKidsDayDrop) >= number(1, iRandRange))
 		{
 			DWORD ITEM_QUIZ_BOX = 50034;
 
@@ -1637,7 +1954,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 올림픽 드롭 이벤트
-	if (pkChr->GetLevel() >= 30 && GetDropPerKillPct(50, 100, iDeltaPercent, "medal_part_drop") >= number(1, iRandRange))
+	if (pkChr->GetLevel() >= 30 && GetDropPerKillPct(50, 100, iDeltaPercent, s_flagMedalPartDrop) >= number(1, iRandRange))
 	{
 		const static DWORD drop_items[] = { 30265, 30266, 30267, 30268, 30269 };
 		int i = number (0, 4);
@@ -1648,7 +1965,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 
 	// ADD_GRANDMASTER_SKILL
 	// 혼석 아이템 드롭
-	if (pkChr->GetLevel() >= 40 && pkChr->GetMobRank() >= MOB_RANK_BOSS && GetDropPerKillPct(/* minimum */ 1, /* default */ 1000, iDeltaPercent, "three_skill_item") / GetThreeSkillLevelAdjust(pkChr->GetLevel()) >= number(1, iRandRange))
+	if (pkChr->GetLevel() >= 40 && pkChr->GetMobRank() >= MOB_RANK_BOSS && GetDropPerKillPct(/* minimum */ 1, /* default */ 1000, iDeltaPercent, s_flagThreeSkillItem) / GetThreeSkillLevelAdjust(pkChr->GetLevel()) >= number(1, iRandRange))
 	{
 		const DWORD ITEM_VNUM = 50513;
 
@@ -1660,7 +1977,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	//
 	// 종자 아이템 drop
 	//
-	if (GetDropPerKillPct(100, 1000, iDeltaPercent, "dragon_boat_festival_drop") >= number(1, iRandRange))
+	if (GetDropPerKillPct(100, 1000, iDeltaPercent, s_flagDragonBoatFestivalDrop) >= number(1, iRandRange))
 	{
 		const DWORD ITEM_SEED = 50085;
 
@@ -1669,7 +1986,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 	}
 
 	// 무신의 축복서용 만년한철 drop
-	if (pkKiller->GetLevel() >= 15 && quest::CQuestManager::instance().GetEventFlag("mars_drop"))
+	if (pkKiller->GetLevel() >= 15 && s_flagMarsDrop.Get())
 	{
 		const DWORD ITEM_HANIRON = 70035;
 		int iDropMultiply[MOB_RANK_MAX_NUM] =
@@ -1683,7 +2000,7 @@ void ITEM_MANAGER::CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller,
 		};
 
 		if (iDropMultiply[pkChr->GetMobRank()] &&
-				GetDropPerKillPct(1000, 1500, iDeltaPercent, "mars_drop") >= number(1, iRandRange) * iDropMultiply[pkChr->GetMobRank()])
+				GetDropPerKillPct(1000, 1500, iDeltaPercent, s_flagMarsDrop) >= number(1, iRandRange) * iDropMultiply[pkChr->GetMobRank()])
 		{
 			if ((item = CreateItem(ITEM_HANIRON, 1, 0, true)))
 				vec_item.push_back(item);
@@ -1,9 +1,8 @@
 ﻿#ifndef __INC_ITEM_MANAGER__
 #define __INC_ITEM_MANAGER__
 
-#ifdef M2_USE_POOL
-#include "pool.h"
-#endif
+#include "slab.h"
+#include "vnum_table.h"
 
 // special_item_group.txt에서 정의하는 속성 그룹
 // type attr로 선언할 수 있다.
@@ -28,6 +27,39 @@ public:
 	std::vector<CSpecialAttrInfo> m_vecAttrs;
 };
 
+// Weighted pick in O(1) with a single number() draw (integer Vose alias method).
+// A draw u in [0, n * total) selects column u / total, which keeps its own entry
+// when u % total falls under the column threshold and yields its alias otherwise,
+// so every entry comes out with exactly weight / total.
+class CDropAliasTable
+{
+	public:
+		CDropAliasTable() : m_iTotal(0)
+		{
+		}
+
+		// Fails (and stays empty) on no entries, a negative weight, or n * total past INT_MAX.
+		bool	Build(const std::vector<int> & c_rvecWeight);
+
+		bool	IsEmpty() const
+		{
+			return m_vecThreshold.empty();
+		}
+
+		int		Pick() const
+		{
+			int u = number(0, (int) m_vecThreshold.size() * m_iTotal - 1);
+			int col = u / m_iTotal;
+
+			return (u % m_iTotal) < m_vecThreshold[col] ? col : m_vecAlias[col];
+		}
+
+	protected:
+		int					m_iTotal;
+		std::vector<int>	m_vecThreshold;
+		std::vector<int>	m_vecAlias;
+};
+
 class CSpecialItemGroup
 {
 	public:
@@ -111,8 +143,22 @@ class CSpecialItemGroup
 			}
 		}
 
+		// 아이템을 다 넣은 뒤 한 번 부른다.
+		void Finalize()
+		{
+			std::vector<int> vecWeight(m_vecProbs.size());
+
+			for (size_t i = 0; i < m_vecProbs.size(); ++i)
+				vecWeight[i] = m_vecProbs[i] - (i ? m_vecProbs[i - 1] : 0);
+
+			m_kAlias.Build(vecWeight);
+		}
+
 		int GetOneIndex() const
 		{
+			if (!m_kAlias.IsEmpty())
+				return m_kAlias.Pick();
+
 			int n = number(1, m_vecProbs.back());
 			itertype(m_vecProbs) it = lower_bound(m_vecProbs.begin(), m_vecProbs.end(), n);
 			return std::distance(m_vecProbs.begin(), it);
@@ -163,6 +209,7 @@ class CSpecialItemGroup
 		BYTE	m_bType;
 		std::vector<int> m_vecProbs;
 		std::vector<CSpecialItemInfo> m_vecItems; // vnum, count
+		CDropAliasTable m_kAlias;
 };
 
 class CMobItemGroup
@@ -209,8 +256,22 @@ class CMobItemGroup
 			return m_vecProbs.empty();
 		}
 
+		// 아이템을 다 넣은 뒤 한 번 부른다.
+		void Finalize()
+		{
+			std::vector<int> vecWeight(m_vecProbs.size());
+
+			for (size_t i = 0; i < m_vecProbs.size(); ++i)
+				vecWeight[i] = m_vecProbs[i] - (i ? m_vecProbs[i - 1] : 0);
+
+			m_kAlias.Build(vecWeight);
+		}
+
 		int GetOneIndex() const
 		{
+			if (!m_kAlias.IsEmpty())
+				return m_kAlias.Pick();
+
 			int n = number(1, m_vecProbs.back());
 			itertype(m_vecProbs) it = lower_bound(m_vecProbs.begin(), m_vecProbs.end(), n);
 			return std::distance(m_vecProbs.begin(), it);
@@ -228,6 +289,7 @@ class CMobItemGroup
 		std::string m_stName;
 		std::vector<int> m_vecProbs;
 		std::vector<SMobItemGroupInfo> m_vecItems;
+		CDropAliasTable m_kAlias;
 };
 
 class CDropItemGroup
@@ -346,8 +408,53 @@ class CBuyerThiefGlovesItemGroup
 
 class ITEM;
 
+// 몹 하나가 죽을 때 굴리는 드롭 그룹들을 몹 vnum 별로 미리 펼쳐 둔 것.
+// BuildDropPlans() 가 드롭 파일을 다 읽은 뒤에 만든다.
+typedef struct SDropPlanEntry
+{
+	DWORD	dwVnum;
+	DWORD	dwPct;
+	int		iCount;
+	bool	bPolymorph;		// proto 가 ITEM_POLYMORPH 인가
+} TDropPlanEntry;
+
+typedef struct SDropPlan
+{
+	std::vector<TDropPlanEntry>	vec_group;			// drop_item_group
+	CMobItemGroup *				pkMobItemGroup;		// mob_drop_item kill 그룹, 비었으면 NULL
+	DWORD						dwLevelLimit;
+	std::vector<TDropPlanEntry>	vec_level;			// limit 그룹
+	std::vector<TDropPlanEntry>	vec_glove;			// thiefgloves 그룹
+	DWORD						dwEtcVnum;			// 몹 proto 의 drop item vnum
+	DWORD						dwEtcPct;			// etc_drop_item 확률, 없으면 0
+
+	SDropPlan() : pkMobItemGroup(NULL), dwLevelLimit(0), dwEtcVnum(0), dwEtcPct(0)
+	{
+	}
+} TDropPlan;
+
+// RollDropItem 이 굴려서 나온 드롭 하나. 아이템은 CreateRolledItem 에서 만든다.
+typedef struct SDropRoll
+{
+	DWORD	dwVnum;
+	int		iCount;
+	int		iRarePct;
+	int		iPolymorphRace;		// 0번 소켓에 넣을 변신 몹 vnum, 없으면 -1
+
+	SDropRoll(DWORD vnum, int count, int rare_pct = -1, int polymorph_race = -1)
+		: dwVnum(vnum), iCount(count), iRarePct(rare_pct), iPolymorphRace(polymorph_race)
+	{
+	}
+} TDropRoll;
+
 class ITEM_MANAGER : public singleton<ITEM_MANAGER>
 {
+	public:
+		enum
+		{
+			ITEM_VNUM_RANGE_DIRECT_MAX = 65536,	// wider vnum ranges stay in the linear fallback
+		};
+
 	public:
 		ITEM_MANAGER();
 		virtual ~ITEM_MANAGER();
@@ -384,6 +491,17 @@ class ITEM_MANAGER : public singleton<ITEM_MANAGER>
 
 		bool			GetDropPct(LPCHARACTER pkChr, LPCHARACTER pkKiller, OUT int& iDeltaPercent, OUT int& iRandRange);
 		bool			CreateDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, std::vector<LPITEM> & vec_item);
+		void			RollDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, int iDeltaPercent, int iRandRange, std::vector<TDropRoll> & vec_roll);
+		void			CreateRolledItem(const std::vector<TDropRoll> & c_rvec_roll, std::vector<LPITEM> & vec_item);
+
+		// vnum_bench: 킬 루프에서 찾는 아이템/몹/스킬 proto 를 예전 방식과 비교해 잰다
+		void			VnumTableBenchmark(int iCount, std::string & rstResult);
+		// drop_bench: pkChr 를 iCount 번 잡았을 때의 드롭 굴림 비용을 잰다. 아이템은 만들지 않는다.
+		void			DropBenchmark(LPCHARACTER pkChr, LPCHARACTER pkKiller, int iCount, std::string & rstResult);
+
+		// 드롭 파일을 모두 읽은 뒤에 부른다.
+		void			BuildDropPlans();
+		const TDropPlan *	GetDropPlan(DWORD dwMobVnum) const	{ return m_tableDropPlan.Get(dwMobVnum); }
 
 		bool			ReadCommonDropItemFile(const char * c_pszFileName);
 		bool			ReadEtcDropItemFile(const char * c_pszFileName);
@@ -423,19 +541,16 @@ class ITEM_MANAGER : public singleton<ITEM_MANAGER>
 		}
 
 	protected:
-		int                     RealNumber(DWORD vnum);
 		void			CreateQuestDropItem(LPCHARACTER pkChr, LPCHARACTER pkKiller, std::vector<LPITEM> & vec_item, int iDeltaPercent, int iRandRange);
 
 	protected:
-		typedef std::map<DWORD, LPITEM> ITEM_VID_MAP;		
-
 		std::vector<TItemTable>		m_vec_prototype;
-		std::vector<TItemTable*> m_vec_item_vnum_range_info;
+		CVnumTable<TItemTable>		m_tableProto;		///< vnum 및 vnum range -> m_vec_prototype
+		std::vector<TItemTable*> m_vec_item_vnum_range_info;	///< m_tableProto 에 펼치기엔 너무 넓은 range 만
 		std::map<DWORD, DWORD>		m_map_ItemRefineFrom;
 		int				m_iTopOfTable;
 
-		ITEM_VID_MAP			m_VIDMap;			///< m_dwVIDCount 의 값단위로 아이템을 저장한다.
-		DWORD				m_dwVIDCount;			///< 이녀석 VID가 아니라 그냥 프로세스 단위 유니크 번호다.
+		CObjectSlab<CItem, 20, 1024>	m_slabItem;		///< 살아있는 모든 아이템. slab handle 이 곧 VID 다.
 		DWORD				m_dwCurrentID;
 		TItemIDRangeTable	m_ItemIDRange;
 		TItemIDRangeTable	m_ItemIDSpareRange;
@@ -451,6 +566,9 @@ class ITEM_MANAGER : public singleton<ITEM_MANAGER>
 		std::map<DWORD, CLevelItemGroup*> m_map_pkLevelItemGroup;
 		std::map<DWORD, CBuyerThiefGlovesItemGroup*> m_map_pkGloveItemGroup;
 
+		std::vector<TDropPlan>		m_vec_dropPlan;
+		CVnumTable<TDropPlan>		m_tableDropPlan;	///< mob vnum -> m_vec_dropPlan
+
 		// CHECK_UNIQUE_GROUP
 		std::map<DWORD, int>		m_ItemToSpecialGroup;
 		// END_OF_CHECK_UNIQUE_GROUP
@@ -477,10 +595,6 @@ class ITEM_MANAGER : public singleton<ITEM_MANAGER>
 		const static int MAX_NORM_ATTR_NUM = 5;
 		const static int MAX_RARE_ATTR_NUM = 2;
 		bool ReadItemVnumMaskTable(const char * c_pszFileName);
-	private:
-#ifdef M2_USE_POOL
-		ObjectPool<CItem> pool_;
-#endif
 };
 
 #ifndef DEBUG_ALLOC
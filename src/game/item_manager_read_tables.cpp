@@ -287,6 +287,7 @@ bool ITEM_MANAGER::ReadSpecialDropItemFile(const char * c_pszFileName)
 				break;
 			}
 			loader.SetParentNode();
+			pkGroup->Finalize();
 			if (CSpecialItemGroup::QUEST == type)
 			{
 				m_map_pkQuestItemGroup.insert(std::make_pair(iVnum, pkGroup));
@@ -619,6 +620,7 @@ bool ITEM_MANAGER::ReadMonsterDropItemGroup(const char * c_pszFileName)
 
 				break;
 			}
+			pkGroup->Finalize();
 			m_map_pkMobItemGroup.insert(std::map<DWORD, CMobItemGroup*>::value_type(iMobVnum, pkGroup));
 
 		}
@@ -58,6 +58,8 @@
 #include "SpeedServer.h"
 #include "DragonSoul.h"
 #include "idle_hunting_manager.h"
+#include "metrics.h"
+#include "pathfinder.h"
 
 // #ifndef OS_WINDOWS
 // #include <gtest/gtest.h>
@@ -209,19 +211,36 @@ extern std::map<DWORD, CLoginSim *> g_simByPID;
 extern std::vector<TPlayerTable> g_vec_save;
 unsigned int save_idx = 0;
 
+bool g_bInHeartbeat = false;
+
+struct SHeartbeatScope
+{
+	SHeartbeatScope()	{ g_bInHeartbeat = true; }
+	~SHeartbeatScope()	{ g_bInHeartbeat = false; }
+};
+
 void heartbeat(LPHEART ht, int pulse) 
 {
+	SHeartbeatScope scope;
+	M2_TRACE_SCOPE_ARG("heartbeat", pulse);
 	DWORD t;
+	uint64_t ns = CMetrics::GetClockNs();
 
 	t = get_dword_time();
-	num_events_called += event_process(pulse);
+	int iEvents = event_process(pulse);
+	num_events_called += iEvents;
+	CMetrics::instance().AddEvents(iEvents);
 	s_dwProfiler[PROF_EVENT] += (get_dword_time() - t);
+	ns = CMetrics::instance().ObservePhase(METRIC_PHASE_EVENT, ns);
 
 	t = get_dword_time();
 
 	// 1초마다
 	if (!(pulse % ht->passes_per_sec))
 	{
+		CAffectExpiryWheel::instance().Update();
+		CPathFinder::instance().Update();
+
 		if (!g_bAuthServer)
 		{
 			TPlayerCountPacket pack;
@@ -273,6 +292,8 @@ void heartbeat(LPHEART ht, int pulse)
 	if (!(pulse % (passes_per_sec + 4)))
 		CHARACTER_MANAGER::instance().ProcessDelayedSave();
 
+	regen_process();
+
 	// 약 5.08초마다
 	if (!(pulse % (passes_per_sec * 5 + 2)))
 	{
@@ -281,10 +302,12 @@ void heartbeat(LPHEART ht, int pulse)
 	}
 
 	s_dwProfiler[PROF_HEARTBEAT] += (get_dword_time() - t);
+	ns = CMetrics::instance().ObservePhase(METRIC_PHASE_HEARTBEAT, ns);
 
 	DBManager::instance().Process();
 	AccountDB::instance().Process();
 	CPVPManager::instance().Process();
+	CMetrics::instance().ObservePhase(METRIC_PHASE_DB, ns);
 
 	if (g_bShutdown)
 	{
@@ -332,7 +355,10 @@ int main(int argc, char **argv)
 
 	WriteVersion();
 	
+	CMetrics	metrics;
 	SECTREE_MANAGER	sectree_manager;
+	CPathFinder		pathfinder;
+	CAffectExpiryWheel	affect_expiry_wheel;	// outlives every character
 	CHARACTER_MANAGER	char_manager;
 	ITEM_MANAGER	item_manager;
 	CShopManager	shop_manager;
@@ -584,6 +610,9 @@ int start(int argc, char **argv)
 	config_init(st_localeServiceName);
 	// END_OF_LOCALE_SERVICE
 
+	M2_TRACE_SET_TRIGGER(g_iTraceSpikeMs, g_iTraceWindowSec, g_stTraceDir.c_str());
+	CPathFinder::instance().SetBudget(g_iPathBudget);
+
 #ifdef OS_WINDOWS
 	// In Windows dev mode, "verbose" option is [on] by default.
 	bVerbose = true;
@@ -723,6 +752,13 @@ int idle()
 	assert(passed_pulses > 0);
 
 	DWORD t;
+	uint64_t qwLoopStart = CMetrics::GetClockNs();
+	uint64_t ns;
+
+	CMetrics::instance().AddPulses(passed_pulses);
+#ifdef ENABLE_SCOPED_TRACE
+	int iPulses = passed_pulses;
+#endif
 
 	while (passed_pulses--) {
 		heartbeat(thecore_heart, ++thecore_heart->pulse);
@@ -731,14 +767,21 @@ int idle()
 		thecore_tick();
 	}
 
+	ns = CMetrics::GetClockNs();
 	t = get_dword_time();
 	CHARACTER_MANAGER::instance().Update(thecore_heart->pulse);
 	db_clientdesc->Update(t);
 	s_dwProfiler[PROF_CHR_UPDATE] += (get_dword_time() - t);
+	ns = CMetrics::instance().ObservePhase(METRIC_PHASE_CHR_UPDATE, ns);
 
 	t = get_dword_time();
 	if (!io_loop(main_fdw)) return 0;
 	s_dwProfiler[PROF_IO] += (get_dword_time() - t);
+	CMetrics::instance().ObservePhase(METRIC_PHASE_IO, ns);
+	ns = CMetrics::instance().ObservePhase(METRIC_PHASE_LOOP, qwLoopStart);
+
+	// Same clock as the trace scopes, so the loop span brackets them in the dump.
+	M2_TRACE_PULSE("loop", qwLoopStart, ns, iPulses);
 
 	gettimeofday(&now, (struct timezone *) 0);
 	++process_time_count;
@@ -753,6 +796,7 @@ int idle()
 
 		memset(&thecore_profiler[0], 0, sizeof(thecore_profiler));
 		memset(&s_dwProfiler[0], 0, sizeof(s_dwProfiler));
+		CMetrics::instance().RollSecond();
 	}
 
 #ifdef OS_WINDOWS
@@ -0,0 +1,195 @@
+﻿#include "stdafx.h"
+#include <chrono>
+#include <sstream>
+
+#include "constants.h"
+#include "metrics.h"
+#include "desc_manager.h"
+#include "p2p.h"
+#include "char_manager.h"
+#include "char.h"
+#include "regen.h"
+#include "db.h"
+
+namespace
+{
+	// bucket upper bounds in microseconds; 40000 is one pulse at 25 pps
+	const uint64_t s_aqwBucketLimitUs[CMetrics::LATENCY_BUCKET_NUM] =
+	{
+		50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 40000, 100000, 250000, 1000000
+	};
+
+	const char * s_aszPhaseName[METRIC_PHASE_MAX_NUM] =
+	{
+		"event",
+		"heartbeat",
+		"db",
+		"chr_update",
+		"io",
+		"loop",
+	};
+
+	const char * s_aszBroadcastName[CMetrics::BROADCAST_KIND_NUM] =
+	{
+		"target",
+		"party",
+		"update",
+		"points",
+		"far_move",
+	};
+
+	static_assert((int) CMetrics::BROADCAST_KIND_NUM == (int) PENDING_BROADCAST_MAX_NUM, "broadcast kinds out of sync");
+}
+
+CMetrics::CMetrics()
+{
+	memset(m_aHistogram, 0, sizeof(m_aHistogram));
+
+	m_qwEvents = 0;
+	m_qwPulses = 0;
+	m_qwMissedPulses = 0;
+	m_qwBytesIn = 0;
+	m_qwBytesOut = 0;
+	memset(m_aqwBroadcastRequested, 0, sizeof(m_aqwBroadcastRequested));
+	memset(m_aqwBroadcastSent, 0, sizeof(m_aqwBroadcastSent));
+}
+
+CMetrics::~CMetrics()
+{
+}
+
+uint64_t CMetrics::GetClockNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t CMetrics::ObservePhase(BYTE bPhase, uint64_t qwStartNs)
+{
+	uint64_t qwNow = GetClockNs();
+	uint64_t qwElapsed = qwNow - qwStartNs;
+	uint64_t qwElapsedUs = qwElapsed / 1000;
+
+	THistogram & r = m_aHistogram[bPhase];
+
+	int i = 0;
+
+	while (i < LATENCY_BUCKET_NUM && qwElapsedUs > s_aqwBucketLimitUs[i])
+		++i;
+
+	++r.aqwBucket[i];
+	r.qwSumNs += qwElapsed;
+	++r.qwCount;
+
+	if (qwElapsed > r.qwMaxNs)
+		r.qwMaxNs = qwElapsed;
+
+	return qwNow;
+}
+
+void CMetrics::AddPulses(int iPassed)
+{
+	// thecore_idle() returns more than one pulse only when the loop fell behind
+	m_qwPulses += iPassed;
+
+	if (iPassed > 1)
+		m_qwMissedPulses += iPassed - 1;
+}
+
+void CMetrics::RollSecond()
+{
+	for (int i = 0; i < METRIC_PHASE_MAX_NUM; ++i)
+	{
+		m_aHistogram[i].qwLastMaxNs = m_aHistogram[i].qwMaxNs;
+		m_aHistogram[i].qwMaxNs = 0;
+	}
+}
+
+std::string CMetrics::Render() const
+{
+	std::ostringstream oss;
+
+	oss << "# TYPE game_phase_duration_seconds histogram\n";
+
+	for (int iPhase = 0; iPhase < METRIC_PHASE_MAX_NUM; ++iPhase)
+	{
+		const THistogram & r = m_aHistogram[iPhase];
+		uint64_t qwCumulative = 0;
+
+		for (int i = 0; i < LATENCY_BUCKET_NUM; ++i)
+		{
+			qwCumulative += r.aqwBucket[i];
+			oss << "game_phase_duration_seconds_bucket{phase=\"" << s_aszPhaseName[iPhase] << "\",le=\""
+				<< s_aqwBucketLimitUs[i] / 1000000.0 << "\"} " << qwCumulative << "\n";
+		}
+
+		qwCumulative += r.aqwBucket[LATENCY_BUCKET_NUM];
+		oss << "game_phase_duration_seconds_bucket{phase=\"" << s_aszPhaseName[iPhase] << "\",le=\"+Inf\"} " << qwCumulative << "\n";
+		oss << "game_phase_duration_seconds_sum{phase=\"" << s_aszPhaseName[iPhase] << "\"} " << r.qwSumNs / 1000000000.0 << "\n";
+		oss << "game_phase_duration_seconds_count{phase=\"" << s_aszPhaseName[iPhase] << "\"} " << r.qwCount << "\n";
+	}
+
+	oss << "# TYPE game_phase_last_second_max_seconds gauge\n";
+
+	for (int iPhase = 0; iPhase < METRIC_PHASE_MAX_NUM; ++iPhase)
+		oss << "game_phase_last_second_max_seconds{phase=\"" << s_aszPhaseName[iPhase] << "\"} " << m_aHistogram[iPhase].qwLastMaxNs / 1000000000.0 << "\n";
+
+	oss << "# TYPE game_pulses_total counter\n";
+	oss << "game_pulses_total " << m_qwPulses << "\n";
+	oss << "# TYPE game_missed_pulses_total counter\n";
+	oss << "game_missed_pulses_total " << m_qwMissedPulses << "\n";
+
+	oss << "# TYPE game_events_processed_total counter\n";
+	oss << "game_events_processed_total " << m_qwEvents << "\n";
+	oss << "# TYPE game_events_pending gauge\n";
+	oss << "game_events_pending " << event_count() << "\n";
+
+	oss << "# TYPE game_sql_queue_depth gauge\n";
+	oss << "game_sql_queue_depth{queue=\"query\"} " << DBManager::instance().CountQuery() << "\n";
+	oss << "game_sql_queue_depth{queue=\"result\"} " << DBManager::instance().CountQueryResult() << "\n";
+
+	int iTotal;
+	int * paiEmpireUserCount;
+	int iLocal;
+	DESC_MANAGER::instance().GetUserCount(iTotal, &paiEmpireUserCount, iLocal);
+
+	oss << "# TYPE game_descriptors gauge\n";
+	oss << "game_descriptors{kind=\"client\"} " << DESC_MANAGER::instance().GetClientSet().size() << "\n";
+	oss << "game_descriptors{kind=\"p2p\"} " << P2P_MANAGER::instance().GetDescCount() << "\n";
+	oss << "# TYPE game_users gauge\n";
+	oss << "game_users{scope=\"local\"} " << iLocal << "\n";
+	oss << "game_users{scope=\"total\"} " << iTotal << "\n";
+	oss << "# TYPE game_characters gauge\n";
+	oss << "game_characters " << CHARACTER_MANAGER::instance().GetCharacterCount() << "\n";
+
+	REGEN_SCHEDULER_STAT regenStat;
+	regen_get_scheduler_stat(regenStat);
+
+	oss << "# TYPE game_regen_backlog gauge\n";
+
+	for (itertype(regenStat.backlog) it = regenStat.backlog.begin(); it != regenStat.backlog.end(); ++it)
+		oss << "game_regen_backlog{map=\"" << it->first << "\"} " << it->second << "\n";
+
+	oss << "# TYPE game_regen_backlog_spawns gauge\n";
+	oss << "game_regen_backlog_spawns " << regenStat.missing << "\n";
+	oss << "# TYPE game_regen_spawn_cost_total counter\n";
+	oss << "game_regen_spawn_cost_total " << regenStat.spawned << "\n";
+	oss << "# TYPE game_regen_deferred_total counter\n";
+	oss << "game_regen_deferred_total " << regenStat.deferred << "\n";
+
+	// requested - sent is what per-pulse coalescing saved
+	oss << "# TYPE game_chr_broadcast_requested_total counter\n";
+
+	for (int i = 0; i < BROADCAST_KIND_NUM; ++i)
+		oss << "game_chr_broadcast_requested_total{kind=\"" << s_aszBroadcastName[i] << "\"} " << m_aqwBroadcastRequested[i] << "\n";
+
+	oss << "# TYPE game_chr_broadcast_sent_total counter\n";
+
+	for (int i = 0; i < BROADCAST_KIND_NUM; ++i)
+		oss << "game_chr_broadcast_sent_total{kind=\"" << s_aszBroadcastName[i] << "\"} " << m_aqwBroadcastSent[i] << "\n";
+
+	oss << "# TYPE game_network_bytes_total counter\n";
+	oss << "game_network_bytes_total{direction=\"in\"} " << m_qwBytesIn << "\n";
+	oss << "game_network_bytes_total{direction=\"out\"} " << m_qwBytesOut << "\n";
+
+	return oss.str();
+}
@@ -0,0 +1,97 @@
+﻿#ifndef __INC_METIN_II_GAME_METRICS_H__
+#define __INC_METIN_II_GAME_METRICS_H__
+
+//
+// Process-wide counters and pulse timing histograms, rendered in the
+// Prometheus text exposition format by the METRICS admin command.
+// Histograms are cumulative since boot; rolling windows come from rate()
+// on the scraper side, the *_last_second_max gauges cover the last second.
+//
+enum EMetricPhases
+{
+	METRIC_PHASE_EVENT,			// event_process()
+	METRIC_PHASE_HEARTBEAT,		// periodic work inside heartbeat()
+	METRIC_PHASE_DB,			// DBManager/AccountDB/PVP processing
+	METRIC_PHASE_CHR_UPDATE,	// CHARACTER_MANAGER::Update and db desc
+	METRIC_PHASE_IO,			// io_loop()
+	METRIC_PHASE_LOOP,			// one whole idle() iteration
+	METRIC_PHASE_MAX_NUM
+};
+
+class CMetrics : public singleton<CMetrics>
+{
+	public:
+		enum
+		{
+			LATENCY_BUCKET_NUM = 13,
+			BROADCAST_KIND_NUM = 5,		// == PENDING_BROADCAST_MAX_NUM
+		};
+
+	public:
+		CMetrics();
+		virtual ~CMetrics();
+
+		static uint64_t	GetClockNs();
+
+		// Records now - qwStartNs for the phase and returns now, so phases can be chained.
+		uint64_t		ObservePhase(BYTE bPhase, uint64_t qwStartNs);
+
+		void			AddEvents(int iCount)		{ m_qwEvents += iCount; }
+		void			AddPulses(int iPassed);
+		void			AddBytesIn(int iBytes)		{ m_qwBytesIn += iBytes; }
+		void			AddBytesOut(int iBytes)		{ m_qwBytesOut += iBytes; }
+
+		// Per-pulse coalesced character broadcasts, by EPendingBroadcasts kind.
+		void			AddBroadcastRequest(BYTE bKind)	{ ++m_aqwBroadcastRequested[bKind]; }
+		void			AddBroadcastSent(BYTE bKind)	{ ++m_aqwBroadcastSent[bKind]; }
+
+		// Called once a second from idle(), next to the legacy profiler reset.
+		void			RollSecond();
+
+		std::string		Render() const;
+
+	protected:
+		typedef struct SHistogram
+		{
+			uint64_t	aqwBucket[LATENCY_BUCKET_NUM + 1];	// last one is +Inf
+			uint64_t	qwSumNs;
+			uint64_t	qwCount;
+			uint64_t	qwMaxNs;		// current second
+			uint64_t	qwLastMaxNs;	// previous full second
+		} THistogram;
+
+		THistogram		m_aHistogram[METRIC_PHASE_MAX_NUM];
+
+		uint64_t		m_qwEvents;
+		uint64_t		m_qwPulses;
+		uint64_t		m_qwMissedPulses;
+		uint64_t		m_qwBytesIn;
+		uint64_t		m_qwBytesOut;
+		uint64_t		m_aqwBroadcastRequested[BROADCAST_KIND_NUM];
+		uint64_t		m_aqwBroadcastSent[BROADCAST_KIND_NUM];
+};
+
+//
+// Time limit for the GM benchmark commands, which run on the game thread.
+// A benchmark checks IsOver() before each run, stops once the budget is spent
+// and reports on the runs it actually did.
+//
+class CBenchBudget
+{
+	public:
+		enum
+		{
+			BUDGET_NS = 5 * 1000 * 1000,	// 5 ms, an eighth of a pulse
+		};
+
+		CBenchBudget() : m_qwEndNs(CMetrics::GetClockNs() + BUDGET_NS)
+		{
+		}
+
+		bool	IsOver() const	{ return CMetrics::GetClockNs() >= m_qwEndNs; }
+
+	protected:
+		uint64_t	m_qwEndNs;
+};
+
+#endif
@@ -37,7 +37,7 @@ void CMob::AddSkillSplash(int iIndex, DWORD dwTiming, DWORD dwHitDistance)
 }
 
 CMobInstance::CMobInstance()
-	: m_IsBerserk(false), m_IsGodSpeed(false), m_IsRevive(false)
+	: m_IsBerserk(false), m_IsGodSpeed(false), m_IsRevive(false), m_bReturnByPath(false)
 {
 	m_dwLastAttackedTime = get_dword_time();
 	m_dwLastWarpTime = get_dword_time();
@@ -57,6 +57,7 @@ bool CMobManager::Initialize(TMobTable * pTable, int iSize)
 {
 	m_map_pkMobByVnum.clear();
 	m_map_pkMobByName.clear();
+	m_tableMob.Clear();
 
 	TMobTable * t = pTable;
 
@@ -68,6 +69,7 @@ bool CMobManager::Initialize(TMobTable * pTable, int iSize)
 		thecore_memcpy(&pkMob->m_table, t, sizeof(TMobTable));
 
 		m_map_pkMobByVnum.insert(std::map<DWORD, CMob *>::value_type(t->dwVnum, pkMob));
+		m_tableMob.Set(t->dwVnum, pkMob);
 		m_map_pkMobByName.insert(std::map<std::string, CMob *>::value_type(t->szLocaleName, pkMob));
 
 		int SkillCount = 0;
@@ -126,12 +128,7 @@ void CMobManager::RebindMobProto(LPCHARACTER ch)
 
 const CMob * CMobManager::Get(DWORD dwVnum)
 {
-	std::map<DWORD, CMob *>::iterator it = m_map_pkMobByVnum.find(dwVnum);
-
-	if (it == m_map_pkMobByVnum.end())
-		return NULL;
-
-	return it->second;
+	return m_tableMob.Get(dwVnum);
 }
 
 const CMob * CMobManager::Get(const char * c_pszName, bool bIsAbbrev)
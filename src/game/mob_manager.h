@@ -1,6 +1,8 @@
 ﻿#ifndef __INC_METIN_II_MOB_MANAGER_H__
 #define __INC_METIN_II_MOB_MANAGER_H__
 
+#include "vnum_table.h"
+
 typedef struct SMobSplashAttackInfo
 {
 	DWORD	dwTiming; // 스킬 사용 후 실제로 데미지 먹힐때까지 기다리는 시간 (ms)
@@ -44,6 +46,7 @@ class CMobInstance
 		bool m_IsBerserk;
 		bool m_IsGodSpeed;
 		bool m_IsRevive;
+		bool m_bReturnByPath;	// Return() 이 경로 중간 지점까지만 갔다
 };
 
 class CMobGroupGroup
@@ -149,6 +152,7 @@ class CMobManager : public singleton<CMobManager>
 
 	private:
 		std::map<DWORD, CMob *> m_map_pkMobByVnum;
+		CVnumTable<CMob>		m_tableMob;
 		std::map<std::string, CMob *> m_map_pkMobByName;
 		std::map<DWORD, CMobGroup *> m_map_pkMobGroup;
 		std::map<DWORD, CMobGroupGroup *> m_map_pkMobGroupGroup;
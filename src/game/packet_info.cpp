@@ -1,24 +1,65 @@
 ﻿#include "stdafx.h"
+#include <bit>
+#include <chrono>
+
 #include "common/stl.h"
 #include "constants.h"
 #include "packet_info.h"
 
+namespace
+{
+	uint64_t GetPacketClockNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// upper bound of a latency bucket, in ns
+	uint64_t GetLatencyBucketLimit(int iBucket)
+	{
+		return (uint64_t) 1 << iBucket;
+	}
+
+	uint64_t GetLatencyPercentile(const TPacketElement * p, double dRatio)
+	{
+		uint64_t qwRank = (uint64_t) (p->iCalled * dRatio);
+		uint64_t qwSeen = 0;
+
+		for (int i = 0; i < PACKET_LATENCY_BUCKET_NUM; ++i)
+		{
+			qwSeen += p->adwLatency[i];
+
+			if (qwSeen > qwRank)
+				return std::min(GetLatencyBucketLimit(i), p->qwMaxNs);
+		}
+
+		return p->qwMaxNs;
+	}
+}
+
 CPacketInfo::CPacketInfo()
-	: m_pCurrentPacket(NULL), m_dwStartTime(0)
+	: m_pCurrentPacket(NULL), m_qwStartTime(0)
 {
+	memset(m_apPacketTable, 0, sizeof(m_apPacketTable));
 }
 
 CPacketInfo::~CPacketInfo()
 {
-	itertype(m_pPacketMap) it = m_pPacketMap.begin();
-	for ( ; it != m_pPacketMap.end(); ++it) {
-		M2_DELETE(it->second);
+	for (int i = 0; i < PACKET_HEADER_MAX_NUM; ++i)
+	{
+		if (m_apPacketTable[i])
+			M2_DELETE(m_apPacketTable[i]);
 	}
 }
 
 void CPacketInfo::Set(int header, int iSize, const char * c_pszName, bool bSeq)
 {
-	if (m_pPacketMap.find(header) != m_pPacketMap.end())
+	if (header < 0 || header >= PACKET_HEADER_MAX_NUM)
+	{
+		sys_err("packet header %d (%s) out of range", header, c_pszName);
+		return;
+	}
+
+	if (m_apPacketTable[header])
 		return;
 
 	TPacketElement * element = M2_NEW TPacketElement;
@@ -26,34 +67,16 @@ void CPacketInfo::Set(int header, int iSize, const char * c_pszName, bool bSeq)
 	element->iSize = iSize;
 	element->stName.assign(c_pszName);
 	element->iCalled = 0;
-	element->dwLoad = 0;
+	element->qwLoadNs = 0;
+	element->qwMaxNs = 0;
+	memset(element->adwLatency, 0, sizeof(element->adwLatency));
 
 	element->bSequencePacket = bSeq;
 
 	if (element->bSequencePacket)
 		element->iSize += sizeof(BYTE);
 
-	m_pPacketMap.insert(std::map<int, TPacketElement *>::value_type(header, element));
-}
-
-bool CPacketInfo::Get(int header, int * size, const char ** c_ppszName)
-{
-	std::map<int, TPacketElement *>::iterator it = m_pPacketMap.find(header);
-
-	if (it == m_pPacketMap.end())
-		return false;
-
-	*size = it->second->iSize;
-	*c_ppszName = it->second->stName.c_str();
-
-	m_pCurrentPacket = it->second;
-	return true;
-}
-
-bool CPacketInfo::IsSequence(int header)
-{
-	TPacketElement * pkElement = GetElement(header);
-	return pkElement ? pkElement->bSequencePacket : false;
+	m_apPacketTable[header] = element;
 }
 
 void CPacketInfo::SetSequence(int header, bool bSeq)
@@ -77,26 +100,23 @@ void CPacketInfo::SetSequence(int header, bool bSeq)
 	}
 }
 
-TPacketElement * CPacketInfo::GetElement(int header)
-{
-	std::map<int, TPacketElement *>::iterator it = m_pPacketMap.find(header);
-
-	if (it == m_pPacketMap.end())
-		return NULL;
-
-	return it->second;
-}
-
 void CPacketInfo::Start()
 {
 	assert(m_pCurrentPacket != NULL);
-	m_dwStartTime = get_dword_time();
+	m_qwStartTime = GetPacketClockNs();
 }
 
 void CPacketInfo::End()
 {
+	uint64_t qwElapsed = GetPacketClockNs() - m_qwStartTime;
+	int iBucket = std::min<int>(std::bit_width(qwElapsed), PACKET_LATENCY_BUCKET_NUM - 1);
+
 	++m_pCurrentPacket->iCalled;
-	m_pCurrentPacket->dwLoad += get_dword_time() - m_dwStartTime;
+	m_pCurrentPacket->qwLoadNs += qwElapsed;
+	++m_pCurrentPacket->adwLatency[iBucket];
+
+	if (qwElapsed > m_pCurrentPacket->qwMaxNs)
+		m_pCurrentPacket->qwMaxNs = qwElapsed;
 }
 
 void CPacketInfo::Log(const char * c_pszFileName)
@@ -108,20 +128,49 @@ void CPacketInfo::Log(const char * c_pszFileName)
 	if (!fp)
 		return;
 
-	std::map<int, TPacketElement *>::iterator it = m_pPacketMap.begin();
-
-	fprintf(fp, "Name             Called     Load       Ratio\n");
+	fprintf(fp, "Name             Called     Load(ms)   Avg(us)    p50(us)    p99(us)    Max(us)\n");
 
-	while (it != m_pPacketMap.end())
+	for (int header = 0; header < PACKET_HEADER_MAX_NUM; ++header)
 	{
-		TPacketElement * p = it->second;
-		++it;
+		TPacketElement * p = m_apPacketTable[header];
 
-		fprintf(fp, "%-16s %-10d %-10u %.2f\n",
+		if (!p)
+			continue;
+
+		fprintf(fp, "%-16s %-10d %-10.2f %-10.2f %-10.2f %-10.2f %-10.2f\n",
 				p->stName.c_str(),
 				p->iCalled,
-				p->dwLoad,
-				p->iCalled != 0 ? (float) p->dwLoad / p->iCalled : 0.0f);
+				p->qwLoadNs / 1000000.0,
+				p->iCalled != 0 ? p->qwLoadNs / 1000.0 / p->iCalled : 0.0,
+				GetLatencyPercentile(p, 0.50) / 1000.0,
+				GetLatencyPercentile(p, 0.99) / 1000.0,
+				p->qwMaxNs / 1000.0);
+	}
+
+	// log2 buckets: "<N:count" counts calls that took less than N ns
+	fprintf(fp, "\nLatency histogram (ns)\n");
+
+	for (int header = 0; header < PACKET_HEADER_MAX_NUM; ++header)
+	{
+		TPacketElement * p = m_apPacketTable[header];
+
+		if (!p || p->iCalled == 0)
+			continue;
+
+		fprintf(fp, "%-16s", p->stName.c_str());
+
+		for (int i = 0; i < PACKET_LATENCY_BUCKET_NUM; ++i)
+		{
+			if (!p->adwLatency[i])
+				continue;
+
+			if (i == PACKET_LATENCY_BUCKET_NUM - 1)
+				fprintf(fp, " >%llu:%u", (unsigned long long) GetLatencyBucketLimit(i - 1), p->adwLatency[i]);
+			else
+				fprintf(fp, " <%llu:%u", (unsigned long long) GetLatencyBucketLimit(i), p->adwLatency[i]);
+		}
+
+		fputc('\n', fp);
 	}
 
 	fclose(fp);
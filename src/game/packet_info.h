@@ -3,12 +3,20 @@
 
 #include "packet.h"
 
+enum
+{
+	PACKET_HEADER_MAX_NUM		= 256,
+	PACKET_LATENCY_BUCKET_NUM	= 32,	// bucket i holds [2^(i-1), 2^i) ns, the last one everything above
+};
+
 typedef struct SPacketElement
 {
 	int		iSize;
 	std::string	stName;
 	int		iCalled;
-	DWORD	dwLoad;
+	uint64_t	qwLoadNs;
+	uint64_t	qwMaxNs;
+	DWORD	adwLatency[PACKET_LATENCY_BUCKET_NUM];
 	bool	bSequencePacket;
 } TPacketElement;
 
@@ -19,23 +27,47 @@ class CPacketInfo
 		virtual ~CPacketInfo();
 
 		void Set(int header, int size, const char * c_pszName, bool bSeq=false);
-		bool Get(int header, int * size, const char ** c_ppszName);
+		bool Get(int header, int * size, const char ** c_ppszName)
+		{
+			TPacketElement * pkElement = GetElement(header);
+
+			if (!pkElement)
+				return false;
+
+			*size = pkElement->iSize;
+			*c_ppszName = pkElement->stName.c_str();
+
+			m_pCurrentPacket = pkElement;
+			return true;
+		}
 
 		void Start();
 		void End();
 
 		void Log(const char * c_pszFileName);
 
-		bool IsSequence(int header);
+		bool IsSequence(int header)
+		{
+			TPacketElement * pkElement = GetElement(header);
+			return pkElement ? pkElement->bSequencePacket : false;
+		}
+
 		void SetSequence(int header, bool bSeq);
 
 	private:
-		TPacketElement * GetElement(int header);
+		TPacketElement * GetElement(int header)
+		{
+			if (header < 0 || header >= PACKET_HEADER_MAX_NUM)
+				return NULL;
+
+			return m_apPacketTable[header];
+		}
 
 	protected:
-		std::map<int, TPacketElement *> m_pPacketMap;
+		// indexed by header byte; NULL for headers this processor does not accept
+		TPacketElement * m_apPacketTable[PACKET_HEADER_MAX_NUM];
 		TPacketElement * m_pCurrentPacket;
-		DWORD m_dwStartTime;
+		uint64_t m_qwStartTime;
 };
 
 class CPacketInfoCG : public CPacketInfo
@@ -0,0 +1,319 @@
+﻿#include "stdafx.h"
+#include "protocol.h"
+#include "packet_writer.h"
+#include "buffer_manager.h"
+#include "metrics.h"
+
+int packet_encrypt_copy(void * pvDest, const void * c_pvSrc, int iSize, const DWORD * c_pdwKey)
+{
+	// TEA_Encrypt 는 8바이트에 못 미치는 끝을 원본 뒤에 0으로 채우므로
+	// 그 끝만 먼저 옮겨 두고 제자리에서 한다.
+	int iBody = iSize & ~7;
+	int iEncrypted = 0;
+
+	if (iBody)
+		iEncrypted = TEA_Encrypt((DWORD *) pvDest, (const DWORD *) c_pvSrc, c_pdwKey, iBody);
+
+	if (iSize > iBody)
+	{
+		DWORD * pdwTail = (DWORD *) ((char *) pvDest + iBody);
+		memcpy(pdwTail, (const char *) c_pvSrc + iBody, iSize - iBody);
+		iEncrypted += TEA_Encrypt(pdwTail, pdwTail, c_pdwKey, iSize - iBody);
+	}
+
+	return iEncrypted;
+}
+
+namespace
+{
+	// DESC 가 쓰는 것과 같은 암호화로 잰다
+	class CBenchCipher
+	{
+		public:
+#ifdef _IMPROVED_PACKET_ENCRYPTION_
+			CBenchCipher()
+			{
+				// 서로 키를 맞춘 한 쌍 중 보내는 쪽만 쓴다
+				char szLocal[1024], szPeer[1024];
+				size_t lenLocal = sizeof(szLocal), lenPeer = sizeof(szPeer);
+				size_t agreed = m_kLocal.Prepare(szLocal, &lenLocal);
+				m_kPeer.Prepare(szPeer, &lenPeer);
+
+				m_kPeer.Activate(false, agreed, szLocal, lenLocal);
+				m_bActivated = agreed && m_kLocal.Activate(true, agreed, szPeer, lenPeer);
+			}
+
+			bool	IsReady() const	{ return m_bActivated; }
+			bool	IsPadded() const	{ return false; }
+			const char *	GetName() const	{ return "cipher"; }
+
+			int	EncryptInPlace(void * pv, int iSize)
+			{
+				m_kLocal.Encrypt(pv, iSize);
+				return iSize;
+			}
+
+			int	EncryptCopy(void * pvDest, const void * c_pvSrc, int iSize)
+			{
+				m_kLocal.Encrypt(pvDest, c_pvSrc, iSize);
+				return iSize;
+			}
+
+		private:
+			Cipher	m_kLocal;
+			Cipher	m_kPeer;
+			bool	m_bActivated;
+#else
+			bool	IsReady() const	{ return true; }
+			bool	IsPadded() const	{ return true; }
+			const char *	GetName() const	{ return "tea"; }
+
+			int	EncryptInPlace(void * pv, int iSize)
+			{
+				return TEA_Encrypt((DWORD *) pv, (DWORD *) pv, c_adwKey, iSize);
+			}
+
+			int	EncryptCopy(void * pvDest, const void * c_pvSrc, int iSize)
+			{
+				return packet_encrypt_copy(pvDest, c_pvSrc, iSize, c_adwKey);
+			}
+
+		private:
+			static constexpr DWORD c_adwKey[4] = { 0x31323334, 0x61626364, 0x35363738, 0x65666768 };
+#endif
+	};
+
+	struct SBenchStat
+	{
+		uint64_t	qwNs;
+		DWORD		dwCopies;
+		DWORD		dwBytes;
+
+		SBenchStat() : qwNs(0), dwCopies(0), dwBytes(0) {}
+	};
+
+	void BenchReserve(LPBUFFER buf)
+	{
+		if (buffer_has_space(buf) < 1024)
+			buffer_reset(buf);
+	}
+
+	// 예전 DESC::Packet: 출력 버퍼로 복사한 뒤 제자리에서 암호화
+	void BenchSendCopy(CBenchCipher & rCipher, LPBUFFER buf, const void * c_pvData, int iSize, SBenchStat & r)
+	{
+		BenchReserve(buf);
+
+		void * pvWritePoint = buffer_write_peek(buf);
+		buffer_write(buf, c_pvData, iSize);
+		++r.dwCopies;
+		r.dwBytes += iSize;
+
+		int iSize2 = rCipher.EncryptInPlace(pvWritePoint, iSize);
+		buffer_write_proceed(buf, iSize2 - iSize);
+	}
+
+	// 지금 DESC::Packet: 원본에서 바로 암호화
+	void BenchSendEncrypt(CBenchCipher & rCipher, LPBUFFER buf, const void * c_pvData, int iSize, SBenchStat & r)
+	{
+		BenchReserve(buf);
+
+		// TEA 는 8바이트에 못 미치는 끝을 옮겨 놓고 암호화한다
+		if (rCipher.IsPadded() && iSize % 8)
+		{
+			++r.dwCopies;
+			r.dwBytes += iSize % 8;
+		}
+
+		buffer_write_proceed(buf, rCipher.EncryptCopy(buffer_write_peek(buf), c_pvData, iSize));
+	}
+
+	// DESC::CommitPacket: 자리에 채운 것을 제자리에서 암호화
+	void BenchCommit(CBenchCipher & rCipher, LPBUFFER buf, int iSize)
+	{
+		buffer_write_proceed(buf, rCipher.EncryptInPlace(buffer_write_peek(buf), iSize));
+	}
+
+	void BenchFillMove(TPacketGCMove & r, DWORD dwVID, int i)
+	{
+		r.bHeader	= HEADER_GC_MOVE;
+		r.bFunc		= FUNC_MOVE;
+		r.bArg		= 0;
+		r.dwVID		= dwVID;
+		r.dwTime	= i;
+		r.bRot		= i % 72;
+		r.lX		= 100 + i;
+		r.lY		= 200 + i;
+		r.dwDuration	= 300;
+	}
+
+	void BenchFillAdd(TPacketGCCharacterAdd & r, DWORD dwVID, int i)
+	{
+		memset(&r, 0, sizeof(r));
+		r.header	= HEADER_GC_CHARACTER_ADD;
+		r.dwVID		= dwVID;
+		r.x		= 100 + i;
+		r.y		= 200 + i;
+		r.wRaceNum	= i % 8;
+	}
+
+	void BenchFillAdditionalInfo(TPacketGCCharacterAdditionalInfo & r, DWORD dwVID)
+	{
+		memset(&r, 0, sizeof(r));
+		r.header	= HEADER_GC_CHAR_ADDITIONAL_INFO;
+		r.dwVID		= dwVID;
+		strlcpy(r.name, "packet_bench", sizeof(r.name));
+	}
+
+	int BenchFormatChat(char * pszBuf, int iMaxLen, int i)
+	{
+		int len = snprintf(pszBuf, iMaxLen, "packet_bench %d: the quick brown fox jumps over the lazy dog", i);
+		return MINMAX(0, len, iMaxLen - 1);
+	}
+}
+
+void packet_writer_benchmark(int iCount, int iViewers, std::string & rstResult)
+{
+	CBenchCipher kCipher;
+
+	if (!kCipher.IsReady())
+	{
+		rstResult = "packet_bench: cannot set up the cipher";
+		return;
+	}
+
+	std::vector<LPBUFFER> vec_buf(iViewers);
+
+	for (int v = 0; v < iViewers; ++v)
+		vec_buf[v] = buffer_new(DEFAULT_PACKET_BUFFER_SIZE);
+
+	SBenchStat kBroadcastOld, kBroadcastNew, kInsertOld, kInsertNew, kChatOld, kChatNew;
+	CBenchBudget kBudget;
+	int iRuns = 0;
+
+	for (int i = 0; i < iCount && !kBudget.IsOver(); ++i, ++iRuns)
+	{
+		// 이동 + 상태 브로드캐스트: 한 번 만들어 보는 사람마다 보낸다
+		uint64_t ns = CMetrics::GetClockNs();
+		{
+			TPacketGCMove pack;
+			BenchFillMove(pack, i, i);
+
+			TPacketGCCharacterUpdate pack_update;
+			memset(&pack_update, 0, sizeof(pack_update));
+			pack_update.header = HEADER_GC_CHARACTER_UPDATE;
+			pack_update.dwVID = i;
+
+			for (int v = 0; v < iViewers; ++v)
+			{
+				BenchSendCopy(kCipher, vec_buf[v], &pack, sizeof(pack), kBroadcastOld);
+				BenchSendCopy(kCipher, vec_buf[v], &pack_update, sizeof(pack_update), kBroadcastOld);
+			}
+		}
+		kBroadcastOld.qwNs += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		{
+			TPacketGCMove pack;
+			BenchFillMove(pack, i, i);
+
+			TPacketGCCharacterUpdate pack_update;
+			memset(&pack_update, 0, sizeof(pack_update));
+			pack_update.header = HEADER_GC_CHARACTER_UPDATE;
+			pack_update.dwVID = i;
+
+			for (int v = 0; v < iViewers; ++v)
+			{
+				BenchSendEncrypt(kCipher, vec_buf[v], &pack, sizeof(pack), kBroadcastNew);
+				BenchSendEncrypt(kCipher, vec_buf[v], &pack_update, sizeof(pack_update), kBroadcastNew);
+			}
+		}
+		kBroadcastNew.qwNs += CMetrics::GetClockNs() - ns;
+
+		// EncodeInsertPacket: 보는 사람마다 따로 만든다
+		ns = CMetrics::GetClockNs();
+		for (int v = 0; v < iViewers; ++v)
+		{
+			TPacketGCCharacterAdd pack;
+			BenchFillAdd(pack, i, i);
+			BenchSendCopy(kCipher, vec_buf[v], &pack, sizeof(pack), kInsertOld);
+
+			TPacketGCCharacterAdditionalInfo addPacket;
+			BenchFillAdditionalInfo(addPacket, i);
+			BenchSendCopy(kCipher, vec_buf[v], &addPacket, sizeof(addPacket), kInsertOld);
+		}
+		kInsertOld.qwNs += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		for (int v = 0; v < iViewers; ++v)
+		{
+			BenchReserve(vec_buf[v]);
+			BenchFillAdd(*(TPacketGCCharacterAdd *) buffer_write_peek(vec_buf[v]), i, i);
+			BenchCommit(kCipher, vec_buf[v], sizeof(TPacketGCCharacterAdd));
+
+			BenchFillAdditionalInfo(*(TPacketGCCharacterAdditionalInfo *) buffer_write_peek(vec_buf[v]), i);
+			BenchCommit(kCipher, vec_buf[v], sizeof(TPacketGCCharacterAdditionalInfo));
+		}
+		kInsertNew.qwNs += CMetrics::GetClockNs() - ns;
+
+		// ChatPacket: 한 사람에게
+		ns = CMetrics::GetClockNs();
+		{
+			char chatbuf[CHAT_MAX_LEN + 1];
+			int len = BenchFormatChat(chatbuf, sizeof(chatbuf), i);
+
+			TPacketGCChat pack_chat;
+			pack_chat.header	= HEADER_GC_CHAT;
+			pack_chat.size		= sizeof(TPacketGCChat) + len;
+			pack_chat.type		= CHAT_TYPE_INFO;
+			pack_chat.id		= 0;
+			pack_chat.bEmpire	= 0;
+
+			TEMP_BUFFER buf;
+			buf.write(&pack_chat, sizeof(TPacketGCChat));
+			buf.write(chatbuf, len);
+			kChatOld.dwCopies += 2;
+			kChatOld.dwBytes += sizeof(TPacketGCChat) + len;
+
+			BenchSendCopy(kCipher, vec_buf[0], buf.read_peek(), buf.size(), kChatOld);
+		}
+		kChatOld.qwNs += CMetrics::GetClockNs() - ns;
+
+		ns = CMetrics::GetClockNs();
+		{
+			BenchReserve(vec_buf[0]);
+
+			TPacketGCChat * p = (TPacketGCChat *) buffer_write_peek(vec_buf[0]);
+			int len = BenchFormatChat((char *) (p + 1), CHAT_MAX_LEN + 1, i);
+
+			p->header	= HEADER_GC_CHAT;
+			p->size		= sizeof(TPacketGCChat) + len;
+			p->type		= CHAT_TYPE_INFO;
+			p->id		= 0;
+			p->bEmpire	= 0;
+
+			BenchCommit(kCipher, vec_buf[0], sizeof(TPacketGCChat) + len);
+		}
+		kChatNew.qwNs += CMetrics::GetClockNs() - ns;
+	}
+
+	for (int v = 0; v < iViewers; ++v)
+		buffer_delete(vec_buf[v]);
+
+	char szBuf[1024];
+	snprintf(szBuf, sizeof(szBuf),
+			"packet_bench %d runs, %d viewers, %s, per broadcast: "
+			"move+update copies %u -> %u (%u -> %u bytes), %llu -> %llu ns; "
+			"insert copies %u -> %u (%u -> %u bytes), %llu -> %llu ns; "
+			"chat copies %u -> %u (%u -> %u bytes), %llu -> %llu ns",
+			iRuns, iViewers, kCipher.GetName(),
+			kBroadcastOld.dwCopies / iRuns, kBroadcastNew.dwCopies / iRuns,
+			kBroadcastOld.dwBytes / iRuns, kBroadcastNew.dwBytes / iRuns,
+			(unsigned long long) (kBroadcastOld.qwNs / iRuns), (unsigned long long) (kBroadcastNew.qwNs / iRuns),
+			kInsertOld.dwCopies / iRuns, kInsertNew.dwCopies / iRuns,
+			kInsertOld.dwBytes / iRuns, kInsertNew.dwBytes / iRuns,
+			(unsigned long long) (kInsertOld.qwNs / iRuns), (unsigned long long) (kInsertNew.qwNs / iRuns),
+			kChatOld.dwCopies / iRuns, kChatNew.dwCopies / iRuns,
+			kChatOld.dwBytes / iRuns, kChatNew.dwBytes / iRuns,
+			(unsigned long long) (kChatOld.qwNs / iRuns), (unsigned long long) (kChatNew.qwNs / iRuns));
+	rstResult = szBuf;
+}
@@ -0,0 +1,151 @@
+﻿// vim:ts=8 sw=4
+#ifndef __INC_METIN_II_GAME_PACKET_WRITER_H__
+#define __INC_METIN_II_GAME_PACKET_WRITER_H__
+
+#include <string>
+#include <vector>
+
+#include "desc.h"
+#include "packet.h"
+
+//
+// Builds a GC packet directly in the descriptor's output buffer:
+//
+//	CPacketWriter<TPacketGCMove> w(d);
+//	w->dwVID = ...;
+//	w.Commit();
+//
+// The header (and the size of variable packets) is filled from the
+// declarations below, so a struct can only go out with its own header and
+// length. Fields are written at the output buffer's write point and encrypted
+// in place on Commit; nothing is copied. When the descriptor cannot take it
+// in place (relay, buffered output, not enough room) the packet is built in
+// a scratch buffer and handed to DESC::Packet as before.
+//
+// Nothing else may be sent to the same descriptor between the constructor
+// and Commit(). A writer that is never committed sends nothing.
+//
+
+// struct, header member, header value
+#define GC_PACKET_WRITER_FIXED_LIST(X) \
+	X(TPacketGCMove,			bHeader,	HEADER_GC_MOVE) \
+	X(TPacketGCCharacterAdd,		header,		HEADER_GC_CHARACTER_ADD) \
+	X(TPacketGCCharacterAdditionalInfo,	header,		HEADER_GC_CHAR_ADDITIONAL_INFO) \
+	X(TPacketGCCharacterUpdate,		header,		HEADER_GC_CHARACTER_UPDATE) \
+	X(TPacketGCWalkMode,			header,		HEADER_GC_WALK_MODE) \
+	X(TPacketGCShopSign,			bHeader,	HEADER_GC_SHOP_SIGN)
+
+// struct, header member, size member, header value
+#define GC_PACKET_WRITER_DYNAMIC_LIST(X) \
+	X(TPacketGCChat,			header,		size,		HEADER_GC_CHAT)
+
+template <typename T> struct SPacketWriterTraits;	// 선언하지 않은 패킷은 컴파일되지 않는다
+
+#define GC_PACKET_WRITER_DECLARE_FIXED(type, header_member, header_value) \
+	template <> struct SPacketWriterTraits<type> \
+	{ \
+		enum { HEADER = header_value, IS_DYNAMIC = false }; \
+		static void SetSize(type &, int) {} \
+	}; \
+	static_assert(offsetof(type, header_member) == 0 && sizeof(((type *) 0)->header_member) == 1, \
+			#type ": header must be the first byte"); \
+	static_assert(header_value > 0 && header_value <= 0xff, #type ": bad header " #header_value);
+
+#define GC_PACKET_WRITER_DECLARE_DYNAMIC(type, header_member, size_member, header_value) \
+	template <> struct SPacketWriterTraits<type> \
+	{ \
+		enum { HEADER = header_value, IS_DYNAMIC = true }; \
+		static void SetSize(type & r, int iSize) { r.size_member = iSize; } \
+	}; \
+	static_assert(offsetof(type, header_member) == 0 && sizeof(((type *) 0)->header_member) == 1, \
+			#type ": header must be the first byte"); \
+	static_assert(offsetof(type, size_member) == 1 && sizeof(((type *) 0)->size_member) == 2, \
+			#type ": size must be the WORD after the header"); \
+	static_assert(header_value > 0 && header_value <= 0xff, #type ": bad header " #header_value);
+
+GC_PACKET_WRITER_FIXED_LIST(GC_PACKET_WRITER_DECLARE_FIXED)
+GC_PACKET_WRITER_DYNAMIC_LIST(GC_PACKET_WRITER_DECLARE_DYNAMIC)
+
+namespace packet_writer_detail
+{
+#define GC_PACKET_WRITER_HEADER_FIXED(type, header_member, header_value)		header_value,
+#define GC_PACKET_WRITER_HEADER_DYNAMIC(type, header_member, size_member, header_value)	header_value,
+
+	constexpr int c_aiDeclaredHeader[] =
+	{
+		GC_PACKET_WRITER_FIXED_LIST(GC_PACKET_WRITER_HEADER_FIXED)
+		GC_PACKET_WRITER_DYNAMIC_LIST(GC_PACKET_WRITER_HEADER_DYNAMIC)
+	};
+
+#undef GC_PACKET_WRITER_HEADER_FIXED
+#undef GC_PACKET_WRITER_HEADER_DYNAMIC
+
+	constexpr bool HasDuplicateHeader()
+	{
+		const int n = sizeof(c_aiDeclaredHeader) / sizeof(c_aiDeclaredHeader[0]);
+
+		for (int i = 0; i < n; ++i)
+			for (int j = i + 1; j < n; ++j)
+				if (c_aiDeclaredHeader[i] == c_aiDeclaredHeader[j])
+					return true;
+
+		return false;
+	}
+
+	static_assert(!HasDuplicateHeader(), "two packets are declared with the same header");
+}
+
+template <typename T>
+class CPacketWriter
+{
+	public:
+		typedef SPacketWriterTraits<T>	TTraits;
+
+		// iMaxExtra: 가변 패킷의 구조체 뒤에 붙일 수 있는 최대 바이트
+		CPacketWriter(LPDESC d, int iMaxExtra = 0) : m_d(d), m_iMaxExtra(iMaxExtra)
+		{
+			assert(TTraits::IS_DYNAMIC || iMaxExtra == 0);
+
+			m_pbData = (BYTE *) m_d->BeginPacket(sizeof(T) + m_iMaxExtra);
+
+			if (!m_pbData)
+			{
+				m_vec_bScratch.resize(sizeof(T) + m_iMaxExtra);
+				m_pbData = &m_vec_bScratch[0];
+			}
+
+			*m_pbData = TTraits::HEADER;
+		}
+
+		T *	operator -> ()		{ return (T *) m_pbData; }
+		T &	operator * ()		{ return *(T *) m_pbData; }
+		char *	GetExtra()		{ return (char *) m_pbData + sizeof(T); }
+
+		void	Commit(int iExtra = 0)
+		{
+			assert(iExtra >= 0 && iExtra <= m_iMaxExtra);
+
+			int iSize = sizeof(T) + iExtra;
+			TTraits::SetSize(**this, iSize);
+
+			if (m_vec_bScratch.empty())
+				m_d->CommitPacket(iSize);
+			else
+				m_d->Packet(m_pbData, iSize);
+		}
+
+	private:
+		LPDESC			m_d;
+		int			m_iMaxExtra;
+		BYTE *			m_pbData;
+		std::vector<BYTE>	m_vec_bScratch;
+};
+
+// c_pvSrc 를 pvDest 로 TEA 암호화해 옮긴다. 원본은 건드리지 않으며 pvDest 는
+// iSize 를 8의 배수로 올린 만큼 비어 있어야 한다. 암호화된 크기를 돌려준다.
+extern int packet_encrypt_copy(void * pvDest, const void * c_pvSrc, int iSize, const DWORD * c_pdwKey);
+
+// packet_bench: 주변 브로드캐스트와 채팅을 예전 방식과 비교해 복사 횟수와 시간을 잰다
+extern void packet_writer_benchmark(int iCount, int iViewers, std::string & rstResult);
+
+#endif
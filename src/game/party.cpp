@@ -1209,13 +1209,12 @@ void CParty::ComputeRolePoint(LPCHARACTER ch, BYTE bRole, bool bAdd)
 {
 	if (!bAdd)
 	{
-		ch->PointChange(POINT_PARTY_ATTACKER_BONUS, -ch->GetPoint(POINT_PARTY_ATTACKER_BONUS));
-		ch->PointChange(POINT_PARTY_TANKER_BONUS, -ch->GetPoint(POINT_PARTY_TANKER_BONUS));
-		ch->PointChange(POINT_PARTY_BUFFER_BONUS, -ch->GetPoint(POINT_PARTY_BUFFER_BONUS));
-		ch->PointChange(POINT_PARTY_SKILL_MASTER_BONUS, -ch->GetPoint(POINT_PARTY_SKILL_MASTER_BONUS));
-		ch->PointChange(POINT_PARTY_DEFENDER_BONUS, -ch->GetPoint(POINT_PARTY_DEFENDER_BONUS));
-		ch->PointChange(POINT_PARTY_HASTE_BONUS, -ch->GetPoint(POINT_PARTY_HASTE_BONUS));
-		ch->ComputeBattlePoints();
+		ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_ATTACKER_BONUS, 0);
+		ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_TANKER_BONUS, 0);
+		ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_BUFFER_BONUS, 0);
+		ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_SKILL_MASTER_BONUS, 0);
+		ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_DEFENDER_BONUS, 0);
+		ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_HASTE_BONUS, 0);
 		return;
 	}
 
@@ -1226,74 +1225,33 @@ void CParty::ComputeRolePoint(LPCHARACTER ch, BYTE bRole, bool bAdd)
 	//sys_log(0,"ComputeRolePoint %fi %d, %d ", k, SKILL_MAX_LEVEL, m_iLeadership ); 
 	//END_SKILL_POWER_BY_LEVEL
 
+	// SetPointContribution only applies the difference and refreshes the
+	// points derived from the bonus, no full ComputePoints per member.
 	switch (bRole)
 	{
 		case PARTY_ROLE_ATTACKER:
-			{
-				//int iBonus = (int) (10 + 90 * k);
-				int iBonus = (int) (10 + 60 * k);
-
-				if (ch->GetPoint(POINT_PARTY_ATTACKER_BONUS) != iBonus)
-				{
-					ch->PointChange(POINT_PARTY_ATTACKER_BONUS, iBonus - ch->GetPoint(POINT_PARTY_ATTACKER_BONUS));
-					ch->ComputePoints();
-				}
-			}
+			//ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_ATTACKER_BONUS, (int) (10 + 90 * k));
+			ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_ATTACKER_BONUS, (int) (10 + 60 * k));
 			break;
 
 		case PARTY_ROLE_TANKER:
-			{
-				int iBonus = (int) (50 + 1450 * k);
-
-				if (ch->GetPoint(POINT_PARTY_TANKER_BONUS) != iBonus)
-				{
-					ch->PointChange(POINT_PARTY_TANKER_BONUS, iBonus - ch->GetPoint(POINT_PARTY_TANKER_BONUS));
-					ch->ComputePoints();
-				}
-			}
+			ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_TANKER_BONUS, (int) (50 + 1450 * k));
 			break;
 
 		case PARTY_ROLE_BUFFER:
-			{
-				int iBonus = (int) (5 + 45 * k);
-
-				if (ch->GetPoint(POINT_PARTY_BUFFER_BONUS) != iBonus)
-				{
-					ch->PointChange(POINT_PARTY_BUFFER_BONUS, iBonus - ch->GetPoint(POINT_PARTY_BUFFER_BONUS));
-				}
-			}
+			ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_BUFFER_BONUS, (int) (5 + 45 * k));
 			break;
 
 		case PARTY_ROLE_SKILL_MASTER:
-			{
-				int iBonus = (int) (25 + 600 * k);
-
-				if (ch->GetPoint(POINT_PARTY_SKILL_MASTER_BONUS) != iBonus)
-				{
-					ch->PointChange(POINT_PARTY_SKILL_MASTER_BONUS, iBonus - ch->GetPoint(POINT_PARTY_SKILL_MASTER_BONUS));
-					ch->ComputePoints();
-				}
-			}
+			ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_SKILL_MASTER_BONUS, (int) (25 + 600 * k));
 			break;
+
 		case PARTY_ROLE_HASTE:
-			{
-				int iBonus = (int) (1+5*k);
-				if (ch->GetPoint(POINT_PARTY_HASTE_BONUS) != iBonus)
-				{
-					ch->PointChange(POINT_PARTY_HASTE_BONUS, iBonus - ch->GetPoint(POINT_PARTY_HASTE_BONUS));
-					ch->ComputePoints();
-				}
-			}
+			ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_HASTE_BONUS, (int) (1+5*k));
 			break;
+
 		case PARTY_ROLE_DEFENDER:
-			{
-				int iBonus = (int) (5+30*k);
-				if (ch->GetPoint(POINT_PARTY_DEFENDER_BONUS) != iBonus)
-				{
-					ch->PointChange(POINT_PARTY_DEFENDER_BONUS, iBonus - ch->GetPoint(POINT_PARTY_DEFENDER_BONUS));
-					ch->ComputePoints();
-				}
-			}
+			ch->SetPointContribution(POINT_SOURCE_PARTY_ROLE, POINT_PARTY_DEFENDER_BONUS, (int) (5+30*k));
 			break;
 	}
 }
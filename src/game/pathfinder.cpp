@@ -0,0 +1,621 @@
+﻿#include "stdafx.h"
+#include <queue>
+
+#include "../libgame/attribute.h"
+#include "utils.h"
+#include "config.h"
+#include "pathfinder.h"
+#include "sectree_manager.h"
+#include "metrics.h"
+
+namespace
+{
+	const DWORD	PATH_INF			= 0xffffffff;
+	const int	CELLS_PER_SECTREE	= SECTREE_SIZE / CELL_SIZE;
+	const int	COST_STRAIGHT		= 10;
+	const int	COST_DIAGONAL		= 14;
+	const int	BUCKET_NUM			= 16;	// > COST_DIAGONAL, for the circular bucket queue
+
+	// straight neighbours first: diagonals look at aiDir[0..3] to refuse corner cutting
+	const int aiDirX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int aiDirY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	enum
+	{
+		CELL_UNKNOWN	= 0,
+		CELL_FREE		= 1,
+		CELL_BLOCKED	= 2,
+		CELL_CLOSED		= 4,
+	};
+
+	inline DWORD OctileDistance(int dx, int dy)
+	{
+		dx = abs(dx);
+		dy = abs(dy);
+		return COST_STRAIGHT * MAX(dx, dy) + (COST_DIAGONAL - COST_STRAIGHT) * MIN(dx, dy);
+	}
+
+	inline long CellCenter(int c)
+	{
+		return c * CELL_SIZE + CELL_SIZE / 2;
+	}
+}
+
+CPathFinder::CPathFinder()
+	: m_iBudget(0), m_iBudgetLeft(0), m_iBudgetPulse(-1),
+	m_lCachedMapIndex(-1), m_pkCachedMap(NULL), m_dwCachedSectree(0), m_pkCachedAttr(NULL)
+{
+	memset(&m_stat, 0, sizeof(m_stat));
+	m_vecBucket.resize(BUCKET_NUM);
+}
+
+CPathFinder::~CPathFinder()
+{
+	for (itertype(m_map_pkFlowField) it = m_map_pkFlowField.begin(); it != m_map_pkFlowField.end(); ++it)
+		M2_DELETE(it->second);
+}
+
+int CPathFinder::GetBudgetLeft()
+{
+	if (m_iBudgetPulse != thecore_pulse())
+	{
+		m_iBudgetPulse = thecore_pulse();
+		m_iBudgetLeft = m_iBudget;
+	}
+
+	return m_iBudgetLeft;
+}
+
+void CPathFinder::ResetCellCache()
+{
+	// Sectrees of private maps come and go, so nothing is kept across calls.
+	m_lCachedMapIndex = -1;
+	m_pkCachedMap = NULL;
+	m_pkCachedAttr = NULL;
+}
+
+bool CPathFinder::IsBlockedCell(long lMapIndex, int cx, int cy)
+{
+	if (cx < 0 || cy < 0)
+		return true;
+
+	SECTREEID id;
+	id.coord.x = cx / CELLS_PER_SECTREE;
+	id.coord.y = cy / CELLS_PER_SECTREE;
+
+	if (lMapIndex != m_lCachedMapIndex)
+	{
+		m_lCachedMapIndex = lMapIndex;
+		m_pkCachedMap = SECTREE_MANAGER::instance().GetMap(lMapIndex);
+		m_dwCachedSectree = id.package + 1;
+	}
+
+	if (id.package != m_dwCachedSectree)
+	{
+		m_dwCachedSectree = id.package;
+
+		LPSECTREE tree = m_pkCachedMap ? m_pkCachedMap->Find(id.package) : NULL;
+		m_pkCachedAttr = tree ? tree->GetAttributePtr() : NULL;
+	}
+
+	if (!m_pkCachedAttr)
+		return true;
+
+	return IS_SET(m_pkCachedAttr->Get(cx % CELLS_PER_SECTREE, cy % CELLS_PER_SECTREE), ATTR_BLOCK | ATTR_OBJECT);
+}
+
+bool CPathFinder::IsClearLine(long lMapIndex, long sx, long sy, long ex, long ey)
+{
+	long dx = ex - sx;
+	long dy = ey - sy;
+	long steps = MAX(abs(dx), abs(dy)) / (CELL_SIZE / 2) + 1;
+
+	// the start cell is skipped: a mob knocked onto a block must still be able to leave it
+	for (long i = 1; i <= steps; ++i)
+	{
+		long x = sx + dx * i / steps;
+		long y = sy + dy * i / steps;
+
+		if (IsBlockedCell(lMapIndex, x / CELL_SIZE, y / CELL_SIZE))
+			return false;
+	}
+
+	return true;
+}
+
+bool CPathFinder::IsStraightPath(long lMapIndex, long sx, long sy, long ex, long ey)
+{
+	ResetCellCache();
+	return IsClearLine(lMapIndex, sx, sy, ex, ey);
+}
+
+void CPathFinder::BuildFlowField(TFlowField & rField, long lMapIndex, int iGoalX, int iGoalY)
+{
+	const int N = FLOW_SIZE * FLOW_SIZE;
+
+	rField.lMapIndex = lMapIndex;
+	rField.iGoalX = iGoalX;
+	rField.iGoalY = iGoalY;
+	rField.iOriginX = iGoalX - FLOW_RADIUS;
+	rField.iOriginY = iGoalY - FLOW_RADIUS;
+	rField.vecDist.assign(N, PATH_INF);
+
+	m_vecBlocked.resize(N);
+
+	// The outer ring stays blocked so the loop below needs no bounds checks.
+	for (int y = 0; y < FLOW_SIZE; ++y)
+		for (int x = 0; x < FLOW_SIZE; ++x)
+		{
+			bool bEdge = x == 0 || y == 0 || x == FLOW_SIZE - 1 || y == FLOW_SIZE - 1;
+			m_vecBlocked[y * FLOW_SIZE + x] = bEdge || IsBlockedCell(lMapIndex, rField.iOriginX + x, rField.iOriginY + y) ? CELL_BLOCKED : CELL_FREE;
+		}
+
+	const int aiOffset[8] =
+	{
+		1, -1, FLOW_SIZE, -FLOW_SIZE, FLOW_SIZE + 1, -FLOW_SIZE + 1, FLOW_SIZE - 1, -FLOW_SIZE - 1
+	};
+
+	// Dial's algorithm: edge costs are 10/14, so 16 circular buckets keyed by
+	// distance replace a heap.
+	for (int i = 0; i < BUCKET_NUM; ++i)
+		m_vecBucket[i].clear();
+
+	DWORD dwGoalIndex = FLOW_RADIUS * FLOW_SIZE + FLOW_RADIUS;
+	rField.vecDist[dwGoalIndex] = 0;
+	m_vecBucket[0].push_back(dwGoalIndex);
+
+	int iPending = 1;
+
+	for (DWORD dwCur = 0; iPending > 0; ++dwCur)
+	{
+		std::vector<DWORD> & rBucket = m_vecBucket[dwCur % BUCKET_NUM];
+
+		while (!rBucket.empty())
+		{
+			DWORD dwIndex = rBucket.back();
+			rBucket.pop_back();
+			--iPending;
+
+			if (rField.vecDist[dwIndex] != dwCur)
+				continue;
+
+			bool abFree[4];
+
+			for (int d = 0; d < 8; ++d)
+			{
+				DWORD dwNext = dwIndex + aiOffset[d];
+				bool bFree = m_vecBlocked[dwNext] == CELL_FREE;
+
+				if (d < 4)
+					abFree[d] = bFree;
+				else if (!abFree[aiDirX[d] > 0 ? 0 : 1] || !abFree[aiDirY[d] > 0 ? 2 : 3])
+					continue;
+
+				if (!bFree)
+					continue;
+
+				DWORD dwDist = dwCur + (d < 4 ? COST_STRAIGHT : COST_DIAGONAL);
+
+				if (dwDist < rField.vecDist[dwNext])
+				{
+					rField.vecDist[dwNext] = dwDist;
+					m_vecBucket[dwDist % BUCKET_NUM].push_back(dwNext);
+					++iPending;
+				}
+			}
+		}
+	}
+}
+
+bool CPathFinder::GetFlowStep(TFlowField & rField, long sx, long sy, long & rx, long & ry)
+{
+	int x = sx / CELL_SIZE - rField.iOriginX;
+	int y = sy / CELL_SIZE - rField.iOriginY;
+
+	if (x < 0 || y < 0 || x >= FLOW_SIZE || y >= FLOW_SIZE)
+		return false;
+
+	const std::vector<DWORD> & c_rDist = rField.vecDist;
+	int iCur = y * FLOW_SIZE + x;
+	bool bFound = false;
+
+	for (int iStep = 0; iStep < STEP_MAX_CELLS && c_rDist[iCur] != 0; ++iStep)
+	{
+		int cx = iCur % FLOW_SIZE;
+		int cy = iCur / FLOW_SIZE;
+		int iBest = -1;
+		bool abOpen[4];
+
+		for (int d = 0; d < 8; ++d)
+		{
+			int nx = cx + aiDirX[d];
+			int ny = cy + aiDirY[d];
+			bool bIn = nx >= 0 && ny >= 0 && nx < FLOW_SIZE && ny < FLOW_SIZE;
+
+			if (d < 4)
+				abOpen[d] = bIn && c_rDist[ny * FLOW_SIZE + nx] != PATH_INF;
+			else if (!abOpen[aiDirX[d] > 0 ? 0 : 1] || !abOpen[aiDirY[d] > 0 ? 2 : 3])
+				continue;
+
+			if (!bIn)
+				continue;
+
+			int iNext = ny * FLOW_SIZE + nx;
+
+			if (c_rDist[iNext] < (iBest < 0 ? c_rDist[iCur] : c_rDist[iBest]))
+				iBest = iNext;
+		}
+
+		if (iBest < 0)
+			break;
+
+		long px = CellCenter(rField.iOriginX + iBest % FLOW_SIZE);
+		long py = CellCenter(rField.iOriginY + iBest / FLOW_SIZE);
+
+		// The first step is adjacent and always taken; further ones only
+		// while the mob can still walk there in a straight line.
+		if (bFound && !IsClearLine(rField.lMapIndex, sx, sy, px, py))
+			break;
+
+		rx = px;
+		ry = py;
+		bFound = true;
+		iCur = iBest;
+	}
+
+	return bFound;
+}
+
+bool CPathFinder::GetChaseStep(DWORD dwTargetVID, long lMapIndex, long tx, long ty, long sx, long sy, long & rx, long & ry)
+{
+	if (!IsEnabled())
+		return false;
+
+	ResetCellCache();
+
+	int iGoalX = tx / CELL_SIZE;
+	int iGoalY = ty / CELL_SIZE;
+
+	itertype(m_map_pkFlowField) it = m_map_pkFlowField.find(dwTargetVID);
+	TFlowField * pField = it != m_map_pkFlowField.end() ? it->second : NULL;
+
+	if (pField && pField->lMapIndex == lMapIndex && pField->iGoalX == iGoalX && pField->iGoalY == iGoalY)
+	{
+		++m_stat.dwFlowReuse;
+	}
+	else if (GetBudgetLeft() >= FLOW_SIZE * FLOW_SIZE)
+	{
+		m_iBudgetLeft -= FLOW_SIZE * FLOW_SIZE;
+
+		if (!pField)
+		{
+			pField = M2_NEW TFlowField;
+			m_map_pkFlowField.insert(std::make_pair(dwTargetVID, pField));
+		}
+
+		BuildFlowField(*pField, lMapIndex, iGoalX, iGoalY);
+		++m_stat.dwFlowBuild;
+	}
+	else
+	{
+		++m_stat.dwBudgetSkip;
+
+		// Out of budget: a field a few cells behind still leads the right way.
+		if (!pField || pField->lMapIndex != lMapIndex ||
+				abs(pField->iGoalX - iGoalX) > FLOW_STALE_CELLS || abs(pField->iGoalY - iGoalY) > FLOW_STALE_CELLS)
+			return false;
+	}
+
+	pField->iLastUsedPulse = thecore_pulse();
+	return GetFlowStep(*pField, sx, sy, rx, ry);
+}
+
+int CPathFinder::Search(long lMapIndex, long sx, long sy, long ex, long ey, std::vector<PIXEL_POSITION> & rvecWaypoint, int iMaxExpand)
+{
+	rvecWaypoint.clear();
+
+	int iStartX = sx / CELL_SIZE, iStartY = sy / CELL_SIZE;
+	int iGoalX = ex / CELL_SIZE, iGoalY = ey / CELL_SIZE;
+
+	int iMinX = MIN(iStartX, iGoalX) - SEARCH_MARGIN;
+	int iMinY = MIN(iStartY, iGoalY) - SEARCH_MARGIN;
+	int iWidth = MAX(iStartX, iGoalX) + SEARCH_MARGIN - iMinX + 1;
+	int iHeight = MAX(iStartY, iGoalY) + SEARCH_MARGIN - iMinY + 1;
+
+	if (iWidth > SEARCH_MAX_SIZE || iHeight > SEARCH_MAX_SIZE || IsBlockedCell(lMapIndex, iGoalX, iGoalY))
+		return 0;
+
+	const int N = iWidth * iHeight;
+	const int iStart = (iStartY - iMinY) * iWidth + (iStartX - iMinX);
+	const int iGoal = (iGoalY - iMinY) * iWidth + (iGoalX - iMinX);
+
+	m_vecBlocked.assign(N, CELL_UNKNOWN);
+	m_vecSearchG.assign(N, PATH_INF);
+	m_vecSearchParent.assign(N, -1);
+
+	typedef std::pair<DWORD, int> TOpen;	// f, cell
+	std::priority_queue<TOpen, std::vector<TOpen>, std::greater<TOpen> > open;
+
+	m_vecBlocked[iStart] = CELL_FREE;
+	m_vecSearchG[iStart] = 0;
+	open.push(TOpen(OctileDistance(iGoalX - iStartX, iGoalY - iStartY), iStart));
+
+	int iExpand = 0;
+	bool bFound = false;
+
+	while (!open.empty() && iExpand < iMaxExpand)
+	{
+		int iCur = open.top().second;
+		open.pop();
+
+		if (m_vecBlocked[iCur] & CELL_CLOSED)
+			continue;
+
+		if (iCur == iGoal)
+		{
+			bFound = true;
+			break;
+		}
+
+		m_vecBlocked[iCur] |= CELL_CLOSED;
+		++iExpand;
+
+		int x = iCur % iWidth;
+		int y = iCur / iWidth;
+		bool abFree[4];
+
+		for (int d = 0; d < 8; ++d)
+		{
+			int nx = x + aiDirX[d];
+			int ny = y + aiDirY[d];
+			bool bFree = false;
+
+			if (nx >= 0 && ny >= 0 && nx < iWidth && ny < iHeight)
+			{
+				BYTE & rState = m_vecBlocked[ny * iWidth + nx];
+
+				if (rState == CELL_UNKNOWN)
+					rState = IsBlockedCell(lMapIndex, iMinX + nx, iMinY + ny) ? CELL_BLOCKED : CELL_FREE;
+
+				bFree = !(rState & CELL_BLOCKED);
+			}
+
+			if (d < 4)
+				abFree[d] = bFree;
+			else if (!abFree[aiDirX[d] > 0 ? 0 : 1] || !abFree[aiDirY[d] > 0 ? 2 : 3])
+				continue;
+
+			if (!bFree)
+				continue;
+
+			int iNext = ny * iWidth + nx;
+			DWORD dwG = m_vecSearchG[iCur] + (d < 4 ? COST_STRAIGHT : COST_DIAGONAL);
+
+			if (dwG < m_vecSearchG[iNext])
+			{
+				m_vecSearchG[iNext] = dwG;
+				m_vecSearchParent[iNext] = iCur;
+				open.push(TOpen(dwG + OctileDistance(iGoalX - (iMinX + nx), iGoalY - (iMinY + ny)), iNext));
+			}
+		}
+	}
+
+	if (!bFound)
+		return iExpand;
+
+	std::vector<int> vecCell;
+
+	for (int i = iGoal; i != iStart; i = m_vecSearchParent[i])
+		vecCell.push_back(i);
+
+	std::reverse(vecCell.begin(), vecCell.end());
+
+	// String pulling: keep a cell only where the straight line from the
+	// previous waypoint stops being walkable.
+	PIXEL_POSITION anchor;
+	anchor.x = sx;
+	anchor.y = sy;
+	anchor.z = 0;
+
+	for (size_t i = 1; i < vecCell.size(); ++i)
+	{
+		long px = CellCenter(iMinX + vecCell[i] % iWidth);
+		long py = CellCenter(iMinY + vecCell[i] / iWidth);
+
+		if (IsClearLine(lMapIndex, anchor.x, anchor.y, px, py))
+			continue;
+
+		anchor.x = CellCenter(iMinX + vecCell[i - 1] % iWidth);
+		anchor.y = CellCenter(iMinY + vecCell[i - 1] / iWidth);
+		rvecWaypoint.push_back(anchor);
+	}
+
+	PIXEL_POSITION goal;
+	goal.x = ex;
+	goal.y = ey;
+	goal.z = 0;
+	rvecWaypoint.push_back(goal);
+	return iExpand;
+}
+
+bool CPathFinder::GetPathStep(long lMapIndex, long sx, long sy, long ex, long ey, long & rx, long & ry)
+{
+	if (!IsEnabled())
+		return false;
+
+	ResetCellCache();
+
+	DWORD dwGoal = ((ex / CELL_SIZE) << 16) | ((ey / CELL_SIZE) & 0xffff);
+
+	SECTREEID id;
+	id.coord.x = sx / SECTREE_SIZE;
+	id.coord.y = sy / SECTREE_SIZE;
+
+	TPathCacheBucket & rBucket = m_map_pathCache[((uint64_t) lMapIndex << 32) | id.package];
+
+	for (size_t i = 0; i < rBucket.size(); ++i)
+	{
+		TPathCacheEntry & r = rBucket[i];
+
+		if (r.dwGoal != dwGoal || r.iExpirePulse < thecore_pulse())
+			continue;
+
+		// furthest waypoint this start can walk to directly
+		for (int j = (int) r.vecWaypoint.size() - 1; j >= 0; --j)
+		{
+			if (IsClearLine(lMapIndex, sx, sy, r.vecWaypoint[j].x, r.vecWaypoint[j].y))
+			{
+				rx = r.vecWaypoint[j].x;
+				ry = r.vecWaypoint[j].y;
+				++m_stat.dwCacheHit;
+				return true;
+			}
+		}
+	}
+
+	int iMaxExpand = MIN((int) SEARCH_MAX_EXPAND, GetBudgetLeft());
+
+	if (iMaxExpand <= 0)
+	{
+		++m_stat.dwBudgetSkip;
+		return false;
+	}
+
+	std::vector<PIXEL_POSITION> vecWaypoint;
+	m_iBudgetLeft -= Search(lMapIndex, sx, sy, ex, ey, vecWaypoint, iMaxExpand);
+	++m_stat.dwSearch;
+
+	if (vecWaypoint.empty())
+	{
+		++m_stat.dwSearchFail;
+		return false;
+	}
+
+	rx = vecWaypoint[0].x;
+	ry = vecWaypoint[0].y;
+
+	if (rBucket.size() >= PATH_CACHE_SIZE)
+	{
+		size_t oldest = 0;
+
+		for (size_t i = 1; i < rBucket.size(); ++i)
+			if (rBucket[i].iExpirePulse < rBucket[oldest].iExpirePulse)
+				oldest = i;
+
+		rBucket.erase(rBucket.begin() + oldest);
+	}
+
+	TPathCacheEntry entry;
+	entry.dwGoal = dwGoal;
+	entry.iExpirePulse = thecore_pulse() + PASSES_PER_SEC(10);
+	entry.vecWaypoint.swap(vecWaypoint);
+	rBucket.push_back(entry);
+	return true;
+}
+
+void CPathFinder::Update()
+{
+	int iPulse = thecore_pulse();
+
+	for (itertype(m_map_pkFlowField) it = m_map_pkFlowField.begin(); it != m_map_pkFlowField.end(); )
+	{
+		if (iPulse - it->second->iLastUsedPulse > PASSES_PER_SEC(5))
+		{
+			M2_DELETE(it->second);
+			it = m_map_pkFlowField.erase(it);
+		}
+		else
+			++it;
+	}
+
+	for (itertype(m_map_pathCache) it = m_map_pathCache.begin(); it != m_map_pathCache.end(); )
+	{
+		TPathCacheBucket & rBucket = it->second;
+
+		for (size_t i = 0; i < rBucket.size(); )
+		{
+			if (rBucket[i].iExpirePulse < iPulse)
+				rBucket.erase(rBucket.begin() + i);
+			else
+				++i;
+		}
+
+		if (rBucket.empty())
+			it = m_map_pathCache.erase(it);
+		else
+			++it;
+	}
+}
+
+void CPathFinder::Benchmark(long lMapIndex, long x, long y, int iCount, std::string & rstResult)
+{
+	const long RANGE = 3000;
+
+	ResetCellCache();
+
+	std::vector<PIXEL_POSITION> vecPoint;
+
+	for (int i = 0; i < iCount * 64 && (int) vecPoint.size() < iCount * 2; ++i)
+	{
+		PIXEL_POSITION pos;
+		pos.x = x + number(-RANGE, RANGE);
+		pos.y = y + number(-RANGE, RANGE);
+		pos.z = 0;
+
+		if (pos.x > 0 && pos.y > 0 && !IsBlockedCell(lMapIndex, pos.x / CELL_SIZE, pos.y / CELL_SIZE))
+			vecPoint.push_back(pos);
+	}
+
+	if (vecPoint.size() < 2)
+	{
+		rstResult = "path_bench: no movable cells around here";
+		return;
+	}
+
+	TFlowField field;
+	uint64_t qwFlowTotal = 0, qwFlowMax = 0;
+	uint64_t qwSearchTotal = 0, qwSearchMax = 0;
+	int iFlowReach = 0, iFound = 0, iExpandTotal = 0;
+	int iRuns = 0;
+	int iPairs = vecPoint.size() / 2;
+	std::vector<PIXEL_POSITION> vecWaypoint;
+	CBenchBudget kBudget;
+
+	for (int i = 0; i < iPairs && !kBudget.IsOver(); ++i, ++iRuns)
+	{
+		const PIXEL_POSITION & c_rGoal = vecPoint[i * 2];
+		const PIXEL_POSITION & c_rStart = vecPoint[i * 2 + 1];
+
+		uint64_t ns = CMetrics::GetClockNs();
+		BuildFlowField(field, lMapIndex, c_rGoal.x / CELL_SIZE, c_rGoal.y / CELL_SIZE);
+		uint64_t qwElapsed = CMetrics::GetClockNs() - ns;
+
+		qwFlowTotal += qwElapsed;
+		qwFlowMax = std::max(qwFlowMax, qwElapsed);
+
+		long rx, ry;
+
+		if (GetFlowStep(field, c_rStart.x, c_rStart.y, rx, ry))
+			++iFlowReach;
+
+		ns = CMetrics::GetClockNs();
+		iExpandTotal += Search(lMapIndex, c_rStart.x, c_rStart.y, c_rGoal.x, c_rGoal.y, vecWaypoint, SEARCH_MAX_EXPAND);
+		qwElapsed = CMetrics::GetClockNs() - ns;
+
+		qwSearchTotal += qwElapsed;
+		qwSearchMax = std::max(qwSearchMax, qwElapsed);
+
+		if (!vecWaypoint.empty())
+			++iFound;
+	}
+
+	char szBuf[512];
+	snprintf(szBuf, sizeof(szBuf),
+			"path_bench map %ld, %d runs within %ld: flow field %dx%d avg %llu us max %llu us (%d reached); "
+			"A* avg %llu us max %llu us, %d expanded avg, %d found; budget %d cells/pulse",
+			lMapIndex, iRuns, RANGE, (int) FLOW_SIZE, (int) FLOW_SIZE,
+			(unsigned long long) (qwFlowTotal / iRuns / 1000), (unsigned long long) (qwFlowMax / 1000), iFlowReach,
+			(unsigned long long) (qwSearchTotal / iRuns / 1000), (unsigned long long) (qwSearchMax / 1000),
+			iExpandTotal / iRuns, iFound, m_iBudget);
+	rstResult = szBuf;
+}
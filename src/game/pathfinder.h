@@ -0,0 +1,128 @@
+﻿#ifndef __INC_METIN_II_GAME_PATHFINDER_H__
+#define __INC_METIN_II_GAME_PATHFINDER_H__
+
+#include <unordered_map>
+#include <vector>
+
+class CAttribute;
+
+//
+// Grid pathfinding for monster movement over the sectree attribute cells
+// (ATTR_BLOCK | ATTR_OBJECT block, CELL_SIZE units per cell).
+//
+// Chasing uses one flow field per target: a Dijkstra distance map over a
+// square window around the target, shared by every mob chasing it and rebuilt
+// only when the target moves to another cell. Returning uses a bounded A*,
+// with the smoothed waypoints cached on the sectree the path starts in so the
+// next mob (or the next step) from there reuses them.
+//
+// Both only run when the straight line is blocked, and both are charged
+// against a per-pulse budget of expanded cells (path_budget in CONFIG). When
+// the budget is spent the callers keep the old straight-line movement.
+//
+class CPathFinder : public singleton<CPathFinder>
+{
+	public:
+		enum
+		{
+			FLOW_RADIUS			= 64,						// cells around the target
+			FLOW_SIZE			= FLOW_RADIUS * 2 + 1,
+			FLOW_STALE_CELLS	= 4,						// reuse an older field while the budget is spent
+			SEARCH_MARGIN		= 32,						// cells around the A* start/goal box
+			SEARCH_MAX_SIZE		= 256,						// widest A* box, in cells
+			SEARCH_MAX_EXPAND	= 8192,
+			PATH_CACHE_SIZE		= 8,						// paths kept per sectree
+			STEP_MAX_CELLS		= 48,						// furthest waypoint handed to Goto
+		};
+
+		typedef struct SPathStat
+		{
+			DWORD	dwFlowBuild;
+			DWORD	dwFlowReuse;
+			DWORD	dwSearch;
+			DWORD	dwSearchFail;
+			DWORD	dwCacheHit;
+			DWORD	dwBudgetSkip;
+		} TPathStat;
+
+	public:
+		CPathFinder();
+		virtual ~CPathFinder();
+
+		void	SetBudget(int iCellsPerPulse)	{ m_iBudget = iCellsPerPulse; }
+		bool	IsEnabled() const				{ return m_iBudget > 0; }
+
+		bool	IsStraightPath(long lMapIndex, long sx, long sy, long ex, long ey);
+
+		// Next waypoint towards the target's flow field; false if there is none
+		// (out of the window, unreachable or no budget).
+		bool	GetChaseStep(DWORD dwTargetVID, long lMapIndex, long tx, long ty, long sx, long sy, long & rx, long & ry);
+
+		// Next waypoint of a bounded A* path from (sx, sy) to (ex, ey).
+		bool	GetPathStep(long lMapIndex, long sx, long sy, long ex, long ey, long & rx, long & ry);
+
+		void	Update();	// once per second: drops unused fields and expired paths
+
+		const TPathStat &	GetStat() const	{ return m_stat; }
+
+		// path_bench: times flow field builds and A* searches between random
+		// movable points around (x, y), ignoring the budget.
+		void	Benchmark(long lMapIndex, long x, long y, int iCount, std::string & rstResult);
+
+	protected:
+		typedef struct SFlowField
+		{
+			long					lMapIndex;
+			int						iGoalX;
+			int						iGoalY;
+			int						iOriginX;
+			int						iOriginY;
+			int						iLastUsedPulse;
+			std::vector<DWORD>		vecDist;
+		} TFlowField;
+
+		typedef struct SPathCacheEntry
+		{
+			DWORD							dwGoal;			// goal cell, x << 16 | y
+			int								iExpirePulse;
+			std::vector<PIXEL_POSITION>		vecWaypoint;
+		} TPathCacheEntry;
+
+		typedef std::vector<TPathCacheEntry>	TPathCacheBucket;
+
+		int		GetBudgetLeft();
+
+		void	ResetCellCache();
+		bool	IsBlockedCell(long lMapIndex, int cx, int cy);
+		bool	IsClearLine(long lMapIndex, long sx, long sy, long ex, long ey);
+
+		void	BuildFlowField(TFlowField & rField, long lMapIndex, int iGoalX, int iGoalY);
+		bool	GetFlowStep(TFlowField & rField, long sx, long sy, long & rx, long & ry);
+
+		// Returns the number of expanded cells; rvecWaypoint is empty when no path was found.
+		int		Search(long lMapIndex, long sx, long sy, long ex, long ey, std::vector<PIXEL_POSITION> & rvecWaypoint, int iMaxExpand);
+
+	protected:
+		int			m_iBudget;
+		int			m_iBudgetLeft;
+		int			m_iBudgetPulse;
+
+		// last map/sectree looked up by IsBlockedCell, valid within one call
+		long			m_lCachedMapIndex;
+		LPSECTREE_MAP	m_pkCachedMap;
+		DWORD			m_dwCachedSectree;
+		CAttribute *	m_pkCachedAttr;
+
+		std::unordered_map<DWORD, TFlowField *>			m_map_pkFlowField;		// key: target vid
+		std::unordered_map<uint64_t, TPathCacheBucket>	m_map_pathCache;		// key: map index << 32 | sectree id
+
+		// scratch buffers reused by every build/search
+		std::vector<BYTE>				m_vecBlocked;
+		std::vector<std::vector<DWORD> >	m_vecBucket;
+		std::vector<DWORD>				m_vecSearchG;
+		std::vector<int>				m_vecSearchParent;
+
+		TPathStat	m_stat;
+};
+
+#endif
@@ -69,6 +69,7 @@ namespace quest
 		SUSPEND_STATE_INPUT,
 		SUSPEND_STATE_CONFIRM,
 		SUSPEND_STATE_SELECT_ITEM,
+		SUSPEND_STATE_QUERY,		// DB 결과를 기다린다, CQuestManager::ResumeQuery
 	};
 
 	enum EQuestConfirmType
@@ -96,12 +97,13 @@ namespace quest
 		//                      |             + 
 		std::string arg;  // <--+             |
 		std::vector<char> when_condition;// <-+
+		int when_ref;	// when_condition compiled at load, held in the lua registry
 		AStateScriptType script;
 		unsigned int quest_index;
 		int state_index;
 
 		AArgScript()
-			: quest_index(0), state_index(0)
+			: when_ref(LUA_NOREF), quest_index(0), state_index(0)
 		{}
 	};
 
@@ -124,9 +126,13 @@ namespace quest
 
 		std::vector<AArgScript *> chat_scripts;
 
+		// SUSPEND_STATE_QUERY 동안 보내지 않고 들고 있는 스크립트
+		std::string	_suspended_script;
+		int		_suspended_skin;
+
 		QuestState()
 			: co(NULL), ico(0), args(0), suspend_state(SUSPEND_STATE_NONE), iIndex(0), bStart(false), st(-1),
-			_clock_value(0), _counter_value(0)
+			_clock_value(0), _counter_value(0), _suspended_skin(0)
 		{}
 	};
 }
@@ -166,22 +166,43 @@ namespace quest
 		lua_rawseti(L, -2, m_count++);
 	}
 
-	bool IsScriptTrue(const char* code, int size)
+	// Compiles code that is evaluated over and over (when conditions) once and keeps
+	// the chunk in the registry. Compile errors are reported here, at quest load.
+	int CompileScript(const char* code, int size, const char* name)
 	{
-		if (size==0)
-			return true;
-
 		lua_State* L = CQuestManager::instance().GetLuaState();
 		int x = lua_gettop(L);
-		int errcode = lua_dobuffer(L, code, size, "IsScriptTrue");
-		int bStart = lua_toboolean(L, -1);
-		if (errcode)
+
+		if (luaL_loadbuffer(L, code, size, name) != 0)
 		{
-			char buf[100];
-			snprintf(buf, sizeof(buf), "LUA ScriptRunError (code:%%d src:[%%%ds])", size);
-			sys_err(buf, errcode, code);
+			sys_err("LUA ScriptCompileError (%s): %s", name, lua_tostring(L, -1));
+			lua_settop(L, x);
+			return LUA_NOREF;
 		}
-		lua_settop(L,x);
+
+		return luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+
+	bool IsScriptTrue(int iCompiledRef)
+	{
+		// A condition that failed to compile is false, as a lua_dobuffer error used to be.
+		if (iCompiledRef == LUA_NOREF)
+			return false;
+
+		lua_State* L = CQuestManager::instance().GetLuaState();
+		int x = lua_gettop(L);
+
+		lua_rawgeti(L, LUA_REGISTRYINDEX, iCompiledRef);
+
+		int errcode = lua_pcall(L, 0, 1, 0);
+		int bStart = 0;
+
+		if (errcode)
+			sys_err("LUA ScriptRunError (code:%d ref:%d): %s", errcode, iCompiledRef, lua_tostring(L, -1));
+		else
+			bStart = lua_toboolean(L, -1);
+
+		lua_settop(L, x);
 		return bStart != 0;
 	}
 
@@ -762,6 +783,15 @@ namespace quest
 		SendScript();
 	}
 
+	void CQuestManager::GotoQueryState(QuestState & qs)
+	{
+		// 기다리는 동안 다른 사람의 스크립트와 섞이지 않게 지금까지 쌓인 것을 들고 있는다.
+		qs.suspend_state = SUSPEND_STATE_QUERY;
+		qs._suspended_script = m_strScript;
+		qs._suspended_skin = m_iCurrentSkin;
+		ClearScript();
+	}
+
 	void CQuestManager::GotoEndState(QuestState & qs)
 	{
 		AddScript("[DONE]");
@@ -791,6 +821,7 @@ namespace quest
 	// 
 	bool CQuestManager::RunState(QuestState & qs)
 	{
+		M2_TRACE_SCOPE("quest_resume");
 		ClearError();
 
 		m_CurrentRunningState = &qs;
@@ -834,6 +865,12 @@ namespace quest
 				GotoSelectItemState(qs);
 				return true;
 			}
+
+			if (!strcmp(lua_tostring(qs.co, 1), "query"))
+			{
+				GotoQueryState(qs);
+				return true;
+			}
 		}
 		else
 		{
@@ -112,7 +112,7 @@ namespace quest
 
 		if ( pkAff != NULL )
 		{
-			lua_pushnumber(L, pkAff->lDuration);
+			lua_pushnumber(L, pkAff->GetDuration());
 			ch->RemoveAffect( pkAff );
 		}
 		else
@@ -217,10 +217,10 @@ namespace quest
 			bApply = aApplyInfo[bApply].bPointType;
 			long value = (long)lua_tonumber(L, 2);
 
-			const std::list<CAffect*>& rList = ch->GetAffectContainer();
+			const std::vector<CAffect*>& rList = ch->GetAffectContainer();
 			const CAffect* pAffect = NULL;
 
-			for ( std::list<CAffect*>::const_iterator iter = rList.begin(); iter != rList.end(); ++iter )
+			for ( std::vector<CAffect*>::const_iterator iter = rList.begin(); iter != rList.end(); ++iter )
 			{
 				pAffect = *iter;
 
@@ -876,7 +876,7 @@ namespace quest
 			ch->PointChange(POINT_SP, ch->GetMaxSP() - ch->GetSP());
 			
 			ch->ComputePoints();
-			ch->PointsPacket();
+			ch->PointsPacketDeferred();
 			ch->SkillLevelPacket();
 
 			return 0;
@@ -987,7 +987,7 @@ namespace quest
 			const char * sz2 = lua_tostring(L, 2);
 			CQuestManager & q = CQuestManager::Instance();
 			PC * pPC = q.GetCurrentPC();
-			pPC->SetFlag(string(sz)+"."+sz2, int(rint(lua_tonumber(L,3))));
+			pPC->SetFlag(q.GetFlagAtom(sz, sz2), int(rint(lua_tonumber(L,3))));
 			return 0;
 		}
 	}
@@ -1009,7 +1009,7 @@ namespace quest
 			{
 				return 0;
 			}
-			lua_pushnumber(L,pPC->GetFlag(string(sz)+"."+sz2));
+			lua_pushnumber(L,pPC->GetFlag(q.GetFlagAtom(sz, sz2, false)));
 			return 1;
 		}
 	}
@@ -1043,7 +1043,7 @@ namespace quest
 			const char* sz = lua_tostring(L,-1);
 			CQuestManager& q = CQuestManager::Instance();
 			PC* pPC = q.GetCurrentPC();
-			lua_pushnumber(L,pPC->GetFlag(pPC->GetCurrentQuestName() + "."+sz));
+			lua_pushnumber(L,pPC->GetFlag(q.GetFlagAtom(pPC->GetCurrentQuestName(), sz, false)));
 			if ( test_server )
 				sys_log( 0 ,"GetQF ( %s . %s )", pPC->GetCurrentQuestName().c_str(), sz );
 		}
@@ -1077,7 +1077,7 @@ namespace quest
 			const char* sz = lua_tostring(L,1);
 			CQuestManager& q = CQuestManager::Instance();
 			PC* pPC = q.GetCurrentPC();
-			pPC->SetFlag(pPC->GetCurrentQuestName()+"."+sz, int(rint(lua_tonumber(L,2))));
+			pPC->SetFlag(q.GetFlagAtom(pPC->GetCurrentQuestName(), sz), int(rint(lua_tonumber(L,2))));
 		}
 		return 0;
 	}
@@ -1091,8 +1091,9 @@ namespace quest
 		}
 
 		const char * sz = lua_tostring(L, 1);
-		PC * pPC = CQuestManager::instance().GetCurrentPC();
-		pPC->DeleteFlag(pPC->GetCurrentQuestName()+"."+sz);
+		CQuestManager & q = CQuestManager::instance();
+		PC * pPC = q.GetCurrentPC();
+		pPC->DeleteFlag(q.GetFlagAtom(pPC->GetCurrentQuestName(), sz, false));
 		return 0;
 	}
 
@@ -1807,7 +1808,7 @@ namespace quest
 		ch->SetPoint(POINT_SKILL, ch->GetRealPoint(POINT_SKILL));
 		ch->PointChange(POINT_SKILL, 0);
 		ch->ComputePoints();
-		ch->PointsPacket();
+		ch->PointsPacketDeferred();
 
 		return 0;
 	}
@@ -2049,6 +2050,49 @@ teleport_area:
 		return 1;
 	}
 
+	// _async 는 DB 를 기다리는 동안 퀘스트를 멈춘다. 코루틴이 아닌 곳(when 조건 등)에서는
+	// 멈출 수 없으므로 위의 동기 버전과 같이 동작한다.
+	int pc_change_empire_async(lua_State* L)
+	{
+		if (L == CQuestManager::instance().GetLuaState())
+			return pc_change_empire(L);
+
+		LPCHARACTER ch = CQuestManager::instance().GetCurrentCharacterPtr();
+		
+		int iRet = ch->ChangeEmpire((unsigned char)lua_tonumber(L, 1), [](LPCHARACTER ch, int iResult)
+				{
+					CQuestManager::instance().ResumeQuery(ch->GetPlayerID(), iResult);
+				});
+
+		if (iRet >= 0)
+		{
+			lua_pushnumber(L, iRet);
+			return 1;
+		}
+
+		// 결과는 DB 에서 돌아온 뒤 ResumeQuery 가 넘겨준다
+		return CQuestManager::YieldForQuery(L);
+	}
+
+	int pc_get_change_empire_count_async(lua_State* L)
+	{
+		if (L == CQuestManager::instance().GetLuaState())
+			return pc_get_change_empire_count(L);
+
+		LPCHARACTER ch = CQuestManager::instance().GetCurrentCharacterPtr();
+
+		if (!ch->LoadChangeEmpireCount([](LPCHARACTER ch, int iCount)
+				{
+					CQuestManager::instance().ResumeQuery(ch->GetPlayerID(), iCount);
+				}))
+		{
+			lua_pushnumber(L, 0);
+			return 1;
+		}
+
+		return CQuestManager::YieldForQuery(L);
+	}
+
 	int pc_set_change_empire_count(lua_State* L)
 	{
 		LPCHARACTER ch = CQuestManager::instance().GetCurrentCharacterPtr();
@@ -2190,7 +2234,7 @@ teleport_area:
 				}
 
 				ch->ComputePoints();
-				ch->PointsPacket();
+				ch->PointsPacketDeferred();
 
 				if ( point == POINT_HT )
 				{
@@ -2248,7 +2292,7 @@ teleport_area:
 		ch->PointChange(POINT_HT, 0);
 		ch->PointChange(POINT_STAT, -usedPoint);
 		ch->ComputePoints();
-		ch->PointsPacket();
+		ch->PointsPacketDeferred();
 		return 1;
 	}
 
@@ -2272,7 +2316,7 @@ teleport_area:
 		ch->PointChange(POINT_IQ, 0);
 		ch->PointChange(POINT_STAT, -usedPoint);
 		ch->ComputePoints();
-		ch->PointsPacket();
+		ch->PointsPacketDeferred();
 		return 1;
 	}
 	
@@ -2296,7 +2340,7 @@ teleport_area:
 		ch->PointChange(POINT_ST, 0);
 		ch->PointChange(POINT_STAT, -usedPoint);
 		ch->ComputePoints();
-		ch->PointsPacket();
+		ch->PointsPacketDeferred();
 		return 1;
 	}
 	
@@ -2320,7 +2364,7 @@ teleport_area:
 		ch->PointChange(POINT_DX, 0);
 		ch->PointChange(POINT_STAT, -usedPoint);
 		ch->ComputePoints();
-		ch->PointsPacket();
+		ch->PointsPacketDeferred();
 		return 1;
 	}
 
@@ -3235,6 +3279,8 @@ teleport_area:
 			
 			{ "change_empire",			pc_change_empire	},
 			{ "get_change_empire_count",	pc_get_change_empire_count	},
+			{ "change_empire_async",		pc_change_empire_async	},
+			{ "get_change_empire_count_async",	pc_get_change_empire_count_async	},
 			{ "set_change_empire_count",	pc_set_change_empire_count	},
 
 			{ "change_name",			pc_change_name },
@@ -32,6 +32,8 @@ namespace quest
 		m_CurrentRunningState(NULL), m_pCurrentCharacter(NULL), m_pCurrentNPCCharacter(NULL), m_pCurrentPartyMember(NULL),
 		m_pCurrentPC(NULL),  m_iCurrentSkin(0), m_bError(false), m_pOtherPCBlockRootPC(NULL)
 	{
+		m_vecFlagAtom.resize(1);
+		m_vecEventFlagValue.resize(1);
 	}
 
 	CQuestManager::~CQuestManager()
@@ -293,6 +295,40 @@ namespace quest
 		}
 	}
 
+	int CQuestManager::YieldForQuery(lua_State * L)
+	{
+		lua_settop(L, 0);
+		lua_pushstring(L, "query");
+		return lua_yield(L, 1);
+	}
+
+	void CQuestManager::ResumeQuery(unsigned int pc, int iResult)
+	{
+		PC * pPC = GetPC(pc);
+
+		if (!pPC || !pPC->IsRunning() || pPC->GetRunningQuestState()->suspend_state != SUSPEND_STATE_QUERY)
+		{
+			sys_err("not wait for a query : %u", pc);
+			return;
+		}
+
+		QuestState & qs = *pPC->GetRunningQuestState();
+
+		m_strScript = qs._suspended_script;
+		m_iCurrentSkin = qs._suspended_skin;
+		qs._suspended_script.clear();
+
+		qs.suspend_state = SUSPEND_STATE_NONE;
+		qs.args = 1;
+		lua_pushnumber(qs.co, iResult);
+
+		if (!RunState(qs))
+		{
+			CloseState(qs);
+			pPC->EndRunning();
+		}
+	}
+
 	void CQuestManager::Resume(unsigned int pc)
 	{
 		PC * pPC;
@@ -1124,6 +1160,7 @@ namespace quest
 			return;
 
 		m_hmQuestName.insert(make_pair(stQuestName, idx));
+		GetQuestStatusAtom(stQuestName);
 		LoadStartQuest(stQuestName, idx);
 		m_mapQuestNameByIndex.insert(make_pair(idx, stQuestName));
 
@@ -1156,6 +1193,87 @@ namespace quest
 		return it->second;
 	}
 
+	CQuestManager::TQuestFlagScope & CQuestManager::GetQuestFlagScope(std::string_view quest_name)
+	{
+		auto it = m_mapQuestFlagScope.find(quest_name);
+
+		if (it != m_mapQuestFlagScope.end())
+			return it->second;
+
+		TQuestFlagScope & r = m_mapQuestFlagScope[string(quest_name)];
+		r.stEnabledEventFlag = "quest_" + string(quest_name) + "_enabled";
+		return r;
+	}
+
+	DWORD CQuestManager::GetFlagAtom(std::string_view quest_name, std::string_view flag_name, bool bCreate)
+	{
+		TQuestFlagScope & rScope = GetQuestFlagScope(quest_name);
+
+		auto it = rScope.mapFlagAtom.find(flag_name);
+
+		if (it != rScope.mapFlagAtom.end())
+			return it->second;
+
+		if (!bCreate)
+			return 0;
+
+		DWORD dwAtom = m_vecFlagAtom.size();
+
+		TFlagAtom atom;
+		atom.stQuestName = quest_name;
+		atom.stFlagName = flag_name;
+		atom.stName = atom.stQuestName + "." + atom.stFlagName;
+		m_vecFlagAtom.push_back(atom);
+
+		rScope.mapFlagAtom.insert(make_pair(string(flag_name), dwAtom));
+		return dwAtom;
+	}
+
+	DWORD CQuestManager::GetFlagAtom(std::string_view full_name, bool bCreate)
+	{
+		size_t pos = full_name.find('.');
+
+		if (pos == full_name.npos)
+			return GetFlagAtom(full_name, std::string_view(), bCreate);
+
+		return GetFlagAtom(full_name.substr(0, pos), full_name.substr(pos + 1), bCreate);
+	}
+
+	DWORD CQuestManager::GetQuestStatusAtom(std::string_view quest_name)
+	{
+		TQuestFlagScope & rScope = GetQuestFlagScope(quest_name);
+
+		if (!rScope.dwStatusAtom)
+			rScope.dwStatusAtom = GetFlagAtom(quest_name, "__status");
+
+		return rScope.dwStatusAtom;
+	}
+
+	bool CQuestManager::IsQuestStatusAtom(DWORD dwAtom) const
+	{
+		return dwAtom && dwAtom < m_vecFlagAtom.size() && m_vecFlagAtom[dwAtom].stFlagName == "__status";
+	}
+
+	const string & CQuestManager::GetFlagAtomName(DWORD dwAtom) const
+	{
+		return m_vecFlagAtom[dwAtom < m_vecFlagAtom.size() ? dwAtom : 0].stName;
+	}
+
+	const string & CQuestManager::GetFlagAtomQuestName(DWORD dwAtom) const
+	{
+		return m_vecFlagAtom[dwAtom < m_vecFlagAtom.size() ? dwAtom : 0].stQuestName;
+	}
+
+	const string & CQuestManager::GetFlagAtomFlagName(DWORD dwAtom) const
+	{
+		return m_vecFlagAtom[dwAtom < m_vecFlagAtom.size() ? dwAtom : 0].stFlagName;
+	}
+
+	const string & CQuestManager::GetQuestEnabledEventFlagName(std::string_view quest_name)
+	{
+		return GetQuestFlagScope(quest_name).stEnabledEventFlag;
+	}
+
 	void CQuestManager::SendEventFlagList(LPCHARACTER ch)
 	{
 		for (auto it = m_mapEventFlag.begin(); it != m_mapEventFlag.end(); ++it)
@@ -1191,6 +1309,7 @@ namespace quest
 
 		sys_log(0, "QUEST eventflag %s %d prev_value %d", name.c_str(), value, m_mapEventFlag[name]);
 		m_mapEventFlag[name] = value;
+		m_vecEventFlagValue[GetEventFlagHandle(name)] = value;
 
 		if (name == "mob_item")
 		{
@@ -1493,12 +1612,26 @@ namespace quest
 
 	int	CQuestManager::GetEventFlag(const string& name)
 	{
-		map<string,int>::iterator it = m_mapEventFlag.find(name);
+		auto it = m_mapEventFlagHandle.find(name);
 
-		if (it == m_mapEventFlag.end())
+		if (it == m_mapEventFlagHandle.end())
 			return 0;
 
-		return it->second;
+		return m_vecEventFlagValue[it->second];
+	}
+
+	DWORD CQuestManager::GetEventFlagHandle(std::string_view name)
+	{
+		auto it = m_mapEventFlagHandle.find(name);
+
+		if (it != m_mapEventFlagHandle.end())
+			return it->second;
+
+		// 아직 set 된 적 없는 flag 도 핸들은 만들어 둔다. 값은 0 이고 IsEventFlagSet 은 false.
+		DWORD dwHandle = m_vecEventFlagValue.size();
+		m_vecEventFlagValue.push_back(0);
+		m_mapEventFlagHandle.insert(make_pair(string(name), dwHandle));
+		return dwHandle;
 	}
 
 	bool CQuestManager::IsEventFlagSet(const string& name)
@@ -1576,7 +1709,8 @@ namespace quest
 	{
 		// Check if quest is enabled via event flag
 		// Only blocks if flag is explicitly set to 0 (default is enabled)
-		string quest_flag = "quest_" + quest_name + "_enabled";
+		static const string s_stGlobalEnabledFlag = "quests_global_enabled";
+		const string & quest_flag = CQuestManager::instance().GetQuestEnabledEventFlagName(quest_name);
 
 		if (CQuestManager::instance().IsEventFlagSet(quest_flag)
 			&& CQuestManager::instance().GetEventFlag(quest_flag) == 0)
@@ -1587,14 +1721,16 @@ namespace quest
 		}
 
 		// Check global quest disable flag (only if explicitly set)
-		if (CQuestManager::instance().IsEventFlagSet("quests_global_enabled")
-			&& CQuestManager::instance().GetEventFlag("quests_global_enabled") == 0)
+		if (CQuestManager::instance().IsEventFlagSet(s_stGlobalEnabledFlag)
+			&& CQuestManager::instance().GetEventFlag(s_stGlobalEnabledFlag) == 0)
 		{
 			if (test_server)
 				sys_log(0, "QUEST: All quests are disabled via quests_global_enabled flag");
 			return false;
 		}
 
+		M2_TRACE_SCOPE_ARG("quest_execute", pc.GetID());
+
 		// 실행공간을 생성
 		QuestState qs = CQuestManager::instance().OpenState(quest_name, state);
 		if (pChatScripts)
@@ -2,6 +2,7 @@
 #define __METIN2_SERVER_QUEST_MANAGER__
 
 #include <unordered_map>
+#include <string_view>
 
 #include "questnpc.h"
 
@@ -13,7 +14,8 @@ namespace quest
 {
 	using namespace std;
 
-	bool IsScriptTrue(const char* code, int size);
+	bool IsScriptTrue(int iCompiledRef);
+	int CompileScript(const char* code, int size, const char* name);
 	string ScriptToString(const string& str);
 
 	class CQuestManager : public singleton<CQuestManager>
@@ -113,6 +115,11 @@ namespace quest
 			void		Confirm(unsigned int pc, EQuestConfirmType confirm, unsigned int pc2 = 0);
 			void		SelectItem(unsigned int pc, unsigned int selection);
 
+			// 퀘스트 함수가 DB 결과를 기다릴 때 "return CQuestManager::YieldForQuery(L);" 한다.
+			// 결과가 오면 ResumeQuery 가 iResult 를 그 함수의 리턴값으로 넘겨 이어서 실행한다.
+			static int	YieldForQuery(lua_State * L);
+			void		ResumeQuery(unsigned int pc, int iResult);
+
 			void		LogoutPC(LPCHARACTER ch);
 			void		Cancel(unsigned int pc);
 			void		DisconnectPC(LPCHARACTER ch);
@@ -153,10 +160,27 @@ namespace quest
 			unsigned int 	GetQuestIndexByName(const string& name);
 			const string& 	GetQuestNameByIndex(unsigned int idx);
 
+			// PC quest flags ("quest.flag") are interned to stable atoms (0 = none).
+			// Atoms survive Reload() since every PC keeps its flags by atom.
+			DWORD		GetFlagAtom(std::string_view quest_name, std::string_view flag_name, bool bCreate = true);
+			DWORD		GetFlagAtom(std::string_view full_name, bool bCreate = true);
+			DWORD		GetQuestStatusAtom(std::string_view quest_name);
+			bool		IsQuestStatusAtom(DWORD dwAtom) const;
+			const string &	GetFlagAtomName(DWORD dwAtom) const;
+			const string &	GetFlagAtomQuestName(DWORD dwAtom) const;
+			const string &	GetFlagAtomFlagName(DWORD dwAtom) const;
+			const string &	GetQuestEnabledEventFlagName(std::string_view quest_name);
+
 			void		RequestSetEventFlag(const string& name, int value);
 
 			void		SetEventFlag(const string& name, int value);
 			int			GetEventFlag(const string& name);
+
+			// Event flags are registered to stable handles (0 = none). SetEventFlag
+			// keeps the value array in step, so hot paths read by handle instead of
+			// building a string and walking the map. See CEventFlagRef below.
+			DWORD		GetEventFlagHandle(std::string_view name);
+			int			GetEventFlagByHandle(DWORD dwHandle) const	{ return m_vecEventFlagValue[dwHandle]; }
 			bool		IsEventFlagSet(const string& name);  // Check if flag exists
 			void		BroadcastEventFlagOnLogin(LPCHARACTER ch);
 
@@ -188,6 +212,7 @@ namespace quest
 			void			GotoInputState(QuestState& qs);
 			void			GotoConfirmState(QuestState& qs);
 			void			GotoSelectItemState(QuestState& qs);
+			void			GotoQueryState(QuestState& qs);
 
 			lua_State *		L;
 
@@ -230,6 +255,40 @@ namespace quest
 				}
 			};
 
+			struct stringviewhash
+			{
+				typedef void is_transparent;
+
+				size_t operator () (std::string_view str) const
+				{
+					return std::hash<std::string_view>()(str);
+				}
+			};
+
+			struct TFlagAtom
+			{
+				string	stName;
+				string	stQuestName;
+				string	stFlagName;
+			};
+
+			struct TQuestFlagScope
+			{
+				std::unordered_map<string, DWORD, stringviewhash, std::equal_to<> >	mapFlagAtom;
+				DWORD	dwStatusAtom;
+				string	stEnabledEventFlag;	// "quest_<name>_enabled"
+
+				TQuestFlagScope() : dwStatusAtom(0) {}
+			};
+
+			TQuestFlagScope &	GetQuestFlagScope(std::string_view quest_name);
+
+			std::unordered_map<string, TQuestFlagScope, stringviewhash, std::equal_to<> >	m_mapQuestFlagScope;
+			vector<TFlagAtom>	m_vecFlagAtom;	// index == atom, [0] is the "none" atom
+
+			std::unordered_map<string, DWORD, stringviewhash, std::equal_to<> >	m_mapEventFlagHandle;
+			vector<int>			m_vecEventFlagValue;	// index == handle, [0] is the "none" handle
+
 			typedef std::unordered_map<string, int, stringhash> THashMapQuestName;
 			typedef std::unordered_map<unsigned int, vector<char> > THashMapQuestStartScript;
 
@@ -254,6 +313,30 @@ namespace quest
 			PC*			m_pOtherPCBlockRootPC;
 			std::vector <DWORD>	m_vecPCStack;
 	};
+
+	// A fixed event flag name whose handle is resolved on first use, so it can be
+	// a file-scope static next to the code that polls it.
+	class CEventFlagRef
+	{
+		public:
+			explicit CEventFlagRef(const char * c_pszName) : m_c_pszName(c_pszName), m_dwHandle(0)
+			{
+			}
+
+			int Get()
+			{
+				if (!m_dwHandle)
+					m_dwHandle = CQuestManager::instance().GetEventFlagHandle(m_c_pszName);
+
+				return CQuestManager::instance().GetEventFlagByHandle(m_dwHandle);
+			}
+
+			const char * GetName() const	{ return m_c_pszName; }
+
+		private:
+			const char *	m_c_pszName;
+			DWORD			m_dwHandle;
+	};
 };
 
 #endif
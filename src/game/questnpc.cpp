@@ -149,7 +149,17 @@ namespace quest
 
 			if (type_name == "when")
 			{
-				copy(ib, ie, back_inserter(m_mapOwnArgQuest[event_index][quest_index][state_index][index].when_condition));
+				AArgScript & rArgScript = m_mapOwnArgQuest[event_index][quest_index][state_index][index];
+
+				copy(ib, ie, back_inserter(rArgScript.when_condition));
+
+				if (rArgScript.when_ref != LUA_NOREF)
+					luaL_unref(q.GetLuaState(), LUA_REGISTRYINDEX, rArgScript.when_ref);
+
+				rArgScript.when_ref = LUA_NOREF;
+
+				if (!rArgScript.when_condition.empty())
+					rArgScript.when_ref = CompileScript(&rArgScript.when_condition[0], rArgScript.when_condition.size(), filename);
 			}
 			else if (type_name == "arg")
 			{
@@ -236,7 +246,7 @@ namespace quest
 			if (argScript.when_condition.size() > 0)
 				sys_log(1, "OnTarget when %s size %d", &argScript.when_condition[0], argScript.when_condition.size());
 	
-			if (argScript.when_condition.size() != 0 && !IsScriptTrue(&argScript.when_condition[0], argScript.when_condition.size()))
+			if (argScript.when_condition.size() != 0 && !IsScriptTrue(argScript.when_ref))
 				continue;
 
 			sys_log(1, "OnTarget execute qi %u st %d code %s", dwQuestIndex, iState, (const char *) argScript.script.GetCode());
@@ -850,7 +860,7 @@ namespace quest
 				for (i = 0; i < itQuestMap->second[QUEST_START_STATE_INDEX].size(); ++i)
 				{
 					if (itQuestMap->second[QUEST_START_STATE_INDEX][i].when_condition.size() == 0 || 
-							IsScriptTrue(&itQuestMap->second[QUEST_START_STATE_INDEX][i].when_condition[0], itQuestMap->second[QUEST_START_STATE_INDEX][i].when_condition.size()))
+							IsScriptTrue(itQuestMap->second[QUEST_START_STATE_INDEX][i].when_ref))
 						rAvailScript.push_back(&itQuestMap->second[QUEST_START_STATE_INDEX][i]);
 				}
 			}
@@ -875,7 +885,7 @@ namespace quest
 				for (i = 0; i < itQuestMap->second[iState].size(); i++)
 				{
 					if ( itQuestMap->second[iState][i].when_condition.size() == 0 ||
-							IsScriptTrue(&itQuestMap->second[iState][i].when_condition[0], itQuestMap->second[iState][i].when_condition.size()))
+							IsScriptTrue(itQuestMap->second[iState][i].when_ref))
 						rAvailScript.push_back(&itQuestMap->second[iState][i]);
 				}
 			}
@@ -50,72 +50,84 @@ namespace quest
 		return CQuestManager::instance().GetQuestIndexByName(GetCurrentQuestName());
 	}
 
-	void PC::SetFlag(const string& name, int value, bool bSkipSave)
+	void PC::SetFlag(std::string_view name, int value, bool bSkipSave)
+	{
+		SetFlag(CQuestManager::instance().GetFlagAtom(name), value, bSkipSave);
+	}
+
+	bool PC::DeleteFlag(std::string_view name)
+	{
+		DWORD dwAtom = CQuestManager::instance().GetFlagAtom(name, false);
+		return dwAtom ? DeleteFlag(dwAtom) : false;
+	}
+
+	int PC::GetFlag(std::string_view name)
+	{
+		DWORD dwAtom = CQuestManager::instance().GetFlagAtom(name, false);
+		return dwAtom ? GetFlag(dwAtom) : 0;
+	}
+
+	void PC::SetFlag(DWORD dwAtom, int value, bool bSkipSave)
 	{
 		if ( test_server )
-			sys_log(0, "QUEST Setting flag %s %d", name.c_str(),value);
+			sys_log(0, "QUEST Setting flag %s %d", CQuestManager::instance().GetFlagAtomName(dwAtom).c_str(), value);
 		else
-			sys_log(1, "QUEST Setting flag %s %d", name.c_str(),value);
+			sys_log(1, "QUEST Setting flag %s %d", CQuestManager::instance().GetFlagAtomName(dwAtom).c_str(), value);
 
 		if (value == 0)
 		{
-			DeleteFlag(name);
+			DeleteFlag(dwAtom);
 			return;
 		}
 
-		TFlagMap::iterator it = m_FlagMap.find(name);
+		TFlagMap::iterator it = m_FlagMap.find(dwAtom);
 
 		if (it == m_FlagMap.end())
-			m_FlagMap.insert(make_pair(name, value));
+			m_FlagMap.insert(make_pair(dwAtom, value));
 		else if (it->second != value)
 			it->second = value;
 		else
 			bSkipSave = true;
 
 		if (!bSkipSave)
-			SaveFlag(name, value);
+			SaveFlag(dwAtom, value);
 	}
 
-	bool PC::DeleteFlag(const string & name)
+	bool PC::DeleteFlag(DWORD dwAtom)
 	{
-		TFlagMap::iterator it = m_FlagMap.find(name);
+		TFlagMap::iterator it = m_FlagMap.find(dwAtom);
 
 		if (it != m_FlagMap.end())
 		{
 			m_FlagMap.erase(it);
-			SaveFlag(name, 0);
+			SaveFlag(dwAtom, 0);
 			return true;
 		}
 
 		return false;
 	}
 
-	int PC::GetFlag(const string & name)
+	int PC::GetFlag(DWORD dwAtom)
 	{
-		TFlagMap::iterator it = m_FlagMap.find(name);
+		TFlagMap::iterator it = m_FlagMap.find(dwAtom);
 
 		if (it != m_FlagMap.end())
 		{
-			sys_log(1, "QUEST getting flag %s %d", name.c_str(),it->second);
+			sys_log(1, "QUEST getting flag %s %d", CQuestManager::instance().GetFlagAtomName(dwAtom).c_str(), it->second);
 			return it->second;
 		}
 		return 0;
 	}
 
-	void PC::SaveFlag(const string & name, int value)
+	void PC::SaveFlag(DWORD dwAtom, int value)
 	{
-		TFlagMap::iterator it = m_FlagSaveMap.find(name);
-
-		if (it == m_FlagSaveMap.end())
-			m_FlagSaveMap.insert(make_pair(name, value));
-		else if (it->second != value)
-			it->second = value;
+		m_FlagSaveMap[dwAtom] = value;
 	}
 
 	// only from lua call
 	void PC::SetCurrentQuestStateName(const string& state_name) 
 	{
-		SetFlag(m_stCurQuest + ".__status", CQuestManager::Instance().GetQuestStateIndex(m_stCurQuest,state_name));
+		SetFlag(CQuestManager::Instance().GetQuestStatusAtom(m_stCurQuest), CQuestManager::Instance().GetQuestStateIndex(m_stCurQuest,state_name));
 	}
 
 	void PC::SetQuestState(const string& quest_name, const string& state_name)
@@ -125,7 +137,7 @@ namespace quest
 
 	void PC::SetQuestState(const string& quest_name, int new_state_index)
 	{
-		int iNowState = GetFlag(quest_name + ".__status");
+		int iNowState = GetFlag(CQuestManager::instance().GetQuestStatusAtom(quest_name));
 
 		if (iNowState != new_state_index)
 			AddQuestStateChange(quest_name, iNowState, new_state_index);
@@ -154,7 +166,7 @@ namespace quest
 		m_iSendToClient = 0;
 
 		m_iLastState = qs.st;
-		SetFlag(quest_name + ".__status", qs.st);
+		SetFlag(CQuestManager::instance().GetQuestStatusAtom(quest_name), qs.st);
 
 		//m_RunningQuestState->iIndex = GetCurrentQuestBeginFlag();
 		m_RunningQuestState->iIndex = qi;
@@ -358,12 +370,13 @@ namespace quest
 			DWORD dwQuestIndex = CQuestManager::instance().GetQuestIndexByName(m_stCurQuest);
 			if (ch)
 			{
-				SetFlag(m_stCurQuest + ".__status", m_iLastState);
+				const DWORD dwStatusAtom = CQuestManager::instance().GetQuestStatusAtom(m_stCurQuest);
+				SetFlag(dwStatusAtom, m_iLastState);
 				CQuestManager::instance().LeaveState(ch->GetPlayerID(), dwQuestIndex, m_iLastState);
 				pOldState->st = iNowState;
-				SetFlag(m_stCurQuest + ".__status", iNowState);
+				SetFlag(dwStatusAtom, iNowState);
 				CQuestManager::instance().EnterState(ch->GetPlayerID(), dwQuestIndex, iNowState);
-				if (GetFlag(m_stCurQuest + ".__status") == iNowState)
+				if (GetFlag(dwStatusAtom) == iNowState)
 					CQuestManager::instance().Letter(ch->GetPlayerID(), dwQuestIndex, iNowState);
 			}
 		}
@@ -388,6 +401,7 @@ namespace quest
 			DWORD dwQuestIdx = rInfo.quest_idx;
 			QuestInfoIterator it = quest_find(dwQuestIdx);
 			const string stQuestName = CQuestManager::instance().GetQuestNameByIndex(dwQuestIdx);
+			const DWORD dwStatusAtom = CQuestManager::instance().GetQuestStatusAtom(stQuestName);
 
 			if (it == quest_end())
 			{
@@ -395,7 +409,7 @@ namespace quest
 				qs.st = 0;
 
 				m_QuestInfo.insert(make_pair(dwQuestIdx, qs));
-				SetFlag(stQuestName + ".__status", 0);
+				SetFlag(dwStatusAtom, 0);
 
 				it = quest_find(dwQuestIdx);
 			}
@@ -406,11 +420,11 @@ namespace quest
 
 			CQuestManager::instance().LeaveState(ch->GetPlayerID(), dwQuestIdx, rInfo.prev_state);
 			it->second.st = rInfo.next_state;
-			SetFlag(stQuestName + ".__status", rInfo.next_state);
+			SetFlag(dwStatusAtom, rInfo.next_state);
 
 			CQuestManager::instance().EnterState(ch->GetPlayerID(), dwQuestIdx, rInfo.next_state);
 
-			if (GetFlag(stQuestName + ".__status")==rInfo.next_state)
+			if (GetFlag(dwStatusAtom)==rInfo.next_state)
 				CQuestManager::instance().Letter(ch->GetPlayerID(), dwQuestIdx, rInfo.next_state);
 		}
 	}
@@ -525,32 +539,22 @@ namespace quest
 
 		int i = 0;
 
+		CQuestManager & q = CQuestManager::instance();
 		TFlagMap::iterator it = m_FlagSaveMap.begin();
 
 		while (it != m_FlagSaveMap.end())
 		{
-			const std::string & stComp = it->first;
+			DWORD dwAtom = it->first;
 			long lValue = it->second;
 
 			++it;
 
-			int iPos = stComp.find(".");
-
-			if (iPos < 0)
-			{
-				sys_err("quest::PC::Save : cannot find . in FlagMap");
-				continue;
-			}
-
-			string stName;
-			stName.assign(stComp, 0, iPos);
-
-			string stState;
-			stState.assign(stComp, iPos + 1, stComp.length());
+			const string & stName = q.GetFlagAtomQuestName(dwAtom);
+			const string & stState = q.GetFlagAtomFlagName(dwAtom);
 
 			if (stName.length() == 0 || stState.length() == 0)
 			{
-				sys_err("quest::PC::Save : invalid quest data: %s", stComp.c_str());
+				sys_err("quest::PC::Save : invalid quest data: %s", q.GetFlagAtomName(dwAtom).c_str());
 				continue;
 			}
 
@@ -601,7 +605,7 @@ namespace quest
 	void PC::GiveItem(const string& label, DWORD dwVnum, int count)
 	{
 		sys_log(1, "QUEST GiveItem %s %d %d", label.c_str(),dwVnum,count);
-		if (!GetFlag(m_stCurQuest+"."+label))
+		if (!GetFlag(CQuestManager::instance().GetFlagAtom(m_stCurQuest, label, false)))
 		{
 			m_vRewardData.push_back(RewardData(RewardData::REWARD_TYPE_ITEM, dwVnum, count));
 			//SetFlag(m_stCurQuest+"."+label,1);
@@ -614,7 +618,7 @@ namespace quest
 	{
 		sys_log(1, "QUEST GiveExp %s %d", label.c_str(),exp);
 
-		if (!GetFlag(m_stCurQuest+"."+label))
+		if (!GetFlag(CQuestManager::instance().GetFlagAtom(m_stCurQuest, label, false)))
 		{
 			m_vRewardData.push_back(RewardData(RewardData::REWARD_TYPE_EXP, exp));
 			//SetFlag(m_stCurQuest+"."+label,1);
@@ -661,11 +665,13 @@ namespace quest
 
 	void PC::Build()
 	{
+		CQuestManager & q = CQuestManager::instance();
+
 		for (auto it = m_FlagMap.begin(); it != m_FlagMap.end(); ++it)
 		{
-			if (it->first.size()>9 && it->first.compare(it->first.size()-9,9, ".__status") == 0)
+			if (q.IsQuestStatusAtom(it->first))
 			{
-				DWORD dwQuestIndex = CQuestManager::instance().GetQuestIndexByName(it->first.substr(0, it->first.size()-9));
+				DWORD dwQuestIndex = q.GetQuestIndexByName(q.GetFlagAtomQuestName(it->first));
 				int state = it->second;
 				QuestState qs;
 				qs.st = state;
@@ -677,11 +683,12 @@ namespace quest
 
 	void PC::ClearQuest(const string& quest_name)
 	{
-		string quest_name_with_dot = quest_name + '.';
+		CQuestManager & q = CQuestManager::instance();
+
 		for (itertype(m_FlagMap) it = m_FlagMap.begin(); it!= m_FlagMap.end();)
 		{
 			itertype(m_FlagMap) itNow = it++;
-			if (itNow->second != 0 && itNow->first.compare(0, quest_name_with_dot.size(), quest_name_with_dot) == 0)
+			if (itNow->second != 0 && q.GetFlagAtomQuestName(itNow->first) == quest_name)
 			{
 				//m_FlagMap.erase(itNow);
 				SetFlag(itNow->first, 0);
@@ -707,17 +714,19 @@ namespace quest
 
 	void PC::SendFlagList(LPCHARACTER ch)
 	{
+		CQuestManager & q = CQuestManager::instance();
+
 		for (itertype(m_FlagMap) it = m_FlagMap.begin(); it!= m_FlagMap.end(); ++it)
 		{
-			if (it->first.size()>9 && it->first.compare(it->first.size()-9,9, ".__status") == 0)
+			if (q.IsQuestStatusAtom(it->first))
 			{
-				const string quest_name = it->first.substr(0, it->first.size()-9);
-				const char* state_name = CQuestManager::instance().GetQuestStateName(quest_name, it->second);
+				const string & quest_name = q.GetFlagAtomQuestName(it->first);
+				const char* state_name = q.GetQuestStateName(quest_name, it->second);
 				ch->ChatPacket(CHAT_TYPE_INFO, "%s %s (%d)", quest_name.c_str(), state_name, it->second);
 			}
 			else
 			{
-				ch->ChatPacket(CHAT_TYPE_INFO, "%s %d", it->first.c_str(), it->second);
+				ch->ChatPacket(CHAT_TYPE_INFO, "%s %d", q.GetFlagAtomName(it->first).c_str(), it->second);
 			}
 		}
 	}
@@ -1,6 +1,8 @@
 ﻿#ifndef __QUEST_PC_H
 #define __QUEST_PC_H
 
+#include <string_view>
+
 #include "quest.h"
 
 class CHARACTER;
@@ -95,9 +97,14 @@ namespace quest
 			vector<TQuestStateChangeInfo> m_QuestStateChange;
 
 		public:
-			void		SetFlag(const string & name, int value, bool bSkipSave = false);
-			int			GetFlag(const string & name);
-			bool		DeleteFlag(const string & name);
+			void		SetFlag(std::string_view name, int value, bool bSkipSave = false);
+			int			GetFlag(std::string_view name);
+			bool		DeleteFlag(std::string_view name);
+
+			// atom from CQuestManager::GetFlagAtom
+			void		SetFlag(DWORD dwAtom, int value, bool bSkipSave = false);
+			int			GetFlag(DWORD dwAtom);
+			bool		DeleteFlag(DWORD dwAtom);
 
 			const string &	GetCurrentQuestName() const;
 			int			GetCurrentQuestIndex();
@@ -146,7 +153,7 @@ namespace quest
 		private:
 			void		SetSendFlag(int idx);
 			void		ClearSendFlag() { m_iSendToClient = 0; }
-			void		SaveFlag(const string & name, int value);
+			void		SaveFlag(DWORD dwAtom, int value);
 
 			void		ClearCurrentQuestBeginFlag();
 			void		SetCurrentQuestBeginFlag();
@@ -167,7 +174,7 @@ namespace quest
 			QuestState *	m_RunningQuestState;
 			string		m_stCurQuest;
 
-			typedef map<string, int> TFlagMap;
+			typedef std::unordered_map<DWORD, int> TFlagMap;	// atom -> value
 			TFlagMap		m_FlagMap;
 
 			TFlagMap		m_FlagSaveMap;
@@ -9,6 +9,21 @@
 LPREGEN	regen_list = NULL;
 LPREGEN_EXCEPTION regen_exception_list = NULL;
 
+typedef struct regen_bucket
+{
+	int					tokens;
+	std::deque<LPREGEN>	queue;
+
+	regen_bucket() : tokens(0)
+	{}
+} REGEN_BUCKET;
+
+static std::map<long, REGEN_BUCKET>	s_map_regenBucket;
+static int							s_iRegenQueued = 0;
+static uint64_t						s_qwRegenSpawned = 0;
+static uint64_t						s_qwRegenDeferred = 0;
+static DWORD						s_dwRegenPhaseSeq = 0;
+
 enum ERegenModes
 {
 	MODE_TYPE = 0,
@@ -322,20 +337,47 @@ static void regen_spawn_dungeon(LPREGEN regen, LPDUNGEON pDungeon, bool bOnce)
 	}
 }
 
-static void regen_spawn(LPREGEN regen, bool bOnce)
+// Budget cost of one spawn attempt: a group costs as many tokens as it has members.
+static int regen_spawn_cost(LPREGEN regen)
+{
+	if (regen->type == REGEN_TYPE_GROUP)
+	{
+		CMobGroup * pkGroup = CMobManager::instance().GetGroup(regen->vnum);
+
+		if (pkGroup && !pkGroup->GetMemberVector().empty())
+			return pkGroup->GetMemberVector().size();
+	}
+
+	return 1;
+}
+
+// Returns false when piBudget ran out before every missing spawn was attempted.
+static bool regen_spawn(LPREGEN regen, bool bOnce, int * piBudget = NULL)
 {
 	DWORD	num;
 	DWORD	i;
 
+	if (regen->count >= regen->max_count)
+		return true;
+
 	num = (regen->max_count - regen->count);
 
-	if (!num)
-		return;
+	int iCost = piBudget ? regen_spawn_cost(regen) : 0;
 
 	for (i = 0; i < num; ++i)
 	{
 		LPCHARACTER ch = NULL;
 
+		if (piBudget)
+		{
+			// The bucket may go into debt by one attempt so large groups are never starved.
+			if (*piBudget <= 0)
+				return false;
+
+			*piBudget -= iCost;
+			s_qwRegenSpawned += iCost;
+		}
+
 		if (regen->type == REGEN_TYPE_ANYWHERE)
 		{
 			ch = CHARACTER_MANAGER::instance().SpawnMobRandomPosition(regen->vnum, regen->lMapIndex);
@@ -380,6 +422,77 @@ static void regen_spawn(LPREGEN regen, bool bOnce)
 		if (ch && !bOnce)
 			ch->SetRegen(regen);
 	}
+
+	return true;
+}
+
+static void regen_schedule(LPREGEN regen)
+{
+	if (regen->is_queued || regen->count >= regen->max_count)
+		return;
+
+	regen->is_queued = true;
+	s_map_regenBucket[regen->lMapIndex].queue.push_back(regen);
+	++s_iRegenQueued;
+}
+
+// Spreads regens sharing a period evenly over it (golden ratio sequence), so a map
+// full of 60s regens does not come due on the same pulse forever after boot.
+static long regen_phase(LPREGEN regen)
+{
+	long lPeriod = PASSES_PER_SEC(regen->time);
+
+	if (lPeriod <= 1)
+		return 1;
+
+	return 1 + (long) ((++s_dwRegenPhaseSeq * 2654435761u) % (DWORD) lPeriod);
+}
+
+void regen_process()
+{
+	if (!s_iRegenQueued)
+		return;
+
+	for (itertype(s_map_regenBucket) it = s_map_regenBucket.begin(); it != s_map_regenBucket.end(); ++it)
+	{
+		REGEN_BUCKET & rBucket = it->second;
+
+		rBucket.tokens = MIN(rBucket.tokens + g_iRegenSpawnBudget, g_iRegenSpawnBudget);
+
+		while (!rBucket.queue.empty() && rBucket.tokens > 0)
+		{
+			LPREGEN regen = rBucket.queue.front();
+
+			if (!regen_spawn(regen, false, &rBucket.tokens))
+				break;
+
+			rBucket.queue.pop_front();
+			regen->is_queued = false;
+			--s_iRegenQueued;
+		}
+
+		if (!rBucket.queue.empty())
+			++s_qwRegenDeferred;
+	}
+}
+
+void regen_get_scheduler_stat(REGEN_SCHEDULER_STAT & r)
+{
+	r.backlog.clear();
+	r.missing = 0;
+	r.spawned = s_qwRegenSpawned;
+	r.deferred = s_qwRegenDeferred;
+
+	for (itertype(s_map_regenBucket) it = s_map_regenBucket.begin(); it != s_map_regenBucket.end(); ++it)
+	{
+		if (it->second.queue.empty())
+			continue;
+
+		r.backlog[it->first] = it->second.queue.size();
+
+		for (itertype(it->second.queue) it2 = it->second.queue.begin(); it2 != it->second.queue.end(); ++it2)
+			r.missing += MAX(0, (*it2)->max_count - (*it2)->count);
+	}
 }
 
 EVENTFUNC(dungeon_regen_event)
@@ -600,7 +713,11 @@ EVENTFUNC(regen_event)
 	if (regen->time == 0)
 		regen->event = NULL;
 
-	regen_spawn(regen, false);
+	if (g_iRegenSpawnBudget > 0)
+		regen_schedule(regen);
+	else
+		regen_spawn(regen, false);
+
 	return PASSES_PER_SEC(regen->time);
 }
 
@@ -694,7 +811,7 @@ bool regen_load(const char* filename, long lMapIndex, int base_x, int base_y)
 
 				info->regen = regen;
 
-				regen->event = event_create(regen_event, info, PASSES_PER_SEC(number(0, 16)) + PASSES_PER_SEC(regen->time)); 
+				regen->event = event_create(regen_event, info, regen_phase(regen));
 			}
 			//END_NO_REGEN
 		}
@@ -733,6 +850,9 @@ void regen_free(void)
 
 	regen_list = NULL;
 
+	s_map_regenBucket.clear();
+	s_iRegenQueued = 0;
+
 	for (exc = regen_exception_list; exc; exc = next_exc)
 	{
 		next_exc = exc->next;
@@ -29,6 +29,7 @@ typedef struct regen
 	bool	is_aggressive;
 
 	LPEVENT	event;
+	bool	is_queued;	// waiting in the per-map spawn queue
 
 	size_t id; // to help dungeon regen identification
 
@@ -45,6 +46,7 @@ typedef struct regen
 		vnum(0),
 		is_aggressive(0),
 		event(NULL),
+		is_queued(false),
 		id(0)
 	{}
 } REGEN;
@@ -90,3 +92,17 @@ extern void	regen_free();
 
 extern bool	is_regen_exception(long x, long y);
 extern void	regen_reset(int x, int y);
+
+// Field regens that come due are queued per map and spawned from regen_process()
+// within g_iRegenSpawnBudget spawns per map per pulse. Dungeon regens bypass the
+// queue so quest scripts see the full spawn as soon as regen_do() returns.
+typedef struct regen_scheduler_stat
+{
+	std::map<long, int>	backlog;		// map index -> queued regens
+	int					missing;		// mobs/groups still owed by queued regens
+	uint64_t			spawned;		// spawn cost paid from the budget since boot
+	uint64_t			deferred;		// map pulses that ended with a non-empty queue
+} REGEN_SCHEDULER_STAT;
+
+extern void	regen_process();
+extern void	regen_get_scheduler_stat(REGEN_SCHEDULER_STAT & r);
@@ -142,6 +142,14 @@ bool SECTREE::InsertEntity(LPENTITY pkEnt)
 	{
 		LPCHARACTER pkChr = (LPCHARACTER) pkEnt;
 
+		if (!pkChr->GetMapLink().pkMap)
+		{
+			LPSECTREE_MAP pkMap = SECTREE_MANAGER::instance().GetMap(pkChr->GetMapIndex());
+
+			if (pkMap)
+				pkMap->RegisterCharacter(pkChr);
+		}
+
 		if (pkChr->IsPC())
 		{
 			IncreasePC();
@@ -171,7 +179,12 @@ void SECTREE::RemoveEntity(LPENTITY pkEnt)
 
 	if (pkEnt->IsType(ENTITY_CHARACTER))
 	{
-		if (((LPCHARACTER) pkEnt)->IsPC())
+		LPCHARACTER pkChr = (LPCHARACTER) pkEnt;
+
+		if (pkChr->GetMapLink().pkMap)
+			pkChr->GetMapLink().pkMap->UnregisterCharacter(pkChr);
+
+		if (pkChr->IsPC())
 			DecreasePC();
 	}
 }
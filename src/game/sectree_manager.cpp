@@ -22,10 +22,25 @@ WORD SECTREE_MANAGER::current_sectree_version = MAKEWORD(0, 3);
 SECTREE_MAP::SECTREE_MAP()
 {
 	memset( &m_setting, 0, sizeof(m_setting) );
+	memset( m_apkCharacterHead, 0, sizeof(m_apkCharacterHead) );
+	memset( m_aCharacterCount, 0, sizeof(m_aCharacterCount) );
+	memset( m_aLiveCount, 0, sizeof(m_aLiveCount) );
 }
 
 SECTREE_MAP::~SECTREE_MAP()
 {
+	// Characters that outlive the map (e.g. a PC whose desc is still closing)
+	// must not unlink themselves from freed memory later.
+	for (int i = 0; i < MAP_CHARACTER_KIND_MAX_NUM; ++i)
+	{
+		for (LPCHARACTER ch = m_apkCharacterHead[i]; ch; )
+		{
+			CHARACTER::SMapLink & rLink = ch->GetMapLink();
+			ch = rLink.pkNext;
+			memset(&rLink, 0, sizeof(rLink));
+		}
+	}
+
 	MapType::iterator it = map_.begin();
 
 	while (it != map_.end()) {
@@ -39,6 +54,9 @@ SECTREE_MAP::~SECTREE_MAP()
 SECTREE_MAP::SECTREE_MAP(SECTREE_MAP & r)
 {
 	m_setting = r.m_setting;
+	memset( m_apkCharacterHead, 0, sizeof(m_apkCharacterHead) );
+	memset( m_aCharacterCount, 0, sizeof(m_aCharacterCount) );
+	memset( m_aLiveCount, 0, sizeof(m_aLiveCount) );
 
 	MapType::iterator it = r.map_.begin();
 
@@ -56,6 +74,107 @@ SECTREE_MAP::SECTREE_MAP(SECTREE_MAP & r)
 	Build();
 }
 
+BYTE SECTREE_MAP::GetCharacterKind(LPCHARACTER ch)
+{
+	if (ch->GetCharType() == CHAR_TYPE_PC)
+		return MAP_CHARACTER_KIND_PC;
+
+	if (ch->IsMonster())
+		return MAP_CHARACTER_KIND_MONSTER;
+
+	if (ch->IsStone())
+		return MAP_CHARACTER_KIND_STONE;
+
+	return MAP_CHARACTER_KIND_NPC;
+}
+
+void SECTREE_MAP::RegisterCharacter(LPCHARACTER ch)
+{
+	CHARACTER::SMapLink & rLink = ch->GetMapLink();
+
+	if (rLink.pkMap == this)
+		return;
+
+	if (rLink.pkMap)
+		rLink.pkMap->UnregisterCharacter(ch);
+
+	BYTE bKind = GetCharacterKind(ch);
+
+	rLink.pkMap = this;
+	rLink.bKind = bKind;
+	rLink.bAlive = bKind == MAP_CHARACTER_KIND_PC || !ch->IsDead();
+	rLink.dwVnum = bKind == MAP_CHARACTER_KIND_PC ? 0 : ch->GetMobTable().dwVnum;
+	rLink.pkPrev = NULL;
+	rLink.pkNext = m_apkCharacterHead[bKind];
+
+	if (rLink.pkNext)
+		rLink.pkNext->GetMapLink().pkPrev = ch;
+
+	m_apkCharacterHead[bKind] = ch;
+	++m_aCharacterCount[bKind];
+
+	if (rLink.bAlive)
+	{
+		++m_aLiveCount[bKind];
+		++m_map_liveVnumCount[bKind][rLink.dwVnum];
+	}
+}
+
+void SECTREE_MAP::UnregisterCharacter(LPCHARACTER ch)
+{
+	CHARACTER::SMapLink & rLink = ch->GetMapLink();
+
+	if (rLink.pkMap != this)
+		return;
+
+	BYTE bKind = rLink.bKind;
+
+	if (rLink.bAlive)
+		OnCharacterDead(ch);
+
+	if (rLink.pkPrev)
+		rLink.pkPrev->GetMapLink().pkNext = rLink.pkNext;
+	else
+		m_apkCharacterHead[bKind] = rLink.pkNext;
+
+	if (rLink.pkNext)
+		rLink.pkNext->GetMapLink().pkPrev = rLink.pkPrev;
+
+	--m_aCharacterCount[bKind];
+	memset(&rLink, 0, sizeof(rLink));
+}
+
+void SECTREE_MAP::OnCharacterDead(LPCHARACTER ch)
+{
+	CHARACTER::SMapLink & rLink = ch->GetMapLink();
+
+	if (rLink.pkMap != this || !rLink.bAlive)
+		return;
+
+	rLink.bAlive = false;
+	--m_aLiveCount[rLink.bKind];
+
+	TVnumCountMap & rVnumCount = m_map_liveVnumCount[rLink.bKind];
+	TVnumCountMap::iterator it = rVnumCount.find(rLink.dwVnum);
+
+	if (it != rVnumCount.end() && --it->second == 0)
+		rVnumCount.erase(it);
+}
+
+size_t SECTREE_MAP::GetLiveCount(BYTE bKind, DWORD dwVnum) const
+{
+	TVnumCountMap::const_iterator it = m_map_liveVnumCount[bKind].find(dwVnum);
+	return it != m_map_liveVnumCount[bKind].end() ? it->second : 0;
+}
+
+void SECTREE_MAP::GetCharacters(BYTE bKind, std::vector<LPCHARACTER> & rvecCharacters) const
+{
+	rvecCharacters.reserve(rvecCharacters.size() + m_aCharacterCount[bKind]);
+
+	for (LPCHARACTER ch = m_apkCharacterHead[bKind]; ch; ch = ch->GetMapLink().pkNext)
+		rvecCharacters.push_back(ch);
+}
+
 LPSECTREE SECTREE_MAP::Find(DWORD dwPackage)
 {
 	MapType::iterator it = map_.find(dwPackage);
@@ -1507,160 +1626,58 @@ bool SECTREE_MANAGER::SaveAttributeToImage(int lMapIndex, const char * c_pszFile
 	}
 }
 
-struct FPurgeMonsters
-{
-	void operator() (LPENTITY ent)
-	{
-		if ( ent->IsType(ENTITY_CHARACTER) == true )
-		{
-			LPCHARACTER lpChar = (LPCHARACTER)ent;
-
-			if ( lpChar->IsMonster() == true && !lpChar->IsPet())
-			{
-				M2_DESTROY_CHARACTER(lpChar);
-			}
-		}
-	}
-};
-
-void SECTREE_MANAGER::PurgeMonstersInMap(long lMapIndex)
+static void PurgeCharactersInMap(long lMapIndex, BYTE bKind)
 {
 	LPSECTREE_MAP sectree = SECTREE_MANAGER::instance().GetMap(lMapIndex);
 
 	if ( sectree != NULL )
 	{
-		struct FPurgeMonsters f;
+		std::vector<LPCHARACTER> v;
+		sectree->GetCharacters(bKind, v);
 
-		sectree->for_each( f );
-	}
-}
-
-struct FPurgeStones
-{
-	void operator() (LPENTITY ent)
-	{
-		if ( ent->IsType(ENTITY_CHARACTER) == true )
+		for (size_t i = 0; i < v.size(); ++i)
 		{
-			LPCHARACTER lpChar = (LPCHARACTER)ent;
-
-			if ( lpChar->IsStone() == true )
-			{
-				M2_DESTROY_CHARACTER(lpChar);
-			}
+			if (!v[i]->IsPet())
+				M2_DESTROY_CHARACTER(v[i]);
 		}
 	}
-};
+}
 
-void SECTREE_MANAGER::PurgeStonesInMap(long lMapIndex)
+void SECTREE_MANAGER::PurgeMonstersInMap(long lMapIndex)
 {
-	LPSECTREE_MAP sectree = SECTREE_MANAGER::instance().GetMap(lMapIndex);
-
-	if ( sectree != NULL )
-	{
-		struct FPurgeStones f;
-
-		sectree->for_each( f );
-	}
+	PurgeCharactersInMap(lMapIndex, MAP_CHARACTER_KIND_MONSTER);
 }
 
-struct FPurgeNPCs
+void SECTREE_MANAGER::PurgeStonesInMap(long lMapIndex)
 {
-	void operator() (LPENTITY ent)
-	{
-		if ( ent->IsType(ENTITY_CHARACTER) == true )
-		{
-			LPCHARACTER lpChar = (LPCHARACTER)ent;
-
-			if ( lpChar->IsNPC() == true && !lpChar->IsPet())
-			{
-				M2_DESTROY_CHARACTER(lpChar);
-			}
-		}
-	}
-};
+	PurgeCharactersInMap(lMapIndex, MAP_CHARACTER_KIND_STONE);
+}
 
 void SECTREE_MANAGER::PurgeNPCsInMap(long lMapIndex)
 {
-	LPSECTREE_MAP sectree = SECTREE_MANAGER::instance().GetMap(lMapIndex);
-
-	if ( sectree != NULL )
-	{
-		struct FPurgeNPCs f;
-
-		sectree->for_each( f );
-	}
+	// IsNPC() covers every non-PC character type
+	PurgeCharactersInMap(lMapIndex, MAP_CHARACTER_KIND_MONSTER);
+	PurgeCharactersInMap(lMapIndex, MAP_CHARACTER_KIND_STONE);
+	PurgeCharactersInMap(lMapIndex, MAP_CHARACTER_KIND_NPC);
 }
 
-struct FCountMonsters
-{
-	std::map<VID, VID> m_map_Monsters;
-
-	void operator() (LPENTITY ent)
-	{
-		if ( ent->IsType(ENTITY_CHARACTER) == true )
-		{
-			LPCHARACTER lpChar = (LPCHARACTER)ent;
-
-			if ( lpChar->IsMonster() == true )
-			{
-				m_map_Monsters[lpChar->GetVID()] = lpChar->GetVID();
-			}
-		}
-	}
-};
-
 size_t SECTREE_MANAGER::GetMonsterCountInMap(long lMapIndex)
 {
 	LPSECTREE_MAP sectree = SECTREE_MANAGER::instance().GetMap(lMapIndex);
 
 	if ( sectree != NULL )
-	{
-		struct FCountMonsters f;
-
-		sectree->for_each( f );
-
-		return f.m_map_Monsters.size();
-	}
+		return sectree->GetLiveCount(MAP_CHARACTER_KIND_MONSTER);
 
 	return 0;
 }
 
-struct FCountSpecifiedMonster
-{
-	DWORD SpecifiedVnum;
-	size_t cnt;
-
-	FCountSpecifiedMonster(DWORD id)
-		: SpecifiedVnum(id), cnt(0)
-	{}
-
-	void operator() (LPENTITY ent)
-	{
-		if (true == ent->IsType(ENTITY_CHARACTER))
-		{
-			LPCHARACTER pChar = static_cast<LPCHARACTER>(ent);
-
-			if (true == pChar->IsStone())
-			{
-				if (pChar->GetMobTable().dwVnum == SpecifiedVnum)
-					cnt++;
-			}
-		}
-	}
-};
-
 size_t SECTREE_MANAGER::GetMonsterCountInMap(long lMapIndex, DWORD dwVnum)
 {
 	LPSECTREE_MAP sectree = SECTREE_MANAGER::instance().GetMap(lMapIndex);
 
+	// only ever used for the dragon stones, which are stones rather than monsters
 	if (NULL != sectree)
-	{
-		struct FCountSpecifiedMonster f(dwVnum);
-
-		sectree->for_each( f );
-
-		return f.cnt;
-	}
+		return sectree->GetLiveCount(MAP_CHARACTER_KIND_STONE, dwVnum);
 
 	return 0;
 }
@@ -48,10 +48,20 @@ typedef struct SSetting
 	PIXEL_POSITION	posSpawn;
 } TMapSetting;
 
+enum EMapCharacterKinds
+{
+	MAP_CHARACTER_KIND_PC,
+	MAP_CHARACTER_KIND_MONSTER,
+	MAP_CHARACTER_KIND_STONE,
+	MAP_CHARACTER_KIND_NPC,
+	MAP_CHARACTER_KIND_MAX_NUM
+};
+
 class SECTREE_MAP
 {
 	public:
 		typedef std::map<DWORD, LPSECTREE> MapType;
+		typedef std::unordered_map<DWORD, size_t> TVnumCountMap;
 
 		SECTREE_MAP();
 		SECTREE_MAP(SECTREE_MAP & r);
@@ -89,6 +99,22 @@ class SECTREE_MAP
 			*/
 		}
 
+		// Characters standing on this map, linked per kind through
+		// CHARACTER::GetMapLink(). Live counts drop when a non-PC dies rather
+		// than when its corpse is removed.
+		static BYTE	GetCharacterKind(LPCHARACTER ch);
+
+		void		RegisterCharacter(LPCHARACTER ch);
+		void		UnregisterCharacter(LPCHARACTER ch);
+		void		OnCharacterDead(LPCHARACTER ch);
+
+		size_t		GetCharacterCount(BYTE bKind) const	{ return m_aCharacterCount[bKind]; }
+		size_t		GetLiveCount(BYTE bKind) const		{ return m_aLiveCount[bKind]; }
+		size_t		GetLiveCount(BYTE bKind, DWORD dwVnum) const;
+
+		// Snapshot of one kind's list, safe against the callback destroying characters.
+		void		GetCharacters(BYTE bKind, std::vector<LPCHARACTER> & rvecCharacters) const;
+
 		void DumpAllToSysErr() {
 			SECTREE_MAP::MapType::iterator i;
 			for (i = map_.begin(); i != map_.end(); ++i)
@@ -99,6 +125,11 @@ class SECTREE_MAP
 
 	private:
 		MapType map_;
+
+		LPCHARACTER		m_apkCharacterHead[MAP_CHARACTER_KIND_MAX_NUM];
+		size_t			m_aCharacterCount[MAP_CHARACTER_KIND_MAX_NUM];
+		size_t			m_aLiveCount[MAP_CHARACTER_KIND_MAX_NUM];
+		TVnumCountMap	m_map_liveVnumCount[MAP_CHARACTER_KIND_MAX_NUM];
 };
 
 enum EAttrRegionMode
@@ -5,25 +5,69 @@
 #include "skill.h"
 #include "char.h"
 
-void CSkillProto::SetPointVar(const std::string& strName, double dVar)
+static const char * s_aszSkillPolyVarName[SKILL_VAR_MAX_NUM] =
 {
-	kPointPoly.SetVar(strName, dVar);
-	kPointPoly2.SetVar(strName, dVar);
-	kPointPoly3.SetVar(strName, dVar);
-	kMasterBonusPoly.SetVar(strName, dVar);
+	"k",
+	"lv",
+	"iq",
+	"str",
+	"dex",
+	"con",
+	"def",
+	"odef",
+	"horse_level",
+	"ar",
+	"atk",
+	"maxv",
+	"maxhp",
+	"maxsp",
+	"chain",
+	"ek",
+	"wep",
+	"mtk",
+	"mwep",
+	"v",
+};
+
+void CSkillProto::BindPolyVars()
+{
+	for (int i = 0; i < SKILL_VAR_MAX_NUM; ++i)
+	{
+		std::string stName(s_aszSkillPolyVarName[i]);
+
+		aiPointVarSlot[0][i] = kPointPoly.GetVarIndex(stName);
+		aiPointVarSlot[1][i] = kPointPoly2.GetVarIndex(stName);
+		aiPointVarSlot[2][i] = kPointPoly3.GetVarIndex(stName);
+		aiPointVarSlot[3][i] = kMasterBonusPoly.GetVarIndex(stName);
+
+		aiDurationVarSlot[0][i] = kDurationPoly.GetVarIndex(stName);
+		aiDurationVarSlot[1][i] = kDurationPoly2.GetVarIndex(stName);
+		aiDurationVarSlot[2][i] = kDurationPoly3.GetVarIndex(stName);
+
+		aiSPCostVarSlot[0][i] = kSPCostPoly.GetVarIndex(stName);
+		aiSPCostVarSlot[1][i] = kGrandMasterAddSPCostPoly.GetVarIndex(stName);
+	}
+}
+
+void CSkillProto::SetPointVar(BYTE bVar, double dVar)
+{
+	kPointPoly.SetVar(aiPointVarSlot[0][bVar], dVar);
+	kPointPoly2.SetVar(aiPointVarSlot[1][bVar], dVar);
+	kPointPoly3.SetVar(aiPointVarSlot[2][bVar], dVar);
+	kMasterBonusPoly.SetVar(aiPointVarSlot[3][bVar], dVar);
 }
 
-void CSkillProto::SetDurationVar(const std::string& strName, double dVar)
+void CSkillProto::SetDurationVar(BYTE bVar, double dVar)
 {
-	kDurationPoly.SetVar(strName, dVar);
-	kDurationPoly2.SetVar(strName, dVar);
-	kDurationPoly3.SetVar(strName, dVar);
+	kDurationPoly.SetVar(aiDurationVarSlot[0][bVar], dVar);
+	kDurationPoly2.SetVar(aiDurationVarSlot[1][bVar], dVar);
+	kDurationPoly3.SetVar(aiDurationVarSlot[2][bVar], dVar);
 }
 
-void CSkillProto::SetSPCostVar(const std::string& strName, double dVar)
+void CSkillProto::SetSPCostVar(BYTE bVar, double dVar)
 {
-	kSPCostPoly.SetVar(strName, dVar);
-	kGrandMasterAddSPCostPoly.SetVar(strName, dVar);
+	kSPCostPoly.SetVar(aiSPCostVarSlot[0][bVar], dVar);
+	kGrandMasterAddSPCostPoly.SetVar(aiSPCostVarSlot[1][bVar], dVar);
 }
 
 CSkillManager::CSkillManager()
@@ -289,6 +333,8 @@ bool CSkillManager::Initialize(TSkillTable * pTab, int iSize)
 			continue;
 		}
 
+		pkProto->BindPolyVars();
+
 		sys_log(0, "#%-3d %-24s type %u flag %u affect %u point_poly: %s", 
 				pkProto->dwVnum, pkProto->szName, pkProto->dwType, pkProto->dwFlag, pkProto->dwAffectFlag, t->szPointPoly);
 
@@ -306,6 +352,7 @@ bool CSkillManager::Initialize(TSkillTable * pTab, int iSize)
 		}
 
 		m_map_pkSkillProto.clear();
+		m_tableSkillProto.Clear();
 
 		// 새로운 내용을 삽입
 		it = map_pkSkillProto.begin();
@@ -313,6 +360,7 @@ bool CSkillManager::Initialize(TSkillTable * pTab, int iSize)
 		while (it != map_pkSkillProto.end())
 		{
 			m_map_pkSkillProto.insert(std::map<DWORD, CSkillProto *>::value_type(it->first, it->second));
+			m_tableSkillProto.Set(it->first, it->second);
 			++it;
 		}
 
@@ -326,12 +374,7 @@ bool CSkillManager::Initialize(TSkillTable * pTab, int iSize)
 
 CSkillProto * CSkillManager::Get(DWORD dwVnum)
 {
-	std::map<DWORD, CSkillProto *>::iterator it = m_map_pkSkillProto.find(dwVnum);
-
-	if (it == m_map_pkSkillProto.end())
-		return NULL;
-
-	return it->second;
+	return m_tableSkillProto.Get(dwVnum);
 }
 
 CSkillProto * CSkillManager::Get(const char * c_pszSkillName)
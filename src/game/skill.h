@@ -2,6 +2,7 @@
 #define __INC_METIN_II_GAME_CSkillManager_H__
 
 #include "libpoly/Poly.h"
+#include "vnum_table.h"
 
 enum ESkillFlags
 {
@@ -172,6 +173,32 @@ enum ESkillIndexes
 
 };
 
+// Variables the game binds into skill formulas, resolved to CPoly slots at load
+enum ESkillPolyVars
+{
+	SKILL_VAR_K,
+	SKILL_VAR_LV,
+	SKILL_VAR_IQ,
+	SKILL_VAR_STR,
+	SKILL_VAR_DEX,
+	SKILL_VAR_CON,
+	SKILL_VAR_DEF,
+	SKILL_VAR_ODEF,
+	SKILL_VAR_HORSE_LEVEL,
+	SKILL_VAR_AR,
+	SKILL_VAR_ATK,
+	SKILL_VAR_MAXV,
+	SKILL_VAR_MAXHP,
+	SKILL_VAR_MAXSP,
+	SKILL_VAR_CHAIN,
+	SKILL_VAR_EK,
+	SKILL_VAR_WEP,
+	SKILL_VAR_MTK,
+	SKILL_VAR_MWEP,
+	SKILL_VAR_V,
+	SKILL_VAR_MAX_NUM
+};
+
 class CSkillProto
 {
 	public:
@@ -225,9 +252,16 @@ class CSkillProto
 
 		CPoly kGrandMasterAddSPCostPoly;
 
-		void SetPointVar(const std::string& strName, double dVar);
-		void SetDurationVar(const std::string& strName, double dVar);
-		void SetSPCostVar(const std::string& strName, double dVar);
+		void SetPointVar(BYTE bVar, double dVar);
+		void SetDurationVar(BYTE bVar, double dVar);
+		void SetSPCostVar(BYTE bVar, double dVar);
+
+		// Resolves ESkillPolyVars to slots of each formula; call once all of them are analyzed.
+		void BindPolyVars();
+
+		int	aiPointVarSlot[4][SKILL_VAR_MAX_NUM];		// kPointPoly, 2, 3, kMasterBonusPoly
+		int	aiDurationVarSlot[3][SKILL_VAR_MAX_NUM];	// kDurationPoly, 2, 3
+		int	aiSPCostVarSlot[2][SKILL_VAR_MAX_NUM];		// kSPCostPoly, kGrandMasterAddSPCostPoly
 };
 
 class CSkillManager : public singleton<CSkillManager>
@@ -242,6 +276,7 @@ class CSkillManager : public singleton<CSkillManager>
 
 	protected:
 		std::map<DWORD, CSkillProto *> m_map_pkSkillProto;
+		CVnumTable<CSkillProto, 8>		m_tableSkillProto;
 };
 
 #endif
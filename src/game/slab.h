@@ -0,0 +1,182 @@
+﻿#ifndef __INC_METIN_II_GAME_SLAB_H__
+#define __INC_METIN_II_GAME_SLAB_H__
+
+#include <new>
+#include <utility>
+#include <vector>
+
+// Typed slab arena handing out generation-checked handles.
+//
+// A handle packs the slot index into the low SLOT_BITS bits and the slot's
+// generation above it. The generation is bumped whenever a slot is freed, so
+// a stale handle never resolves to the object that later reuses the slot.
+// Handles never have the top bit set and are never 0.
+//
+// Slots are carved out of fixed-size chunks that stay put until the slab
+// itself goes away, and freed slots are reused oldest first so a given
+// handle value comes back as late as possible. Not thread-safe.
+template <typename T, int SLOT_BITS = 20, int CHUNK_SIZE = 256>
+class CObjectSlab
+{
+	public:
+		enum
+		{
+			SLOT_MASK		= (1 << SLOT_BITS) - 1,
+			GENERATION_MASK	= (1 << (31 - SLOT_BITS)) - 1,
+		};
+
+		CObjectSlab() : m_dwSlotCount(0), m_dwLiveCount(0), m_dwFreeHead(INVALID_SLOT), m_dwFreeTail(INVALID_SLOT)
+		{
+		}
+
+		~CObjectSlab()
+		{
+			ForEach([this] (T * p) { Destroy(p); });
+
+			for (size_t i = 0; i < m_vecChunk.size(); ++i)
+				delete [] m_vecChunk[i];
+		}
+
+		template <typename... Args>
+		T * Construct(DWORD * pdwHandle, Args &&... args)
+		{
+			SSlot * pSlot = AllocSlot();
+
+			if (!pSlot)
+				return NULL;
+
+			T * p = new (pSlot->abStorage) T(std::forward<Args>(args)...);
+
+			pSlot->bLive = true;
+			++m_dwLiveCount;
+
+			*pdwHandle = (pSlot->dwGeneration << SLOT_BITS) | pSlot->dwIndex;
+			return p;
+		}
+
+		void Destroy(T * p)
+		{
+			if (!p)
+				return;
+
+			SSlot * pSlot = reinterpret_cast<SSlot *>(p);
+
+			if (!pSlot->bLive)
+			{
+				sys_err("slab: destroying a free slot %u", pSlot->dwIndex);
+				return;
+			}
+
+			p->~T();
+
+			pSlot->bLive = false;
+			--m_dwLiveCount;
+
+			if (++pSlot->dwGeneration > GENERATION_MASK)
+				pSlot->dwGeneration = 1;
+
+			pSlot->dwNextFree = INVALID_SLOT;
+
+			if (m_dwFreeTail != INVALID_SLOT)
+				GetSlot(m_dwFreeTail)->dwNextFree = pSlot->dwIndex;
+			else
+				m_dwFreeHead = pSlot->dwIndex;
+
+			m_dwFreeTail = pSlot->dwIndex;
+		}
+
+		T * Get(DWORD dwHandle) const
+		{
+			DWORD dwIndex = dwHandle & SLOT_MASK;
+
+			if (dwIndex >= m_dwSlotCount)
+				return NULL;
+
+			SSlot * pSlot = GetSlot(dwIndex);
+
+			if (!pSlot->bLive || pSlot->dwGeneration != (dwHandle >> SLOT_BITS))
+				return NULL;
+
+			return reinterpret_cast<T *>(pSlot->abStorage);
+		}
+
+		// f may destroy the object it is given, but no other.
+		template <typename Func>
+		void ForEach(Func f)
+		{
+			for (DWORD i = 0; i < m_dwSlotCount; ++i)
+			{
+				SSlot * pSlot = GetSlot(i);
+
+				if (pSlot->bLive)
+					f(reinterpret_cast<T *>(pSlot->abStorage));
+			}
+		}
+
+		size_t Size() const		{ return m_dwLiveCount; }
+		size_t Capacity() const	{ return m_dwSlotCount; }
+
+	private:
+		enum
+		{
+			INVALID_SLOT = 0xffffffff,
+		};
+
+		struct SSlot
+		{
+			alignas(T) unsigned char	abStorage[sizeof(T)];	// must stay first
+			DWORD	dwIndex;
+			DWORD	dwGeneration;
+			DWORD	dwNextFree;
+			bool	bLive;
+		};
+
+		SSlot * GetSlot(DWORD dwIndex) const
+		{
+			return &m_vecChunk[dwIndex / CHUNK_SIZE][dwIndex % CHUNK_SIZE];
+		}
+
+		SSlot * AllocSlot()
+		{
+			if (m_dwFreeHead != INVALID_SLOT)
+			{
+				SSlot * pSlot = GetSlot(m_dwFreeHead);
+
+				m_dwFreeHead = pSlot->dwNextFree;
+
+				if (m_dwFreeHead == INVALID_SLOT)
+					m_dwFreeTail = INVALID_SLOT;
+
+				return pSlot;
+			}
+
+			if (m_dwSlotCount > SLOT_MASK)
+			{
+				sys_err("slab: out of slots (%u)", m_dwSlotCount);
+				return NULL;
+			}
+
+			if (m_dwSlotCount % CHUNK_SIZE == 0)
+				m_vecChunk.push_back(new SSlot[CHUNK_SIZE]);
+
+			SSlot * pSlot = GetSlot(m_dwSlotCount);
+
+			pSlot->dwIndex = m_dwSlotCount++;
+			pSlot->dwGeneration = 1;
+			pSlot->dwNextFree = INVALID_SLOT;
+			pSlot->bLive = false;
+			return pSlot;
+		}
+
+		std::vector<SSlot *>	m_vecChunk;
+		DWORD					m_dwSlotCount;
+		DWORD					m_dwLiveCount;
+		DWORD					m_dwFreeHead;
+		DWORD					m_dwFreeTail;
+
+		// No copy
+		CObjectSlab(const CObjectSlab &);
+		void operator = (const CObjectSlab &);
+};
+
+#endif
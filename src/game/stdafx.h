@@ -11,6 +11,7 @@
 #include "common/singleton.h"
 #include "common/utils.h"
 #include "common/service.h"
+#include "libthecore/trace.h"
 
 #include <algorithm>
 #include <math.h>
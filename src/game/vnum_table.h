@@ -0,0 +1,112 @@
+﻿#ifndef __INC_METIN_II_GAME_VNUM_TABLE_H__
+#define __INC_METIN_II_GAME_VNUM_TABLE_H__
+
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+// Direct-mapped vnum -> prototype table for the proto managers.
+//
+// Two levels: a page directory indexed by vnum >> PAGE_BITS and pages of
+// 1 << PAGE_BITS pointers, allocated only where a vnum lives, so the usual
+// clustered vnum ranges cost a few pages. Vnums past MAX_PAGE_NUM pages go to
+// an overflow hash instead of growing the directory.
+//
+// Filled at boot/reload and read-only afterwards. Does not own the pointees.
+template <typename T, int PAGE_BITS = 10>
+class CVnumTable
+{
+	public:
+		enum
+		{
+			PAGE_SIZE		= 1 << PAGE_BITS,
+			PAGE_MASK		= PAGE_SIZE - 1,
+			MAX_PAGE_NUM	= 1 << 16,
+		};
+
+		CVnumTable()
+		{
+		}
+
+		~CVnumTable()
+		{
+			Clear();
+		}
+
+		void Clear()
+		{
+			for (size_t i = 0; i < m_vecPage.size(); ++i)
+				delete [] m_vecPage[i];
+
+			m_vecPage.clear();
+			m_map_overflow.clear();
+		}
+
+		void Set(DWORD dwVnum, T * p)
+		{
+			DWORD dwPage = dwVnum >> PAGE_BITS;
+
+			if (dwPage >= MAX_PAGE_NUM)
+			{
+				m_map_overflow[dwVnum] = p;
+				return;
+			}
+
+			if (dwPage >= m_vecPage.size())
+				m_vecPage.resize(dwPage + 1, NULL);
+
+			if (!m_vecPage[dwPage])
+			{
+				m_vecPage[dwPage] = new T * [PAGE_SIZE];
+				memset(m_vecPage[dwPage], 0, sizeof(T *) * PAGE_SIZE);
+			}
+
+			m_vecPage[dwPage][dwVnum & PAGE_MASK] = p;
+		}
+
+		// Maps [dwStart, dwStart + dwCount) to p without touching vnums already set.
+		void SetRange(DWORD dwStart, DWORD dwCount, T * p)
+		{
+			for (DWORD i = 0; i < dwCount; ++i)
+				if (!Get(dwStart + i))
+					Set(dwStart + i, p);
+		}
+
+		T * Get(DWORD dwVnum) const
+		{
+			DWORD dwPage = dwVnum >> PAGE_BITS;
+
+			if (dwPage < m_vecPage.size())
+			{
+				T ** ppPage = m_vecPage[dwPage];
+				return ppPage ? ppPage[dwVnum & PAGE_MASK] : NULL;
+			}
+
+			if (m_map_overflow.empty())
+				return NULL;
+
+			typename std::unordered_map<DWORD, T *>::const_iterator it = m_map_overflow.find(dwVnum);
+			return it != m_map_overflow.end() ? it->second : NULL;
+		}
+
+		size_t GetPageCount() const
+		{
+			size_t count = 0;
+
+			for (size_t i = 0; i < m_vecPage.size(); ++i)
+				if (m_vecPage[i])
+					++count;
+
+			return count;
+		}
+
+	protected:
+		std::vector<T **>					m_vecPage;
+		std::unordered_map<DWORD, T *>		m_map_overflow;
+
+	private:
+		CVnumTable(const CVnumTable &);
+		CVnumTable & operator = (const CVnumTable &);
+};
+
+#endif
@@ -6,25 +6,37 @@
 #include <algorithm>
 CGrid::CGrid(int w, int h) : m_iWidth(w), m_iHeight(h)
 {
-    m_pGrid = new char[m_iWidth * m_iHeight];
-    memset(m_pGrid, 0, sizeof(char) * m_iWidth * m_iHeight);
+    m_pRows = new unsigned int[m_iHeight];
+    memset(m_pRows, 0, sizeof(unsigned int) * m_iHeight);
 }
 
 CGrid::CGrid(CGrid * pkGrid, int w, int h) : m_iWidth(w), m_iHeight(h)
 {
-    m_pGrid = new char[m_iWidth * m_iHeight];
+    m_pRows = new unsigned int[m_iHeight];
+    memset(m_pRows, 0, sizeof(unsigned int) * m_iHeight);
+
+    // copy cell by cell so a different width keeps the linear cell order
     int iSize = std::min(w * h, pkGrid->m_iWidth * pkGrid->m_iHeight);
-    thecore_memcpy(m_pGrid, pkGrid->m_pGrid, sizeof(char) * iSize);
+
+    for (int i = 0; i < iSize; ++i)
+	if (pkGrid->m_pRows[i / pkGrid->m_iWidth] & (1u << (i % pkGrid->m_iWidth)))
+	    m_pRows[i / m_iWidth] |= 1u << (i % m_iWidth);
 }
 
 CGrid::~CGrid()
 {
-    delete [] m_pGrid;
+    delete [] m_pRows;
 }
 
 void CGrid::Clear()
 {
-    memset(m_pGrid, 0, sizeof(char) * m_iWidth * m_iHeight);
+    memset(m_pRows, 0, sizeof(unsigned int) * m_iHeight);
+}
+
+unsigned int CGrid::GetSpanMask(int iCol, int w) const
+{
+    unsigned int dwSpan = w >= 32 ? ~0u : ((1u << w) - 1);
+    return dwSpan << iCol;
 }
 
 int CGrid::FindBlank(int w, int h)
@@ -33,17 +45,24 @@ int CGrid::FindBlank(int w, int h)
     if (w > m_iWidth || h > m_iHeight)
 	return -1;
 
-    int iRow;
+    const unsigned int dwRowMask = GetSpanMask(0, m_iWidth);
 
-    for (iRow = 0; iRow < m_iHeight; ++iRow)
+    for (int iRow = 0; iRow + h <= m_iHeight; ++iRow)
     {
-	for (int iCol = 0; iCol < m_iWidth; ++iCol)
-	{
-	    int iIndex = iRow * m_iWidth + iCol;
+	unsigned int dwUsed = 0;
+
+	for (int y = 0; y < h; ++y)
+	    dwUsed |= m_pRows[iRow + y];
 
-	    if (IsEmpty(iIndex, w, h))
-		return iIndex;
-	}
+	unsigned int dwFree = ~dwUsed & dwRowMask;
+	unsigned int dwFit = dwFree;
+
+	// a column fits when the next w - 1 columns are free as well
+	for (int x = 1; x < w && dwFit; ++x)
+	    dwFit &= dwFree >> x;
+
+	if (dwFit)
+	    return iRow * m_iWidth + std::countr_zero(dwFit);
     }
 
     return -1;
@@ -54,15 +73,11 @@ bool CGrid::Put(int iPos, int w, int h)
     if (!IsEmpty(iPos, w, h))
 	return false;
 
-    for (int y = 0; y < h; ++y)
-    {
-	int iStart = iPos + (y * m_iWidth);
-	m_pGrid[iStart] = true;
+    int iRow = iPos / m_iWidth;
+    unsigned int dwSpan = GetSpanMask(iPos % m_iWidth, w);
 
-	int x = 1;
-	while (x < w)
-	    m_pGrid[iStart + x++] = true;
-    }
+    for (int y = 0; y < h; ++y)
+	m_pRows[iRow + y] |= dwSpan;
 
     return true;
 }
@@ -72,15 +87,11 @@ void CGrid::Get(int iPos, int w, int h)
     if (iPos < 0 || iPos >= m_iWidth * m_iHeight)
 	return;
 
-    for (int y = 0; y < h; ++y)
-    {
-	int iStart = iPos + (y * m_iWidth);
-	m_pGrid[iStart] = false;
+    int iRow = iPos / m_iWidth;
+    unsigned int dwSpan = GetSpanMask(iPos % m_iWidth, w);
 
-	int x = 1;
-	while (x < w)
-	    m_pGrid[iStart + x++] = false;
-    }
+    for (int y = 0; y < h && iRow + y < m_iHeight; ++y)
+	m_pRows[iRow + y] &= ~dwSpan;
 }
 
 bool CGrid::IsEmpty(int iPos, int w, int h)
@@ -97,19 +108,12 @@ bool CGrid::IsEmpty(int iPos, int w, int h)
     if (iPos + w > iRow * m_iWidth + m_iWidth)
 	return false;
 
-    for (int y = 0; y < h; ++y)
-    {
-	int iStart = iPos + (y * m_iWidth);
+    unsigned int dwSpan = GetSpanMask(iPos % m_iWidth, w);
 
-	if (m_pGrid[iStart])
+    for (int y = 0; y < h; ++y)
+	if (m_pRows[iRow + y] & dwSpan)
 	    return false;
 
-	int x = 1;
-	while (x < w)
-	    if (m_pGrid[iStart + x++])
-		return false;
-    }
-
     return true;
 }
 
@@ -120,7 +124,7 @@ void CGrid::Print()
     for (int y = 0; y < m_iHeight; ++y)
     {
 	for (int x = 0; x < m_iWidth; ++x)
-	    printf("%d", m_pGrid[y * m_iWidth + x]);
+	    printf("%d", (m_pRows[y] >> x) & 1);
 
 	printf("\n");
     }
@@ -130,4 +134,3 @@ unsigned int CGrid::GetSize()
 {
     return m_iWidth * m_iHeight;
 }
-
@@ -1,6 +1,36 @@
 ﻿#ifndef __INC_METIN_II_GRID_H__
 #define __INC_METIN_II_GRID_H__
 
+#include <bit>
+#include <type_traits>
+
+//
+// Bitboard helper for vertical items: bit i of occupied is cell i of a board
+// laid out row-major with iColumns cells per row. Returns the lowest cell
+// where an item iHeight cells tall fits without leaving the board, or -1.
+//
+template <typename T>
+inline int FindBlankColumnBits(T occupied, int iCells, int iColumns, int iHeight)
+{
+    typedef typename std::make_unsigned<T>::type U;
+
+    U board = iCells >= (int) (sizeof(U) * 8) ? (U) ~(U) 0 : (U) (((U) 1 << iCells) - 1);
+    U free = (U) ~(U) occupied & board;
+    U fit = free;
+
+    // cell c fits when c, c + columns, ... c + columns * (height - 1) are free;
+    // shifting in zeros from above also rejects items hanging off the board
+    for (int j = 1; j < iHeight && fit; ++j)
+	fit &= free >> (iColumns * j);
+
+    if (!fit)
+	return -1;
+
+    return std::countr_zero(fit);
+}
+
+// Occupancy grid kept as one bitmask per row (up to 32 columns), so FindBlank
+// and IsEmpty test a whole row span at once instead of cell by cell.
 class CGrid
 {
     public:
@@ -17,10 +47,12 @@ class CGrid
 	unsigned int	GetSize();
 
     protected:
+	unsigned int	GetSpanMask(int iCol, int w) const;
+
 	int	m_iWidth;
 	int	m_iHeight;
 
-	char *	m_pGrid;
+	unsigned int *	m_pRows;
 };
 
 #endif
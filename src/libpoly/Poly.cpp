@@ -32,7 +32,7 @@ double CPoly::my_frandom(double start, double end)
 
 CPoly::CPoly()
 	: iToken(0), iNumToken(0), iLookAhead(0), iErrorPos(0), ErrorOccur(true),
-	uiLookPos(0), STSize(0)
+	uiLookPos(0), STSize(0), m_bConstant(false), m_dConstant(0)
 {
     lSymbol.clear();
     lSymbol.reserve(50);
@@ -50,7 +50,307 @@ void CPoly::SetStr(const string & str)
     strData = str;
 }
 
+// Compiled-only opcodes: a binary operator fused with a right operand that is a
+// literal (dValue) or a variable (iSlot), which saves a push and a dispatch.
+enum
+{
+	OP_FUSED_BASE	= 100,
+	OP_PLU_NUM		= OP_FUSED_BASE,
+	OP_MIN_NUM,
+	OP_MUL_NUM,
+	OP_DIV_NUM,
+	OP_PLU_ID,
+	OP_MIN_ID,
+	OP_MUL_ID,
+};
+
+bool CPoly::apply(int iCode, double * save, int & iSp)
+{
+	double t;
+
+	switch (iCode)
+	{
+		case PLU:
+			iSp--;
+			save[iSp-1]+=save[iSp]; break;
+		case MIN:
+			iSp--;
+			save[iSp-1]-=save[iSp]; break;
+		case MUL:
+			iSp--;
+			save[iSp-1]*=save[iSp]; break;
+		case MOD:
+			iSp--;
+			if (save[iSp]==0) return false;
+			save[iSp-1]=fmod(save[iSp-1],save[iSp]); break;
+		case DIV:
+			iSp--;
+			if (save[iSp]==0) return false;
+			save[iSp-1]/=save[iSp]; break;
+		case POW:
+			iSp--;
+			save[iSp-1]=pow(save[iSp-1],save[iSp]); break;
+		case ROOT:
+			if (save[iSp-1]<0) return false;
+			save[iSp-1]=sqrt(save[iSp-1]); break;
+		case COS:
+			save[iSp-1]=cos(save[iSp-1]); break;
+		case SIN:
+			save[iSp-1]=sin(save[iSp-1]); break;
+		case SIGN:
+			if (save[iSp-1] == 0.0) save[iSp-1] = 0.0;
+			else if (save[iSp-1] < 0.0) save[iSp-1] = -1.0;
+			else save[iSp-1] = 1.0f;
+			break;
+		case TAN:
+			if (!(t=cos(save[iSp-1]))) return false;
+			save[iSp-1]=tan(save[iSp-1]); break;
+		case CSC:
+			if (!(t=sin(save[iSp-1]))) return false;
+			save[iSp-1]=1/t; break;
+		case SEC:
+			if (!(t=cos(save[iSp-1]))) return false;
+			save[iSp-1]=1/t; break;
+		case COT:
+			if (!(t=sin(save[iSp-1]))) return false;
+			save[iSp-1]=cos(save[iSp-1])/t; break;
+		case LN:
+			if (save[iSp-1]<=0) return false;
+			save[iSp-1]=log(save[iSp-1]); break;
+		case LOG10:
+			if (save[iSp-1]<=0) return false;
+			save[iSp-1]=log10(save[iSp-1]); break;
+		case LOG:
+			if (save[iSp-1]<=0) return false;
+			if (save[iSp-2]<=0 || save[iSp-2]==1) return false;
+			save[iSp-2]=log(save[iSp-1])/log(save[iSp-2]);
+			iSp--;
+			break;
+		case ABS:	save[iSp-1]=fabs(save[iSp-1]); break;
+		case FLOOR:	save[iSp-1]=floor(save[iSp-1]); break;
+		case MINF:
+			save[iSp-2]=(save[iSp-2]<save[iSp-1])?save[iSp-2]:save[iSp-1];
+			iSp--;
+			break;
+		case MAXF:
+			save[iSp-2]=(save[iSp-2]>save[iSp-1])?save[iSp-2]:save[iSp-1];
+			iSp--;
+			break;
+		default:
+			return false;
+	}
+
+	return true;
+}
+
 double CPoly::Eval()
+{
+	if (ErrorOccur)
+		return 0;
+
+	if (m_bConstant)
+		return m_dConstant;
+
+	if (m_vecCode.empty())
+		return Interpret();
+
+	double save[MAXSTACK];
+	int iSp = 0;
+
+	const double * pValue = m_vecValue.empty() ? NULL : &m_vecValue[0];
+	const TOp * pOp = &m_vecCode[0];
+	const TOp * pEnd = pOp + m_vecCode.size();
+
+	for (; pOp != pEnd; ++pOp)
+	{
+		switch (pOp->iCode)
+		{
+			case NUM:
+				save[iSp++] = pOp->dValue;
+				break;
+			case ID:
+				save[iSp++] = pValue[pOp->iSlot];
+				break;
+			case PLU:
+				iSp--;
+				save[iSp-1] += save[iSp];
+				break;
+			case MIN:
+				iSp--;
+				save[iSp-1] -= save[iSp];
+				break;
+			case MUL:
+				iSp--;
+				save[iSp-1] *= save[iSp];
+				break;
+			case OP_PLU_NUM:	save[iSp-1] += pOp->dValue; break;
+			case OP_MIN_NUM:	save[iSp-1] -= pOp->dValue; break;
+			case OP_MUL_NUM:	save[iSp-1] *= pOp->dValue; break;
+			case OP_DIV_NUM:	save[iSp-1] /= pOp->dValue; break;
+			case OP_PLU_ID:		save[iSp-1] += pValue[pOp->iSlot]; break;
+			case OP_MIN_ID:		save[iSp-1] -= pValue[pOp->iSlot]; break;
+			case OP_MUL_ID:		save[iSp-1] *= pValue[pOp->iSlot]; break;
+			case IRAND:
+				save[iSp-2] = my_irandom(save[iSp-2], save[iSp-1]);
+				iSp--;
+				break;
+			case FRAND:
+				save[iSp-2] = my_frandom(save[iSp-2], save[iSp-1]);
+				iSp--;
+				break;
+			default:
+				if (!apply(pOp->iCode, save, iSp))
+					return 0;
+		}
+	}
+
+	return save[iSp-1];
+}
+
+//
+// Turns the token stream into a flat program: literals and slot indices are
+// stored inline, any subexpression without variables or random calls is
+// folded into a single literal, and + - * / take a literal or variable right
+// operand directly. Folding keeps the random() call order of
+// Interpret(), and an expression that would fail at runtime (e.g. a division
+// by a literal zero) is left unfolded so Eval() still returns 0 for it.
+//
+void CPoly::compile()
+{
+	m_vecCode.clear();
+	m_bConstant = false;
+
+	// Per stack entry: whether it is a single NUM op / a single ID op
+	std::vector<bool> vecConst;
+	std::vector<bool> vecVar;
+	vector<int>::iterator pos = tokenBase.begin();
+	vector<double>::iterator posn = numBase.begin();
+
+	while (pos != tokenBase.end())
+	{
+		TOp op;
+		op.iCode = *pos++;
+		op.iSlot = 0;
+		op.dValue = 0;
+
+		int iArgs = 0;
+
+		switch (op.iCode)
+		{
+			case NUM:
+				op.dValue = *posn++;
+				m_vecCode.push_back(op);
+				vecConst.push_back(true);
+				vecVar.push_back(false);
+				break;
+
+			case ID:
+				op.iSlot = *pos++;
+				m_vecCode.push_back(op);
+				vecConst.push_back(false);
+				vecVar.push_back(true);
+				break;
+
+			case PLU: case MIN: case MUL: case DIV: case MOD: case POW:
+			case LOG: case MINF: case MAXF: case IRAND: case FRAND:
+				iArgs = 2;
+				break;
+
+			default:
+				iArgs = 1;
+				break;
+		}
+
+		if (vecConst.size() > MAXSTACK || (int) vecConst.size() < iArgs)
+		{
+			// Malformed but accepted by the parser; leave it to Interpret() as before.
+			m_vecCode.clear();
+			return;
+		}
+
+		if (!iArgs)
+			continue;
+
+		bool bFold = op.iCode != IRAND && op.iCode != FRAND;
+
+		for (int i = 0; i < iArgs && bFold; ++i)
+			bFold = vecConst[vecConst.size() - 1 - i];
+
+		if (bFold)
+		{
+			double save[2];
+			int iSp = iArgs;
+
+			for (int i = 0; i < iArgs; ++i)
+				save[i] = m_vecCode[m_vecCode.size() - iArgs + i].dValue;
+
+			if (apply(op.iCode, save, iSp))
+			{
+				m_vecCode.resize(m_vecCode.size() - iArgs);
+				vecConst.resize(vecConst.size() - iArgs);
+				vecVar.resize(vecVar.size() - iArgs);
+
+				op.iCode = NUM;
+				op.dValue = save[0];
+				m_vecCode.push_back(op);
+				vecConst.push_back(true);
+				vecVar.push_back(false);
+				continue;
+			}
+		}
+
+		if (iArgs == 2 && (vecConst.back() || vecVar.back()))
+		{
+			const TOp & rRight = m_vecCode.back();
+			int iFused = -1;
+
+			switch (op.iCode)
+			{
+				case PLU: iFused = rRight.iCode == NUM ? OP_PLU_NUM : OP_PLU_ID; break;
+				case MIN: iFused = rRight.iCode == NUM ? OP_MIN_NUM : OP_MIN_ID; break;
+				case MUL: iFused = rRight.iCode == NUM ? OP_MUL_NUM : OP_MUL_ID; break;
+				case DIV:
+					// a variable or zero divisor keeps the runtime check of DIV
+					if (rRight.iCode == NUM && rRight.dValue != 0)
+						iFused = OP_DIV_NUM;
+					break;
+			}
+
+			if (iFused != -1)
+			{
+				op.iCode = iFused;
+				op.iSlot = rRight.iSlot;
+				op.dValue = rRight.dValue;
+				m_vecCode.back() = op;
+				vecConst.resize(vecConst.size() - 1);
+				vecVar.resize(vecVar.size() - 1);
+				vecConst.back() = false;
+				vecVar.back() = false;
+				continue;
+			}
+		}
+
+		m_vecCode.push_back(op);
+		vecConst.resize(vecConst.size() - iArgs);
+		vecVar.resize(vecVar.size() - iArgs);
+		vecConst.push_back(false);
+		vecVar.push_back(false);
+	}
+
+	if (vecConst.size() != 1)
+	{
+		m_vecCode.clear();
+		return;
+	}
+
+	if (vecConst[0])
+	{
+		m_bConstant = true;
+		m_dConstant = m_vecCode[0].dValue;
+	}
+}
+
+double CPoly::Interpret()
 {
 	int stNow;
 	double save[MAXSTACK],t;
@@ -77,7 +377,7 @@ double CPoly::Eval()
 				save[iSp++]=*posn++; break;
 			case ID:
 				save[iSp++]=
-					lSymbol[ *pos ]->dVal; 
+					m_vecValue[ *pos ]; 
 				pos++;
 				break;
 				//case '+':
@@ -238,6 +538,9 @@ int CPoly::Analyze(const char * pszStr)
 	return false;
     }
 
+    if (!ErrorOccur)
+	compile();
+
     return !ErrorOccur;
 }
 
@@ -258,6 +561,10 @@ void CPoly::Clear()
     lSymbol.clear();
     SymbolIndex.clear();
     STSize=0;
+
+    m_vecCode.clear();
+    m_vecValue.clear();
+    m_bConstant=false;
 }
 
 void CPoly::expr() 
@@ -540,6 +847,7 @@ int CPoly::insert(const string & s, int tok)
 	//transform(s.begin(),s.end(),s.begin(),std::tolower);
 	//lSymbol.SetAtGrow(STSize,new CSymTable(tok,s));
 	lSymbol.push_back(new CSymTable(tok,s));
+	m_vecValue.push_back(0.0);
 	for (i=0;i<STSize;i++)
 	{
 		if (s<lSymbol[SymbolIndex[i]]->strlex)
@@ -564,11 +872,18 @@ int CPoly::SetVar(const string & strName, double dVar)
     if (ErrorOccur) return false;
     int index = find(strName);
     if (index == -1) return false;
-    CSymTable * stVar = lSymbol[(/*FindIndex*/(index))];
-    stVar->dVal = dVar;
+    m_vecValue[index] = dVar;
     return true;
 }
 
+int CPoly::GetVarIndex(const std::string & strName)
+{
+    if (ErrorOccur) return -1;
+    int index = find(strName);
+    if (index == -1 || lSymbol[index]->token != ID) return -1;
+    return index;
+}
+
 double CPoly::GetVar(const std::string & strName)
 {
     if (ErrorOccur) return false;
@@ -577,7 +892,7 @@ double CPoly::GetVar(const std::string & strName)
     CSymTable * stVar = lSymbol[(/*FindIndex*/(index))];
 	if(!stVar)
 		return -1;
-	return stVar->dVal;
+	return m_vecValue[index];
 }
 
 void CPoly::init()
@@ -15,15 +15,37 @@ class CPoly
 
 		int	Analyze(const char * pszStr = NULL);
 		double	Eval();
+		double	Interpret();
 		void	SetStr(const std::string & str);
 		int	SetVar(const std::string & strName, double dVar);
 		double GetVar(const std::string & strName);
 		void	Clear();
 
+		// Slot of a variable for SetVar(int, double), -1 if the formula does not use it.
+		// Valid until the next Analyze()/Clear().
+		int	GetVarIndex(const std::string & strName);
+
+		void	SetVar(int iIndex, double dVar)
+		{
+		    if (iIndex >= 0)
+			m_vecValue[iIndex] = dVar;
+		}
+
 	protected:
+		typedef struct SOp
+		{
+		    int		iCode;
+		    int		iSlot;		// ID: index into m_vecValue
+		    double	dValue;		// NUM: literal
+		} TOp;
+
+		static bool	apply(int iCode, double * save, int & iSp);
+
 		int		my_irandom(double start, double end);
 		double		my_frandom(double start, double end);
 
+		void		compile();
+
 		void		init();
 		int		insert(const std::string & s, int tok);
 		int		find(const std::string & s);
@@ -51,6 +73,13 @@ class CPoly
 		int				STSize;
 		std::string			strData;
 
+		// Analyze() output compiled to a flat program with folded constants.
+		// Variable values live in m_vecValue, indexed like lSymbol.
+		std::vector<TOp>		m_vecCode;
+		std::vector<double>		m_vecValue;
+		bool				m_bConstant;
+		double				m_dConstant;
+
 };
 
 #endif 
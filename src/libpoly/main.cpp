@@ -7,15 +7,77 @@
 
 #include "Poly.h"
 
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <unistd.h>
 
 using namespace std;
 
+// poly bench "<formula>" [iterations]
+// Times the compiled Eval() against the token Interpret() with a skill-like variable set.
+static int bench(const char * c_pszFormula, int iCount)
+{
+    static const char * s_aszVar[] = { "k", "lv", "atk", "ar", "iq", "str", "dex", "con", "def", "maxhp" };
+    const int iVarCount = sizeof(s_aszVar) / sizeof(s_aszVar[0]);
+
+    CPoly p;
+
+    if (!p.Analyze(c_pszFormula))
+    {
+	cout << "Analyze failed" << endl;
+	return 1;
+    }
+
+    int aiSlot[iVarCount];
+
+    for (int i = 0; i < iVarCount; ++i)
+	aiSlot[i] = p.GetVarIndex(s_aszVar[i]);
+
+    double dSumInterpret = 0, dSumEval = 0;
+    chrono::steady_clock::time_point t0, t1;
+
+    srandom(1);
+    t0 = chrono::steady_clock::now();
+
+    for (int n = 0; n < iCount; ++n)
+    {
+	for (int i = 0; i < iVarCount; ++i)
+	    p.SetVar(aiSlot[i], (n + i) & 63);
+
+	dSumInterpret += p.Interpret();
+    }
+
+    t1 = chrono::steady_clock::now();
+    double dInterpretNs = chrono::duration<double, nano>(t1 - t0).count() / iCount;
+
+    srandom(1);
+    t0 = chrono::steady_clock::now();
+
+    for (int n = 0; n < iCount; ++n)
+    {
+	for (int i = 0; i < iVarCount; ++i)
+	    p.SetVar(aiSlot[i], (n + i) & 63);
+
+	dSumEval += p.Eval();
+    }
+
+    t1 = chrono::steady_clock::now();
+    double dEvalNs = chrono::duration<double, nano>(t1 - t0).count() / iCount;
+
+    printf("interpret %.1f ns/eval, compiled %.1f ns/eval, %s\n",
+	    dInterpretNs, dEvalNs, dSumInterpret == dSumEval ? "results match" : "RESULTS DIFFER");
+
+    return dSumInterpret == dSumEval ? 0 : 1;
+}
+
 int main(int argc, char ** argv)
 {
+    if (argc >= 3 && !strcmp(argv[1], "bench"))
+	return bench(argv[2], argc >= 4 ? atoi(argv[3]) : 1000000);
+
 	printf( "12345\n" );
 
 #ifndef OS_WINDOWS
@@ -11,7 +11,7 @@
 CAsyncSQL::CAsyncSQL()
 	: m_stHost(""), m_stUser(""), m_stPassword(""), m_stDB(""), m_stLocale(""),
 	m_iPort(0), m_thread(nullptr), m_bEnd(false), m_bConnected(false),
-	m_iMsgCount(0), m_iQueryFinished(0), m_iCopiedQuery(0), m_ulThreadID(0)
+	m_iMsgCount(0), m_iQueryFinished(0), m_iCopiedQuery(0), m_ulThreadID(0), m_iInjectedLatency(0)
 {
 	memset(&m_hDB, 0, sizeof(m_hDB));
 }
@@ -148,6 +148,14 @@ void CAsyncSQL::Quit()
 	}
 }
 
+void CAsyncSQL::InjectLatency() const
+{
+	int iMs = m_iInjectedLatency.load(std::memory_order_acquire);
+
+	if (iMs > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(iMs));
+}
+
 std::unique_ptr<SQLMsg> CAsyncSQL::DirectQuery(const char* c_pszQuery)
 {
 	unsigned long currentThreadID = mysql_thread_id(&m_hDB);
@@ -163,6 +171,8 @@ std::unique_ptr<SQLMsg> CAsyncSQL::DirectQuery(const char* c_pszQuery)
 	p->iID = m_iMsgCount.fetch_add(1, std::memory_order_acq_rel) + 1;
 	p->stQuery = c_pszQuery;
 
+	InjectLatency();
+
 	if (mysql_real_query(&m_hDB, p->stQuery.c_str(), p->stQuery.length()))
 	{
 		char buf[1024];
@@ -409,6 +419,8 @@ void CAsyncSQL::ChildLoop()
 				m_ulThreadID.store(currentThreadID, std::memory_order_release);
 			}
 
+			InjectLatency();
+
 			if (mysql_real_query(&m_hDB, p->stQuery.c_str(), p->stQuery.length()))
 			{
 				p->uiSQLErrno = mysql_errno(&m_hDB);
@@ -167,6 +167,10 @@ class CAsyncSQL
 
 		bool Connect();
 		bool IsConnected() const { return m_bConnected.load(std::memory_order_acquire); }
+
+		// Test aid: every query on this connection waits iMs before it reaches
+		// the server, to see how callers behave against a slow SQL server.
+		void SetInjectedLatency(int iMs) { m_iInjectedLatency.store(iMs, std::memory_order_release); }
 		bool QueryLocaleSet();
 
 		void AsyncQuery(const char* c_pszQuery);
@@ -236,6 +240,9 @@ class CAsyncSQL
 		std::atomic<int> m_iQueryFinished;
 		std::atomic<int> m_iCopiedQuery;
 		std::atomic<unsigned long> m_ulThreadID;
+		std::atomic<int> m_iInjectedLatency;
+
+		void InjectLatency() const;
 };
 
 class CAsyncSQL2 : public CAsyncSQL
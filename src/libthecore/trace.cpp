@@ -0,0 +1,171 @@
+﻿#include "stdafx.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef struct STraceEvent
+{
+	const char *	c_pszName;
+	uint64_t		qwBeginNs;
+	uint64_t		qwEndNs;
+	uint64_t		qwArg;
+} TTraceEvent;
+
+// Written only by its owning thread; trace_dump() reads it from another.
+typedef struct STraceRing
+{
+	std::atomic<uint64_t>	qwHead;
+	DWORD					dwTid;
+	TTraceEvent				aEvent[TRACE_RING_SIZE];
+} TTraceRing;
+
+// Rings live until exit, so a dump still sees threads that have finished.
+static std::mutex					s_lockRing;
+static std::vector<TTraceRing *>	s_vecRing;
+static thread_local TTraceRing *	s_pRing = NULL;
+
+static int			s_iSpikeMs = 0;
+static int			s_iWindowSec = 3;
+static std::string	s_stDir = "trace";
+static time_t		s_tLastDump = 0;
+
+static TTraceRing * trace_ring_new()
+{
+	TTraceRing * pRing = new TTraceRing;
+	pRing->qwHead.store(0, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(s_lockRing);
+	s_vecRing.push_back(pRing);
+	pRing->dwTid = s_vecRing.size();
+	return pRing;
+}
+
+uint64_t trace_clock_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void trace_record(const char * c_pszName, uint64_t qwBeginNs, uint64_t qwEndNs, uint64_t qwArg)
+{
+	if (!s_pRing)
+		s_pRing = trace_ring_new();
+
+	uint64_t qwHead = s_pRing->qwHead.load(std::memory_order_relaxed);
+	TTraceEvent & r = s_pRing->aEvent[qwHead & (TRACE_RING_SIZE - 1)];
+
+	r.c_pszName	= c_pszName;
+	r.qwBeginNs	= qwBeginNs;
+	r.qwEndNs	= qwEndNs;
+	r.qwArg		= qwArg;
+
+	s_pRing->qwHead.store(qwHead + 1, std::memory_order_release);
+}
+
+bool trace_dump(const char * c_pszFileName, int iWindowSec)
+{
+	std::vector<TTraceRing *> vecRing;
+
+	{
+		std::lock_guard<std::mutex> lock(s_lockRing);
+		vecRing = s_vecRing;
+	}
+
+	FILE * fp = fopen(c_pszFileName, "w");
+
+	if (!fp)
+		return false;
+
+	uint64_t qwSinceNs = trace_clock_ns() - (uint64_t) iWindowSec * 1000000000ULL;
+	int pid = getpid();
+	std::vector<TTraceEvent> vecEvent;
+	bool bFirst = true;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	for (size_t i = 0; i < vecRing.size(); ++i)
+	{
+		TTraceRing * pRing = vecRing[i];
+
+		// Copy first, then drop whatever the owner may have overwritten meanwhile.
+		uint64_t qwHead = pRing->qwHead.load(std::memory_order_acquire);
+		uint64_t qwTail = qwHead > TRACE_RING_SIZE ? qwHead - TRACE_RING_SIZE : 0;
+
+		vecEvent.clear();
+		vecEvent.reserve(qwHead - qwTail);
+
+		for (uint64_t j = qwTail; j < qwHead; ++j)
+			vecEvent.push_back(pRing->aEvent[j & (TRACE_RING_SIZE - 1)]);
+
+		uint64_t qwHeadAfter = pRing->qwHead.load(std::memory_order_acquire);
+		size_t skip = 0;
+
+		if (qwHeadAfter - qwTail > TRACE_RING_SIZE)
+			skip = std::min<uint64_t>(vecEvent.size(), qwHeadAfter - qwTail - TRACE_RING_SIZE);
+
+		fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+				bFirst ? "" : ",", pid, pRing->dwTid, pRing->dwTid);
+		bFirst = false;
+
+		for (size_t j = skip; j < vecEvent.size(); ++j)
+		{
+			const TTraceEvent & c_r = vecEvent[j];
+
+			if (c_r.qwEndNs < qwSinceNs)
+				continue;
+
+			fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"arg\":%llu}}",
+					c_r.c_pszName, pid, pRing->dwTid,
+					c_r.qwBeginNs / 1000.0, (c_r.qwEndNs - c_r.qwBeginNs) / 1000.0,
+					(unsigned long long) c_r.qwArg);
+		}
+	}
+
+	fprintf(fp, "\n]}\n");
+	return fclose(fp) == 0;
+}
+
+void trace_set_trigger(int iSpikeMs, int iWindowSec, const char * c_pszDir)
+{
+	s_iSpikeMs = MAX(0, iSpikeMs);
+	s_iWindowSec = MAX(1, iWindowSec);
+
+	if (c_pszDir && *c_pszDir)
+		s_stDir = c_pszDir;
+}
+
+void trace_pulse_end(uint64_t qwPulseNs)
+{
+	if (!s_iSpikeMs || qwPulseNs < (uint64_t) s_iSpikeMs * 1000000ULL)
+		return;
+
+	// Writing the dump stalls the loop itself; the interval keeps one spike
+	// from triggering the next.
+	time_t now = time(0);
+
+	if (now - s_tLastDump < TRACE_MIN_INTERVAL)
+		return;
+
+	s_tLastDump = now;
+
+	std::error_code ec;
+	std::filesystem::create_directories(s_stDir, ec);
+
+	struct tm tm;
+	localtime_r(&now, &tm);
+
+	char szFileName[PATH_MAX];
+	snprintf(szFileName, sizeof(szFileName), "%s/trace_%04d%02d%02d_%02d%02d%02d.json",
+			s_stDir.c_str(), tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+
+	if (trace_dump(szFileName, s_iWindowSec))
+		sys_log(0, "TRACE: pulse took %llu ms (limit %d ms), dumped last %d sec to %s",
+				(unsigned long long) (qwPulseNs / 1000000), s_iSpikeMs, s_iWindowSec, szFileName);
+	else
+		sys_err("TRACE: cannot write %s", szFileName);
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <stdint.h>
+
+#include "common/service.h"
+
+//
+// Scoped tracing into per-thread ring buffers.
+//
+// M2_TRACE_SCOPE("name") records the begin/end time of the enclosing scope.
+// Only the name pointer is stored, so it must stay valid until exit (string
+// literals or static tables); recording is two clock reads and a few stores,
+// with no lookup or allocation.
+//
+// Each thread keeps its last TRACE_RING_SIZE scopes. trace_pulse_end() is fed
+// the length of every main loop pulse and, when one exceeds the configured
+// threshold, dumps the last few seconds of every thread as Chrome trace-event
+// JSON (load in chrome://tracing or ui.perfetto.dev).
+//
+// Without ENABLE_SCOPED_TRACE the macros compile to nothing, so the servers
+// only reach the functions below through them.
+//
+enum
+{
+	TRACE_RING_SIZE		= 1 << 16,
+	TRACE_MIN_INTERVAL	= 30,	// seconds between two dumps
+};
+
+uint64_t	trace_clock_ns();
+void		trace_record(const char * c_pszName, uint64_t qwBeginNs, uint64_t qwEndNs, uint64_t qwArg);
+
+// iSpikeMs 0 disables the trigger.
+void		trace_set_trigger(int iSpikeMs, int iWindowSec, const char * c_pszDir);
+void		trace_pulse_end(uint64_t qwPulseNs);
+
+// Writes the scopes that ended within the last iWindowSec seconds. Returns false on I/O error.
+bool		trace_dump(const char * c_pszFileName, int iWindowSec);
+
+class CTraceScope
+{
+	public:
+		CTraceScope(const char * c_pszName, uint64_t qwArg = 0) : m_c_pszName(c_pszName), m_qwArg(qwArg), m_qwBeginNs(trace_clock_ns())
+		{
+		}
+
+		~CTraceScope()
+		{
+			trace_record(m_c_pszName, m_qwBeginNs, trace_clock_ns(), m_qwArg);
+		}
+
+	private:
+		const char *	m_c_pszName;
+		uint64_t		m_qwArg;
+		uint64_t		m_qwBeginNs;
+
+		CTraceScope(const CTraceScope &);
+		CTraceScope & operator = (const CTraceScope &);
+};
+
+#ifdef ENABLE_SCOPED_TRACE
+#define M2_TRACE_CONCAT2(a, b)			a##b
+#define M2_TRACE_CONCAT(a, b)			M2_TRACE_CONCAT2(a, b)
+#define M2_TRACE_SCOPE(name)			CTraceScope M2_TRACE_CONCAT(__trace_scope_, __LINE__)(name)
+#define M2_TRACE_SCOPE_ARG(name, arg)	CTraceScope M2_TRACE_CONCAT(__trace_scope_, __LINE__)(name, (uint64_t) (arg))
+// Records one main loop pulse [begin_ns, end_ns) as a scope and feeds its length to trace_pulse_end().
+#define M2_TRACE_PULSE(name, begin_ns, end_ns, arg) \
+	do { uint64_t __trace_end_ns = (end_ns); trace_record(name, begin_ns, __trace_end_ns, (uint64_t) (arg)); trace_pulse_end(__trace_end_ns - (begin_ns)); } while (0)
+#define M2_TRACE_SET_TRIGGER(spike_ms, window_sec, dir)	trace_set_trigger(spike_ms, window_sec, dir)
+#else
+#define M2_TRACE_SCOPE(name)			((void) 0)
+#define M2_TRACE_SCOPE_ARG(name, arg)	((void) 0)
+#define M2_TRACE_PULSE(name, begin_ns, end_ns, arg)		((void) 0)
+#define M2_TRACE_SET_TRIGGER(spike_ms, window_sec, dir)	((void) 0)
+#endif
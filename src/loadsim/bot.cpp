@@ -0,0 +1,689 @@
+﻿#include "stdafx.h"
+#include <chrono>
+
+#include <netdb.h>
+#include <netinet/tcp.h>
+
+#include "bot.h"
+#include "gc_packet.h"
+
+// must match SEQUENCE_SEED in game/desc.h
+static const uint64_t LOADSIM_SEQUENCE_SEED = 0;
+
+TLoadSimStats g_kStats;
+
+uint64_t loadsim_time_us()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t random_us(uint64_t qwMinMs, uint64_t qwMaxMs)
+{
+	return (qwMinMs + rand() % (qwMaxMs - qwMinMs + 1)) * 1000;
+}
+
+CBot::CBot(int iIndex, const std::string & c_rstLogin, const TLoadSimConfig * c_pConfig)
+	: m_iIndex(iIndex), m_stLogin(c_rstLogin), m_pConfig(c_pConfig),
+	m_eState(STATE_IDLE), m_iSocket(-1),
+	m_dwLoginKey(0), m_bHasCharacter(false), m_qwStartUs(0),
+	m_dwServerTimeBase(0), m_qwServerTimeBaseUs(0),
+	m_dwVID(0), m_lX(0), m_lY(0), m_lHomeX(0), m_lHomeY(0),
+	m_dwChatProbe(0), m_qwNextMoveUs(0), m_qwNextAttackUs(0), m_qwNextChatUs(0), m_qwNextTradeUs(0),
+	m_qwExchangeAcceptUs(0), m_qwExchangeCancelUs(0), m_qwRestartUs(0), m_pkPartner(NULL),
+	m_pReplay(NULL), m_iReplayPos(0), m_qwReplayStartUs(0)
+{
+	for (int i = 0; i < 4; ++i)
+		m_adwClientKey[i] = (DWORD) rand();
+}
+
+CBot::~CBot()
+{
+	Disconnect();
+}
+
+bool CBot::Start()
+{
+	m_qwStartUs = loadsim_time_us();
+
+	if (!Connect(m_pConfig->stAuthHost, m_pConfig->wAuthPort))
+	{
+		Close(true);
+		return false;
+	}
+
+	m_eState = STATE_AUTH;
+	return true;
+}
+
+void CBot::Close(bool bError)
+{
+	if (bError)
+	{
+		if (m_eState == STATE_GAME)
+			++g_kStats.iDisconnected;
+		else if (m_eState != STATE_CLOSED)
+			++g_kStats.iLoginFailed;
+	}
+
+	Disconnect();
+	m_eState = STATE_CLOSED;
+}
+
+bool CBot::Connect(const std::string & c_rstHost, WORD wPort)
+{
+	Disconnect();
+
+	struct addrinfo hints, * pResult = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	char szPort[16];
+	snprintf(szPort, sizeof(szPort), "%u", wPort);
+
+	if (getaddrinfo(c_rstHost.c_str(), szPort, &hints, &pResult) != 0 || !pResult)
+	{
+		fprintf(stderr, "%s: cannot resolve %s\n", m_stLogin.c_str(), c_rstHost.c_str());
+		return false;
+	}
+
+	m_iSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+	// blocking connect; the login ramp keeps this cheap against a local core
+	bool bConnected = m_iSocket >= 0 && connect(m_iSocket, pResult->ai_addr, pResult->ai_addrlen) == 0;
+	freeaddrinfo(pResult);
+
+	if (!bConnected)
+	{
+		fprintf(stderr, "%s: connect to %s:%u failed: %s\n", m_stLogin.c_str(), c_rstHost.c_str(), wPort, strerror(errno));
+		return false;
+	}
+
+	int iFlag = 1;
+	setsockopt(m_iSocket, IPPROTO_TCP, TCP_NODELAY, &iFlag, sizeof(iFlag));
+	fcntl(m_iSocket, F_SETFL, fcntl(m_iSocket, F_GETFL, 0) | O_NONBLOCK);
+
+	// every connection is a fresh DESC on the server side
+	m_cipher.CleanUp();
+	m_kSequence.seed(LOADSIM_SEQUENCE_SEED);
+	m_stOutput.clear();
+	m_vecInput.clear();
+	return true;
+}
+
+void CBot::Disconnect()
+{
+	if (m_iSocket >= 0)
+	{
+		close(m_iSocket);
+		m_iSocket = -1;
+	}
+}
+
+void CBot::Send(const void * c_pvData, int iSize, bool bSequence)
+{
+	size_t iStart = m_stOutput.size();
+
+	m_stOutput.append((const char *) c_pvData, iSize);
+
+	if (bSequence)
+		m_stOutput.push_back((char) m_kSequence(UINT8_MAX + 1));
+
+	if (m_cipher.activated())
+		m_cipher.Encrypt(&m_stOutput[iStart], m_stOutput.size() - iStart);
+
+	++g_kStats.qwPacketsSent;
+	g_kStats.qwBytesSent += m_stOutput.size() - iStart;
+}
+
+void CBot::OnWritable()
+{
+	if (m_iSocket < 0 || m_stOutput.empty())
+		return;
+
+	ssize_t iSent = send(m_iSocket, m_stOutput.data(), m_stOutput.size(), MSG_NOSIGNAL);
+
+	if (iSent < 0)
+	{
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			Close(true);
+
+		return;
+	}
+
+	m_stOutput.erase(0, iSent);
+}
+
+void CBot::OnReadable()
+{
+	char buf[16384];
+
+	while (m_iSocket >= 0)
+	{
+		ssize_t iRead = recv(m_iSocket, buf, sizeof(buf), 0);
+
+		if (iRead == 0)
+		{
+			Close(true);
+			return;
+		}
+
+		if (iRead < 0)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				Close(true);
+
+			break;
+		}
+
+		// bytes that arrive before KEY_AGREEMENT_COMPLETED are plain
+		if (m_cipher.activated())
+			m_cipher.Decrypt(buf, iRead);
+
+		m_vecInput.insert(m_vecInput.end(), buf, buf + iRead);
+		g_kStats.qwBytesRecv += iRead;
+	}
+
+	ProcessInput();
+}
+
+void CBot::ProcessInput()
+{
+	size_t iPos = 0;
+
+	while (m_iSocket >= 0 && iPos < m_vecInput.size())
+	{
+		const char * c_pData = &m_vecInput[iPos];
+		int iSize = GCPacketGetSize(c_pData, m_vecInput.size() - iPos);
+
+		if (iSize == 0)
+			break;
+
+		if (iSize < 0)
+		{
+			fprintf(stderr, "%s: cannot frame header %u, dropping connection\n", m_stLogin.c_str(), (BYTE) *c_pData);
+			++g_kStats.iFramingErrors;
+			Close(true);
+			return;
+		}
+
+		++g_kStats.qwPacketsRecv;
+		iPos += iSize;
+
+#ifdef _IMPROVED_PACKET_ENCRYPTION_
+		if ((BYTE) *c_pData == HEADER_GC_KEY_AGREEMENT_COMPLETED)
+		{
+			// the rest of what we already have was sent encrypted
+			m_cipher.set_activated(true);
+
+			if (iPos < m_vecInput.size())
+				m_cipher.Decrypt(&m_vecInput[iPos], m_vecInput.size() - iPos);
+
+			continue;
+		}
+#endif
+
+		if (!HandlePacket(c_pData, iSize))
+			return;	// reconnected or closed; the buffer belongs to the new connection
+	}
+
+	if (iPos > 0 && iPos <= m_vecInput.size())
+		m_vecInput.erase(m_vecInput.begin(), m_vecInput.begin() + iPos);
+}
+
+DWORD CBot::GetServerTime() const
+{
+	return m_dwServerTimeBase + (DWORD) ((loadsim_time_us() - m_qwServerTimeBaseUs) / 1000);
+}
+
+bool CBot::HandlePacket(const char * c_pData, int iSize)
+{
+	switch ((BYTE) *c_pData)
+	{
+		case HEADER_GC_HANDSHAKE:
+			{
+				const TPacketGCHandshake * p = (const TPacketGCHandshake *) c_pData;
+
+				m_dwServerTimeBase = p->dwTime + p->lDelta;
+				m_qwServerTimeBaseUs = loadsim_time_us();
+
+				TPacketCGHandshake pack;
+				pack.bHeader		= HEADER_CG_HANDSHAKE;
+				pack.dwHandshake	= p->dwHandshake;
+				pack.dwTime			= m_dwServerTimeBase;
+				pack.lDelta			= p->lDelta;
+				Send(&pack, sizeof(pack), false);
+			}
+			break;
+
+#ifdef _IMPROVED_PACKET_ENCRYPTION_
+		case HEADER_GC_KEY_AGREEMENT:
+			{
+				const TPacketKeyAgreement * p = (const TPacketKeyAgreement *) c_pData;
+
+				TPacketKeyAgreement pack;
+				size_t data_length = TPacketKeyAgreement::MAX_DATA_LEN;
+				size_t agreed_length = m_cipher.Prepare(pack.data, &data_length);
+
+				if (agreed_length == 0 || !m_cipher.Activate(true, p->wAgreedLength, p->data, p->wDataLength))
+				{
+					fprintf(stderr, "%s: key agreement failed\n", m_stLogin.c_str());
+					Close(true);
+					return false;
+				}
+
+				// keys are ready but the server switches only after KEY_AGREEMENT_COMPLETED
+				m_cipher.set_activated(false);
+
+				pack.bHeader		= HEADER_CG_KEY_AGREEMENT;
+				pack.wAgreedLength	= (WORD) agreed_length;
+				pack.wDataLength	= (WORD) data_length;
+				Send(&pack, sizeof(pack), false);
+			}
+			break;
+#endif
+
+		case HEADER_GC_PHASE:
+			OnPhase(((const TPacketGCPhase *) c_pData)->phase);
+			return m_iSocket >= 0;
+
+		case HEADER_GC_AUTH_SUCCESS:
+			{
+				const TPacketGCAuthSuccess * p = (const TPacketGCAuthSuccess *) c_pData;
+
+				if (!p->bResult)
+				{
+					fprintf(stderr, "%s: auth failed\n", m_stLogin.c_str());
+					Close(true);
+					return false;
+				}
+
+				m_dwLoginKey = p->dwLoginKey;
+
+				if (!Connect(m_pConfig->stGameHost, m_pConfig->wGamePort))
+				{
+					Close(true);
+					return false;
+				}
+
+				m_eState = STATE_LOGIN;
+			}
+			return false;
+
+		case HEADER_GC_LOGIN_FAILURE:
+			fprintf(stderr, "%s: login failure %s\n", m_stLogin.c_str(), ((const TPacketGCLoginFailure *) c_pData)->szStatus);
+			Close(true);
+			return false;
+
+		case HEADER_GC_LOGIN_SUCCESS_NEWSLOT:
+			{
+				const TPacketGCLoginSuccess * p = (const TPacketGCLoginSuccess *) c_pData;
+				m_bHasCharacter = m_pConfig->bSlot < PLAYER_PER_ACCOUNT && p->players[m_pConfig->bSlot].dwID != 0;
+			}
+			break;
+
+		case HEADER_GC_MAIN_CHARACTER:
+		case HEADER_GC_MAIN_CHARACTER3_BGM:
+		case HEADER_GC_MAIN_CHARACTER4_BGM_VOL:
+			{
+				// all three start with the vid; the position sits past the name fields
+				if ((BYTE) *c_pData == HEADER_GC_MAIN_CHARACTER)
+				{
+					const TPacketGCMainCharacter * p = (const TPacketGCMainCharacter *) c_pData;
+					m_dwVID = p->dwVID, m_lX = p->lx, m_lY = p->ly;
+				}
+				else if ((BYTE) *c_pData == HEADER_GC_MAIN_CHARACTER3_BGM)
+				{
+					const TPacketGCMainCharacter3_BGM * p = (const TPacketGCMainCharacter3_BGM *) c_pData;
+					m_dwVID = p->dwVID, m_lX = p->lx, m_lY = p->ly;
+				}
+				else
+				{
+					const TPacketGCMainCharacter4_BGM_VOL * p = (const TPacketGCMainCharacter4_BGM_VOL *) c_pData;
+					m_dwVID = p->dwVID, m_lX = p->lx, m_lY = p->ly;
+				}
+
+				m_lHomeX = m_lX;
+				m_lHomeY = m_lY;
+
+				if (!m_pConfig->stClientVersion.empty())
+				{
+					TPacketCGClientVersion pack;
+					memset(&pack, 0, sizeof(pack));
+					pack.header = HEADER_CG_CLIENT_VERSION;
+					strlcpy(pack.filename, "loadsim", sizeof(pack.filename));
+					strlcpy(pack.timestamp, m_pConfig->stClientVersion.c_str(), sizeof(pack.timestamp));
+					Send(&pack, sizeof(pack), true);
+				}
+
+				TPacketCGEnterGame pack;
+				pack.header = HEADER_CG_ENTERGAME;
+				Send(&pack, sizeof(pack), true);
+			}
+			break;
+
+		case HEADER_GC_PING:
+			{
+				BYTE bHeader = HEADER_CG_PONG;
+				Send(&bHeader, sizeof(bHeader), true);
+			}
+			break;
+
+		case HEADER_GC_CHARACTER_ADD:
+			{
+				const TPacketGCCharacterAdd * p = (const TPacketGCCharacterAdd *) c_pData;
+
+				if (p->bType == CHAR_TYPE_MONSTER)
+					m_mapMonster[p->dwVID] = std::make_pair((long) p->x, (long) p->y);
+			}
+			break;
+
+		case HEADER_GC_CHARACTER_DEL:
+			m_mapMonster.erase(((const TPacketGCCharacterDelete *) c_pData)->id);
+			break;
+
+		case HEADER_GC_MOVE:
+			{
+				const TPacketGCMove * p = (const TPacketGCMove *) c_pData;
+				std::map<DWORD, std::pair<long, long> >::iterator it = m_mapMonster.find(p->dwVID);
+
+				if (it != m_mapMonster.end())
+					it->second = std::make_pair((long) p->lX, (long) p->lY);
+			}
+			break;
+
+		case HEADER_GC_DEAD:
+			if (((const TPacketGCDead *) c_pData)->vid == m_dwVID)
+				m_qwRestartUs = loadsim_time_us() + 5000000;
+			break;
+
+		case HEADER_GC_CHAT:
+			{
+				const TPacketGCChat * p = (const TPacketGCChat *) c_pData;
+
+				if (p->id != m_dwVID || iSize <= (int) sizeof(TPacketGCChat))
+					break;
+
+				std::string stText(c_pData + sizeof(TPacketGCChat), iSize - sizeof(TPacketGCChat));
+				size_t iMark = stText.find("loadsim#");
+
+				if (iMark == std::string::npos)
+					break;
+
+				DWORD dwProbe = strtoul(stText.c_str() + iMark + 8, NULL, 10);
+				std::map<DWORD, uint64_t>::iterator it = m_mapChatSent.find(dwProbe);
+
+				if (it != m_mapChatSent.end())
+				{
+					g_kStats.vecRttUs.push_back((DWORD) (loadsim_time_us() - it->second));
+					m_mapChatSent.erase(it);
+				}
+			}
+			break;
+
+		case HEADER_GC_EXCHANGE:
+			{
+				const struct packet_exchange * p = (const struct packet_exchange *) c_pData;
+
+				if (p->sub_header == EXCHANGE_SUBHEADER_GC_START)
+				{
+					uint64_t qwNow = loadsim_time_us();
+					m_qwExchangeAcceptUs = qwNow + 500000;
+					m_qwExchangeCancelUs = qwNow + 5000000;
+				}
+				else if (p->sub_header == EXCHANGE_SUBHEADER_GC_END)
+					m_qwExchangeAcceptUs = m_qwExchangeCancelUs = 0;
+			}
+			break;
+	}
+
+	return true;
+}
+
+void CBot::OnPhase(BYTE bPhase)
+{
+	switch (bPhase)
+	{
+		case PHASE_AUTH:
+			{
+				TPacketCGLogin3 pack;
+				memset(&pack, 0, sizeof(pack));
+				pack.header = HEADER_CG_LOGIN3;
+				strlcpy(pack.login, m_stLogin.c_str(), sizeof(pack.login));
+				strlcpy(pack.passwd, m_pConfig->stPasswd.c_str(), sizeof(pack.passwd));
+				memcpy(pack.adwClientKey, m_adwClientKey, sizeof(pack.adwClientKey));
+				Send(&pack, sizeof(pack), true);
+			}
+			break;
+
+		case PHASE_LOGIN:
+			{
+				TPacketCGLogin2 pack;
+				memset(&pack, 0, sizeof(pack));
+				pack.header = HEADER_CG_LOGIN2;
+				strlcpy(pack.login, m_stLogin.c_str(), sizeof(pack.login));
+				pack.dwLoginKey = m_dwLoginKey;
+				memcpy(pack.adwClientKey, m_adwClientKey, sizeof(pack.adwClientKey));
+				Send(&pack, sizeof(pack), true);
+			}
+			break;
+
+		case PHASE_SELECT:
+			{
+				if (!m_bHasCharacter)
+				{
+					fprintf(stderr, "%s: no character in slot %u\n", m_stLogin.c_str(), m_pConfig->bSlot);
+					Close(true);
+					return;
+				}
+
+				TPacketCGPlayerSelect pack;
+				pack.header = HEADER_CG_CHARACTER_SELECT;
+				pack.index = m_pConfig->bSlot;
+				Send(&pack, sizeof(pack), true);
+			}
+			break;
+
+		case PHASE_GAME:
+			{
+				if (m_eState == STATE_GAME)
+					break;	// back from PHASE_DEAD
+
+				uint64_t qwNow = loadsim_time_us();
+
+				g_kStats.vecLoginMs.push_back((DWORD) ((qwNow - m_qwStartUs) / 1000));
+				m_eState = STATE_GAME;
+
+				m_qwNextMoveUs = qwNow + random_us(500, 2000);
+				m_qwNextAttackUs = qwNow + random_us(1000, 3000);
+				m_qwNextChatUs = qwNow + random_us(1000, 5000);
+				m_qwNextTradeUs = qwNow + random_us(5000, 15000);
+				m_qwReplayStartUs = qwNow;
+				m_iReplayPos = 0;
+			}
+			break;
+
+		case PHASE_CLOSE:
+			Close(true);
+			break;
+	}
+}
+
+void CBot::Update(uint64_t qwNowUs)
+{
+	if (m_eState != STATE_GAME || m_iSocket < 0)
+		return;
+
+	if (m_pReplay)
+		UpdateReplay(qwNowUs);
+	else
+		UpdateScript(qwNowUs);
+}
+
+void CBot::UpdateScript(uint64_t qwNowUs)
+{
+	if (m_qwRestartUs)
+	{
+		if (qwNowUs < m_qwRestartUs)
+			return;
+
+		m_qwRestartUs = 0;
+		SendChat("/restart_here");
+	}
+
+	if (qwNowUs >= m_qwNextMoveUs)
+	{
+		// wander around the spawn point, well inside the server's teleport check
+		long lX = m_lHomeX + (rand() % 1200) - 600;
+		long lY = m_lHomeY + (rand() % 1200) - 600;
+
+		SendMove(FUNC_MOVE, lX, lY);
+		m_lX = lX;
+		m_lY = lY;
+		m_qwNextMoveUs = qwNowUs + random_us(1000, 2000);
+	}
+
+	if (qwNowUs >= m_qwNextAttackUs)
+	{
+		DWORD dwTarget = 0;
+		long long llBest = 1500LL * 1500LL;
+
+		for (std::map<DWORD, std::pair<long, long> >::iterator it = m_mapMonster.begin(); it != m_mapMonster.end(); ++it)
+		{
+			long long dx = it->second.first - m_lX, dy = it->second.second - m_lY;
+
+			if (dx * dx + dy * dy < llBest)
+			{
+				llBest = dx * dx + dy * dy;
+				dwTarget = it->first;
+			}
+		}
+
+		if (dwTarget)
+		{
+			SendMove(FUNC_ATTACK, m_lX, m_lY);
+			SendAttack(dwTarget);
+		}
+
+		m_qwNextAttackUs = qwNowUs + random_us(1200, 2000);
+	}
+
+	if (qwNowUs >= m_qwNextChatUs)
+	{
+		char szText[64];
+		snprintf(szText, sizeof(szText), "loadsim#%u", ++m_dwChatProbe);
+
+		m_mapChatSent[m_dwChatProbe] = qwNowUs;
+		SendChat(szText);
+
+		// forget probes the server dropped (spam filter, chat counter)
+		while (m_mapChatSent.size() > 16)
+			m_mapChatSent.erase(m_mapChatSent.begin());
+
+		m_qwNextChatUs = qwNowUs + random_us(3000, 5000);
+	}
+
+	// even bots open a trade with the next bot; both sides accept it
+	if (m_pkPartner && qwNowUs >= m_qwNextTradeUs)
+	{
+		if (m_pkPartner->IsInGame() && !m_qwExchangeCancelUs)
+			SendExchange(EXCHANGE_SUBHEADER_CG_START, m_pkPartner->GetVID());
+
+		m_qwNextTradeUs = qwNowUs + random_us(10000, 20000);
+	}
+
+	if (m_qwExchangeAcceptUs && qwNowUs >= m_qwExchangeAcceptUs)
+	{
+		SendExchange(EXCHANGE_SUBHEADER_CG_ACCEPT, 0);
+		m_qwExchangeAcceptUs = 0;
+	}
+
+	if (m_qwExchangeCancelUs && qwNowUs >= m_qwExchangeCancelUs)
+	{
+		SendExchange(EXCHANGE_SUBHEADER_CG_CANCEL, 0);
+		m_qwExchangeCancelUs = 0;
+	}
+}
+
+void CBot::UpdateReplay(uint64_t qwNowUs)
+{
+	if (m_pReplay->empty())
+		return;
+
+	while (m_iSocket >= 0)
+	{
+		if (m_iReplayPos >= m_pReplay->size())
+		{
+			// loop the capture for as long as the run lasts
+			m_iReplayPos = 0;
+			m_qwReplayStartUs = qwNowUs;
+		}
+
+		const TReplayPacket & c_rPacket = (*m_pReplay)[m_iReplayPos];
+
+		if (qwNowUs - m_qwReplayStartUs < (uint64_t) c_rPacket.dwTime * 1000)
+			break;
+
+		++m_iReplayPos;
+
+		// the captured sequence byte belongs to the recorded connection
+		std::vector<char> vecData(c_rPacket.vecData);
+
+		if (c_rPacket.bSequence)
+			vecData.pop_back();
+
+		if (vecData.empty())
+			continue;
+
+		if ((BYTE) vecData[0] == HEADER_CG_MOVE && vecData.size() >= sizeof(TPacketCGMove))
+			((TPacketCGMove *) &vecData[0])->dwTime = GetServerTime();
+
+		Send(&vecData[0], vecData.size(), c_rPacket.bSequence);
+	}
+}
+
+void CBot::SendMove(BYTE bFunc, long lX, long lY)
+{
+	TPacketCGMove pack;
+	pack.bHeader	= HEADER_CG_MOVE;
+	pack.bFunc		= bFunc;
+	pack.bArg		= 0;
+	pack.bRot		= (BYTE) (rand() % 36);
+	pack.lX			= lX;
+	pack.lY			= lY;
+	pack.dwTime		= GetServerTime();
+	Send(&pack, sizeof(pack), true);
+}
+
+void CBot::SendAttack(DWORD dwVID)
+{
+	TPacketCGAttack pack;
+	memset(&pack, 0, sizeof(pack));
+	pack.bHeader	= HEADER_CG_ATTACK;
+	pack.dwVID		= dwVID;
+	Send(&pack, sizeof(pack), true);
+}
+
+void CBot::SendChat(const char * c_pszText)
+{
+	size_t iLen = strlen(c_pszText) + 1;
+
+	TPacketCGChat pack;
+	pack.header	= HEADER_CG_CHAT;
+	pack.size	= sizeof(pack) + iLen;
+	pack.type	= CHAT_TYPE_TALKING;
+
+	// the sequence byte goes after the text, so send it as one packet
+	std::string stBuf((const char *) &pack, sizeof(pack));
+	stBuf.append(c_pszText, iLen);
+	Send(stBuf.data(), stBuf.size(), true);
+}
+
+void CBot::SendExchange(BYTE bSubHeader, DWORD dwArg)
+{
+	TPacketCGExchange pack = {};
+	pack.header		= HEADER_CG_EXCHANGE;
+	pack.sub_header	= bSubHeader;
+	pack.arg1		= dwArg;
+	Send(&pack, sizeof(pack), true);
+}
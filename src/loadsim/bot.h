@@ -0,0 +1,144 @@
+﻿#ifndef __INC_LOADSIM_BOT_H__
+#define __INC_LOADSIM_BOT_H__
+
+#include <pcg_random.hpp>
+
+#include "game/cipher.h"
+
+typedef struct SLoadSimConfig
+{
+	std::string	stAuthHost;
+	WORD		wAuthPort;
+	std::string	stGameHost;
+	WORD		wGamePort;
+	std::string	stPasswd;
+	std::string	stClientVersion;	// sent before ENTERGAME when not empty
+	BYTE		bSlot;
+} TLoadSimConfig;
+
+// Client packets of one captured descriptor, times relative to its first packet.
+typedef struct SReplayPacket
+{
+	DWORD				dwTime;
+	bool				bSequence;
+	std::vector<char>	vecData;
+} TReplayPacket;
+
+typedef std::vector<TReplayPacket> TReplayStream;
+
+// Shared by all bots, reset every report interval except the totals.
+typedef struct SLoadSimStats
+{
+	uint64_t				qwPacketsSent;
+	uint64_t				qwPacketsRecv;
+	uint64_t				qwBytesSent;
+	uint64_t				qwBytesRecv;
+	std::vector<DWORD>		vecRttUs;		// chat round trips
+	std::vector<DWORD>		vecLoginMs;		// connect to auth -> PHASE_GAME
+	int						iLoginFailed;
+	int						iDisconnected;
+	int						iFramingErrors;
+} TLoadSimStats;
+
+extern TLoadSimStats g_kStats;
+
+uint64_t loadsim_time_us();
+
+class CBot
+{
+	public:
+		enum EState
+		{
+			STATE_IDLE,
+			STATE_AUTH,			// connected to the auth core
+			STATE_LOGIN,		// connected to the game core, until PHASE_GAME
+			STATE_GAME,
+			STATE_CLOSED,
+		};
+
+	public:
+		CBot(int iIndex, const std::string & c_rstLogin, const TLoadSimConfig * c_pConfig);
+		~CBot();
+
+		bool			Start();
+		void			Close(bool bError);
+
+		int				GetSocket() const		{ return m_iSocket; }
+		EState			GetState() const		{ return m_eState; }
+		bool			IsInGame() const		{ return m_eState == STATE_GAME; }
+		bool			HasOutput() const		{ return m_stOutput.size() > 0; }
+		DWORD			GetVID() const			{ return m_dwVID; }
+
+		void			SetPartner(CBot * pkPartner)	{ m_pkPartner = pkPartner; }
+		void			SetReplay(const TReplayStream * c_pStream)	{ m_pReplay = c_pStream; }
+
+		void			OnReadable();
+		void			OnWritable();
+		void			Update(uint64_t qwNowUs);
+
+	protected:
+		bool			Connect(const std::string & c_rstHost, WORD wPort);
+		void			Disconnect();
+
+		// Appends the sequence byte and encrypts once the cipher is active.
+		void			Send(const void * c_pvData, int iSize, bool bSequence);
+
+		void			ProcessInput();
+		bool			HandlePacket(const char * c_pData, int iSize);
+		void			OnPhase(BYTE bPhase);
+
+		DWORD			GetServerTime() const;
+
+		void			UpdateScript(uint64_t qwNowUs);
+		void			UpdateReplay(uint64_t qwNowUs);
+
+		void			SendMove(BYTE bFunc, long lX, long lY);
+		void			SendAttack(DWORD dwVID);
+		void			SendChat(const char * c_pszText);
+		void			SendExchange(BYTE bSubHeader, DWORD dwArg);
+
+	protected:
+		int							m_iIndex;
+		std::string					m_stLogin;
+		const TLoadSimConfig *		m_pConfig;
+
+		EState						m_eState;
+		int							m_iSocket;
+		std::string					m_stOutput;
+		std::vector<char>			m_vecInput;
+
+		Cipher						m_cipher;
+		pcg32						m_kSequence;
+
+		DWORD						m_adwClientKey[4];
+		DWORD						m_dwLoginKey;
+		bool						m_bHasCharacter;
+		uint64_t					m_qwStartUs;
+
+		DWORD						m_dwServerTimeBase;	// GC_HANDSHAKE time + delta
+		uint64_t					m_qwServerTimeBaseUs;	// our clock when it arrived
+
+		DWORD						m_dwVID;
+		long						m_lX, m_lY;
+		long						m_lHomeX, m_lHomeY;
+
+		// scripted mode
+		std::map<DWORD, std::pair<long, long> >	m_mapMonster;
+		std::map<DWORD, uint64_t>	m_mapChatSent;		// probe id -> send time
+		DWORD						m_dwChatProbe;
+		uint64_t					m_qwNextMoveUs;
+		uint64_t					m_qwNextAttackUs;
+		uint64_t					m_qwNextChatUs;
+		uint64_t					m_qwNextTradeUs;
+		uint64_t					m_qwExchangeAcceptUs;
+		uint64_t					m_qwExchangeCancelUs;
+		uint64_t					m_qwRestartUs;
+		CBot *						m_pkPartner;
+
+		// replay mode
+		const TReplayStream *		m_pReplay;
+		size_t						m_iReplayPos;
+		uint64_t					m_qwReplayStartUs;
+};
+
+#endif
@@ -0,0 +1,179 @@
+﻿#include "stdafx.h"
+#include "gc_packet.h"
+
+static int s_aiSize[256];
+
+#define GC_PACKET(header, size) s_aiSize[header] = (int) (size)
+
+void GCPacketInit()
+{
+	memset(s_aiSize, 0, sizeof(s_aiSize));
+
+#ifdef _IMPROVED_PACKET_ENCRYPTION_
+	GC_PACKET(HEADER_GC_KEY_AGREEMENT_COMPLETED,	sizeof(TPacketKeyAgreementCompleted));
+	GC_PACKET(HEADER_GC_KEY_AGREEMENT,			sizeof(TPacketKeyAgreement));
+#endif
+	GC_PACKET(HEADER_GC_TIME_SYNC,				sizeof(BYTE));
+	GC_PACKET(HEADER_GC_PHASE,					sizeof(TPacketGCPhase));
+	GC_PACKET(HEADER_GC_BINDUDP,				sizeof(TPacketGCBindUDP));
+	GC_PACKET(HEADER_GC_HANDSHAKE,				sizeof(TPacketGCHandshake));
+
+	GC_PACKET(HEADER_GC_CHARACTER_ADD,			sizeof(TPacketGCCharacterAdd));
+	GC_PACKET(HEADER_GC_CHARACTER_DEL,			sizeof(TPacketGCCharacterDelete));
+	GC_PACKET(HEADER_GC_MOVE,					sizeof(TPacketGCMove));
+	GC_PACKET(HEADER_GC_CHAT,					GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_SYNC_POSITION,			GC_PACKET_DYNAMIC);
+
+	GC_PACKET(HEADER_GC_LOGIN_SUCCESS_NEWSLOT,	sizeof(TPacketGCLoginSuccess));
+	GC_PACKET(HEADER_GC_LOGIN_FAILURE,			sizeof(TPacketGCLoginFailure));
+	GC_PACKET(HEADER_GC_CHARACTER_CREATE_SUCCESS,	sizeof(TPacketGCPlayerCreateSuccess));
+	GC_PACKET(HEADER_GC_CHARACTER_CREATE_FAILURE,	sizeof(TPacketGCCreateFailure));
+	GC_PACKET(HEADER_GC_CHARACTER_DELETE_SUCCESS,	sizeof(BYTE));
+	GC_PACKET(HEADER_GC_CHARACTER_DELETE_WRONG_SOCIAL_ID,	sizeof(BYTE));
+
+	GC_PACKET(HEADER_GC_STUN,					sizeof(TPacketGCStun));
+	GC_PACKET(HEADER_GC_DEAD,					sizeof(TPacketGCDead));
+	GC_PACKET(HEADER_GC_CHARACTER_POINTS,		sizeof(TPacketGCPoints));
+	GC_PACKET(HEADER_GC_CHARACTER_POINT_CHANGE,	sizeof(TPacketGCPointChange));
+	GC_PACKET(HEADER_GC_CHARACTER_UPDATE,		sizeof(TPacketGCCharacterUpdate));
+
+	GC_PACKET(HEADER_GC_ITEM_DEL,				sizeof(TPacketGCItemDel));
+	GC_PACKET(HEADER_GC_ITEM_SET,				sizeof(TPacketGCItemSet));
+	GC_PACKET(HEADER_GC_ITEM_USE,				sizeof(struct packet_item_use));
+	GC_PACKET(HEADER_GC_ITEM_UPDATE,			sizeof(TPacketGCItemUpdate));
+	GC_PACKET(HEADER_GC_ITEM_GROUND_ADD,		sizeof(TPacketGCItemGroundAdd));
+	GC_PACKET(HEADER_GC_ITEM_GROUND_DEL,		sizeof(TPacketGCItemGroundDel));
+	GC_PACKET(HEADER_GC_ITEM_OWNERSHIP,			sizeof(TPacketGCItemOwnership));
+
+	GC_PACKET(HEADER_GC_QUICKSLOT_ADD,			sizeof(struct packet_quickslot_add));
+	GC_PACKET(HEADER_GC_QUICKSLOT_DEL,			sizeof(struct packet_quickslot_del));
+	GC_PACKET(HEADER_GC_QUICKSLOT_SWAP,			sizeof(struct packet_quickslot_swap));
+
+	GC_PACKET(HEADER_GC_WHISPER,				GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_MOTION,					sizeof(struct packet_motion));
+	GC_PACKET(HEADER_GC_SHOP,					GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_SHOP_SIGN,				sizeof(TPacketGCShopSign));
+	GC_PACKET(HEADER_GC_DUEL_START,				GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_PVP,					sizeof(TPacketGCPVP));
+	GC_PACKET(HEADER_GC_EXCHANGE,				sizeof(struct packet_exchange));
+	GC_PACKET(HEADER_GC_CHARACTER_POSITION,		sizeof(struct packet_position));
+	GC_PACKET(HEADER_GC_PING,					sizeof(TPacketGCPing));
+	GC_PACKET(HEADER_GC_SCRIPT,					GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_QUEST_CONFIRM,			sizeof(TPacketGCQuestConfirm));
+
+	GC_PACKET(HEADER_GC_OWNERSHIP,				sizeof(TPacketGCOwnership));
+	GC_PACKET(HEADER_GC_TARGET,					sizeof(TPacketGCTarget));
+	GC_PACKET(HEADER_GC_WARP,					sizeof(TPacketGCWarp));
+	GC_PACKET(HEADER_GC_ADD_FLY_TARGETING,		sizeof(TPacketGCFlyTargeting));
+	GC_PACKET(HEADER_GC_CREATE_FLY,				sizeof(TPacketGCCreateFly));
+	GC_PACKET(HEADER_GC_FLY_TARGETING,			sizeof(TPacketGCFlyTargeting));
+	GC_PACKET(HEADER_GC_SKILL_LEVEL,			sizeof(TPacketGCSkillLevel));
+
+	GC_PACKET(HEADER_GC_MESSENGER,				GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_GUILD,					GC_PACKET_DYNAMIC);
+
+	GC_PACKET(HEADER_GC_PARTY_INVITE,			sizeof(TPacketGCPartyInvite));
+	GC_PACKET(HEADER_GC_PARTY_ADD,				sizeof(TPacketGCPartyAdd));
+	GC_PACKET(HEADER_GC_PARTY_UPDATE,			sizeof(TPacketGCPartyUpdate));
+	GC_PACKET(HEADER_GC_PARTY_REMOVE,			sizeof(TPacketGCPartyRemove));
+	GC_PACKET(HEADER_GC_PARTY_PARAMETER,		sizeof(TPacketGCPartyParameter));
+	GC_PACKET(HEADER_GC_PARTY_LINK,				sizeof(TPacketGCPartyLink));
+	GC_PACKET(HEADER_GC_PARTY_UNLINK,			sizeof(TPacketGCPartyUnlink));
+
+	GC_PACKET(HEADER_GC_QUEST_INFO,				GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_REQUEST_MAKE_GUILD,		sizeof(BYTE));
+
+	GC_PACKET(HEADER_GC_SAFEBOX_SET,			sizeof(TPacketGCItemSet));
+	GC_PACKET(HEADER_GC_SAFEBOX_DEL,			sizeof(TPacketGCItemDel));
+	GC_PACKET(HEADER_GC_SAFEBOX_WRONG_PASSWORD,	sizeof(TPacketCGSafeboxWrongPassword));
+	GC_PACKET(HEADER_GC_SAFEBOX_SIZE,			sizeof(TPacketCGSafeboxSize));
+	GC_PACKET(HEADER_GC_MALL_OPEN,				sizeof(TPacketCGSafeboxSize));
+	GC_PACKET(HEADER_GC_MALL_SET,				sizeof(TPacketGCItemSet));
+	GC_PACKET(HEADER_GC_MALL_DEL,				sizeof(TPacketGCItemDel));
+
+	GC_PACKET(HEADER_GC_FISHING,				sizeof(TPacketGCFishing));
+	GC_PACKET(HEADER_GC_EMPIRE,					sizeof(TPacketGCEmpire));
+	GC_PACKET(HEADER_GC_VIEW_EQUIP,				sizeof(TPacketViewEquip));
+	GC_PACKET(HEADER_GC_MARK_BLOCK,				GC_PACKET_DYNAMIC32);
+	GC_PACKET(HEADER_GC_MARK_IDXLIST,			GC_PACKET_DYNAMIC32);
+	GC_PACKET(HEADER_GC_TIME,					sizeof(TPacketGCTime));
+	GC_PACKET(HEADER_GC_CHANGE_NAME,			sizeof(TPacketGCChangeName));
+	GC_PACKET(HEADER_GC_DUNGEON,				GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_WALK_MODE,				sizeof(TPacketGCWalkMode));
+	GC_PACKET(HEADER_GC_SKILL_GROUP,			sizeof(TPacketGCChangeSkillGroup));
+	GC_PACKET(HEADER_GC_MAIN_CHARACTER,			sizeof(TPacketGCMainCharacter));
+	GC_PACKET(HEADER_GC_MAIN_CHARACTER3_BGM,	sizeof(TPacketGCMainCharacter3_BGM));
+	GC_PACKET(HEADER_GC_MAIN_CHARACTER4_BGM_VOL,	sizeof(TPacketGCMainCharacter4_BGM_VOL));
+	GC_PACKET(HEADER_GC_SEPCIAL_EFFECT,			sizeof(TPacketGCSpecialEffect));
+	GC_PACKET(HEADER_GC_NPC_POSITION,			GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_REFINE_INFORMATION,		sizeof(TPacketGCRefineInformation));
+	GC_PACKET(HEADER_GC_CHANNEL,				sizeof(TPacketGCChannel));
+
+	GC_PACKET(HEADER_GC_TARGET_UPDATE,			sizeof(TPacketGCTargetUpdate));
+	GC_PACKET(HEADER_GC_TARGET_DELETE,			sizeof(TPacketGCTargetDelete));
+	GC_PACKET(HEADER_GC_TARGET_CREATE,			sizeof(TPacketGCTargetCreate));
+	GC_PACKET(HEADER_GC_AFFECT_ADD,				sizeof(TPacketGCAffectAdd));
+	GC_PACKET(HEADER_GC_AFFECT_REMOVE,			sizeof(TPacketGCAffectRemove));
+
+	GC_PACKET(HEADER_GC_LAND_LIST,				GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_LOVER_INFO,				sizeof(TPacketGCLoverInfo));
+	GC_PACKET(HEADER_GC_LOVE_POINT_UPDATE,		sizeof(TPacketGCLovePointUpdate));
+	GC_PACKET(HEADER_GC_SYMBOL_DATA,			GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_DIG_MOTION,				sizeof(TPacketGCDigMotion));
+	GC_PACKET(HEADER_GC_DAMAGE_INFO,			sizeof(TPacketGCDamageInfo));
+	GC_PACKET(HEADER_GC_CHAR_ADDITIONAL_INFO,	sizeof(TPacketGCCharacterAdditionalInfo));
+	GC_PACKET(HEADER_GC_IDLE_HUNTING,			sizeof(TPacketGCIdleHunting));
+
+	GC_PACKET(HEADER_GC_AUTH_SUCCESS,			sizeof(TPacketGCAuthSuccess));
+	GC_PACKET(HEADER_GC_PANAMA_PACK,			sizeof(TPacketGCPanamaPack));
+	GC_PACKET(HEADER_GC_HYBRIDCRYPT_KEYS,		GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_HYBRIDCRYPT_SDB,		GC_PACKET_DYNAMIC);
+	GC_PACKET(HEADER_GC_SPECIFIC_EFFECT,		sizeof(TPacketGCSpecificEffect));
+	GC_PACKET(HEADER_GC_DRAGON_SOUL_REFINE,		sizeof(TPacketGCDragonSoulRefine));
+}
+
+int GCPacketGetSize(const char * c_pData, int iBytes)
+{
+	if (iBytes < 1)
+		return 0;
+
+	int iSize = s_aiSize[(BYTE) *c_pData];
+
+	switch (iSize)
+	{
+		case GC_PACKET_UNKNOWN:
+			return -1;
+
+		case GC_PACKET_DYNAMIC:
+			{
+				if (iBytes < (int) (sizeof(BYTE) + sizeof(WORD)))
+					return 0;
+
+				WORD wSize;
+				memcpy(&wSize, c_pData + sizeof(BYTE), sizeof(WORD));
+
+				if (wSize < sizeof(BYTE) + sizeof(WORD))
+					return -1;
+
+				iSize = wSize;
+			}
+			break;
+
+		case GC_PACKET_DYNAMIC32:
+			{
+				if (iBytes < (int) (sizeof(BYTE) + sizeof(DWORD)))
+					return 0;
+
+				DWORD dwSize;
+				memcpy(&dwSize, c_pData + sizeof(BYTE), sizeof(DWORD));
+
+				if (dwSize < sizeof(BYTE) + sizeof(DWORD))
+					return -1;
+
+				iSize = dwSize;
+			}
+			break;
+	}
+
+	return iBytes >= iSize ? iSize : 0;
+}
@@ -0,0 +1,22 @@
+﻿#ifndef __INC_LOADSIM_GC_PACKET_H__
+#define __INC_LOADSIM_GC_PACKET_H__
+
+//
+// Framing of the game -> client stream. The game never sends a length prefix,
+// so like the real client the bots need to know every packet's size up front.
+// Dynamic packets carry their total size right after the header.
+//
+enum EGCPacketSize
+{
+	GC_PACKET_UNKNOWN	= 0,
+	GC_PACKET_DYNAMIC	= -1,	// uint16_t total size at offset 1
+	GC_PACKET_DYNAMIC32	= -2,	// uint32_t total size at offset 1 (mark server)
+};
+
+void GCPacketInit();
+
+// Returns the size of the packet at c_pData, 0 if more data is needed,
+// or -1 if the header is unknown and the stream cannot be framed any more.
+int GCPacketGetSize(const char * c_pData, int iBytes);
+
+#endif
@@ -0,0 +1,477 @@
+﻿#include "stdafx.h"
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+#include "common/packet_capture.h"
+
+#include "bot.h"
+#include "gc_packet.h"
+
+//
+// loadsim - headless client load generator for a local auth/game/db set.
+//
+// Every bot logs in through the auth core like the real client (handshake,
+// key agreement, LOGIN3 -> LOGIN2 -> select -> ENTERGAME) and then either runs
+// a small script (move, attack nearby monsters, chat, trade with the next bot)
+// or replays a packet_capture file recorded by the game.
+//
+// Once a second it prints packets/s and chat round trip p50/p99; at the end it
+// diffs the game's METRICS text command to report per-pulse loop timing.
+//
+static volatile bool s_bShutdown = false;
+
+static void sig_shutdown(int)
+{
+	s_bShutdown = true;
+}
+
+static void usage()
+{
+	printf("Usage: loadsim -a <auth host:port> -g <game host:port> [options]\n"
+			"-n <count>    : number of bots (default 10)\n"
+			"-u <prefix>   : account name prefix, bots log in as <prefix><index> (default bot)\n"
+			"-o <index>    : first account index (default 1)\n"
+			"-w <passwd>   : account password (default 1234)\n"
+			"-s <slot>     : character slot to select (default 0)\n"
+			"-d <seconds>  : run time after the first bot is in game (default 60)\n"
+			"-R <per sec>  : login ramp, bots started per second (default 10)\n"
+			"-c <version>  : client version sent before ENTERGAME\n"
+			"-r <file>     : replay a packet_capture file instead of the script\n"
+			"-M            : do not read METRICS from the game core\n");
+}
+
+static bool split_host_port(const char * c_pszArg, std::string & rstHost, WORD & rwPort)
+{
+	const char * c_pszColon = strrchr(c_pszArg, ':');
+
+	if (!c_pszColon)
+		return false;
+
+	rstHost.assign(c_pszArg, c_pszColon - c_pszArg);
+	rwPort = (WORD) atoi(c_pszColon + 1);
+	return !rstHost.empty() && rwPort != 0;
+}
+
+static DWORD percentile(std::vector<DWORD> & rvec, double dRatio)
+{
+	if (rvec.empty())
+		return 0;
+
+	size_t n = std::min(rvec.size() - 1, (size_t) (dRatio * rvec.size()));
+	std::nth_element(rvec.begin(), rvec.begin() + n, rvec.end());
+	return rvec[n];
+}
+
+static bool load_replay(const char * c_pszFileName, std::vector<TReplayStream> & rvecStream)
+{
+	CPacketCaptureReader reader;
+
+	if (!reader.Open(c_pszFileName))
+		return false;
+
+	std::map<DWORD, size_t> mapStreamIndex;
+	std::map<DWORD, DWORD> mapFirstTime;
+	TPacketCaptureRecord record;
+	std::vector<char> vecData;
+
+	while (reader.Next(record, vecData))
+	{
+		if (vecData.empty())
+			continue;
+
+		switch ((BYTE) vecData[0])
+		{
+			// answered live or bound to the recorded connection's clock
+			case HEADER_CG_PONG:
+			case HEADER_CG_HANDSHAKE:
+			case HEADER_CG_TIME_SYNC:
+			case HEADER_CG_CLIENT_VERSION:
+			case HEADER_CG_CLIENT_VERSION2:
+				continue;
+		}
+
+		std::map<DWORD, size_t>::iterator it = mapStreamIndex.find(record.dwHandle);
+
+		if (it == mapStreamIndex.end())
+		{
+			it = mapStreamIndex.insert(std::make_pair(record.dwHandle, rvecStream.size())).first;
+			mapFirstTime[record.dwHandle] = record.dwTime;
+			rvecStream.push_back(TReplayStream());
+		}
+
+		TReplayPacket packet;
+		packet.dwTime = record.dwTime - mapFirstTime[record.dwHandle];
+		packet.bSequence = record.bSequence != 0;
+		packet.vecData.swap(vecData);
+		rvecStream[it->second].push_back(packet);
+	}
+
+	return !rvecStream.empty();
+}
+
+// METRICS over the game's text command. Returns "name{labels}" -> value.
+static bool read_metrics(const std::string & c_rstHost, WORD wPort, std::map<std::string, double> & rmap)
+{
+	struct addrinfo hints, * pResult = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	char szPort[16];
+	snprintf(szPort, sizeof(szPort), "%u", wPort);
+
+	if (getaddrinfo(c_rstHost.c_str(), szPort, &hints, &pResult) != 0 || !pResult)
+		return false;
+
+	int iSocket = socket(AF_INET, SOCK_STREAM, 0);
+	bool bConnected = iSocket >= 0 && connect(iSocket, pResult->ai_addr, pResult->ai_addrlen) == 0;
+	freeaddrinfo(pResult);
+
+	if (!bConnected)
+	{
+		if (iSocket >= 0)
+			close(iSocket);
+
+		return false;
+	}
+
+	struct timeval tv = { 0, 500000 };
+	setsockopt(iSocket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	const char c_szCommand[] = "@METRICS\n";
+	send(iSocket, c_szCommand, sizeof(c_szCommand) - 1, MSG_NOSIGNAL);
+
+	// the server never closes a text session; read until it goes quiet
+	std::string stText;
+	char buf[8192];
+	ssize_t iRead;
+
+	while ((iRead = recv(iSocket, buf, sizeof(buf), 0)) > 0)
+		stText.append(buf, iRead);
+
+	close(iSocket);
+
+	// skip the binary phase/handshake packets sent on accept
+	size_t iPos = stText.find("# TYPE");
+
+	if (iPos == std::string::npos)
+		return false;
+
+	while (iPos < stText.size())
+	{
+		size_t iEnd = stText.find('\n', iPos);
+
+		if (iEnd == std::string::npos)
+			iEnd = stText.size();
+
+		std::string stLine = stText.substr(iPos, iEnd - iPos);
+		size_t iSpace = stLine.rfind(' ');
+
+		if (stLine[0] != '#' && iSpace != std::string::npos)
+			rmap[stLine.substr(0, iSpace)] = atof(stLine.c_str() + iSpace + 1);
+
+		iPos = iEnd + 1;
+	}
+
+	return true;
+}
+
+static void report_pulse(const std::map<std::string, double> & c_rBegin, const std::map<std::string, double> & c_rEnd)
+{
+	const std::string c_stPrefix = "game_phase_duration_seconds_bucket{phase=\"loop\",le=\"";
+
+	// (upper bound, cumulative count delta) per bucket
+	std::vector<std::pair<double, double> > vecBucket;
+
+	for (std::map<std::string, double>::const_iterator it = c_rEnd.begin(); it != c_rEnd.end(); ++it)
+	{
+		if (it->first.compare(0, c_stPrefix.size(), c_stPrefix))
+			continue;
+
+		std::string stLe = it->first.substr(c_stPrefix.size());
+		double dLimit = stLe.compare(0, 4, "+Inf") ? atof(stLe.c_str()) : 1e9;
+
+		std::map<std::string, double>::const_iterator itBegin = c_rBegin.find(it->first);
+		vecBucket.push_back(std::make_pair(dLimit, it->second - (itBegin != c_rBegin.end() ? itBegin->second : 0)));
+	}
+
+	std::sort(vecBucket.begin(), vecBucket.end());
+
+	if (vecBucket.empty() || vecBucket.back().second <= 0)
+	{
+		printf("pulse: no loop samples in METRICS\n");
+		return;
+	}
+
+	double dTotal = vecBucket.back().second;
+	double adLimit[2] = { 0, 0 };
+	const double c_adRatio[2] = { 0.5, 0.99 };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		for (size_t n = 0; n < vecBucket.size(); ++n)
+		{
+			if (vecBucket[n].second >= c_adRatio[i] * dTotal)
+			{
+				adLimit[i] = vecBucket[n].first;
+				break;
+			}
+		}
+	}
+
+	std::map<std::string, double>::const_iterator itSumBegin = c_rBegin.find("game_phase_duration_seconds_sum{phase=\"loop\"}");
+	std::map<std::string, double>::const_iterator itSumEnd = c_rEnd.find("game_phase_duration_seconds_sum{phase=\"loop\"}");
+	double dAvgMs = 0;
+
+	if (itSumBegin != c_rBegin.end() && itSumEnd != c_rEnd.end())
+		dAvgMs = (itSumEnd->second - itSumBegin->second) * 1000.0 / dTotal;
+
+	std::map<std::string, double>::const_iterator itMissBegin = c_rBegin.find("game_missed_pulses_total");
+	std::map<std::string, double>::const_iterator itMissEnd = c_rEnd.find("game_missed_pulses_total");
+	double dMissed = 0;
+
+	if (itMissBegin != c_rBegin.end() && itMissEnd != c_rEnd.end())
+		dMissed = itMissEnd->second - itMissBegin->second;
+
+	// bucket bounds, so p50/p99 read as "at most"
+	printf("pulse: loops %.0f avg %.2fms p50 <= %.2fms p99 <= %.2fms missed pulses %.0f\n",
+			dTotal, dAvgMs, adLimit[0] * 1000.0, adLimit[1] * 1000.0, dMissed);
+}
+
+int main(int argc, char ** argv)
+{
+	TLoadSimConfig config;
+	config.wAuthPort = 0;
+	config.wGamePort = 0;
+	config.stPasswd = "1234";
+	config.bSlot = 0;
+
+	int iBotCount = 10;
+	int iFirstIndex = 1;
+	int iDuration = 60;
+	int iRamp = 10;
+	bool bMetrics = true;
+	std::string stPrefix = "bot";
+	std::string stReplayFile;
+
+	int ch;
+
+	while ((ch = getopt(argc, argv, "a:g:n:u:o:w:s:d:R:c:r:Mh")) != -1)
+	{
+		switch (ch)
+		{
+			case 'a':
+				if (!split_host_port(optarg, config.stAuthHost, config.wAuthPort))
+				{
+					usage();
+					return 1;
+				}
+				break;
+
+			case 'g':
+				if (!split_host_port(optarg, config.stGameHost, config.wGamePort))
+				{
+					usage();
+					return 1;
+				}
+				break;
+
+			case 'n': iBotCount = atoi(optarg); break;
+			case 'u': stPrefix = optarg; break;
+			case 'o': iFirstIndex = atoi(optarg); break;
+			case 'w': config.stPasswd = optarg; break;
+			case 's': config.bSlot = (BYTE) atoi(optarg); break;
+			case 'd': iDuration = atoi(optarg); break;
+			case 'R': iRamp = std::max(1, atoi(optarg)); break;
+			case 'c': config.stClientVersion = optarg; break;
+			case 'r': stReplayFile = optarg; break;
+			case 'M': bMetrics = false; break;
+
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (!config.wAuthPort || !config.wGamePort || iBotCount <= 0)
+	{
+		usage();
+		return 1;
+	}
+
+	signal(SIGINT, sig_shutdown);
+	signal(SIGTERM, sig_shutdown);
+	signal(SIGPIPE, SIG_IGN);
+	srand(time(NULL));
+
+	GCPacketInit();
+
+	std::vector<TReplayStream> vecReplay;
+
+	if (!stReplayFile.empty())
+	{
+		if (!load_replay(stReplayFile.c_str(), vecReplay))
+		{
+			fprintf(stderr, "cannot load replay %s\n", stReplayFile.c_str());
+			return 1;
+		}
+
+		printf("replay: %zu streams from %s\n", vecReplay.size(), stReplayFile.c_str());
+	}
+
+	std::vector<CBot *> vecBot;
+
+	for (int i = 0; i < iBotCount; ++i)
+	{
+		char szLogin[LOGIN_MAX_LEN + 1];
+		snprintf(szLogin, sizeof(szLogin), "%s%d", stPrefix.c_str(), iFirstIndex + i);
+
+		CBot * pkBot = new CBot(i, szLogin, &config);
+
+		if (!vecReplay.empty())
+			pkBot->SetReplay(&vecReplay[i % vecReplay.size()]);
+
+		vecBot.push_back(pkBot);
+	}
+
+	for (int i = 0; i + 1 < iBotCount; i += 2)
+		vecBot[i]->SetPartner(vecBot[i + 1]);
+
+	std::map<std::string, double> mapMetricsBegin, mapMetricsEnd;
+	bool bMetricsBegin = false;
+
+	uint64_t qwStartUs = loadsim_time_us();
+	uint64_t qwRunStartUs = 0;		// first bot in game
+	uint64_t qwNextReportUs = qwStartUs + 1000000;
+	uint64_t qwLastReportUs = qwStartUs;
+	uint64_t qwLastSent = 0, qwLastRecv = 0;
+	int iStarted = 0;
+
+	std::vector<struct pollfd> vecPoll;
+	std::vector<CBot *> vecPollBot;
+
+	while (!s_bShutdown)
+	{
+		uint64_t qwNow = loadsim_time_us();
+
+		// login ramp
+		while (iStarted < iBotCount && (uint64_t) iStarted * 1000000 / iRamp <= qwNow - qwStartUs)
+			vecBot[iStarted++]->Start();
+
+		vecPoll.clear();
+		vecPollBot.clear();
+
+		int iInGame = 0, iAlive = 0;
+
+		for (size_t i = 0; i < vecBot.size(); ++i)
+		{
+			CBot * pkBot = vecBot[i];
+
+			if (pkBot->IsInGame())
+				++iInGame;
+
+			if (pkBot->GetSocket() < 0)
+				continue;
+
+			++iAlive;
+
+			struct pollfd pfd;
+			pfd.fd = pkBot->GetSocket();
+			pfd.events = POLLIN | (pkBot->HasOutput() ? POLLOUT : 0);
+			pfd.revents = 0;
+			vecPoll.push_back(pfd);
+			vecPollBot.push_back(pkBot);
+		}
+
+		if (iInGame && !qwRunStartUs)
+		{
+			qwRunStartUs = qwNow;
+
+			if (bMetrics)
+				bMetricsBegin = read_metrics(config.stGameHost, config.wGamePort, mapMetricsBegin);
+		}
+
+		if (qwRunStartUs && qwNow - qwRunStartUs >= (uint64_t) iDuration * 1000000)
+			break;
+
+		if (iStarted == iBotCount && !iAlive)
+		{
+			printf("all bots disconnected\n");
+			break;
+		}
+
+		if (!vecPoll.empty())
+			poll(&vecPoll[0], vecPoll.size(), 10);
+		else
+			usleep(10000);
+
+		for (size_t i = 0; i < vecPoll.size(); ++i)
+		{
+			CBot * pkBot = vecPollBot[i];
+
+			if (vecPoll[i].revents & (POLLIN | POLLHUP | POLLERR))
+				pkBot->OnReadable();
+
+			if (vecPoll[i].revents & POLLOUT)
+				pkBot->OnWritable();
+		}
+
+		qwNow = loadsim_time_us();
+
+		for (size_t i = 0; i < vecBot.size(); ++i)
+		{
+			vecBot[i]->Update(qwNow);
+
+			// push what the script queued without waiting for the next poll
+			if (vecBot[i]->HasOutput())
+				vecBot[i]->OnWritable();
+		}
+
+		if (qwNow >= qwNextReportUs)
+		{
+			double dSec = (qwNow - qwLastReportUs) / 1000000.0;
+			std::vector<DWORD> vecRtt(g_kStats.vecRttUs);
+
+			printf("t=%3llus bots %d/%d in game, send %.0f pkt/s, recv %.0f pkt/s, chat rtt p50 %.2fms p99 %.2fms (%zu)\n",
+					(unsigned long long) ((qwNow - qwStartUs) / 1000000), iInGame, iBotCount,
+					(g_kStats.qwPacketsSent - qwLastSent) / dSec, (g_kStats.qwPacketsRecv - qwLastRecv) / dSec,
+					percentile(vecRtt, 0.5) / 1000.0, percentile(vecRtt, 0.99) / 1000.0, vecRtt.size());
+			fflush(stdout);
+
+			qwLastSent = g_kStats.qwPacketsSent;
+			qwLastRecv = g_kStats.qwPacketsRecv;
+			qwLastReportUs = qwNow;
+			qwNextReportUs = qwNow + 1000000;
+		}
+	}
+
+	uint64_t qwEndUs = loadsim_time_us();
+	bool bMetricsEnd = bMetrics && bMetricsBegin && read_metrics(config.stGameHost, config.wGamePort, mapMetricsEnd);
+
+	for (size_t i = 0; i < vecBot.size(); ++i)
+		delete vecBot[i];
+
+	double dRunSec = qwRunStartUs ? (qwEndUs - qwRunStartUs) / 1000000.0 : 0;
+
+	printf("---\n");
+	printf("bots %d, login failed %d, disconnected in game %d, framing errors %d\n",
+			iBotCount, g_kStats.iLoginFailed, g_kStats.iDisconnected, g_kStats.iFramingErrors);
+	printf("login: p50 %ums p99 %ums (%zu)\n",
+			percentile(g_kStats.vecLoginMs, 0.5), percentile(g_kStats.vecLoginMs, 0.99), g_kStats.vecLoginMs.size());
+
+	if (dRunSec > 0)
+		printf("traffic: send %.0f pkt/s %.0f B/s, recv %.0f pkt/s %.0f B/s over %.1fs\n",
+				g_kStats.qwPacketsSent / dRunSec, g_kStats.qwBytesSent / dRunSec,
+				g_kStats.qwPacketsRecv / dRunSec, g_kStats.qwBytesRecv / dRunSec, dRunSec);
+
+	printf("chat rtt: p50 %.2fms p99 %.2fms (%zu)\n",
+			percentile(g_kStats.vecRttUs, 0.5) / 1000.0, percentile(g_kStats.vecRttUs, 0.99) / 1000.0, g_kStats.vecRttUs.size());
+
+	if (bMetricsEnd)
+		report_pulse(mapMetricsBegin, mapMetricsEnd);
+	else if (bMetrics)
+		printf("pulse: METRICS unavailable (adminpage_ip?)\n");
+
+	return 0;
+}
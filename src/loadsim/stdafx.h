@@ -0,0 +1,14 @@
+﻿#pragma once
+
+#include "libthecore/stdafx.h"
+
+#include "common/service.h"
+#include "common/length.h"
+#include "common/tables.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "game/packet.h"